@@ -0,0 +1,416 @@
+/// @file algorithm.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 並列アルゴリズムと基数整列を提供します
+/// 並列処理はスレッドプールに分割した区間を割り当て、呼び出し元のスレッドも1区間を処理します
+
+#ifndef ELEKICORE_ALGORITHM_HPP
+#define ELEKICORE_ALGORITHM_HPP
+
+#include <thread>
+#include <memory>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "floatingpoint.hpp"
+#include "array.hpp"
+#include "view.hpp"
+#include "tasks.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// 並列処理で1区間に割り当てる最小の要素数です
+    constexpr size_t PARALLEL_MIN_GRAIN = 4096;
+
+    /// 並列整列で1区間に割り当てる最小の要素数です
+    constexpr size_t PARALLEL_SORT_MIN_GRAIN = 16384;
+
+    // 要素数を並列に処理する区間数を返す
+    inline size_t _parallelChunksCount(size_t count, size_t grain)
+    {
+        size_t workers = std::thread::hardware_concurrency();
+        if(!workers) workers = 1;
+        if(!grain) grain = 1;
+        auto chunks = (count + grain - 1) / grain;
+        return chunks < workers ? (chunks ? chunks : 1) : workers;
+    }
+
+    // 処理を区間数だけ並列に実行し、すべての終了を待つ
+    // @param count 区間数
+    // @param func void(size_t chunk)の関数オブジェクト
+    template<class F>
+    void _parallelInvoke(size_t count, const F &func)
+    {
+        if(count <= 1)
+        {
+            if(count) func(0);
+            return;
+        }
+
+        List<UR<Task<void>>> tasks;
+        for(size_t i = 1; i < count; i++)
+        {
+            tasks.add(parallel([&func, i]() { func(i); }, EThreadMode::THREAD_POOL));
+        }
+        func(0);
+        for(auto &task : tasks) task->marge();
+    }
+
+    /// すべての要素に関数を並列に適用します
+    /// @param elements 要素のビュー
+    /// @param func void(T &element)の関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class F>
+    void parallelForEach(Span<T> elements, const F &func, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        auto count = elements.count();
+        auto chunks = _parallelChunksCount(count, grain);
+        _parallelInvoke(chunks, [&](size_t chunk)
+        {
+            auto end = count * (chunk + 1) / chunks;
+            for(auto i = count * chunk / chunks; i < end; i++) func(elements.data()[i]);
+        });
+    }
+
+    /// すべての要素に関数を並列に適用します
+    /// @param elements 要素のビュー
+    /// @param func void(T &element)の関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class F>
+    void parallelForEach(List<T> &elements, const F &func, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        parallelForEach(elements.span(), func, grain);
+    }
+
+    /// すべての要素に関数を並列に適用します
+    /// @param elements 要素のビュー
+    /// @param func void(T &element)の関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, size_t N, class F>
+    void parallelForEach(Array<T, N> &elements, const F &func, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        parallelForEach(elements.span(), func, grain);
+    }
+
+    /// 要素を関数で変換した結果を並列に書き込みます
+    /// 変換元と変換先の少ない方の要素数だけ変換します
+    /// @param from 変換元のビュー
+    /// @param to 変換先のビュー
+    /// @param func U(const T &element)の関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class U, class F>
+    void parallelTransform(ArrayView<T> from, Span<U> to, const F &func, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        auto count = from.count() < to.count() ? from.count() : to.count();
+        auto chunks = _parallelChunksCount(count, grain);
+        _parallelInvoke(chunks, [&](size_t chunk)
+        {
+            auto end = count * (chunk + 1) / chunks;
+            for(auto i = count * chunk / chunks; i < end; i++) to.data()[i] = func(from.data()[i]);
+        });
+    }
+
+    /// 要素を関数で変換した結果を並列に書き込みます
+    /// 変換先は変換元と同じ要素数に作り直します
+    /// @param from 変換元
+    /// @param to 変換先
+    /// @param func U(const T &element)の関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class U, class F>
+    void parallelTransform(const List<T> &from, List<U> &to, const F &func, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        to = List<U>(from.count(), to.allocator());
+        parallelTransform(from.view(), to.span(), func, grain);
+    }
+
+    /// 要素を関数で変換した結果を並列に書き込みます
+    /// @param from 変換元
+    /// @param to 変換先
+    /// @param func U(const T &element)の関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class U, size_t N, class F>
+    void parallelTransform(const Array<T, N> &from, Array<U, N> &to, const F &func, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        parallelTransform(from.view(), to.span(), func, grain);
+    }
+
+    /// 要素を結果の型へ並列に畳み込みます
+    /// 区間毎に単位元から畳み込み、最後に区間の結果を順に結合します
+    /// 関数は結合則を満たす必要があります
+    /// @param elements 要素のビュー
+    /// @param identity 単位元
+    /// @param func U(const U &accumulator, const T &element)の関数オブジェクト
+    /// @param combine U(const U &left, const U &right)の区間の結果を結合する関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class U, class F, class G>
+    U parallelFold(ArrayView<T> elements, const U &identity, const F &func, const G &combine, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        auto count = elements.count();
+        auto chunks = _parallelChunksCount(count, grain);
+
+        List<U> results;
+        for(size_t i = 0; i < chunks; i++) results.add(identity);
+
+        _parallelInvoke(chunks, [&](size_t chunk)
+        {
+            auto end = count * (chunk + 1) / chunks;
+            U accumulator = identity;
+            for(auto i = count * chunk / chunks; i < end; i++) accumulator = func(accumulator, elements.data()[i]);
+            results[chunk] = std::move(accumulator);
+        });
+
+        U result = identity;
+        for(auto &partial : results) result = combine(result, partial);
+        return result;
+    }
+
+    /// 要素を並列に畳み込みます
+    /// 区間の結果の結合にも同じ関数を使用するため、要素と結果が同じ型である必要があります
+    /// @param elements 要素のビュー
+    /// @param identity 単位元
+    /// @param func T(const T &accumulator, const T &element)の関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class F>
+    T parallelReduce(ArrayView<T> elements, const T &identity, const F &func, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        return parallelFold(elements, identity, func, func, grain);
+    }
+
+    /// 要素を結果の型へ並列に畳み込みます
+    /// @param elements 要素
+    /// @param identity 単位元
+    /// @param func U(const U &accumulator, const T &element)の関数オブジェクト
+    /// @param combine U(const U &left, const U &right)の区間の結果を結合する関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class U, class F, class G>
+    U parallelFold(const List<T> &elements, const U &identity, const F &func, const G &combine, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        return parallelFold(elements.view(), identity, func, combine, grain);
+    }
+
+    /// 要素を並列に畳み込みます
+    /// @param elements 要素
+    /// @param identity 単位元
+    /// @param func T(const T &accumulator, const T &element)の関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class F>
+    T parallelReduce(const List<T> &elements, const T &identity, const F &func, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        return parallelReduce(elements.view(), identity, func, grain);
+    }
+
+    /// 要素を結果の型へ並列に畳み込みます
+    /// @param elements 要素
+    /// @param identity 単位元
+    /// @param func U(const U &accumulator, const T &element)の関数オブジェクト
+    /// @param combine U(const U &left, const U &right)の区間の結果を結合する関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, size_t N, class U, class F, class G>
+    U parallelFold(const Array<T, N> &elements, const U &identity, const F &func, const G &combine, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        return parallelFold(elements.view(), identity, func, combine, grain);
+    }
+
+    /// 要素を並列に畳み込みます
+    /// @param elements 要素
+    /// @param identity 単位元
+    /// @param func T(const T &accumulator, const T &element)の関数オブジェクト
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, size_t N, class F>
+    T parallelReduce(const Array<T, N> &elements, const T &identity, const F &func, size_t grain = PARALLEL_MIN_GRAIN)
+    {
+        return parallelReduce(elements.view(), identity, func, grain);
+    }
+
+    /// 生配列を並列に整列させます
+    /// 区間毎に整列させた後、隣り合う区間の併合を並列に繰り返します
+    /// 安定な整列ではありません
+    /// @param elements 整列させる生配列
+    /// @param count 整列させる要素数
+    /// @param trueLR 第1引数を第2引数より前に並べる場合、真を返してください 等しい場合は偽を返してください
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class C = Less<T>>
+    void parallelSort(T *elements, size_t count, const C &trueLR = C{}, size_t grain = PARALLEL_SORT_MIN_GRAIN)
+    {
+        // 併合で対にできるよう、区間数を2の冪乗に切り下げる
+        auto chunks = _parallelChunksCount(count, grain);
+        while(chunks & (chunks - 1)) chunks &= chunks - 1;
+        if(chunks <= 1)
+        {
+            ElekiEngine::sort<T>(elements, count, trueLR);
+            return;
+        }
+
+        auto buffer = (T *) Memory::allocate(sizeof(T) * count);
+        if(!buffer)
+        {
+            printError("failed to allocate. void parallelSort(T *elements, size_t count, const C &trueLR, size_t grain)");
+            ElekiEngine::sort<T>(elements, count, trueLR);
+            return;
+        }
+        auto bound = [count, chunks](size_t chunk) { return count * chunk / chunks; };
+
+        // 区間毎に整列させ、作業領域に移す
+        _parallelInvoke(chunks, [&](size_t chunk)
+        {
+            std::sort(elements + bound(chunk), elements + bound(chunk + 1), trueLR);
+            std::uninitialized_move(elements + bound(chunk), elements + bound(chunk + 1), buffer + bound(chunk));
+        });
+
+        // 隣り合う区間を交互の領域に併合する
+        auto from = buffer;
+        auto to = elements;
+        for(size_t width = 1; width < chunks; width *= 2)
+        {
+            _parallelInvoke(chunks / (width * 2), [&](size_t pair)
+            {
+                auto begin = from + bound(pair * width * 2);
+                auto middle = from + bound(pair * width * 2 + width);
+                auto end = from + bound(pair * width * 2 + width * 2);
+                std::merge(std::make_move_iterator(begin), std::make_move_iterator(middle),
+                           std::make_move_iterator(middle), std::make_move_iterator(end),
+                           to + bound(pair * width * 2), trueLR);
+            });
+            std::swap(from, to);
+        }
+
+        // 結果が作業領域にある場合は戻す
+        if(from != elements)
+        {
+            _parallelInvoke(chunks, [&](size_t chunk)
+            {
+                std::move(from + bound(chunk), from + bound(chunk + 1), elements + bound(chunk));
+            });
+        }
+
+        for(size_t i = 0; i < count; i++) buffer[i].~T();
+        Memory::deallocate(buffer);
+    }
+
+    /// リストを並列に整列させます
+    /// @param list 整列させるリスト
+    /// @param trueLR 第1引数を第2引数より前に並べる場合、真を返してください 等しい場合は偽を返してください
+    /// @param grain 1区間に割り当てる最小の要素数
+    template<class T, class C = Less<T>>
+    void parallelSort(List<T> &list, const C &trueLR = C{}, size_t grain = PARALLEL_SORT_MIN_GRAIN)
+    {
+        parallelSort<T>(list.data(), list.count(), trueLR, grain);
+    }
+
+    // 基数整列のキーに変換する構造体
+    // 符号無し整数として比較して、元の値と同じ順序になるように変換する
+    template<class T, bool IS_FLOAT = std::is_floating_point_v<T>, bool IS_SIGNED = std::is_signed_v<T>>
+    struct _RadixKey
+    {
+        using Key = std::make_unsigned_t<T>;
+
+        Key operator()(T value) const
+        {
+            return (Key) value;
+        }
+    };
+
+    // 符号付き整数は符号ビットを反転させる
+    template<class T>
+    struct _RadixKey<T, false, true>
+    {
+        using Key = std::make_unsigned_t<T>;
+
+        Key operator()(T value) const
+        {
+            return (Key) value ^ ((Key) 1 << (sizeof(T) * 8 - 1));
+        }
+    };
+
+    // 浮動小数点数は負のとき全ビットを、正のとき符号ビットを反転させる
+    template<class T>
+    struct _RadixKey<T, true, true>
+    {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "not supported type. _RadixKey<T, true, true>");
+        using Key = std::conditional_t<sizeof(T) == 4, u32, u64>;
+
+        Key operator()(T value) const
+        {
+            Key bits;
+            std::memcpy(&bits, &value, sizeof(T));
+            constexpr Key sign = (Key) 1 << (sizeof(T) * 8 - 1);
+            return bits ^ ((bits & sign) ? ~(Key) 0 : sign);
+        }
+    };
+
+    /// 生配列を基数整列で昇順に整列させます
+    /// 下位から1バイトずつ分配する、安定な整列です
+    /// すべての要素で同じ値のバイトは分配を省略します
+    /// @param elements 整列させる整数、または、f32かf64の生配列
+    /// @param count 整列させる要素数
+    template<class T>
+    void radixSort(T *elements, size_t count)
+    {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && (!std::is_floating_point_v<T> || sizeof(T) == 4 || sizeof(T) == 8), "not supported type. void radixSort(T *elements, size_t count)");
+        constexpr size_t DIGITS = sizeof(T);
+        constexpr size_t RADIX = 256;
+
+        if(count < 2) return;
+
+        auto buffer = (T *) Memory::allocate(sizeof(T) * count);
+        if(!buffer)
+        {
+            printError("failed to allocate. void radixSort(T *elements, size_t count)");
+            ElekiEngine::sort<T>(elements, count);
+            return;
+        }
+
+        // 全桁の度数を1度の走査で数える
+        _RadixKey<T> toKey;
+        size_t histograms[DIGITS][RADIX] = {};
+        for(size_t i = 0; i < count; i++)
+        {
+            auto key = toKey(elements[i]);
+            for(size_t d = 0; d < DIGITS; d++) histograms[d][(key >> (d * 8)) & 0xFF]++;
+        }
+
+        auto from = elements;
+        auto to = buffer;
+        for(size_t d = 0; d < DIGITS; d++)
+        {
+            auto &histogram = histograms[d];
+
+            // すべての要素が同じバイトの場合は分配しない
+            if(histogram[(toKey(from[0]) >> (d * 8)) & 0xFF] == count) continue;
+
+            // 度数から分配先の位置を求める
+            size_t offset = 0;
+            for(size_t r = 0; r < RADIX; r++)
+            {
+                auto tmp = histogram[r];
+                histogram[r] = offset;
+                offset += tmp;
+            }
+
+            for(size_t i = 0; i < count; i++)
+            {
+                to[histogram[(toKey(from[i]) >> (d * 8)) & 0xFF]++] = from[i];
+            }
+            std::swap(from, to);
+        }
+
+        if(from != elements) std::memcpy(elements, from, sizeof(T) * count);
+        Memory::deallocate(buffer);
+    }
+
+    /// リストを基数整列で昇順に整列させます
+    /// @param list 整列させる整数、または、浮動小数点数のリスト
+    template<class T>
+    void radixSort(List<T> &list)
+    {
+        radixSort<T>(list.data(), list.count());
+    }
+
+}
+
+#endif // !ELEKICORE_ALGORITHM_HPP
\ No newline at end of file
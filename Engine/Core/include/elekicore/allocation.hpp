@@ -1,5 +1,5 @@
 /// @file allocation.hpp
-/// @version 1.22.4
+/// @version 1.22.6
 /// @copyright © 2022 Taichi Ito
 /// メモリ確保、解放処理機能を提供します
 
@@ -8,6 +8,7 @@
 
 #include "preprocess.hpp"
 #include "integer.hpp"
+#include "intrusive.hpp"
 
 /// ELEKi ENGINE
 namespace ElekiEngine
@@ -129,19 +130,18 @@ namespace ElekiEngine
         {
             StaticMemoryPool mMemory;   // バッファ管理
             DynamicMemoryPool *mSystem; // このノードを管理するシステム
-            Node *mPrev;                // 前ノード
-            Node *mNext;                // 次ノード
+            IntrusiveListHook mHook;    // ノードリストのフック
 
             // コンストラクタ
-            Node(size_t elementSize, size_t elementsCount, DynamicMemoryPool *system, Node *prev, Node *next);
+            Node(size_t elementSize, size_t elementsCount, DynamicMemoryPool *system);
 
             // デストラクタ
             ~Node();
         };
 
-        size_t mElementSize;   // 要素サイズ
-        size_t mElementsCount; // 要素数
-        Node *mTopNode;        // 現在使用中のノード
+        size_t mElementSize;                      // 要素サイズ
+        size_t mElementsCount;                    // 要素数
+        IntrusiveList<Node, &Node::mHook> mNodes; // ノードリスト 先頭が現在使用中のノード
 
     public:
 
@@ -180,6 +180,35 @@ namespace ElekiEngine
         virtual void deallocate(void *pointer) = 0;
     };
 
+    /// フレームメモリから確保するアロケータです
+    /// 個別の解放は行わず、フレームメモリの一括解放で解放します
+    /// 1フレームの間だけ使う一時的な文字列や配列に渡して使用します
+    class FrameAllocator: public IAllocator
+    {
+        DynamicFrameMemory *mMemory; // 確保元のフレームメモリ
+
+    public:
+
+        /// コンストラクタ
+        /// @param memory 確保元のフレームメモリ
+        FrameAllocator(DynamicFrameMemory *memory)
+            : mMemory(memory)
+        {}
+
+        /// メモリを確保します
+        /// @param byteSize 確保するメモリサイズ
+        /// @retval nullptr メモリの確保に失敗しました
+        void *allocate(size_t byteSize) override
+        {
+            return mMemory->allocate(byteSize);
+        }
+
+        /// 何もしません
+        /// フレームメモリの一括解放で解放されます
+        void deallocate(void *) override
+        {}
+    };
+
     /// 終了処理インタフェース
     class IDeleter
     {
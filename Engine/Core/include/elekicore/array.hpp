@@ -6,23 +6,27 @@
 #ifndef ELEKICORE_ARRAY_HPP
 #define ELEKICORE_ARRAY_HPP
 
+#include <new>
+#include <utility>
 #include <algorithm>
 #include "functional.hpp"
 #include "allocation.hpp"
 #include "datalog.hpp"
+#include "view.hpp"
 
 /// ELEKi ENGINE
 namespace ElekiEngine
 {
     
     /// 生配列を整列させます
+    /// 比較関数はテンプレート引数で受け取るため、インライン展開されます
     /// @param elements 整列させる生配列
     /// @param count 整列させる要素数
-    /// @param trueLR 先頭から第1引数、第2引数の順に並べる場合、真を返してください
-    template<class T>
-    void sort(T *elements, size_t count, const Compare<T> &trueLR = [](const T &l, const T &r) { return l <= r; })
+    /// @param trueLR 第1引数を第2引数より前に並べる場合、真を返してください 等しい場合は偽を返してください
+    template<class T, class C = Less<T>>
+    void sort(T *elements, size_t count, const C &trueLR = C{})
     {
-        std::sort(elements, &elements[count], trueLR);
+        std::sort(elements, elements + count, trueLR);
     }
 
     /// 生配列をコピーします 
@@ -380,42 +384,67 @@ namespace ElekiEngine
         /// 添え字から要素にアクセスします
         T &operator[](size_t index)
         {
-            if(index >= N) printError(T("out of range. T &Array<T>::operator[](size_t index)"));
+            if(index >= N) printError("out of range. T &Array<T>::operator[](size_t index)");
             return elements[index];
         }
 
         /// 添え字から要素にアクセスします
         const T &operator[](size_t index) const
         {
-            if(index >= N) printError(T("out of range. const T &Array<T>::operator[](size_t index) const"));
+            if(index >= N) printError("out of range. const T &Array<T>::operator[](size_t index) const");
             return elements[index];
         }
 
         /// 添え字から要素にアクセスします
         T &at(size_t index)
         {
-            if(index >= N) printError(T("out of range. T &Array<T>::at(size_t index)"));
+            if(index >= N) printError("out of range. T &Array<T>::at(size_t index)");
             return elements[index];
         }
 
         /// 添え字から要素にアクセスします
         const T &at(size_t index) const
         {
-            if(index >= N) printError(T("out of range. const T &Array<T>::at(size_t index) const"));
+            if(index >= N) printError("out of range. const T &Array<T>::at(size_t index) const");
             return elements[index];
         }
 
+        /// 不変ビューに変換します
+        operator ArrayView<T>() const
+        {
+            return ArrayView<T>(elements, N);
+        }
+
+        /// 可変ビューに変換します
+        operator Span<T>()
+        {
+            return Span<T>(elements, N);
+        }
+
         /// 要素数を返します
         constexpr size_t count() const
         {
             return N;
         }
 
+        /// 不変ビューを返します
+        ArrayView<T> view() const
+        {
+            return ArrayView<T>(elements, N);
+        }
+
+        /// 可変ビューを返します
+        Span<T> span()
+        {
+            return Span<T>(elements, N);
+        }
+
         /// 整列します
-        /// @param trueLR 先頭から第1引数、第2引数の順に並べる場合、真を返してください
-        Array<T, N> &sort(const Compare<T> &trueLR = [](const T &l, const T &r) { return l <= r; })
+        /// @param trueLR 第1引数を第2引数より前に並べる場合、真を返してください 等しい場合は偽を返してください
+        template<class C = Less<T>>
+        Array<T, N> &sort(const C &trueLR = C{})
         {
-            sort<T>(elements, N, trueLR);
+            ElekiEngine::sort<T>(elements, N, trueLR);
             return *this;
         }
 
@@ -428,7 +457,7 @@ namespace ElekiEngine
         {
             Array<T, M> arr;
             auto len = N - B < C ? N - B : C;
-            copy<T>(elements, B, arr.elements, 0, len);
+            ElekiEngine::copy<T>(elements, B, arr.elements, 0, len);
             return arr;
         }
 
@@ -441,7 +470,7 @@ namespace ElekiEngine
         {
             Array<T, M> arr;
             auto len = N - beginIndex < rangeCount ? N - beginIndex : rangeCount;
-            copy<T>(elements, beginIndex, arr.elements, 0, len);
+            ElekiEngine::copy<T>(elements, beginIndex, arr.elements, 0, len);
             return arr;
         }
 
@@ -499,103 +528,162 @@ namespace ElekiEngine
         size_t mCount;                                 // 要素数
         T *mElements;                                  // 要素配列
 
-        // コピー
-        void copyFrom(T *ptr, size_t count)
+        // 配列を確保する
+        T *allocateElements(size_t size)
         {
-            mAllocator->deallocate(mElements, mSize);
-            mCount = count;
-            mSize = mCount * 2;
-            mElements = mAllocator->allocate(mSize);
-
-            copy(ptr, 0, mElements, 0, mCount);
+            return size ? (T *) mAllocator->allocate(TYPE_SIZE * size) : nullptr;
         }
 
-        // 末尾にリスト追加
-        void addFrom(T *ptr, size_t count)
+        // 配列を解放する
+        void deallocateElements(T *elements)
         {
-            auto newCount = mCount + count;
-            auto newSize = newCount * 2;
-            auto newElems = mAllocator->allocate(newSize);
+            if(elements) mAllocator->deallocate(elements);
+        }
 
-            copy(mElements, 0, newElems, 0, mCount);
-            copy(ptr, 0, newElems, mCount, count);
+        // 配列サイズを変更する
+        // 配列サイズより後ろの要素は破棄する
+        void reallocate(size_t size)
+        {
+            auto newElems = allocateElements(size);
+            auto len = mCount < size ? mCount : size;
+            for(size_t i = 0; i < len; i++) new(&newElems[i]) T(std::move(mElements[i]));
+            for(size_t i = 0; i < mCount; i++) mElements[i].~T();
 
-            mAllocator->deallocate(mElements, mSize);
-            mCount = newCount;
-            mSize = newSize;
+            deallocateElements(mElements);
             mElements = newElems;
+            mSize = size;
+            mCount = len;
         }
 
-        // 末尾に要素を追加
-        void addFrom(const T &elem)
+        // 指定要素数が入るように配列を増やす
+        void reserveFor(size_t count)
         {
-            // 配列が足りない場合は倍に増やす
-            if(mCount == mSize)
-            {
-                auto newSize = mCount * 2;
-                auto newElems = mAllocator->allocate(newSize);
+            if(count <= mSize) return;
+            auto newSize = mSize * 2;
+            if(newSize < count) newSize = count;
+            if(newSize < INIT_ELEM_CNT_A) newSize = INIT_ELEM_CNT_A;
+            reallocate(newSize);
+        }
 
-                copy(mElements, 0, newElems, 0, mCount);
+        // 生配列が自身の要素を指しているか判定する
+        bool isInside(const T *ptr) const
+        {
+            return mElements && mElements <= ptr && ptr < mElements + mCount;
+        }
 
-                mAllocator->deallocate(mElements, mSize);
-                mSize = newSize;
-                mElements = newElems;
+        // コピー
+        void copyFrom(const T *ptr, size_t count)
+        {
+            if(isInside(ptr))
+            {
+                List<T> tmp(ArrayView<T>(ptr, count), mAllocator);
+                *this = std::move(tmp);
+                return;
             }
 
-            // 追加
-            mElements[mCount] = elem;
-            mCount++;
+            clearElements();
+            reserveFor(count);
+            for(size_t i = 0; i < count; i++) new(&mElements[i]) T(ptr[i]);
+            mCount = count;
         }
 
-        // 指定位置にリスト追加
-        void insertFrom(size_t index, T *ptr, size_t count)
+        // 末尾にリスト追加
+        void addFrom(const T *ptr, size_t count)
         {
-            auto newCount = mCount + count;
-            auto newSize = newCount * 2;
-            auto newElems = mAllocator->allocate(newSize);
-
-            copy(mElements, 0, newElems, 0, index);
-            copy(ptr, 0, newElems, index, count);
-            copy(mSize, index, newElems, index + count, mCount - index);
+            // 自身の要素を追加する場合、伸長で移動するため位置で覚えておく
+            if(isInside(ptr))
+            {
+                auto offset = (size_t) (ptr - mElements);
+                reserveFor(mCount + count);
+                ptr = mElements + offset;
+            }
+            else
+            {
+                reserveFor(mCount + count);
+            }
 
-            mAllocator->deallocate(mElements, mSize);
-            mCount = newCount;
-            mSize = newSize;
-            mElements = newElems;
+            for(size_t i = 0; i < count; i++) new(&mElements[mCount + i]) T(ptr[i]);
+            mCount += count;
         }
 
-        // 指定位置に要素を追加
-        void insertFrom(size_t index, const T &elem)
+        // 末尾に要素を追加
+        void addFrom(const T &elem)
         {
             // 配列が足りない場合は倍に増やす
             if(mCount == mSize)
             {
-                auto newSize = mCount * 2;
-                auto newElems = mAllocator->allocate(newSize);
+                T tmp(elem);
+                reserveFor(mCount + 1);
+                new(&mElements[mCount]) T(std::move(tmp));
+            }
+            else
+            {
+                new(&mElements[mCount]) T(elem);
+            }
+            mCount++;
+        }
 
-                copy(mElements, 0, newElems, 0, index);
-                copy(mElements, index, newElems, index + 1, mCount - index);
+        // 末尾に要素を追加
+        void addFrom(T &&elem)
+        {
+            // 配列が足りない場合は倍に増やす
+            if(mCount == mSize)
+            {
+                T tmp(std::move(elem));
+                reserveFor(mCount + 1);
+                new(&mElements[mCount]) T(std::move(tmp));
+            }
+            else
+            {
+                new(&mElements[mCount]) T(std::move(elem));
+            }
+            mCount++;
+        }
 
-                mAllocator->deallocate(mElements, mSize);
-                mSize = newSize;
-                mElements = newElems;
+        // 指定位置にリスト追加
+        void insertFrom(size_t index, const T *ptr, size_t count)
+        {
+            if(!count) return;
 
-                // 追加
-                mElements[index] = elem;
-                mCount++;
+            // 自身の要素を挿入する場合、移動で上書きされるため複製してから挿入する
+            if(isInside(ptr))
+            {
+                List<T> tmp(ArrayView<T>(ptr, count), mAllocator);
+                insertFrom(index, tmp.mElements, tmp.mCount);
+                return;
             }
-            else
+
+            reserveFor(mCount + count);
+
+            // 挿入位置から後ろを移動
+            for(size_t i = mCount; i-- > index;)
             {
-                // 移動
-                for(int i = mCount - 1; i >= index; i--)
-                {
-                    mElements[i + 1] = mElements[i];
-                }
+                auto to = i + count;
+                if(to >= mCount) new(&mElements[to]) T(std::move(mElements[i]));
+                else mElements[to] = std::move(mElements[i]);
+            }
 
-                // 追加
-                mElements[index] = elem;
-                mCount++;
+            // 追加
+            for(size_t i = 0; i < count; i++)
+            {
+                auto to = index + i;
+                if(to < mCount) mElements[to] = ptr[i];
+                else new(&mElements[to]) T(ptr[i]);
             }
+            mCount += count;
+        }
+
+        // 指定位置に要素を追加
+        void insertFrom(size_t index, const T &elem)
+        {
+            insertFrom(index, &elem, 1);
+        }
+
+        // 要素をすべて破棄する
+        void clearElements()
+        {
+            for(size_t i = 0; i < mCount; i++) mElements[i].~T();
+            mCount = 0;
         }
 
     public:
@@ -607,67 +695,117 @@ namespace ElekiEngine
             : mAllocator(allocator)
             , mSize(count + INIT_ELEM_CNT_A)
             , mCount(count)
-            , mElements(allocator.allocate(mSize))
-        {}
+            , mElements(allocateElements(mSize))
+        {
+            for(size_t i = 0; i < mCount; i++) new(&mElements[i]) T();
+        }
 
         /// コンストラクタ
         /// @param allocator 使用するアロケータ
         List(IAllocator *allocator = Memory::allocator())
-            : List(0, allocator)
+            : mAllocator(allocator)
+            , mSize(INIT_ELEM_CNT_A)
+            , mCount(0)
+            , mElements(allocateElements(mSize))
         {}
 
         /// コンストラクタ
         /// @param list 初期化リスト
         /// @param allocator 使用するアロケータ
         List(std::initializer_list<T> list, IAllocator *allocator = Memory::allocator())
-            : List(list.size(), allocator)
-        {}
+            : List(allocator)
+        {
+            addFrom(list.begin(), list.size());
+        }
+
+        /// コンストラクタ
+        /// @param view コピーする要素のビュー
+        /// @param allocator 使用するアロケータ
+        explicit List(ArrayView<T> view, IAllocator *allocator = Memory::allocator())
+            : List(allocator)
+        {
+            addFrom(view.data(), view.count());
+        }
 
         /// コピーコンストラクタ
         List(const List<T> &list)
-            : List(list.count(), list.mAllocator)
+            : List(list.mAllocator)
         {
-            copy(list.mElements, 0, mElements, 0, mCount);
+            addFrom(list.mElements, list.mCount);
         }
 
         /// ムーブコンストラクタ
         List(List<T> &&list) noexcept
-            : List(list.count(), list.mAllocator)
+            : mAllocator(list.mAllocator)
+            , mSize(list.mSize)
+            , mCount(list.mCount)
+            , mElements(list.mElements)
         {
-            copy(list.mElements, 0, mElements, 0, mCount);
+            list.mSize = 0;
+            list.mCount = 0;
+            list.mElements = nullptr;
         }
 
         /// デストラクタ
         ~List()
         {
-            mAllocator->deallocate(mElements, mSize);
+            clearElements();
+            deallocateElements(mElements);
         }
 
         /// コピー代入します
         List<T> &operator=(const List<T> &list)
         {
-            copyFrom(list.mElements, list.mCount);
+            if(this != &list) copyFrom(list.mElements, list.mCount);
             return *this;
         }
 
         /// ムーブ代入します
         List<T> &operator=(List<T> &&list) noexcept
         {
-            copyFrom(list.mElements, list.mCount);
+            if(this == &list) return *this;
+            clearElements();
+            deallocateElements(mElements);
+            mAllocator = list.mAllocator;
+            mSize = list.mSize;
+            mCount = list.mCount;
+            mElements = list.mElements;
+            list.mSize = 0;
+            list.mCount = 0;
+            list.mElements = nullptr;
             return *this;
         }
 
+        /// 不変ビューに変換します
+        operator ArrayView<T>() const
+        {
+            return ArrayView<T>(mElements, mCount);
+        }
+
+        /// 可変ビューに変換します
+        operator Span<T>()
+        {
+            return Span<T>(mElements, mCount);
+        }
+
         /// 末尾に追加します
         List<T> &operator+=(const List<T> &list)
         {
-            addFrom(list.mElements, list.mSize);
+            addFrom(list.mElements, list.mCount);
             return *this;
         }
 
         /// 末尾に追加します
         List<T> &operator+=(List<T> &&list) noexcept
         {
-            addFrom(list.mElements, list.mSize);
+            addFrom(list.mElements, list.mCount);
+            return *this;
+        }
+
+        /// 末尾に追加します
+        List<T> &operator+=(ArrayView<T> view)
+        {
+            addFrom(view.data(), view.count());
             return *this;
         }
 
@@ -681,51 +819,50 @@ namespace ElekiEngine
         /// 末尾に追加します
         List<T> &operator+=(T &&element) noexcept
         {
-            addFrom(element);
+            addFrom(std::move(element));
             return *this;
         }
 
         /// 添え字から要素にアクセスします
         T &operator[](size_t index)
         {
-            if(index >= mCount) printError(T("out of range. T &List<T>::operator[](size_t index)"));
+            if(index >= mCount) printError("out of range. T &List<T>::operator[](size_t index)");
             return mElements[index];
         }
 
         /// 添え字から要素にアクセスします
         const T &operator[](size_t index) const
         {
-            if(index >= mCount) printError(T("out of range. const T &List<T>::operator[](size_t index) const"));
+            if(index >= mCount) printError("out of range. const T &List<T>::operator[](size_t index) const");
             return mElements[index];
         }
 
         /// 配列のサイズを変更します
         List<T> &resize(size_t size)
         {
-            // コピー
-            auto newElems = mAllocator->allocate(size);
-            auto len = mCount < size ? mCount : size;
-            copy(mElements, 0, newElems, 0, len);
-
-            mAllocator->deallocate(mElements, mSize);
-            mElements = newElems;
-            mSize = size;
-            mCount = len;
-
+            reallocate(size);
             return *this;
         }
 
         /// 末尾に追加します
         List<T> &add(const List<T> &list)
         {
-            addFrom(list.mElements, list.mSize);
+            addFrom(list.mElements, list.mCount);
             return *this;
         }
 
         /// 末尾に追加します
         List<T> &add(List<T> &&list) noexcept
         {
-            addFrom(list.mElements, list.mSize);
+            addFrom(list.mElements, list.mCount);
+            return *this;
+        }
+
+        /// 末尾に範囲を追加します
+        /// @param view 追加する要素のビュー
+        List<T> &add(ArrayView<T> view)
+        {
+            addFrom(view.data(), view.count());
             return *this;
         }
 
@@ -739,21 +876,21 @@ namespace ElekiEngine
         /// 末尾に追加します
         List<T> &add(T &&element) noexcept
         {
-            addFrom(element);
+            addFrom(std::move(element));
             return *this;
         }
 
         /// 添え字から要素にアクセスします
         T &at(size_t index)
         {
-            if(index >= mCount) printError(T("out of range. T &List<T>::at(size_t index)"));
+            if(index >= mCount) printError("out of range. T &List<T>::at(size_t index)");
             return mElements[index];
         }
 
         /// 添え字から要素にアクセスします
         const T &at(size_t index) const
         {
-            if(index >= mCount) printError(T("out of range. const T &at(size_t index) const"));
+            if(index >= mCount) printError("out of range. const T &at(size_t index) const");
             return mElements[index];
         }
 
@@ -762,7 +899,7 @@ namespace ElekiEngine
         {
             if(index >= mCount)
             {
-                printError(T("out of range. List<T> &List<T>::insert(size_t index, const List<T> &list)"));
+                printError("out of range. List<T> &List<T>::insert(size_t index, const List<T> &list)");
             }
             else
             {
@@ -776,7 +913,7 @@ namespace ElekiEngine
         {
             if(index >= mCount)
             {
-                printError(T("out of range. List<T> &List<T>::insert(size_t index, List<T> &&list)"));
+                printError("out of range. List<T> &List<T>::insert(size_t index, List<T> &&list)");
             }
             else
             {
@@ -785,12 +922,28 @@ namespace ElekiEngine
             return *this;
         }
 
+        /// 指定位置に範囲を挿入します
+        /// @param index 挿入位置
+        /// @param view 挿入する要素のビュー
+        List<T> &insert(size_t index, ArrayView<T> view)
+        {
+            if(index >= mCount)
+            {
+                printError("out of range. List<T> &List<T>::insert(size_t index, ArrayView<T> view)");
+            }
+            else
+            {
+                insertFrom(index, view.data(), view.count());
+            }
+            return *this;
+        }
+
         /// 指定位置に挿入します
         List<T> &insert(size_t index, const T &element)
         {
             if(index >= mCount)
             {
-                printError(T("out of range. List<T> &List<T>::insert(size_t index, const T &element)"));
+                printError("out of range. List<T> &List<T>::insert(size_t index, const T &element)");
             }
             else
             {
@@ -804,7 +957,7 @@ namespace ElekiEngine
         {
             if(index >= mCount)
             {
-                printError(T("out of range. List<T> &List<T>::insert(size_t index, T &&element)"));
+                printError("out of range. List<T> &List<T>::insert(size_t index, T &&element)");
             }
             else
             {
@@ -857,29 +1010,30 @@ namespace ElekiEngine
         {
             if(index >= mCount)
             {
-                printError(T("out of range. List<T> &List<T>::removeAt(size_t index, bool swapLast)"));
+                printError("out of range. List<T> &List<T>::removeAt(size_t index, bool swapLast)");
             }
             else
             {
                 if(swapLast)
                 {
                     // 末尾を代わりに入れる
-                    mElements[index] = mElements[mCount - 1];
+                    if(index != mCount - 1) mElements[index] = std::move(mElements[mCount - 1]);
                 }
                 else
                 {
                     // 順に詰める
                     for(size_t i = index; i < mCount - 1; i++)
                     {
-                        mElements[i] = mElements[i + 1];
+                        mElements[i] = std::move(mElements[i + 1]);
                     }
                 }
                 mCount--;
+                mElements[mCount].~T();
 
                 // 要素数が配列長の1/2以下のとき、配列長を3/4にする
-                if(mCount <= (size_t) (mSize * 0.5f))
+                if(mCount <= (size_t) (mSize * 0.5f) && mSize > INIT_ELEM_CNT_A)
                 {
-                    resize((size_t) (mSize * 0.75f)));
+                    resize((size_t) (mSize * 0.75f));
                 }
             }
             return *this;
@@ -916,20 +1070,61 @@ namespace ElekiEngine
         }
 
         /// 整列します
-        /// @param trueLR 先頭から第1引数、第2引数の順に並べる場合、真を返してください
-        List<T> &sort(const Compare<T> &trueLR = [](const T &l, const T &r) { return l <= r; })
+        /// @param trueLR 第1引数を第2引数より前に並べる場合、真を返してください 等しい場合は偽を返してください
+        template<class C = Less<T>>
+        List<T> &sort(const C &trueLR = C{})
         {
-            sort<T>(mElements, mCount, trueLR);
+            ElekiEngine::sort<T>(mElements, mCount, trueLR);
             return *this;
         }
 
         /// クリアします
         void clear()
         {
-            mAllocator->deallocate(mElements, mSize);
+            clearElements();
+            deallocateElements(mElements);
             mSize = INIT_ELEM_CNT_A;
-            mCount = 0;
-            mElements = mAllocator->allocate(mSize);
+            mElements = allocateElements(mSize);
+        }
+
+        /// 不変ビューを返します
+        ArrayView<T> view() const
+        {
+            return ArrayView<T>(mElements, mCount);
+        }
+
+        /// 一部を参照する不変ビューを返します
+        /// @param index 先頭位置
+        /// @param length 要素数
+        ArrayView<T> view(size_t index, size_t length) const
+        {
+            return view().sub(index, length);
+        }
+
+        /// 可変ビューを返します
+        Span<T> span()
+        {
+            return Span<T>(mElements, mCount);
+        }
+
+        /// 一部を参照する可変ビューを返します
+        /// @param index 先頭位置
+        /// @param length 要素数
+        Span<T> span(size_t index, size_t length)
+        {
+            return span().sub(index, length);
+        }
+
+        /// 先頭要素のポインタを返します
+        T *data()
+        {
+            return mElements;
+        }
+
+        /// 先頭要素のポインタを返します
+        const T *data() const
+        {
+            return mElements;
         }
 
         /// 先頭イテレータを返します
@@ -947,13 +1142,13 @@ namespace ElekiEngine
         /// 番兵イテレータを返します
         PointerItr<T> end()
         {
-            return PointerItr<T>(&mElements[mCount]);
+            return PointerItr<T>(mElements + mCount);
         }
 
         /// 番兵イテレータを返します
         ConstPointerItr<T> end() const
         {
-            return ConstPointerItr<T>(&mElements[mCount]);
+            return ConstPointerItr<T>(mElements + mCount);
         }
 
         /// アロケータを取得します
@@ -0,0 +1,106 @@
+/// @file bit.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// ビット演算機能を提供します
+
+#ifndef ELEKICORE_BIT_HPP
+#define ELEKICORE_BIT_HPP
+
+#include "preprocess.hpp"
+#include "integer.hpp"
+
+#if ELEKI_COMPILER_VC
+#include <intrin.h>
+#endif
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// 立っているビットの数を返します
+    inline u32 popCount(u64 value)
+    {
+    #if ELEKI_COMPILER_GCC || ELEKI_COMPILER_CLANG
+        return (u32) __builtin_popcountll(value);
+    #elif ELEKI_COMPILER_VC && ELEKI_OS_WINDOWS64 && ELEKI_SIMD_AVX2
+        return (u32) __popcnt64(value);
+    #else
+        value = value - ((value >> 1) & 0x5555555555555555ull);
+        value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+        value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+        return (u32) ((value * 0x0101010101010101ull) >> 56);
+    #endif
+    }
+
+    /// 下位から連続する0のビット数を返します
+    /// @retval 64 値が0です
+    inline u32 countTrailingZeros(u64 value)
+    {
+        if(!value) return 64;
+    #if ELEKI_COMPILER_GCC || ELEKI_COMPILER_CLANG
+        return (u32) __builtin_ctzll(value);
+    #elif ELEKI_COMPILER_VC && ELEKI_OS_WINDOWS64
+        unsigned long index = 0;
+        _BitScanForward64(&index, value);
+        return (u32) index;
+    #else
+        u32 count = 0;
+        while(!(value & 1))
+        {
+            value >>= 1;
+            count++;
+        }
+        return count;
+    #endif
+    }
+
+    /// 上位から連続する0のビット数を返します
+    /// @retval 64 値が0です
+    inline u32 countLeadingZeros(u64 value)
+    {
+        if(!value) return 64;
+    #if ELEKI_COMPILER_GCC || ELEKI_COMPILER_CLANG
+        return (u32) __builtin_clzll(value);
+    #elif ELEKI_COMPILER_VC && ELEKI_OS_WINDOWS64
+        unsigned long index = 0;
+        _BitScanReverse64(&index, value);
+        return (u32) (63 - index);
+    #else
+        u32 count = 0;
+        while(!(value & 0x8000000000000000ull))
+        {
+            value <<= 1;
+            count++;
+        }
+        return count;
+    #endif
+    }
+
+    /// 左にビット回転させます
+    constexpr u64 rotateLeft(u64 value, u32 shift)
+    {
+        return (value << (shift & 63)) | (value >> ((64 - shift) & 63));
+    }
+
+    /// 右にビット回転させます
+    constexpr u64 rotateRight(u64 value, u32 shift)
+    {
+        return (value >> (shift & 63)) | (value << ((64 - shift) & 63));
+    }
+
+    /// 2の冪乗か判定します
+    constexpr bool isPowerOfTwo(u64 value)
+    {
+        return value && !(value & (value - 1));
+    }
+
+    /// 値以上で最小の2の冪乗を返します
+    inline u64 nextPowerOfTwo(u64 value)
+    {
+        if(value <= 1) return 1;
+        return 1ull << (64 - countLeadingZeros(value - 1));
+    }
+
+}
+
+#endif // !ELEKICORE_BIT_HPP
\ No newline at end of file
@@ -0,0 +1,826 @@
+/// @file bitset.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 固定長ビット集合、可変長ビット集合を提供します
+/// アーキタイプのシグネチャ、クエリの照合、タスクの依存マスクなどに使用します
+
+#ifndef ELEKICORE_BITSET_HPP
+#define ELEKICORE_BITSET_HPP
+
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "bit.hpp"
+#include "allocation.hpp"
+#include "datalog.hpp"
+
+#if ELEKI_SIMD_AVX2
+#include <immintrin.h>
+#elif ELEKI_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// 1ワードのビット数です
+    constexpr size_t BITS_PER_WORD = 64;
+
+    // ビット列同士の演算を代入する関数を作成するマクロです
+    // a は代入先、b は演算対象のベクトルを表します
+    #if ELEKI_SIMD_AVX2
+    #define _ELEKICORE_BITSET_OPERATION(NAME, OP256, OP128, OP64)                           \
+    inline void NAME(u64 *to, const u64 *from, size_t words)                                \
+    {                                                                                       \
+        size_t i = 0;                                                                       \
+        for(; i + 4 <= words; i += 4)                                                       \
+        {                                                                                   \
+            auto a = _mm256_loadu_si256((const __m256i *) (const void *) &to[i]);           \
+            auto b = _mm256_loadu_si256((const __m256i *) (const void *) &from[i]);         \
+            _mm256_storeu_si256((__m256i *) (void *) &to[i], OP256);                        \
+        }                                                                                   \
+        for(; i < words; i++)                                                               \
+        {                                                                                   \
+            auto a = to[i];                                                                 \
+            auto b = from[i];                                                               \
+            to[i] = OP64;                                                                   \
+        }                                                                                   \
+    }
+    #elif ELEKI_SIMD_SSE2
+    #define _ELEKICORE_BITSET_OPERATION(NAME, OP256, OP128, OP64)                           \
+    inline void NAME(u64 *to, const u64 *from, size_t words)                                \
+    {                                                                                       \
+        size_t i = 0;                                                                       \
+        for(; i + 2 <= words; i += 2)                                                       \
+        {                                                                                   \
+            auto a = _mm_loadu_si128((const __m128i *) (const void *) &to[i]);              \
+            auto b = _mm_loadu_si128((const __m128i *) (const void *) &from[i]);            \
+            _mm_storeu_si128((__m128i *) (void *) &to[i], OP128);                           \
+        }                                                                                   \
+        for(; i < words; i++)                                                               \
+        {                                                                                   \
+            auto a = to[i];                                                                 \
+            auto b = from[i];                                                               \
+            to[i] = OP64;                                                                   \
+        }                                                                                   \
+    }
+    #else
+    #define _ELEKICORE_BITSET_OPERATION(NAME, OP256, OP128, OP64)                           \
+    inline void NAME(u64 *to, const u64 *from, size_t words)                                \
+    {                                                                                       \
+        for(size_t i = 0; i < words; i++)                                                   \
+        {                                                                                   \
+            auto a = to[i];                                                                 \
+            auto b = from[i];                                                               \
+            to[i] = OP64;                                                                   \
+        }                                                                                   \
+    }
+    #endif
+    _ELEKICORE_BITSET_OPERATION(_bitsAnd, _mm256_and_si256(a, b), _mm_and_si128(a, b), a & b);
+    _ELEKICORE_BITSET_OPERATION(_bitsOr, _mm256_or_si256(a, b), _mm_or_si128(a, b), a | b);
+    _ELEKICORE_BITSET_OPERATION(_bitsXor, _mm256_xor_si256(a, b), _mm_xor_si128(a, b), a ^ b);
+    _ELEKICORE_BITSET_OPERATION(_bitsAndNot, _mm256_andnot_si256(b, a), _mm_andnot_si128(b, a), a & ~b);
+
+    // ビット列の立っているビット数を返す
+    inline size_t _bitsCount(const u64 *words, size_t count)
+    {
+        size_t i = 0;
+        size_t result = 0;
+    #if ELEKI_SIMD_AVX2
+        // 4ビット毎の表引きでバイト単位のビット数を求め、8バイト毎に合計する
+        if(count >= 8)
+        {
+            auto table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            auto low = _mm256_set1_epi8(0x0F);
+            auto acc = _mm256_setzero_si256();
+            for(; i + 4 <= count; i += 4)
+            {
+                auto v = _mm256_loadu_si256((const __m256i *) (const void *) &words[i]);
+                auto lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+                auto hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+            }
+            alignas(32) u64 lanes[4];
+            _mm256_store_si256((__m256i *) (void *) lanes, acc);
+            result = (size_t) (lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+        }
+    #endif
+        for(; i < count; i++) result += popCount(words[i]);
+        return result;
+    }
+
+    // ビット列aがビット列bのビットをすべて含むか判定する
+    inline bool _bitsContains(const u64 *a, const u64 *b, size_t words)
+    {
+        size_t i = 0;
+    #if ELEKI_SIMD_AVX2
+        for(; i + 4 <= words; i += 4)
+        {
+            auto va = _mm256_loadu_si256((const __m256i *) (const void *) &a[i]);
+            auto vb = _mm256_loadu_si256((const __m256i *) (const void *) &b[i]);
+            if(!_mm256_testc_si256(va, vb)) return false;
+        }
+    #elif ELEKI_SIMD_SSE2
+        auto zero = _mm_setzero_si128();
+        for(; i + 2 <= words; i += 2)
+        {
+            auto va = _mm_loadu_si128((const __m128i *) (const void *) &a[i]);
+            auto vb = _mm_loadu_si128((const __m128i *) (const void *) &b[i]);
+            if(_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_andnot_si128(va, vb), zero)) != 0xFFFF) return false;
+        }
+    #endif
+        for(; i < words; i++)
+        {
+            if(b[i] & ~a[i]) return false;
+        }
+        return true;
+    }
+
+    // ビット列aとビット列bに共通するビットがあるか判定する
+    inline bool _bitsIntersects(const u64 *a, const u64 *b, size_t words)
+    {
+        size_t i = 0;
+    #if ELEKI_SIMD_AVX2
+        for(; i + 4 <= words; i += 4)
+        {
+            auto va = _mm256_loadu_si256((const __m256i *) (const void *) &a[i]);
+            auto vb = _mm256_loadu_si256((const __m256i *) (const void *) &b[i]);
+            if(!_mm256_testz_si256(va, vb)) return true;
+        }
+    #elif ELEKI_SIMD_SSE2
+        auto zero = _mm_setzero_si128();
+        for(; i + 2 <= words; i += 2)
+        {
+            auto va = _mm_loadu_si128((const __m128i *) (const void *) &a[i]);
+            auto vb = _mm_loadu_si128((const __m128i *) (const void *) &b[i]);
+            if(_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(va, vb), zero)) != 0xFFFF) return true;
+        }
+    #endif
+        for(; i < words; i++)
+        {
+            if(a[i] & b[i]) return true;
+        }
+        return false;
+    }
+
+    // ビット列がすべて0か判定する
+    inline bool _bitsNone(const u64 *words, size_t count)
+    {
+        u64 any = 0;
+        for(size_t i = 0; i < count; i++) any |= words[i];
+        return !any;
+    }
+
+    // ビット列が等しいか判定する
+    inline bool _bitsEqual(const u64 *a, const u64 *b, size_t words)
+    {
+        u64 diff = 0;
+        for(size_t i = 0; i < words; i++) diff |= a[i] ^ b[i];
+        return !diff;
+    }
+
+    /// 立っているビットの位置を走査するイテレータです
+    /// ワード毎に最下位の立っているビットを取り出して進みます
+    class BitItr
+    {
+        const u64 *mWords;  // ワード配列
+        size_t mWordCount;  // ワード数
+        size_t mWordIndex;  // 走査中のワード位置
+        u64 mWord;          // 走査中のワードの未走査ビット
+
+        // 立っているビットがあるワードまで進む
+        void skip()
+        {
+            while(!mWord && mWordIndex < mWordCount)
+            {
+                mWordIndex++;
+                mWord = mWordIndex < mWordCount ? mWords[mWordIndex] : 0;
+            }
+        }
+
+    public:
+
+        /// コンストラクタ
+        /// @param words ワード配列
+        /// @param wordCount ワード数
+        /// @param wordIndex 走査を始めるワード位置
+        BitItr(const u64 *words, size_t wordCount, size_t wordIndex)
+            : mWords(words)
+            , mWordCount(wordCount)
+            , mWordIndex(wordIndex)
+            , mWord(wordIndex < wordCount ? words[wordIndex] : 0)
+        {
+            skip();
+        }
+
+        /// 次に移動します
+        BitItr &operator++()
+        {
+            mWord &= mWord - 1;
+            skip();
+            return *this;
+        }
+
+        /// ビット位置を返します
+        size_t operator*() const
+        {
+            return mWordIndex * BITS_PER_WORD + countTrailingZeros(mWord);
+        }
+
+        /// 位置が等しいか判定します
+        bool operator==(const BitItr &r) const
+        {
+            return mWordIndex == r.mWordIndex && mWord == r.mWord;
+        }
+
+        /// 位置が等しくないか判定します
+        bool operator!=(const BitItr &r) const
+        {
+            return !(*this == r);
+        }
+    };
+
+    /// 固定長ビット集合を提供します
+    /// @tparam N ビット数
+    template<size_t N>
+    class Bitset
+    {
+        static constexpr size_t WORD_COUNT = (N + BITS_PER_WORD - 1) / BITS_PER_WORD;                         // ワード数
+        static constexpr u64 LAST_MASK = (N % BITS_PER_WORD) ? ((1ull << (N % BITS_PER_WORD)) - 1) : U64_MAX; // 末尾ワードの有効ビット
+
+        u64 mWords[WORD_COUNT ? WORD_COUNT : 1]; // ワード配列
+
+    public:
+
+        /// コンストラクタ
+        Bitset()
+            : mWords()
+        {}
+
+        /// 論理積を代入します
+        Bitset<N> &operator&=(const Bitset<N> &r)
+        {
+            _bitsAnd(mWords, r.mWords, WORD_COUNT);
+            return *this;
+        }
+
+        /// 論理和を代入します
+        Bitset<N> &operator|=(const Bitset<N> &r)
+        {
+            _bitsOr(mWords, r.mWords, WORD_COUNT);
+            return *this;
+        }
+
+        /// 排他的論理和を代入します
+        Bitset<N> &operator^=(const Bitset<N> &r)
+        {
+            _bitsXor(mWords, r.mWords, WORD_COUNT);
+            return *this;
+        }
+
+        /// 差を代入します
+        Bitset<N> &operator-=(const Bitset<N> &r)
+        {
+            _bitsAndNot(mWords, r.mWords, WORD_COUNT);
+            return *this;
+        }
+
+        /// 反転させた集合を返します
+        Bitset<N> operator~() const
+        {
+            Bitset<N> ret;
+            for(size_t i = 0; i < WORD_COUNT; i++) ret.mWords[i] = ~mWords[i];
+            if(WORD_COUNT) ret.mWords[WORD_COUNT - 1] &= LAST_MASK;
+            return ret;
+        }
+
+        /// 等しいか判定します
+        bool operator==(const Bitset<N> &r) const
+        {
+            return _bitsEqual(mWords, r.mWords, WORD_COUNT);
+        }
+
+        /// 等しくないか判定します
+        bool operator!=(const Bitset<N> &r) const
+        {
+            return !(*this == r);
+        }
+
+        /// ビットが立っているか判定します
+        bool operator[](size_t index) const
+        {
+            return test(index);
+        }
+
+        /// ビットを設定します
+        /// @param index ビット位置
+        /// @param value 設定する値
+        Bitset<N> &set(size_t index, bool value = true)
+        {
+            if(index >= N)
+            {
+                printError("out of range. Bitset<N> &Bitset<N>::set(size_t index, bool value)");
+                return *this;
+            }
+            auto mask = 1ull << (index % BITS_PER_WORD);
+            auto &word = mWords[index / BITS_PER_WORD];
+            word = value ? (word | mask) : (word & ~mask);
+            return *this;
+        }
+
+        /// ビットを下ろします
+        Bitset<N> &reset(size_t index)
+        {
+            return set(index, false);
+        }
+
+        /// ビットを反転させます
+        Bitset<N> &flip(size_t index)
+        {
+            if(index >= N)
+            {
+                printError("out of range. Bitset<N> &Bitset<N>::flip(size_t index)");
+                return *this;
+            }
+            mWords[index / BITS_PER_WORD] ^= 1ull << (index % BITS_PER_WORD);
+            return *this;
+        }
+
+        /// ビットが立っているか判定します
+        bool test(size_t index) const
+        {
+            if(index >= N) return false;
+            return (mWords[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
+        }
+
+        /// すべてのビットを立てます
+        Bitset<N> &setAll()
+        {
+            for(size_t i = 0; i < WORD_COUNT; i++) mWords[i] = U64_MAX;
+            if(WORD_COUNT) mWords[WORD_COUNT - 1] &= LAST_MASK;
+            return *this;
+        }
+
+        /// すべてのビットを下ろします
+        Bitset<N> &resetAll()
+        {
+            for(size_t i = 0; i < WORD_COUNT; i++) mWords[i] = 0;
+            return *this;
+        }
+
+        /// 立っているビットの数を返します
+        size_t count() const
+        {
+            return _bitsCount(mWords, WORD_COUNT);
+        }
+
+        /// ビット数を返します
+        constexpr size_t size() const
+        {
+            return N;
+        }
+
+        /// 立っているビットがあるか判定します
+        bool any() const
+        {
+            return !_bitsNone(mWords, WORD_COUNT);
+        }
+
+        /// 立っているビットが無いか判定します
+        bool none() const
+        {
+            return _bitsNone(mWords, WORD_COUNT);
+        }
+
+        /// すべてのビットが立っているか判定します
+        bool all() const
+        {
+            return count() == N;
+        }
+
+        /// 指定集合のビットをすべて含むか判定します
+        /// クエリとアーキタイプのシグネチャの照合に使用します
+        bool containsAll(const Bitset<N> &r) const
+        {
+            return _bitsContains(mWords, r.mWords, WORD_COUNT);
+        }
+
+        /// 指定集合と共通するビットがあるか判定します
+        bool intersects(const Bitset<N> &r) const
+        {
+            return _bitsIntersects(mWords, r.mWords, WORD_COUNT);
+        }
+
+        /// 立っているビットの位置を順に関数に渡します
+        /// @param func void(size_t index)の関数オブジェクト
+        template<class F>
+        void forEach(const F &func) const
+        {
+            for(size_t i = 0; i < WORD_COUNT; i++)
+            {
+                for(auto word = mWords[i]; word; word &= word - 1)
+                {
+                    func(i * BITS_PER_WORD + countTrailingZeros(word));
+                }
+            }
+        }
+
+        /// ワード配列を返します
+        const u64 *words() const
+        {
+            return mWords;
+        }
+
+        /// ワード数を返します
+        constexpr size_t wordCount() const
+        {
+            return WORD_COUNT;
+        }
+
+        /// 立っているビットの先頭イテレータを返します
+        BitItr begin() const
+        {
+            return BitItr(mWords, WORD_COUNT, 0);
+        }
+
+        /// 番兵イテレータを返します
+        BitItr end() const
+        {
+            return BitItr(mWords, WORD_COUNT, WORD_COUNT);
+        }
+    };
+
+    /// 論理積です
+    template<size_t N>
+    Bitset<N> operator&(const Bitset<N> &l, const Bitset<N> &r)
+    {
+        return Bitset<N>(l) &= r;
+    }
+
+    /// 論理和です
+    template<size_t N>
+    Bitset<N> operator|(const Bitset<N> &l, const Bitset<N> &r)
+    {
+        return Bitset<N>(l) |= r;
+    }
+
+    /// 排他的論理和です
+    template<size_t N>
+    Bitset<N> operator^(const Bitset<N> &l, const Bitset<N> &r)
+    {
+        return Bitset<N>(l) ^= r;
+    }
+
+    /// 差です
+    template<size_t N>
+    Bitset<N> operator-(const Bitset<N> &l, const Bitset<N> &r)
+    {
+        return Bitset<N>(l) -= r;
+    }
+
+    /// 可変長ビット集合を提供します
+    /// 範囲外のビットは下りているものとして扱い、立てる際に自動で伸長します
+    class DynamicBitset
+    {
+        IAllocator *mAllocator; // アロケータ
+        size_t mWordCount;      // ワード数
+        size_t mSize;           // ビット数
+        u64 *mWords;            // ワード配列
+
+        // ワード数を変更する
+        void reallocate(size_t wordCount)
+        {
+            auto newWords = wordCount ? (u64 *) mAllocator->allocate(sizeof(u64) * wordCount) : nullptr;
+            auto len = mWordCount < wordCount ? mWordCount : wordCount;
+            for(size_t i = 0; i < len; i++) newWords[i] = mWords[i];
+            for(size_t i = len; i < wordCount; i++) newWords[i] = 0;
+            if(mWords) mAllocator->deallocate(mWords);
+            mWordCount = wordCount;
+            mWords = newWords;
+        }
+
+        // 末尾ワードの範囲外ビットを下ろす
+        void maskLast()
+        {
+            auto words = (mSize + BITS_PER_WORD - 1) / BITS_PER_WORD;
+            for(size_t i = words; i < mWordCount; i++) mWords[i] = 0;
+            if(words && (mSize % BITS_PER_WORD)) mWords[words - 1] &= (1ull << (mSize % BITS_PER_WORD)) - 1;
+        }
+
+        // 使用中のワード数を返す
+        size_t usedWordCount() const
+        {
+            return (mSize + BITS_PER_WORD - 1) / BITS_PER_WORD;
+        }
+
+    public:
+
+        /// コンストラクタ
+        /// @param size 初期ビット数
+        /// @param allocator アロケータ
+        DynamicBitset(size_t size = 0, IAllocator *allocator = Memory::allocator())
+            : mAllocator(allocator)
+            , mWordCount(0)
+            , mSize(0)
+            , mWords(nullptr)
+        {
+            resize(size);
+        }
+
+        /// コピーコンストラクタ
+        DynamicBitset(const DynamicBitset &bitset)
+            : DynamicBitset(bitset.mSize, bitset.mAllocator)
+        {
+            for(size_t i = 0; i < usedWordCount(); i++) mWords[i] = bitset.mWords[i];
+        }
+
+        /// ムーブコンストラクタ
+        DynamicBitset(DynamicBitset &&bitset) noexcept
+            : mAllocator(bitset.mAllocator)
+            , mWordCount(bitset.mWordCount)
+            , mSize(bitset.mSize)
+            , mWords(bitset.mWords)
+        {
+            bitset.mWordCount = 0;
+            bitset.mSize = 0;
+            bitset.mWords = nullptr;
+        }
+
+        /// デストラクタ
+        ~DynamicBitset()
+        {
+            if(mWords) mAllocator->deallocate(mWords);
+        }
+
+        /// コピー代入します
+        DynamicBitset &operator=(const DynamicBitset &bitset)
+        {
+            if(this == &bitset) return *this;
+            resetAll();
+            resize(bitset.mSize);
+            for(size_t i = 0; i < usedWordCount(); i++) mWords[i] = bitset.mWords[i];
+            return *this;
+        }
+
+        /// ムーブ代入します
+        DynamicBitset &operator=(DynamicBitset &&bitset) noexcept
+        {
+            if(this == &bitset) return *this;
+            if(mWords) mAllocator->deallocate(mWords);
+            mAllocator = bitset.mAllocator;
+            mWordCount = bitset.mWordCount;
+            mSize = bitset.mSize;
+            mWords = bitset.mWords;
+            bitset.mWordCount = 0;
+            bitset.mSize = 0;
+            bitset.mWords = nullptr;
+            return *this;
+        }
+
+        /// 論理積を代入します
+        DynamicBitset &operator&=(const DynamicBitset &r)
+        {
+            auto words = usedWordCount();
+            auto rWords = r.usedWordCount();
+            auto len = words < rWords ? words : rWords;
+            _bitsAnd(mWords, r.mWords, len);
+            for(size_t i = len; i < words; i++) mWords[i] = 0;
+            return *this;
+        }
+
+        /// 論理和を代入します
+        DynamicBitset &operator|=(const DynamicBitset &r)
+        {
+            if(mSize < r.mSize) resize(r.mSize);
+            _bitsOr(mWords, r.mWords, r.usedWordCount());
+            return *this;
+        }
+
+        /// 排他的論理和を代入します
+        DynamicBitset &operator^=(const DynamicBitset &r)
+        {
+            if(mSize < r.mSize) resize(r.mSize);
+            _bitsXor(mWords, r.mWords, r.usedWordCount());
+            return *this;
+        }
+
+        /// 差を代入します
+        DynamicBitset &operator-=(const DynamicBitset &r)
+        {
+            auto words = usedWordCount();
+            auto rWords = r.usedWordCount();
+            _bitsAndNot(mWords, r.mWords, words < rWords ? words : rWords);
+            return *this;
+        }
+
+        /// 等しいか判定します
+        /// ビット数が異なっていても、立っているビットが同じであれば等しいとします
+        bool operator==(const DynamicBitset &r) const
+        {
+            auto words = usedWordCount();
+            auto rWords = r.usedWordCount();
+            auto len = words < rWords ? words : rWords;
+            if(!_bitsEqual(mWords, r.mWords, len)) return false;
+            return words < rWords ? _bitsNone(&r.mWords[len], rWords - len) : _bitsNone(&mWords[len], words - len);
+        }
+
+        /// 等しくないか判定します
+        bool operator!=(const DynamicBitset &r) const
+        {
+            return !(*this == r);
+        }
+
+        /// ビットが立っているか判定します
+        bool operator[](size_t index) const
+        {
+            return test(index);
+        }
+
+        /// ビットを設定します
+        /// 範囲外のビットを立てる場合、伸長します
+        /// @param index ビット位置
+        /// @param value 設定する値
+        DynamicBitset &set(size_t index, bool value = true)
+        {
+            if(index >= mSize)
+            {
+                if(!value) return *this;
+                resize(index + 1);
+            }
+            auto mask = 1ull << (index % BITS_PER_WORD);
+            auto &word = mWords[index / BITS_PER_WORD];
+            word = value ? (word | mask) : (word & ~mask);
+            return *this;
+        }
+
+        /// ビットを下ろします
+        DynamicBitset &reset(size_t index)
+        {
+            return set(index, false);
+        }
+
+        /// ビットを反転させます
+        DynamicBitset &flip(size_t index)
+        {
+            return set(index, !test(index));
+        }
+
+        /// ビットが立っているか判定します
+        bool test(size_t index) const
+        {
+            if(index >= mSize) return false;
+            return (mWords[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
+        }
+
+        /// すべてのビットを立てます
+        DynamicBitset &setAll()
+        {
+            for(size_t i = 0; i < usedWordCount(); i++) mWords[i] = U64_MAX;
+            maskLast();
+            return *this;
+        }
+
+        /// すべてのビットを下ろします
+        DynamicBitset &resetAll()
+        {
+            for(size_t i = 0; i < mWordCount; i++) mWords[i] = 0;
+            return *this;
+        }
+
+        /// ビット数を変更します
+        /// 伸長したビットは下りています
+        DynamicBitset &resize(size_t size)
+        {
+            auto words = (size + BITS_PER_WORD - 1) / BITS_PER_WORD;
+            if(words > mWordCount)
+            {
+                // ワード数は倍に増やす
+                auto newWordCount = mWordCount * 2;
+                reallocate(newWordCount > words ? newWordCount : words);
+            }
+            mSize = size;
+            maskLast();
+            return *this;
+        }
+
+        /// 立っているビットの数を返します
+        size_t count() const
+        {
+            return _bitsCount(mWords, usedWordCount());
+        }
+
+        /// ビット数を返します
+        size_t size() const
+        {
+            return mSize;
+        }
+
+        /// 立っているビットがあるか判定します
+        bool any() const
+        {
+            return !_bitsNone(mWords, usedWordCount());
+        }
+
+        /// 立っているビットが無いか判定します
+        bool none() const
+        {
+            return _bitsNone(mWords, usedWordCount());
+        }
+
+        /// すべてのビットが立っているか判定します
+        bool all() const
+        {
+            return count() == mSize;
+        }
+
+        /// 指定集合のビットをすべて含むか判定します
+        /// クエリとアーキタイプのシグネチャの照合に使用します
+        bool containsAll(const DynamicBitset &r) const
+        {
+            auto words = usedWordCount();
+            auto rWords = r.usedWordCount();
+            if(rWords > words) return _bitsContains(mWords, r.mWords, words) && _bitsNone(&r.mWords[words], rWords - words);
+            return _bitsContains(mWords, r.mWords, rWords);
+        }
+
+        /// 指定集合と共通するビットがあるか判定します
+        bool intersects(const DynamicBitset &r) const
+        {
+            auto words = usedWordCount();
+            auto rWords = r.usedWordCount();
+            return _bitsIntersects(mWords, r.mWords, words < rWords ? words : rWords);
+        }
+
+        /// 立っているビットの位置を順に関数に渡します
+        /// @param func void(size_t index)の関数オブジェクト
+        template<class F>
+        void forEach(const F &func) const
+        {
+            for(size_t i = 0; i < usedWordCount(); i++)
+            {
+                for(auto word = mWords[i]; word; word &= word - 1)
+                {
+                    func(i * BITS_PER_WORD + countTrailingZeros(word));
+                }
+            }
+        }
+
+        /// ワード配列を返します
+        const u64 *words() const
+        {
+            return mWords;
+        }
+
+        /// 使用中のワード数を返します
+        size_t wordCount() const
+        {
+            return usedWordCount();
+        }
+
+        /// 立っているビットの先頭イテレータを返します
+        BitItr begin() const
+        {
+            return BitItr(mWords, usedWordCount(), 0);
+        }
+
+        /// 番兵イテレータを返します
+        BitItr end() const
+        {
+            return BitItr(mWords, usedWordCount(), usedWordCount());
+        }
+
+        /// アロケータを取得します
+        IAllocator *allocator() const
+        {
+            return mAllocator;
+        }
+    };
+
+    /// 論理積です
+    inline DynamicBitset operator&(const DynamicBitset &l, const DynamicBitset &r)
+    {
+        return DynamicBitset(l) &= r;
+    }
+
+    /// 論理和です
+    inline DynamicBitset operator|(const DynamicBitset &l, const DynamicBitset &r)
+    {
+        return DynamicBitset(l) |= r;
+    }
+
+    /// 排他的論理和です
+    inline DynamicBitset operator^(const DynamicBitset &l, const DynamicBitset &r)
+    {
+        return DynamicBitset(l) ^= r;
+    }
+
+    /// 差です
+    inline DynamicBitset operator-(const DynamicBitset &l, const DynamicBitset &r)
+    {
+        return DynamicBitset(l) -= r;
+    }
+
+}
+
+#endif // !ELEKICORE_BITSET_HPP
\ No newline at end of file
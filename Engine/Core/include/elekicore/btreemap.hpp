@@ -0,0 +1,254 @@
+/// @file btreemap.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// B+木による順序付き連想配列を提供します
+/// 範囲検索や、キー順の走査が必要な場合に使用します
+
+#ifndef ELEKICORE_BTREEMAP_HPP
+#define ELEKICORE_BTREEMAP_HPP
+
+#include "btreeset.hpp"
+#include "flatmap.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// B+木による順序付き連想配列を提供します
+    /// キーと値のペアを葉にキー順で格納し、内部節点はキーの写しのみを持ちます
+    /// 葉同士を連結しているため、範囲の走査は木をたどらずに行えます
+    /// 節点はメモリプールから確保します
+    /// @tparam L キーの順序を判定する関数オブジェクト型
+    /// @tparam N 1節点の要素数
+    template<class K, class V, class L = Less<K>, size_t N = BTREE_NODE_ELEMENTS_COUNT>
+    class BTreeMap
+    {
+        using Tree = _BTree<KeyValuePair<K, V>, K, _FlatKeyOf<K, V>, L, N>;
+
+        Tree mTree; // 木
+
+    public:
+
+        /// 前方向イテレータです
+        /// キーの順に走査します
+        using Itr = typename Tree::template Itr<const KeyValuePair<K, V>>;
+
+        /// コンストラクタ
+        /// @param allocator アロケータ
+        BTreeMap(IAllocator *allocator = Memory::allocator())
+            : mTree(allocator)
+        {}
+
+        /// コンストラクタ
+        /// @param list 初期化リスト
+        /// @param allocator アロケータ
+        BTreeMap(std::initializer_list<KeyValuePair<K, V>> list, IAllocator *allocator = Memory::allocator())
+            : mTree(allocator)
+        {
+            add(list);
+        }
+
+        /// 追加します
+        /// 同じキーが既にある場合は追加しません
+        BTreeMap<K, V, L, N> &operator+=(const KeyValuePair<K, V> &r)
+        {
+            bool inserted;
+            mTree.insert(r, inserted);
+            return *this;
+        }
+
+        /// 追加します
+        /// 同じキーが既にある場合は追加しません
+        BTreeMap<K, V, L, N> &operator+=(KeyValuePair<K, V> &&r)
+        {
+            bool inserted;
+            mTree.insert(std::move(r), inserted);
+            return *this;
+        }
+
+        /// 削除します
+        BTreeMap<K, V, L, N> &operator-=(const K &r)
+        {
+            mTree.remove(r);
+            return *this;
+        }
+
+        /// キーからアクセスします
+        V &operator[](const K &key)
+        {
+            return at(key);
+        }
+
+        /// キーからアクセスします
+        const V &operator[](const K &key) const
+        {
+            return at(key);
+        }
+
+        /// 含まれるか判定します
+        bool operator()(const K &key) const
+        {
+            return mTree.find(key) != nullptr;
+        }
+
+        /// 追加します
+        /// 同じキーが既にある場合は追加しません
+        BTreeMap<K, V, L, N> &add(const K &key, const V &value)
+        {
+            return operator+=(KeyValuePair<K, V>(key, value));
+        }
+
+        /// 一括で追加します
+        /// 空の連想配列にキーの狭義の昇順で追加する場合は、節点を下から組み立てるため線形時間で完了します
+        /// @param elements 追加する生配列
+        /// @param count 追加する要素数
+        BTreeMap<K, V, L, N> &add(const KeyValuePair<K, V> *elements, size_t count)
+        {
+            mTree.insert(elements, count);
+            return *this;
+        }
+
+        /// 一括で追加します
+        /// @param list 初期化リスト
+        BTreeMap<K, V, L, N> &add(std::initializer_list<KeyValuePair<K, V>> list)
+        {
+            mTree.insert(list.begin(), list.size());
+            return *this;
+        }
+
+        /// 追加するか、同じキーがある場合は値を上書きします
+        /// @return 追加、または、上書きした値
+        V &set(const K &key, const V &value)
+        {
+            bool inserted;
+            auto element = mTree.insert(KeyValuePair<K, V>(key, value), inserted);
+            if(!element)
+            {
+                printError("failed to allocate. V &BTreeMap<K, V, L, N>::set(const K &key, const V &value)");
+            }
+            else if(!inserted)
+            {
+                element->value = value;
+            }
+            return element->value;
+        }
+
+        /// 削除します
+        /// @retval false キーが見つかりませんでした
+        bool remove(const K &key)
+        {
+            return mTree.remove(key);
+        }
+
+        /// キーからアクセスします
+        V &at(const K &key)
+        {
+            auto element = mTree.find(key);
+            if(!element) printError("key not found. V &BTreeMap<K, V, L, N>::at(const K &key)");
+            return element->value;
+        }
+
+        /// キーからアクセスします
+        const V &at(const K &key) const
+        {
+            auto element = mTree.find(key);
+            if(!element) printError("key not found. const V &BTreeMap<K, V, L, N>::at(const K &key) const");
+            return element->value;
+        }
+
+        /// キーから値を検索します
+        /// @retval nullptr キーが見つかりませんでした
+        V *find(const K &key)
+        {
+            auto element = mTree.find(key);
+            return element ? &element->value : nullptr;
+        }
+
+        /// キーから値を検索します
+        /// @retval nullptr キーが見つかりませんでした
+        const V *find(const K &key) const
+        {
+            auto element = mTree.find(key);
+            return element ? &element->value : nullptr;
+        }
+
+        /// 含まれるか判定します
+        bool contains(const K &key) const
+        {
+            return mTree.find(key) != nullptr;
+        }
+
+        /// キー以上となる最初の位置を返します
+        Itr lowerBound(const K &key) const
+        {
+            return mTree.lowerBound(key);
+        }
+
+        /// キーより大きい最初の位置を返します
+        Itr upperBound(const K &key) const
+        {
+            return mTree.upperBound(key);
+        }
+
+        /// キーが半開区間[first, last)にある要素の範囲を返します
+        BTreeRange<Itr> range(const K &first, const K &last) const
+        {
+            if(!L{}(first, last)) return BTreeRange<Itr>(end(), end());
+            return BTreeRange<Itr>(lowerBound(first), lowerBound(last));
+        }
+
+        /// キーが最小の要素を取得します
+        const KeyValuePair<K, V> &first() const
+        {
+            if(!mTree.count()) printError("map is empty. const KeyValuePair<K, V> &BTreeMap<K, V, L, N>::first() const");
+            return *mTree.first();
+        }
+
+        /// キーが最大の要素を取得します
+        const KeyValuePair<K, V> &last() const
+        {
+            if(!mTree.count()) printError("map is empty. const KeyValuePair<K, V> &BTreeMap<K, V, L, N>::last() const");
+            return *mTree.last();
+        }
+
+        /// 要素数を返します
+        size_t count() const
+        {
+            return mTree.count();
+        }
+
+        /// 木の高さを返します
+        size_t height() const
+        {
+            return mTree.height();
+        }
+
+        /// クリアします
+        void clear()
+        {
+            mTree.clear();
+        }
+
+        /// 先頭イテレータを返します
+        /// キーの順に走査します
+        Itr begin() const
+        {
+            return mTree.begin();
+        }
+
+        /// 番兵イテレータを返します
+        Itr end() const
+        {
+            return mTree.end();
+        }
+
+        /// アロケータを取得します
+        IAllocator *allocator() const
+        {
+            return mTree.allocator();
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_BTREEMAP_HPP
\ No newline at end of file
@@ -0,0 +1,1025 @@
+/// @file btreeset.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// B+木による順序付き集合を提供します
+/// 範囲検索や、キー順の走査が必要な場合に使用します
+
+#ifndef ELEKICORE_BTREESET_HPP
+#define ELEKICORE_BTREESET_HPP
+
+#include <new>
+#include <utility>
+#include <initializer_list>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "allocation.hpp"
+#include "array.hpp"
+#include "flatset.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// B+木の既定の1節点の要素数です
+    constexpr size_t BTREE_NODE_ELEMENTS_COUNT = 32;
+
+    /// B+木のメモリプールが1度に確保する節点数です
+    constexpr size_t BTREE_POOL_NODES_COUNT = 16;
+
+    /// B+木の範囲です
+    /// 範囲for文で走査できます
+    template<class I>
+    class BTreeRange
+    {
+        I mBegin; // 先頭イテレータ
+        I mEnd;   // 番兵イテレータ
+
+    public:
+
+        /// コンストラクタ
+        BTreeRange(const I &begin, const I &end)
+            : mBegin(begin)
+            , mEnd(end)
+        {}
+
+        /// 先頭イテレータを返します
+        I begin() const
+        {
+            return mBegin;
+        }
+
+        /// 番兵イテレータを返します
+        I end() const
+        {
+            return mEnd;
+        }
+
+        /// 空か判定します
+        bool empty() const
+        {
+            return mBegin == mEnd;
+        }
+    };
+
+    // B+木の共通実装
+    // 要素は葉にのみ格納し、葉同士を連結して順に走査する
+    // 内部節点はキーの写しを区切りとして持つ
+    // E 要素型、K キー型、P 要素からキーを取り出す関数オブジェクト型、L キーの順序を判定する関数オブジェクト型、N 1節点の要素数
+    template<class E, class K, class P, class L, size_t N>
+    class _BTree
+    {
+        static_assert(N >= 4, "node size must be 4 or more. _BTree<E, K, P, L, N>");
+        static_assert(alignof(E) <= alignof(size_t) && alignof(K) <= alignof(size_t), "not supported alignment. _BTree<E, K, P, L, N>");
+
+        static constexpr size_t MIN_COUNT = N / 2; // 根以外の節点の最小要素数
+        static constexpr size_t MAX_DEPTH = 48;    // 内部節点の深さの上限
+
+        // 節点
+        struct Node
+        {
+            size_t count; // 要素数、または、区切りのキー数
+            bool leaf;    // 葉か
+        };
+
+        // 葉 分割前に1つ多く入れられるようにする
+        struct Leaf: Node
+        {
+            Leaf *prev;                                 // 前の葉
+            Leaf *next;                                 // 次の葉
+            alignas(E) u8 storage[sizeof(E) * (N + 1)]; // 要素の格納領域
+
+            E *elements()
+            {
+                return (E *) (void *) storage;
+            }
+        };
+
+        // 内部節点 分割前に1つ多く入れられるようにする
+        struct Inner: Node
+        {
+            alignas(K) u8 storage[sizeof(K) * (N + 1)]; // 区切りのキーの格納領域
+            Node *children[N + 2];                      // 子
+
+            K *keys()
+            {
+                return (K *) (void *) storage;
+            }
+        };
+
+        IAllocator *mAllocator;        // メモリプールを確保するアロケータ
+        DynamicMemoryPool *mLeafPool;  // 葉を確保するメモリプール
+        DynamicMemoryPool *mInnerPool; // 内部節点を確保するメモリプール
+        Node *mRoot;                   // 根
+        Leaf *mFirst;                  // 先頭の葉
+        Leaf *mLast;                   // 末尾の葉
+        size_t mCount;                 // 要素数
+        size_t mHeight;                // 高さ 空の場合0
+
+        // キーが等しいか判定する
+        static bool equal(const K &l, const K &r)
+        {
+            return !L{}(l, r) && !L{}(r, l);
+        }
+
+        // 内部節点でキーを含む子の位置を返す
+        static size_t childIndex(Inner *inner, const K &key)
+        {
+            auto index = flatLowerBound<L>(inner->keys(), inner->count, key, _FlatIdentity<K>{});
+            if(index < inner->count && !L{}(key, inner->keys()[index])) index++;
+            return index;
+        }
+
+        // 葉でキー以上となる最初の位置を返す
+        static size_t leafIndex(Leaf *leaf, const K &key)
+        {
+            return flatLowerBound<L>(leaf->elements(), leaf->count, key, P{});
+        }
+
+        // キーを含む葉を返す
+        Leaf *leafOf(const K &key) const
+        {
+            auto node = mRoot;
+            while(!node->leaf) node = ((Inner *) node)->children[childIndex((Inner *) node, key)];
+            return (Leaf *) node;
+        }
+
+        // メモリプールを作成する
+        DynamicMemoryPool *createPool(size_t size)
+        {
+            auto memory = mAllocator->allocate(sizeof(DynamicMemoryPool));
+            return memory ? new(memory) DynamicMemoryPool(size, BTREE_POOL_NODES_COUNT) : nullptr;
+        }
+
+        // 葉を確保する
+        Leaf *newLeaf()
+        {
+            if(!mLeafPool) mLeafPool = createPool(sizeof(Leaf));
+            auto memory = mLeafPool ? mLeafPool->allocate() : nullptr;
+            if(!memory) return nullptr;
+            auto leaf = new(memory) Leaf();
+            leaf->count = 0;
+            leaf->leaf = true;
+            leaf->prev = nullptr;
+            leaf->next = nullptr;
+            return leaf;
+        }
+
+        // 内部節点を確保する
+        Inner *newInner()
+        {
+            if(!mInnerPool) mInnerPool = createPool(sizeof(Inner));
+            auto memory = mInnerPool ? mInnerPool->allocate() : nullptr;
+            if(!memory) return nullptr;
+            auto inner = new(memory) Inner();
+            inner->count = 0;
+            inner->leaf = false;
+            return inner;
+        }
+
+        // 節点と子孫を破棄する
+        static void destroyNode(Node *node)
+        {
+            if(node->leaf)
+            {
+                auto leaf = (Leaf *) node;
+                for(size_t i = 0; i < leaf->count; i++) leaf->elements()[i].~E();
+            }
+            else
+            {
+                auto inner = (Inner *) node;
+                for(size_t i = 0; i <= inner->count; i++) destroyNode(inner->children[i]);
+                for(size_t i = 0; i < inner->count; i++) inner->keys()[i].~K();
+            }
+            DynamicMemoryPool::deallocate(node);
+        }
+
+        // 生配列の位置に空きを作り、値を構築する
+        template<class T, class U>
+        static void insertInto(T *array, size_t count, size_t index, U &&value)
+        {
+            if(index == count)
+            {
+                new(&array[count]) T(std::forward<U>(value));
+                return;
+            }
+            new(&array[count]) T(std::move(array[count - 1]));
+            for(size_t i = count - 1; i > index; i--) array[i] = std::move(array[i - 1]);
+            array[index] = std::forward<U>(value);
+        }
+
+        // 生配列の位置の値を詰めて削除する
+        template<class T>
+        static void removeFrom(T *array, size_t count, size_t index)
+        {
+            for(size_t i = index; i + 1 < count; i++) array[i] = std::move(array[i + 1]);
+            array[count - 1].~T();
+        }
+
+        // 生配列の範囲を別の生配列の末尾へ移動する
+        template<class T>
+        static void moveTo(T *from, size_t count, T *to)
+        {
+            for(size_t i = 0; i < count; i++)
+            {
+                new(&to[i]) T(std::move(from[i]));
+                from[i].~T();
+            }
+        }
+
+        // 内部節点から区切りのキーと、その右の子を削除する
+        static void removeSeparator(Inner *inner, size_t index)
+        {
+            removeFrom(inner->keys(), inner->count, index);
+            for(size_t i = index + 1; i < inner->count; i++) inner->children[i] = inner->children[i + 1];
+            inner->count--;
+        }
+
+        // 右の葉を左の葉へ併合する
+        void mergeLeaves(Leaf *left, Leaf *right)
+        {
+            moveTo(right->elements(), right->count, &left->elements()[left->count]);
+            left->count += right->count;
+            left->next = right->next;
+            if(right->next) right->next->prev = left;
+            else mLast = left;
+            DynamicMemoryPool::deallocate(right);
+        }
+
+        // 区切りのキーを挟んで右の内部節点を左の内部節点へ併合する
+        static void mergeInners(Inner *left, K &separator, Inner *right)
+        {
+            new(&left->keys()[left->count]) K(std::move(separator));
+            moveTo(right->keys(), right->count, &left->keys()[left->count + 1]);
+            for(size_t i = 0; i <= right->count; i++) left->children[left->count + 1 + i] = right->children[i];
+            left->count += right->count + 1;
+            DynamicMemoryPool::deallocate(right);
+        }
+
+        // 葉の要素数の不足を兄弟から借りるか、併合して解消する
+        // @return 親の区切りが減った場合真
+        bool rebalanceLeaf(Leaf *leaf, Inner *parent, size_t index)
+        {
+            auto left = index > 0 ? (Leaf *) parent->children[index - 1] : nullptr;
+            auto right = index < parent->count ? (Leaf *) parent->children[index + 1] : nullptr;
+            if(left && left->count > MIN_COUNT)
+            {
+                insertInto(leaf->elements(), leaf->count, 0, std::move(left->elements()[left->count - 1]));
+                left->elements()[--left->count].~E();
+                leaf->count++;
+                parent->keys()[index - 1] = P{}(leaf->elements()[0]);
+                return false;
+            }
+            if(right && right->count > MIN_COUNT)
+            {
+                new(&leaf->elements()[leaf->count++]) E(std::move(right->elements()[0]));
+                removeFrom(right->elements(), right->count--, 0);
+                parent->keys()[index] = P{}(right->elements()[0]);
+                return false;
+            }
+            if(left)
+            {
+                mergeLeaves(left, leaf);
+                removeSeparator(parent, index - 1);
+            }
+            else
+            {
+                mergeLeaves(leaf, right);
+                removeSeparator(parent, index);
+            }
+            return true;
+        }
+
+        // 内部節点のキー数の不足を兄弟から借りるか、併合して解消する
+        // @return 親の区切りが減った場合真
+        static bool rebalanceInner(Inner *inner, Inner *parent, size_t index)
+        {
+            auto left = index > 0 ? (Inner *) parent->children[index - 1] : nullptr;
+            auto right = index < parent->count ? (Inner *) parent->children[index + 1] : nullptr;
+            if(left && left->count > MIN_COUNT)
+            {
+                // 親の区切りを下ろし、左の末尾の区切りを親へ上げる
+                insertInto(inner->keys(), inner->count, 0, std::move(parent->keys()[index - 1]));
+                for(auto i = inner->count + 1; i > 0; i--) inner->children[i] = inner->children[i - 1];
+                inner->children[0] = left->children[left->count];
+                inner->count++;
+                parent->keys()[index - 1] = std::move(left->keys()[left->count - 1]);
+                left->keys()[--left->count].~K();
+                return false;
+            }
+            if(right && right->count > MIN_COUNT)
+            {
+                // 親の区切りを下ろし、右の先頭の区切りを親へ上げる
+                new(&inner->keys()[inner->count]) K(std::move(parent->keys()[index]));
+                inner->children[inner->count + 1] = right->children[0];
+                inner->count++;
+                parent->keys()[index] = std::move(right->keys()[0]);
+                removeFrom(right->keys(), right->count, 0);
+                for(size_t i = 0; i < right->count; i++) right->children[i] = right->children[i + 1];
+                right->count--;
+                return false;
+            }
+            if(left)
+            {
+                mergeInners(left, parent->keys()[index - 1], inner);
+                removeSeparator(parent, index - 1);
+            }
+            else
+            {
+                mergeInners(inner, parent->keys()[index], right);
+                removeSeparator(parent, index);
+            }
+            return true;
+        }
+
+    public:
+
+        // 前方向イテレータ
+        template<class R>
+        class Itr
+        {
+            friend class _BTree<E, K, P, L, N>;
+
+            Leaf *mLeaf;   // 葉
+            size_t mIndex; // 葉の中の位置
+
+        public:
+
+            /// コンストラクタ
+            /// 葉の末尾を指す場合は次の葉の先頭に進めます
+            Itr(Leaf *leaf, size_t index)
+                : mLeaf(leaf)
+                , mIndex(index)
+            {
+                if(mLeaf && mIndex == mLeaf->count)
+                {
+                    mLeaf = mLeaf->next;
+                    mIndex = 0;
+                }
+            }
+
+            /// 次に移動します
+            Itr<R> &operator++()
+            {
+                if(++mIndex == mLeaf->count)
+                {
+                    mLeaf = mLeaf->next;
+                    mIndex = 0;
+                }
+                return *this;
+            }
+
+            /// 要素を取得します
+            R &operator*() const
+            {
+                return mLeaf->elements()[mIndex];
+            }
+
+            /// 要素を取得します
+            R *operator->() const
+            {
+                return &mLeaf->elements()[mIndex];
+            }
+
+            /// 位置が等しいか判定します
+            bool operator==(const Itr<R> &r) const
+            {
+                return mLeaf == r.mLeaf && mIndex == r.mIndex;
+            }
+
+            /// 位置が等しくないか判定します
+            bool operator!=(const Itr<R> &r) const
+            {
+                return !(*this == r);
+            }
+        };
+
+        // コンストラクタ
+        _BTree(IAllocator *allocator)
+            : mAllocator(allocator)
+            , mLeafPool(nullptr)
+            , mInnerPool(nullptr)
+            , mRoot(nullptr)
+            , mFirst(nullptr)
+            , mLast(nullptr)
+            , mCount(0)
+            , mHeight(0)
+        {}
+
+        // コピーコンストラクタ
+        _BTree(const _BTree &tree)
+            : _BTree(tree.mAllocator)
+        {
+            auto itr = tree.begin();
+            build(tree.mCount, [&]() -> const E &
+            {
+                auto &element = *itr;
+                ++itr;
+                return element;
+            });
+        }
+
+        // ムーブコンストラクタ
+        _BTree(_BTree &&tree) noexcept
+            : mAllocator(tree.mAllocator)
+            , mLeafPool(tree.mLeafPool)
+            , mInnerPool(tree.mInnerPool)
+            , mRoot(tree.mRoot)
+            , mFirst(tree.mFirst)
+            , mLast(tree.mLast)
+            , mCount(tree.mCount)
+            , mHeight(tree.mHeight)
+        {
+            tree.mLeafPool = nullptr;
+            tree.mInnerPool = nullptr;
+            tree.mRoot = nullptr;
+            tree.mFirst = nullptr;
+            tree.mLast = nullptr;
+            tree.mCount = 0;
+            tree.mHeight = 0;
+        }
+
+        // デストラクタ
+        ~_BTree()
+        {
+            clear();
+            for(auto pool : { mLeafPool, mInnerPool })
+            {
+                if(!pool) continue;
+                pool->~DynamicMemoryPool();
+                mAllocator->deallocate(pool);
+            }
+        }
+
+        // コピー代入
+        _BTree &operator=(const _BTree &tree)
+        {
+            if(this == &tree) return *this;
+            clear();
+            auto itr = tree.begin();
+            build(tree.mCount, [&]() -> const E &
+            {
+                auto &element = *itr;
+                ++itr;
+                return element;
+            });
+            return *this;
+        }
+
+        // ムーブ代入
+        _BTree &operator=(_BTree &&tree) noexcept
+        {
+            if(this == &tree) return *this;
+            this->~_BTree();
+            new(this) _BTree(std::move(tree));
+            return *this;
+        }
+
+        // キーに一致する要素を返す、無い場合nullptr
+        E *find(const K &key) const
+        {
+            if(!mRoot) return nullptr;
+            auto leaf = leafOf(key);
+            auto index = leafIndex(leaf, key);
+            return index < leaf->count && equal(P{}(leaf->elements()[index]), key) ? &leaf->elements()[index] : nullptr;
+        }
+
+        // キー以上となる最初の位置を返す
+        Itr<const E> lowerBound(const K &key) const
+        {
+            if(!mRoot) return end();
+            auto leaf = leafOf(key);
+            return Itr<const E>(leaf, leafIndex(leaf, key));
+        }
+
+        // キーより大きい最初の位置を返す
+        Itr<const E> upperBound(const K &key) const
+        {
+            auto itr = lowerBound(key);
+            if(itr != end() && equal(P{}(*itr), key)) ++itr;
+            return itr;
+        }
+
+        // 要素を挿入する、同じキーが既にある場合は挿入しない
+        // @param [out] inserted 挿入した場合真
+        // @return 挿入、または、既にあった要素 確保に失敗した場合nullptr
+        template<class U>
+        E *insert(U &&element, bool &inserted)
+        {
+            // 自身の要素を参照している場合に備え、節点を変更する前に取り出す
+            E tmp(std::forward<U>(element));
+            inserted = false;
+            if(!mRoot)
+            {
+                auto leaf = newLeaf();
+                if(!leaf)
+                {
+                    printError("failed to allocate. E *_BTree<E, K, P, L, N>::insert(U &&element, bool &inserted)");
+                    return nullptr;
+                }
+                mRoot = leaf;
+                mFirst = leaf;
+                mLast = leaf;
+                mHeight = 1;
+            }
+
+            // 根から葉まで、たどった内部節点と子の位置を記録する
+            Inner *path[MAX_DEPTH];
+            size_t slots[MAX_DEPTH];
+            size_t depth = 0;
+            auto node = mRoot;
+            while(!node->leaf)
+            {
+                auto inner = (Inner *) node;
+                path[depth] = inner;
+                slots[depth] = childIndex(inner, P{}(tmp));
+                node = inner->children[slots[depth]];
+                depth++;
+            }
+            auto leaf = (Leaf *) node;
+            auto index = leafIndex(leaf, P{}(tmp));
+            if(index < leaf->count && equal(P{}(leaf->elements()[index]), P{}(tmp))) return &leaf->elements()[index];
+
+            // 分割に必要な節点を変更前に確保し、失敗した場合は何も変更しない
+            Node *spares[MAX_DEPTH + 2];
+            size_t sparesCount = 0;
+            bool failed = false;
+            if(leaf->count == N)
+            {
+                auto newLeafNode = newLeaf();
+                spares[sparesCount++] = newLeafNode;
+                failed |= !newLeafNode;
+                auto d = depth;
+                while(d > 0 && path[d - 1]->count == N)
+                {
+                    auto newInnerNode = newInner();
+                    spares[sparesCount++] = newInnerNode;
+                    failed |= !newInnerNode;
+                    d--;
+                }
+                if(d == 0)
+                {
+                    auto newRoot = newInner();
+                    spares[sparesCount++] = newRoot;
+                    failed |= !newRoot;
+                }
+            }
+            if(failed)
+            {
+                for(size_t i = 0; i < sparesCount; i++)
+                {
+                    if(spares[i]) DynamicMemoryPool::deallocate(spares[i]);
+                }
+                printError("failed to allocate. E *_BTree<E, K, P, L, N>::insert(U &&element, bool &inserted)");
+                return nullptr;
+            }
+
+            insertInto(leaf->elements(), leaf->count, index, std::move(tmp));
+            leaf->count++;
+            mCount++;
+            inserted = true;
+            auto result = &leaf->elements()[index];
+            if(leaf->count <= N) return result;
+
+            // 葉を半分に分割し、右半分の先頭を区切りとして親へ渡す
+            size_t used = 0;
+            auto right = (Leaf *) spares[used++];
+            auto half = leaf->count / 2;
+            moveTo(&leaf->elements()[half], leaf->count - half, right->elements());
+            right->count = leaf->count - half;
+            leaf->count = half;
+            right->prev = leaf;
+            right->next = leaf->next;
+            if(leaf->next) leaf->next->prev = right;
+            else mLast = right;
+            leaf->next = right;
+            if(index >= half) result = &right->elements()[index - half];
+
+            K separator(P{}(right->elements()[0]));
+            Node *child = right;
+            for(;;)
+            {
+                if(!depth)
+                {
+                    // 根を分割したため、新しい根を作る
+                    auto root = (Inner *) spares[used++];
+                    new(&root->keys()[0]) K(std::move(separator));
+                    root->children[0] = mRoot;
+                    root->children[1] = child;
+                    root->count = 1;
+                    mRoot = root;
+                    mHeight++;
+                    break;
+                }
+
+                depth--;
+                auto parent = path[depth];
+                auto slot = slots[depth];
+                insertInto(parent->keys(), parent->count, slot, std::move(separator));
+                for(auto i = parent->count + 1; i > slot + 1; i--) parent->children[i] = parent->children[i - 1];
+                parent->children[slot + 1] = child;
+                parent->count++;
+                if(parent->count <= N) break;
+
+                // 内部節点を分割し、中央の区切りを親へ上げる
+                auto sibling = (Inner *) spares[used++];
+                auto middle = parent->count / 2;
+                separator = std::move(parent->keys()[middle]);
+                sibling->count = parent->count - middle - 1;
+                moveTo(&parent->keys()[middle + 1], sibling->count, sibling->keys());
+                for(size_t i = 0; i <= sibling->count; i++) sibling->children[i] = parent->children[middle + 1 + i];
+                parent->keys()[middle].~K();
+                parent->count = middle;
+                child = sibling;
+            }
+            return result;
+        }
+
+        // 整列済みの要素を一括で挿入する
+        // 空の木に狭義の昇順で挿入する場合は、葉から順に組み立てる
+        void insert(const E *elements, size_t count)
+        {
+            bool sorted = !mCount;
+            for(size_t i = 1; sorted && i < count; i++) sorted = L{}(P{}(elements[i - 1]), P{}(elements[i]));
+            if(sorted)
+            {
+                size_t i = 0;
+                build(count, [&]() -> const E & { return elements[i++]; });
+                return;
+            }
+            bool inserted;
+            for(size_t i = 0; i < count; i++) insert(elements[i], inserted);
+        }
+
+        // 昇順に要素を返す関数から木を組み立てる
+        // 葉を要素で満たし、各段の最小キーを区切りとして上の段を作る
+        // @param count 要素数
+        // @param next const E &()の関数オブジェクト 呼び出し毎に次の要素を返す
+        template<class F>
+        void build(size_t count, const F &next)
+        {
+            clear();
+            if(!count) return;
+
+            // 葉を均等に満たす 葉が2つ以上の場合、各葉は最小要素数以上になる
+            List<Node *> nodes(mAllocator);
+            List<K> minimums(mAllocator);
+            auto leavesCount = (count + N - 1) / N;
+            for(size_t i = 0; i < leavesCount; i++)
+            {
+                auto leaf = newLeaf();
+                if(!leaf)
+                {
+                    printError("failed to allocate. void _BTree<E, K, P, L, N>::build(size_t count, const F &next)");
+                    for(auto node : nodes) destroyNode(node);
+                    mFirst = nullptr;
+                    mLast = nullptr;
+                    return;
+                }
+                auto size = count * (i + 1) / leavesCount - count * i / leavesCount;
+                for(size_t j = 0; j < size; j++) new(&leaf->elements()[j]) E(next());
+                leaf->count = size;
+                leaf->prev = mLast;
+                if(mLast) mLast->next = leaf;
+                else mFirst = leaf;
+                mLast = leaf;
+                nodes.add(leaf);
+                minimums.add(P{}(leaf->elements()[0]));
+            }
+            mCount = count;
+            mHeight = 1;
+
+            // 子の段から内部節点の段を作ることを、1節点になるまで繰り返す
+            while(nodes.count() > 1)
+            {
+                List<Node *> parents(mAllocator);
+                List<K> parentMinimums(mAllocator);
+                auto childrenCount = nodes.count();
+                auto innersCount = (childrenCount + N) / (N + 1);
+                for(size_t i = 0; i < innersCount; i++)
+                {
+                    auto begin = childrenCount * i / innersCount;
+                    auto end = childrenCount * (i + 1) / innersCount;
+                    auto inner = newInner();
+                    if(!inner)
+                    {
+                        // 組み立て済みの節点を子孫ごと破棄する
+                        printError("failed to allocate. void _BTree<E, K, P, L, N>::build(size_t count, const F &next)");
+                        for(auto parent : parents) destroyNode(parent);
+                        for(auto j = begin; j < childrenCount; j++) destroyNode(nodes[j]);
+                        mFirst = nullptr;
+                        mLast = nullptr;
+                        mCount = 0;
+                        mHeight = 0;
+                        return;
+                    }
+                    inner->children[0] = nodes[begin];
+                    for(auto j = begin + 1; j < end; j++)
+                    {
+                        new(&inner->keys()[inner->count]) K(std::move(minimums[j]));
+                        inner->children[++inner->count] = nodes[j];
+                    }
+                    parents.add(inner);
+                    parentMinimums.add(std::move(minimums[begin]));
+                }
+                nodes = std::move(parents);
+                minimums = std::move(parentMinimums);
+                mHeight++;
+            }
+            mRoot = nodes[0];
+        }
+
+        // キーに一致する要素を削除する
+        // @return 削除した場合真
+        bool remove(const K &key)
+        {
+            if(!mRoot) return false;
+
+            Inner *path[MAX_DEPTH];
+            size_t slots[MAX_DEPTH];
+            size_t depth = 0;
+            auto node = mRoot;
+            while(!node->leaf)
+            {
+                auto inner = (Inner *) node;
+                path[depth] = inner;
+                slots[depth] = childIndex(inner, key);
+                node = inner->children[slots[depth]];
+                depth++;
+            }
+            auto leaf = (Leaf *) node;
+            auto index = leafIndex(leaf, key);
+            if(index == leaf->count || !equal(P{}(leaf->elements()[index]), key)) return false;
+
+            removeFrom(leaf->elements(), leaf->count, index);
+            leaf->count--;
+            mCount--;
+
+            if(!depth)
+            {
+                // 根の葉が空になった場合は木を空にする
+                if(!leaf->count)
+                {
+                    DynamicMemoryPool::deallocate(leaf);
+                    mRoot = nullptr;
+                    mFirst = nullptr;
+                    mLast = nullptr;
+                    mHeight = 0;
+                }
+                return true;
+            }
+            if(leaf->count >= MIN_COUNT) return true;
+
+            // 不足を解消し、併合で親の区切りが減った場合は上の段へ続ける
+            depth--;
+            if(!rebalanceLeaf(leaf, path[depth], slots[depth])) return true;
+            while(depth && path[depth]->count < MIN_COUNT)
+            {
+                if(!rebalanceInner(path[depth], path[depth - 1], slots[depth - 1])) return true;
+                depth--;
+            }
+
+            // 根の区切りが無くなった場合は高さを減らす
+            auto root = (Inner *) mRoot;
+            if(!root->count)
+            {
+                mRoot = root->children[0];
+                DynamicMemoryPool::deallocate(root);
+                mHeight--;
+            }
+            return true;
+        }
+
+        // すべての要素を削除する
+        void clear()
+        {
+            if(mRoot) destroyNode(mRoot);
+            mRoot = nullptr;
+            mFirst = nullptr;
+            mLast = nullptr;
+            mCount = 0;
+            mHeight = 0;
+        }
+
+        // 要素数を返す
+        size_t count() const
+        {
+            return mCount;
+        }
+
+        // 高さを返す
+        size_t height() const
+        {
+            return mHeight;
+        }
+
+        // 先頭の要素を返す、空の場合nullptr
+        E *first() const
+        {
+            return mFirst ? &mFirst->elements()[0] : nullptr;
+        }
+
+        // 末尾の要素を返す、空の場合nullptr
+        E *last() const
+        {
+            return mLast ? &mLast->elements()[mLast->count - 1] : nullptr;
+        }
+
+        // 先頭イテレータを返す
+        Itr<const E> begin() const
+        {
+            return Itr<const E>(mFirst, 0);
+        }
+
+        // 番兵イテレータを返す
+        Itr<const E> end() const
+        {
+            return Itr<const E>(nullptr, 0);
+        }
+
+        // アロケータを返す
+        IAllocator *allocator() const
+        {
+            return mAllocator;
+        }
+    };
+
+    /// B+木による順序付き集合を提供します
+    /// 1節点に複数の要素を連続して格納するため、二分木よりキャッシュ効率が良くなります
+    /// 葉同士を連結しているため、範囲の走査は木をたどらずに行えます
+    /// 節点はメモリプールから確保します
+    /// @tparam L 順序を判定する関数オブジェクト型
+    /// @tparam N 1節点の要素数
+    template<class T, class L = Less<T>, size_t N = BTREE_NODE_ELEMENTS_COUNT>
+    class BTreeSet
+    {
+        using Tree = _BTree<T, T, _FlatIdentity<T>, L, N>;
+
+        Tree mTree; // 木
+
+    public:
+
+        /// 前方向イテレータです
+        using Itr = typename Tree::template Itr<const T>;
+
+        /// コンストラクタ
+        /// @param allocator アロケータ
+        BTreeSet(IAllocator *allocator = Memory::allocator())
+            : mTree(allocator)
+        {}
+
+        /// コンストラクタ
+        /// @param list 初期化リスト
+        /// @param allocator アロケータ
+        BTreeSet(std::initializer_list<T> list, IAllocator *allocator = Memory::allocator())
+            : mTree(allocator)
+        {
+            add(list);
+        }
+
+        /// 追加します
+        BTreeSet<T, L, N> &operator|=(const T &r)
+        {
+            bool inserted;
+            mTree.insert(r, inserted);
+            return *this;
+        }
+
+        /// 追加します
+        BTreeSet<T, L, N> &operator|=(T &&r)
+        {
+            bool inserted;
+            mTree.insert(std::move(r), inserted);
+            return *this;
+        }
+
+        /// 削除します
+        BTreeSet<T, L, N> &operator-=(const T &r)
+        {
+            mTree.remove(r);
+            return *this;
+        }
+
+        /// 含まれるか判定します
+        bool operator()(const T &element) const
+        {
+            return mTree.find(element) != nullptr;
+        }
+
+        /// 追加します
+        BTreeSet<T, L, N> &add(const T &r)
+        {
+            return operator|=(r);
+        }
+
+        /// 追加します
+        BTreeSet<T, L, N> &add(T &&r)
+        {
+            return operator|=(std::move(r));
+        }
+
+        /// 一括で追加します
+        /// 空の集合に狭義の昇順で追加する場合は、節点を下から組み立てるため線形時間で完了します
+        /// @param elements 追加する生配列
+        /// @param count 追加する要素数
+        BTreeSet<T, L, N> &add(const T *elements, size_t count)
+        {
+            mTree.insert(elements, count);
+            return *this;
+        }
+
+        /// 一括で追加します
+        /// @param list 初期化リスト
+        BTreeSet<T, L, N> &add(std::initializer_list<T> list)
+        {
+            mTree.insert(list.begin(), list.size());
+            return *this;
+        }
+
+        /// 削除します
+        /// @retval false 含まれていませんでした
+        bool remove(const T &r)
+        {
+            return mTree.remove(r);
+        }
+
+        /// 含まれるか判定します
+        bool contains(const T &element) const
+        {
+            return mTree.find(element) != nullptr;
+        }
+
+        /// 要素以上となる最初の位置を返します
+        Itr lowerBound(const T &element) const
+        {
+            return mTree.lowerBound(element);
+        }
+
+        /// 要素より大きい最初の位置を返します
+        Itr upperBound(const T &element) const
+        {
+            return mTree.upperBound(element);
+        }
+
+        /// 半開区間[first, last)の要素の範囲を返します
+        BTreeRange<Itr> range(const T &first, const T &last) const
+        {
+            if(!L{}(first, last)) return BTreeRange<Itr>(end(), end());
+            return BTreeRange<Itr>(lowerBound(first), lowerBound(last));
+        }
+
+        /// 最小の要素を取得します
+        const T &first() const
+        {
+            if(!mTree.count()) printError("set is empty. const T &BTreeSet<T, L, N>::first() const");
+            return *mTree.first();
+        }
+
+        /// 最大の要素を取得します
+        const T &last() const
+        {
+            if(!mTree.count()) printError("set is empty. const T &BTreeSet<T, L, N>::last() const");
+            return *mTree.last();
+        }
+
+        /// 要素数を返します
+        size_t count() const
+        {
+            return mTree.count();
+        }
+
+        /// 木の高さを返します
+        size_t height() const
+        {
+            return mTree.height();
+        }
+
+        /// クリアします
+        void clear()
+        {
+            mTree.clear();
+        }
+
+        /// 先頭イテレータを返します
+        /// 順に走査します
+        Itr begin() const
+        {
+            return mTree.begin();
+        }
+
+        /// 番兵イテレータを返します
+        Itr end() const
+        {
+            return mTree.end();
+        }
+
+        /// アロケータを取得します
+        IAllocator *allocator() const
+        {
+            return mTree.allocator();
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_BTREESET_HPP
\ No newline at end of file
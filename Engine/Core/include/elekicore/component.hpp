@@ -8,6 +8,8 @@
 
 #include "array.hpp"
 #include "map.hpp"
+#include "flatmap.hpp"
+#include "stringid.hpp"
 #include "serialization.hpp"
 #include "entity.hpp"
 
@@ -70,7 +72,7 @@ namespace ElekiEngine
 	class Archetype
 	{
 		List<IComponent> mTypes;            // Type配列
-		Map<String, size_t> mIndexes; // 型名からTypeの位置を取得するための連想配列
+		FlatMap<StringId, size_t> mIndexes; // 型名の文字列IDからTypeの位置を取得するための連想配列
 
 	public:
 
@@ -78,11 +80,21 @@ namespace ElekiEngine
 		const IComponent *operator[](size_t index) const;
 
 		/// 型名からコンポーネント情報にアクセスします
+		/// @retval nullptr 型が含まれていません
 		const IComponent *operator[](const String &name) const;
 
+		/// 型名の文字列IDからコンポーネント情報にアクセスします
+		/// @retval nullptr 型が含まれていません
+		const IComponent *operator[](StringId id) const;
+
 		/// コンポーネント名から位置を取得します
+		/// @retval 型の数 型が含まれていません
 		size_t operator()(const String &name) const;
 
+		/// コンポーネント名の文字列IDから位置を取得します
+		/// @retval 型の数 型が含まれていません
+		size_t operator()(StringId id) const;
+
 		/// コンポーネントの集合が等しいか比較します
 		bool operator==(const Archetype &r) const;
 
@@ -93,10 +105,22 @@ namespace ElekiEngine
 		const IComponent *atComponent(size_t index) const;
 
 		/// 型名からコンポーネント情報にアクセスします
+		/// 型名は文字列IDに変換して検索し、名前の登録は行いません
+		/// @retval nullptr 型が含まれていません
 		const IComponent *atComponent(const String &name) const;
 
+		/// 型名の文字列IDからコンポーネント情報にアクセスします
+		/// @retval nullptr 型が含まれていません
+		const IComponent *atComponent(StringId id) const;
+
 		/// コンポーネント名から位置を取得します
+		/// 型名は文字列IDに変換して検索し、名前の登録は行いません
+		/// @retval 型の数 型が含まれていません
 		size_t atIndex(const String &name) const;
+
+		/// コンポーネント名の文字列IDから位置を取得します
+		/// @retval 型の数 型が含まれていません
+		size_t atIndex(StringId id) const;
 	};
 
 
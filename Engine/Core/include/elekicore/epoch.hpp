@@ -0,0 +1,103 @@
+/// @file epoch.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 世代による遅延解放を提供します
+/// 他のスレッドが読んでいる可能性のある節点を、全てのスレッドが読み終えた後に解放します
+/// 解放は保留したスレッドとは限らないため、終了処理とアロケータはスレッド安全なものを指定してください
+
+#ifndef ELEKICORE_EPOCH_HPP
+#define ELEKICORE_EPOCH_HPP
+
+#include <cstdlib>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "allocation.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// スレッド毎に保留した解放がこの数を超えると、世代を進めて解放を試みます
+    constexpr size_t EPOCH_RECLAIM_THRESHOLD = 64;
+
+    /// 共有オブジェクトを読む区間を示すガードです
+    /// 生存する間、そのスレッドは現在の世代に留まり、以降にretireしたオブジェクトは解放されません
+    /// 入れ子にでき、最も外側のガードの破棄で区間を抜けます
+    /// 読み取りのたびに参照数を増減する代わりに、区間の出入りで1度ずつ記録します
+    class ELEKICORE_EXPORT EpochGuard
+    {
+        void *mRecord; // スレッドの記録
+
+    public:
+
+        /// コンストラクタ
+        /// 区間に入ります
+        EpochGuard();
+
+        /// デストラクタ
+        /// 区間を抜けます
+        ~EpochGuard();
+
+        EpochGuard(const EpochGuard &) = delete;
+        EpochGuard &operator=(const EpochGuard &) = delete;
+    };
+
+    /// 全てのスレッドが読み終えた後に終了処理を実行します
+    /// 共有の構造から外した後に呼び出してください
+    /// @param pointer 外したオブジェクト
+    /// @param deleter 終了処理
+    void ELEKICORE_EXPORT retire(void *pointer, IDeleter *deleter);
+
+    /// 全てのスレッドが読み終えた後にアロケータで解放します
+    /// @param pointer 外したメモリ
+    /// @param allocator 確保したアロケータ
+    void ELEKICORE_EXPORT retire(void *pointer, IAllocator *allocator);
+
+    /// 全てのスレッドが読み終えた後にメモリプールへ返します
+    /// @param pointer 外した要素
+    /// @param pool 確保したメモリプール
+    void ELEKICORE_EXPORT retire(void *pointer, StaticMemoryPool *pool);
+
+    /// 全てのスレッドが読み終えた後にメモリプールへ返します
+    /// @param pointer 外した要素
+    /// @param pool 確保したメモリプール
+    void ELEKICORE_EXPORT retire(void *pointer, DynamicMemoryPool *pool);
+
+    /// 世代を進め、解放できる保留を全て解放します
+    /// 終了したスレッドが残した保留も解放します
+    /// @return 解放した数
+    size_t ELEKICORE_EXPORT reclaimRetired();
+
+    // オブジェクトのデストラクタを呼び、mallocの領域を解放する終了処理
+    // 解放はどのスレッドでも行われるため、排他しない共有メモリは使わない
+    template<class T>
+    class _RetireDeleter: public IDeleter
+    {
+    public:
+
+        // 終了処理を実行する
+        void operator()(void *pointer) override
+        {
+            ((T *) pointer)->~T();
+            std::free(pointer);
+        }
+
+        // 型ごとの終了処理を返す
+        static IDeleter *instance()
+        {
+            static _RetireDeleter<T> deleter;
+            return &deleter;
+        }
+    };
+
+    /// 全てのスレッドが読み終えた後にデストラクタを呼び、領域を解放します
+    /// @param object std::mallocで確保して構築したオブジェクト
+    template<class T>
+    void retire(T *object)
+    {
+        retire((void *) object, _RetireDeleter<T>::instance());
+    }
+
+}
+
+#endif // !ELEKICORE_EPOCH_HPP
\ No newline at end of file
@@ -0,0 +1,235 @@
+/// @file flatmap.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 整列済み連続配列による連想配列を提供します
+/// 要素数が少なく、変更の少ない検索表に向きます
+
+#ifndef ELEKICORE_FLATMAP_HPP
+#define ELEKICORE_FLATMAP_HPP
+
+#include "flatset.hpp"
+#include "map.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    // キーと値のペアからキーを取り出す関数オブジェクト
+    template<class K, class V>
+    struct _FlatKeyOf
+    {
+        const K &operator()(const KeyValuePair<K, V> &element) const
+        {
+            return element.key;
+        }
+    };
+
+    /// 整列済み連続配列による連想配列を提供します
+    /// キーと値のペアを1本の配列にキー順で格納します
+    /// @tparam L キーの順序を判定する関数オブジェクト型
+    template<class K, class V, class L = Less<K>>
+    class FlatMap
+    {
+        _FlatArray<KeyValuePair<K, V>, K, _FlatKeyOf<K, V>, L> mArray; // 要素配列
+
+    public:
+
+        /// コンストラクタ
+        /// @param allocator アロケータ
+        FlatMap(IAllocator *allocator = Memory::allocator())
+            : mArray(allocator)
+        {}
+
+        /// コンストラクタ
+        /// @param list 初期化リスト
+        /// @param allocator アロケータ
+        FlatMap(std::initializer_list<KeyValuePair<K, V>> list, IAllocator *allocator = Memory::allocator())
+            : mArray(allocator)
+        {
+            mArray.insert(list.begin(), list.size());
+        }
+
+        /// 追加します
+        /// 同じキーが既にある場合は追加しません
+        FlatMap<K, V, L> &operator+=(const KeyValuePair<K, V> &r)
+        {
+            mArray.insert(r);
+            return *this;
+        }
+
+        /// 追加します
+        /// 同じキーが既にある場合は追加しません
+        FlatMap<K, V, L> &operator+=(KeyValuePair<K, V> &&r)
+        {
+            mArray.insert(std::move(r));
+            return *this;
+        }
+
+        /// 削除します
+        FlatMap<K, V, L> &operator-=(const K &r)
+        {
+            mArray.remove(r);
+            return *this;
+        }
+
+        /// キーからアクセスします
+        V &operator[](const K &key)
+        {
+            auto index = mArray.indexOf(key);
+            if(index == mArray.count()) printError("key not found. V &FlatMap<K, V>::operator[](const K &key)");
+            return mArray.element(index).value;
+        }
+
+        /// キーからアクセスします
+        const V &operator[](const K &key) const
+        {
+            auto index = mArray.indexOf(key);
+            if(index == mArray.count()) printError("key not found. const V &FlatMap<K, V>::operator[](const K &key) const");
+            return mArray.element(index).value;
+        }
+
+        /// 含まれるか判定します
+        bool operator()(const K &key) const
+        {
+            return mArray.indexOf(key) != mArray.count();
+        }
+
+        /// 追加します
+        /// 同じキーが既にある場合は追加しません
+        FlatMap<K, V, L> &add(const K &key, const V &value)
+        {
+            return operator+=(KeyValuePair<K, V>(key, value));
+        }
+
+        /// 一括で追加します
+        /// 追加分を1度だけ整列させて併合します
+        /// @param elements 追加する生配列
+        /// @param count 追加する要素数
+        FlatMap<K, V, L> &add(const KeyValuePair<K, V> *elements, size_t count)
+        {
+            mArray.insert(elements, count);
+            return *this;
+        }
+
+        /// 一括で追加します
+        /// @param list 初期化リスト
+        FlatMap<K, V, L> &add(std::initializer_list<KeyValuePair<K, V>> list)
+        {
+            mArray.insert(list.begin(), list.size());
+            return *this;
+        }
+
+        /// 削除します
+        FlatMap<K, V, L> &remove(const K &key)
+        {
+            return operator-=(key);
+        }
+
+        /// キーからアクセスします
+        V &at(const K &key)
+        {
+            auto index = mArray.indexOf(key);
+            if(index == mArray.count()) printError("key not found. V &FlatMap<K, V>::at(const K &key)");
+            return mArray.element(index).value;
+        }
+
+        /// キーからアクセスします
+        const V &at(const K &key) const
+        {
+            auto index = mArray.indexOf(key);
+            if(index == mArray.count()) printError("key not found. const V &FlatMap<K, V>::at(const K &key) const");
+            return mArray.element(index).value;
+        }
+
+        /// キーから値を検索します
+        /// @retval nullptr キーが見つかりませんでした
+        V *find(const K &key)
+        {
+            auto index = mArray.indexOf(key);
+            return index != mArray.count() ? &mArray.element(index).value : nullptr;
+        }
+
+        /// キーから値を検索します
+        /// @retval nullptr キーが見つかりませんでした
+        const V *find(const K &key) const
+        {
+            auto index = mArray.indexOf(key);
+            return index != mArray.count() ? &mArray.element(index).value : nullptr;
+        }
+
+        /// 含まれるか判定します
+        bool contains(const K &key) const
+        {
+            return mArray.indexOf(key) != mArray.count();
+        }
+
+        /// 位置からキーを取得します
+        const K &keyAt(size_t index) const
+        {
+            if(index >= mArray.count()) printError("out of range. const K &FlatMap<K, V>::keyAt(size_t index) const");
+            return mArray.element(index).key;
+        }
+
+        /// 位置から値を取得します
+        V &valueAt(size_t index)
+        {
+            if(index >= mArray.count()) printError("out of range. V &FlatMap<K, V>::valueAt(size_t index)");
+            return mArray.element(index).value;
+        }
+
+        /// 位置から値を取得します
+        const V &valueAt(size_t index) const
+        {
+            if(index >= mArray.count()) printError("out of range. const V &FlatMap<K, V>::valueAt(size_t index) const");
+            return mArray.element(index).value;
+        }
+
+        /// キーの位置を返します
+        /// @retval 要素数 キーが見つかりませんでした
+        size_t indexOf(const K &key) const
+        {
+            return mArray.indexOf(key);
+        }
+
+        /// 要素数を返します
+        size_t count() const
+        {
+            return mArray.count();
+        }
+
+        /// 配列サイズを指定数以上にします
+        FlatMap<K, V, L> &reserve(size_t size)
+        {
+            mArray.reserve(size);
+            return *this;
+        }
+
+        /// クリアします
+        void clear()
+        {
+            mArray.clear();
+        }
+
+        /// 先頭イテレータを返します
+        /// キーの順に走査します
+        ConstPointerItr<KeyValuePair<K, V>> begin() const
+        {
+            return ConstPointerItr<KeyValuePair<K, V>>(mArray.data());
+        }
+
+        /// 番兵イテレータを返します
+        ConstPointerItr<KeyValuePair<K, V>> end() const
+        {
+            return ConstPointerItr<KeyValuePair<K, V>>(mArray.data() + mArray.count());
+        }
+
+        /// アロケータを取得します
+        IAllocator *allocator() const
+        {
+            return mArray.allocator();
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_FLATMAP_HPP
\ No newline at end of file
@@ -0,0 +1,579 @@
+/// @file flatset.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 整列済み連続配列による集合を提供します
+/// 要素数が少なく、変更の少ない検索表に向きます
+
+#ifndef ELEKICORE_FLATSET_HPP
+#define ELEKICORE_FLATSET_HPP
+
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "floatingpoint.hpp"
+#include "array.hpp"
+
+#if ELEKI_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// SIMDによる線形探索に切り替える要素数の上限です
+    constexpr size_t FLAT_LINEAR_SEARCH_MAX = 32;
+
+    // 整列済み生配列をSIMDで走査し、キー未満の要素数を返します
+    inline size_t _flatLinearLowerBound(const i32 *elements, size_t count, i32 key)
+    {
+        size_t i = 0;
+        size_t result = 0;
+    #if ELEKI_SIMD_SSE2
+        auto k = _mm_set1_epi32(key);
+        auto acc = _mm_setzero_si128();
+        for(; i + 4 <= count; i += 4)
+        {
+            // 比較結果は真のとき-1なので、引くことで数える
+            auto v = _mm_loadu_si128((const __m128i *) (const void *) &elements[i]);
+            acc = _mm_sub_epi32(acc, _mm_cmplt_epi32(v, k));
+        }
+        alignas(16) i32 lanes[4];
+        _mm_store_si128((__m128i *) (void *) lanes, acc);
+        result = (size_t) (lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    #endif
+        for(; i < count; i++) result += (elements[i] < key ? 1 : 0);
+        return result;
+    }
+
+    // 整列済み生配列をSIMDで走査し、キー未満の要素数を返します
+    inline size_t _flatLinearLowerBound(const u32 *elements, size_t count, u32 key)
+    {
+        size_t i = 0;
+        size_t result = 0;
+    #if ELEKI_SIMD_SSE2
+        // 符号ビットを反転させ、符号付き比較で符号無しの大小を求める
+        auto sign = _mm_set1_epi32(I32_MIN);
+        auto k = _mm_xor_si128(_mm_set1_epi32((i32) key), sign);
+        auto acc = _mm_setzero_si128();
+        for(; i + 4 <= count; i += 4)
+        {
+            auto v = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (const void *) &elements[i]), sign);
+            acc = _mm_sub_epi32(acc, _mm_cmplt_epi32(v, k));
+        }
+        alignas(16) i32 lanes[4];
+        _mm_store_si128((__m128i *) (void *) lanes, acc);
+        result = (size_t) (lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    #endif
+        for(; i < count; i++) result += (elements[i] < key ? 1 : 0);
+        return result;
+    }
+
+    // 整列済み生配列をSIMDで走査し、キー未満の要素数を返します
+    inline size_t _flatLinearLowerBound(const f32 *elements, size_t count, f32 key)
+    {
+        size_t i = 0;
+        size_t result = 0;
+    #if ELEKI_SIMD_SSE2
+        auto k = _mm_set1_ps(key);
+        auto acc = _mm_setzero_si128();
+        for(; i + 4 <= count; i += 4)
+        {
+            auto v = _mm_loadu_ps(&elements[i]);
+            acc = _mm_sub_epi32(acc, _mm_castps_si128(_mm_cmplt_ps(v, k)));
+        }
+        alignas(16) i32 lanes[4];
+        _mm_store_si128((__m128i *) (void *) lanes, acc);
+        result = (size_t) (lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    #endif
+        for(; i < count; i++) result += (elements[i] < key ? 1 : 0);
+        return result;
+    }
+
+    /// 整列済み生配列からキー以上となる最初の位置を返します
+    /// @tparam L キーの順序を判定する関数オブジェクト型
+    /// @param elements 整列済みの生配列
+    /// @param count 要素数
+    /// @param key 検索するキー
+    /// @param project 要素からキーを取り出す関数オブジェクト
+    /// @return キー以上となる最初の位置、無い場合は要素数
+    template<class L, class T, class K, class P>
+    size_t flatLowerBound(const T *elements, size_t count, const K &key, const P &project)
+    {
+        // SIMDで比較できる型は、小さな配列を線形に走査します
+        if constexpr(std::is_same_v<T, K> && std::is_same_v<L, Less<K>> &&
+                     (std::is_same_v<K, i32> || std::is_same_v<K, u32> || std::is_same_v<K, f32>))
+        {
+            if(count <= FLAT_LINEAR_SEARCH_MAX) return _flatLinearLowerBound(elements, count, key);
+        }
+
+        // 分岐の無い二分探索
+        // 比較結果で先頭位置を選ぶだけにし、分岐予測の失敗を無くします
+        if(!count) return 0;
+        const T *base = elements;
+        size_t n = count;
+        while(n > 1)
+        {
+            size_t half = n / 2;
+            base = L{}(project(base[half]), key) ? &base[half] : base;
+            n -= half;
+        }
+        return (size_t) (base - elements) + (L{}(project(*base), key) ? 1 : 0);
+    }
+
+    // 要素をそのままキーとする関数オブジェクト
+    template<class T>
+    struct _FlatIdentity
+    {
+        const T &operator()(const T &element) const
+        {
+            return element;
+        }
+    };
+
+    // 整列済み連続配列の共通実装
+    // E 要素型、K キー型、P 要素からキーを取り出す関数オブジェクト型、L キーの順序を判定する関数オブジェクト型
+    template<class E, class K, class P, class L>
+    class _FlatArray
+    {
+        static constexpr size_t INIT_ELEM_CNT_A = 8; // 初期の配列長
+
+        IAllocator *mAllocator;                      // アロケータ
+        size_t mSize;                                // 配列サイズ
+        size_t mCount;                               // 要素数
+        E *mElements;                                // 要素配列
+
+        // キーが等しいか判定する
+        static bool equal(const K &l, const K &r)
+        {
+            return !L{}(l, r) && !L{}(r, l);
+        }
+
+        // 配列サイズを変更する
+        void reallocate(size_t size)
+        {
+            auto newElems = (E *) mAllocator->allocate(sizeof(E) * size);
+            for(size_t i = 0; i < mCount; i++)
+            {
+                new(&newElems[i]) E(std::move(mElements[i]));
+                mElements[i].~E();
+            }
+            if(mElements) mAllocator->deallocate(mElements);
+            mSize = size;
+            mElements = newElems;
+        }
+
+        // 指定数を格納できるように配列を広げる
+        void reserveFor(size_t count)
+        {
+            if(count <= mSize) return;
+            auto size = mSize * 2;
+            if(size < INIT_ELEM_CNT_A) size = INIT_ELEM_CNT_A;
+            if(size < count) size = count;
+            reallocate(size);
+        }
+
+        // すべての要素を破棄する
+        void destroy()
+        {
+            for(size_t i = 0; i < mCount; i++) mElements[i].~E();
+            if(mElements) mAllocator->deallocate(mElements);
+            mSize = 0;
+            mCount = 0;
+            mElements = nullptr;
+        }
+
+        // コピー
+        void copyFrom(const _FlatArray &array)
+        {
+            reserveFor(array.mCount);
+            for(size_t i = 0; i < array.mCount; i++) new(&mElements[i]) E(array.mElements[i]);
+            mCount = array.mCount;
+        }
+
+    public:
+
+        // コンストラクタ
+        _FlatArray(IAllocator *allocator)
+            : mAllocator(allocator)
+            , mSize(0)
+            , mCount(0)
+            , mElements(nullptr)
+        {}
+
+        // コピーコンストラクタ
+        _FlatArray(const _FlatArray &array)
+            : _FlatArray(array.mAllocator)
+        {
+            copyFrom(array);
+        }
+
+        // ムーブコンストラクタ
+        _FlatArray(_FlatArray &&array) noexcept
+            : mAllocator(array.mAllocator)
+            , mSize(array.mSize)
+            , mCount(array.mCount)
+            , mElements(array.mElements)
+        {
+            array.mSize = 0;
+            array.mCount = 0;
+            array.mElements = nullptr;
+        }
+
+        // デストラクタ
+        ~_FlatArray()
+        {
+            destroy();
+        }
+
+        // コピー代入
+        _FlatArray &operator=(const _FlatArray &array)
+        {
+            if(this == &array) return *this;
+            clear();
+            copyFrom(array);
+            return *this;
+        }
+
+        // ムーブ代入
+        _FlatArray &operator=(_FlatArray &&array) noexcept
+        {
+            if(this == &array) return *this;
+            destroy();
+            mAllocator = array.mAllocator;
+            mSize = array.mSize;
+            mCount = array.mCount;
+            mElements = array.mElements;
+            array.mSize = 0;
+            array.mCount = 0;
+            array.mElements = nullptr;
+            return *this;
+        }
+
+        // キー以上となる最初の位置を返す
+        size_t lowerBound(const K &key) const
+        {
+            return flatLowerBound<L>(mElements, mCount, key, P{});
+        }
+
+        // キーに一致する要素の位置を返す、無い場合は要素数
+        size_t indexOf(const K &key) const
+        {
+            auto index = lowerBound(key);
+            return (index < mCount && equal(P{}(mElements[index]), key)) ? index : mCount;
+        }
+
+        // 要素を挿入する、同じキーが既にある場合は挿入しない
+        // @return 挿入、または、既にあった要素の位置
+        template<class U>
+        size_t insert(U &&element)
+        {
+            // 自身の要素を参照している場合に備え、配列を広げる前に取り出す
+            E tmp(std::forward<U>(element));
+            auto index = lowerBound(P{}(tmp));
+            if(index < mCount && equal(P{}(mElements[index]), P{}(tmp))) return index;
+
+            reserveFor(mCount + 1);
+            if(index == mCount)
+            {
+                new(&mElements[mCount]) E(std::move(tmp));
+            }
+            else
+            {
+                // 挿入位置から後ろを1つずらす
+                new(&mElements[mCount]) E(std::move(mElements[mCount - 1]));
+                for(size_t i = mCount - 1; i > index; i--) mElements[i] = std::move(mElements[i - 1]);
+                mElements[index] = std::move(tmp);
+            }
+            mCount++;
+            return index;
+        }
+
+        // 複数の要素を挿入する
+        // 追加分を新しい配列の後部で1度だけ整列させ、既存の要素と前方から併合します
+        void insert(const E *elements, size_t count)
+        {
+            if(!count) return;
+            auto size = mSize > mCount + count ? mSize : mCount + count;
+            if(size < INIT_ELEM_CNT_A) size = INIT_ELEM_CNT_A;
+            auto newElems = (E *) mAllocator->allocate(sizeof(E) * size);
+
+            // 新しい配列の既存要素数以降に追加分を作成して整列
+            auto added = &newElems[mCount];
+            for(size_t i = 0; i < count; i++) new(&added[i]) E(elements[i]);
+            std::sort(added, &added[count], [](const E &l, const E &r) { return L{}(P{}(l), P{}(r)); });
+
+            // 追加分同士、及び、既存の要素と重複するものを除く
+            size_t addedCount = 0;
+            for(size_t i = 0; i < count; i++)
+            {
+                auto &key = P{}(added[i]);
+                bool isDuplicate = (addedCount && equal(P{}(added[addedCount - 1]), key)) || indexOf(key) != mCount;
+                if(isDuplicate) continue;
+                if(addedCount != i) added[addedCount] = std::move(added[i]);
+                addedCount++;
+            }
+            for(size_t i = addedCount; i < count; i++) added[i].~E();
+
+            // 前方から併合
+            // 書込み位置は未併合の追加分より常に前にあるため、追い越しません
+            size_t i = 0;
+            size_t j = 0;
+            while(i < mCount || j < addedCount)
+            {
+                auto to = &newElems[i + j];
+                bool fromOld = i < mCount && (j == addedCount || L{}(P{}(mElements[i]), P{}(added[j])));
+                auto &from = fromOld ? mElements[i] : added[j];
+                if(i + j < mCount) new(to) E(std::move(from));
+                else if(to != &from) *to = std::move(from);
+                if(fromOld) i++;
+                else j++;
+            }
+
+            // 古い配列を解放
+            for(size_t k = 0; k < mCount; k++) mElements[k].~E();
+            if(mElements) mAllocator->deallocate(mElements);
+            mSize = size;
+            mCount += addedCount;
+            mElements = newElems;
+        }
+
+        // キーに一致する要素を削除する
+        // @return 削除した場合真
+        bool remove(const K &key)
+        {
+            auto index = indexOf(key);
+            if(index == mCount) return false;
+            removeAt(index);
+            return true;
+        }
+
+        // 指定位置の要素を削除する
+        void removeAt(size_t index)
+        {
+            for(size_t i = index; i + 1 < mCount; i++) mElements[i] = std::move(mElements[i + 1]);
+            mElements[mCount - 1].~E();
+            mCount--;
+        }
+
+        // 配列サイズを指定数以上にする
+        void reserve(size_t size)
+        {
+            if(size > mSize) reallocate(size);
+        }
+
+        // クリアする、配列は解放しません
+        void clear()
+        {
+            for(size_t i = 0; i < mCount; i++) mElements[i].~E();
+            mCount = 0;
+        }
+
+        // 要素にアクセスする
+        E &element(size_t index)
+        {
+            return mElements[index];
+        }
+
+        // 要素にアクセスする
+        const E &element(size_t index) const
+        {
+            return mElements[index];
+        }
+
+        // 要素数を返す
+        size_t count() const
+        {
+            return mCount;
+        }
+
+        // 配列サイズを返す
+        size_t size() const
+        {
+            return mSize;
+        }
+
+        // 先頭ポインタを返す
+        E *data()
+        {
+            return mElements;
+        }
+
+        // 先頭ポインタを返す
+        const E *data() const
+        {
+            return mElements;
+        }
+
+        // アロケータを返す
+        IAllocator *allocator() const
+        {
+            return mAllocator;
+        }
+    };
+
+    /// 整列済み連続配列による集合を提供します
+    /// 検索は分岐の無い二分探索、または、小さな配列ではSIMDによる線形探索で行います
+    /// @tparam L 順序を判定する関数オブジェクト型
+    template<class T, class L = Less<T>>
+    class FlatSet
+    {
+        _FlatArray<T, T, _FlatIdentity<T>, L> mArray; // 要素配列
+
+    public:
+
+        /// コンストラクタ
+        /// @param allocator アロケータ
+        FlatSet(IAllocator *allocator = Memory::allocator())
+            : mArray(allocator)
+        {}
+
+        /// コンストラクタ
+        /// @param list 初期化リスト
+        /// @param allocator アロケータ
+        FlatSet(std::initializer_list<T> list, IAllocator *allocator = Memory::allocator())
+            : mArray(allocator)
+        {
+            mArray.insert(list.begin(), list.size());
+        }
+
+        /// 追加します
+        FlatSet<T, L> &operator|=(const T &r)
+        {
+            mArray.insert(r);
+            return *this;
+        }
+
+        /// 追加します
+        FlatSet<T, L> &operator|=(T &&r)
+        {
+            mArray.insert(std::move(r));
+            return *this;
+        }
+
+        /// 削除します
+        FlatSet<T, L> &operator-=(const T &r)
+        {
+            mArray.remove(r);
+            return *this;
+        }
+
+        /// 添え字から要素にアクセスします
+        const T &operator[](size_t index) const
+        {
+            if(index >= mArray.count()) printError("out of range. const T &FlatSet<T>::operator[](size_t index) const");
+            return mArray.element(index);
+        }
+
+        /// 含まれるか判定します
+        bool operator()(const T &element) const
+        {
+            return mArray.indexOf(element) != mArray.count();
+        }
+
+        /// 追加します
+        FlatSet<T, L> &add(const T &r)
+        {
+            return operator|=(r);
+        }
+
+        /// 追加します
+        FlatSet<T, L> &add(T &&r)
+        {
+            return operator|=(std::move(r));
+        }
+
+        /// 一括で追加します
+        /// 追加分を1度だけ整列させて併合します
+        /// @param elements 追加する生配列
+        /// @param count 追加する要素数
+        FlatSet<T, L> &add(const T *elements, size_t count)
+        {
+            mArray.insert(elements, count);
+            return *this;
+        }
+
+        /// 一括で追加します
+        /// @param list 初期化リスト
+        FlatSet<T, L> &add(std::initializer_list<T> list)
+        {
+            mArray.insert(list.begin(), list.size());
+            return *this;
+        }
+
+        /// 削除します
+        FlatSet<T, L> &remove(const T &r)
+        {
+            return operator-=(r);
+        }
+
+        /// 添え字から要素にアクセスします
+        const T &at(size_t index) const
+        {
+            if(index >= mArray.count()) printError("out of range. const T &FlatSet<T>::at(size_t index) const");
+            return mArray.element(index);
+        }
+
+        /// 含まれるか判定します
+        bool contains(const T &element) const
+        {
+            return mArray.indexOf(element) != mArray.count();
+        }
+
+        /// 一致する要素の位置を返します
+        /// @retval 要素数 一致する要素がありませんでした
+        size_t indexOf(const T &element) const
+        {
+            return mArray.indexOf(element);
+        }
+
+        /// 要素以上となる最初の位置を返します
+        size_t lowerBound(const T &element) const
+        {
+            return mArray.lowerBound(element);
+        }
+
+        /// 要素数を返します
+        size_t count() const
+        {
+            return mArray.count();
+        }
+
+        /// 配列サイズを指定数以上にします
+        FlatSet<T, L> &reserve(size_t size)
+        {
+            mArray.reserve(size);
+            return *this;
+        }
+
+        /// クリアします
+        void clear()
+        {
+            mArray.clear();
+        }
+
+        /// 先頭イテレータを返します
+        ConstPointerItr<T> begin() const
+        {
+            return ConstPointerItr<T>(mArray.data());
+        }
+
+        /// 番兵イテレータを返します
+        ConstPointerItr<T> end() const
+        {
+            return ConstPointerItr<T>(mArray.data() + mArray.count());
+        }
+
+        /// アロケータを取得します
+        IAllocator *allocator() const
+        {
+            return mArray.allocator();
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_FLATSET_HPP
\ No newline at end of file
@@ -0,0 +1,598 @@
+/// @file format.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 書式文字列に値を埋め込む機能を提供します
+/// 文字列リテラルの書式はELEKI_FORMATでコンパイル時に解析し、途中の文字列を作らずに出力先へ直接書き込みます
+///
+/// 書式は'{[添え字][:[[埋める文字]揃え][#][0][幅][.精度][型]]}'です
+/// 添え字を省略すると、直前の引数の次の引数を埋め込みます '{{'と'}}'は括弧1つになります
+/// 揃えは'<'左、'>'右、'^'中央で、数値は右、文字列は左が既定です
+/// '#'は基数の接頭辞を付け、'0'は符号の後を0で埋めます
+/// 型は整数に'x' 'X' 'b' 'o'、浮動小数点数に'f' 'e' 'E' 'g' 'G'を指定できます
+/// 浮動小数点数は型を省略すると、精度の指定があれば小数点以下の桁数、無ければ読み戻すと同じ値になる最短の表現になります
+/// 文字列の精度は最大の符号位置の数です
+
+#ifndef ELEKICORE_FORMAT_HPP
+#define ELEKICORE_FORMAT_HPP
+
+#include <cstdint>
+#include <type_traits>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "floatingpoint.hpp"
+#include "datalog.hpp"
+#include "stringview.hpp"
+#include "string.hpp"
+#include "stringbuilder.hpp"
+
+/// 文字列リテラルの書式をコンパイル時に解析します
+/// 書式の誤りと、引数の数を超える添え字はコンパイルエラーになります
+/// @param literal 書式文字列リテラル
+#define ELEKI_FORMAT(literal)                                                                  \
+    ([]() {                                                                                    \
+        constexpr auto format = ::ElekiEngine::FormatString<                                   \
+            ::ElekiEngine::_formatFieldCount(literal),                                         \
+            ::ElekiEngine::_formatArgumentCount(literal)>(literal);                            \
+        return format;                                                                         \
+    }())
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// 引数を埋め込まない区間の添え字です
+    constexpr size_t FORMAT_NO_ARGUMENT = ~(size_t) 0;
+
+    /// 精度の上限です
+    /// これを超える精度は上限に切り詰めます
+    constexpr size_t FORMAT_PRECISION_MAX = 128;
+
+    /// 書式の1区間です
+    /// 直前の文字列と、埋め込む引数の書式指定を持ちます
+    struct FormatField
+    {
+        size_t literal = 0;                   ///< 直前の文字列の位置
+        size_t literalCount = 0;              ///< 直前の文字列の文字数
+        size_t argument = FORMAT_NO_ARGUMENT; ///< 埋め込む引数の添え字
+        size_t width = 0;                     ///< 最小の幅
+        i32 precision = -1;                   ///< 精度 指定が無い場合は負
+        Char fill = ' ';                      ///< 幅を埋める文字
+        Char align = NULL_CHAR;               ///< 揃え 指定が無い場合はヌル文字
+        Char type = NULL_CHAR;                ///< 型 指定が無い場合はヌル文字
+        bool zero = false;                    ///< 符号の後を0で埋めるか
+        bool alternate = false;               ///< 基数の接頭辞を付けるか
+    };
+
+    // 書式の誤りを出力します
+    // constexprでないため、コンパイル時の解析中に呼ばれるとコンパイルエラーになります
+    inline void _formatError(const Char *message)
+    {
+        printError(message);
+    }
+
+    // ヌル終端文字列の文字数を返します
+    constexpr size_t _formatLength(const Char *format)
+    {
+        size_t count = 0;
+        while(format[count] != NULL_CHAR) count++;
+        return count;
+    }
+
+    // 10進数を読み、位置を進めます
+    constexpr size_t _parseFormatNumber(const Char *format, size_t count, size_t &index)
+    {
+        size_t result = 0;
+        while(index < count && format[index] >= '0' && format[index] <= '9')
+        {
+            result = result * 10 + (size_t) (format[index] - '0');
+            index++;
+        }
+        return result;
+    }
+
+    // 揃えの文字か判定します
+    constexpr bool _isFormatAlign(Char ch)
+    {
+        return ch == '<' || ch == '>' || ch == '^';
+    }
+
+    // 型の文字か判定します
+    constexpr bool _isFormatType(Char ch)
+    {
+        return ch == 'x' || ch == 'X' || ch == 'b' || ch == 'o' ||
+               ch == 'f' || ch == 'e' || ch == 'E' || ch == 'g' || ch == 'G';
+    }
+
+    // 書式の次の区間を解析します
+    // 誤りがある場合はエラーを出力し、その区間を文字列として扱います
+    // @param index 区間の先頭の位置
+    // @param [in,out] nextArgument 添え字を省略した場合の引数の添え字
+    // @param [out] field 解析した区間
+    // @return 次の区間の先頭の位置
+    constexpr size_t _parseFormatField(const Char *format, size_t count, size_t index, size_t &nextArgument, FormatField &field)
+    {
+        field = FormatField();
+        field.literal = index;
+        auto i = index;
+        while(i < count && format[i] != '{' && format[i] != '}') i++;
+        field.literalCount = i - index;
+        if(i == count) return count;
+
+        // 二重の括弧は括弧1つを文字列とする
+        if(i + 1 < count && format[i + 1] == format[i])
+        {
+            field.literalCount++;
+            return i + 2;
+        }
+        if(format[i] == '}')
+        {
+            _formatError("unmatched '}' in format string. size_t _parseFormatField(const Char *format, size_t count, size_t index, size_t &nextArgument, FormatField &field)");
+            field.literalCount++;
+            return i + 1;
+        }
+
+        // 引数の添え字
+        i++;
+        if(i < count && format[i] >= '0' && format[i] <= '9') field.argument = _parseFormatNumber(format, count, i);
+        else field.argument = nextArgument;
+        nextArgument = field.argument + 1;
+
+        // 書式指定
+        auto valid = true;
+        if(i < count && format[i] == ':')
+        {
+            i++;
+            if(i + 1 < count && format[i] != '}' && _isFormatAlign(format[i + 1]))
+            {
+                field.fill = format[i];
+                field.align = format[i + 1];
+                i += 2;
+            }
+            else if(i < count && _isFormatAlign(format[i]))
+            {
+                field.align = format[i];
+                i++;
+            }
+            if(i < count && format[i] == '#')
+            {
+                field.alternate = true;
+                i++;
+            }
+            if(i < count && format[i] == '0')
+            {
+                field.zero = true;
+                i++;
+            }
+            field.width = _parseFormatNumber(format, count, i);
+            if(i < count && format[i] == '.')
+            {
+                auto digits = ++i;
+                auto precision = _parseFormatNumber(format, count, i);
+                valid = digits != i;
+                field.precision = (i32) (precision < FORMAT_PRECISION_MAX ? precision : FORMAT_PRECISION_MAX);
+            }
+            if(i < count && _isFormatType(format[i]))
+            {
+                field.type = format[i];
+                i++;
+            }
+        }
+        if(valid && i < count && format[i] == '}') return i + 1;
+
+        _formatError("invalid format field. size_t _parseFormatField(const Char *format, size_t count, size_t index, size_t &nextArgument, FormatField &field)");
+        while(i < count && format[i] != '}') i++;
+        if(i < count) i++;
+        field.argument = FORMAT_NO_ARGUMENT;
+        field.literalCount = i - index;
+        return i;
+    }
+
+    // 書式の区間の数を返します
+    constexpr size_t _formatFieldCount(const Char *format)
+    {
+        auto count = _formatLength(format);
+        size_t fields = 0;
+        size_t nextArgument = 0;
+        FormatField field;
+        for(size_t i = 0; i < count; fields++) i = _parseFormatField(format, count, i, nextArgument, field);
+        return fields ? fields : 1;
+    }
+
+    // 書式が必要とする引数の数を返します
+    constexpr size_t _formatArgumentCount(const Char *format)
+    {
+        auto count = _formatLength(format);
+        size_t result = 0;
+        size_t nextArgument = 0;
+        FormatField field;
+        for(size_t i = 0; i < count;)
+        {
+            i = _parseFormatField(format, count, i, nextArgument, field);
+            if(field.argument != FORMAT_NO_ARGUMENT && field.argument + 1 > result) result = field.argument + 1;
+        }
+        return result;
+    }
+
+    /// 解析済みの書式です
+    /// ELEKI_FORMATで文字列リテラルから生成してください
+    /// @tparam F 区間の数
+    /// @tparam A 必要な引数の数
+    template<size_t F, size_t A>
+    class FormatString
+    {
+        const Char *mFormat;    // 書式文字列
+        FormatField mFields[F]; // 区間
+
+    public:
+
+        /// コンストラクタ
+        /// @param format 書式文字列リテラル
+        explicit constexpr FormatString(const Char *format)
+            : mFormat(format)
+            , mFields{}
+        {
+            auto count = _formatLength(format);
+            size_t nextArgument = 0;
+            for(size_t i = 0, field = 0; i < count && field < F; field++)
+            {
+                i = _parseFormatField(format, count, i, nextArgument, mFields[field]);
+            }
+        }
+
+        /// 書式文字列を返します
+        constexpr const Char *data() const
+        {
+            return mFormat;
+        }
+
+        /// 区間を返します
+        constexpr const FormatField *fields() const
+        {
+            return mFields;
+        }
+    };
+
+    /// 書式の出力先のインターフェースです
+    class IFormatOutput
+    {
+    public:
+
+        /// 文字列を書き込みます
+        /// @param string 文字列の先頭
+        /// @param count 文字数
+        virtual void write(const Char *string, size_t count) = 0;
+
+        /// 同じ文字を繰り返し書き込みます
+        /// @param ch 文字
+        /// @param count 繰り返す数
+        virtual void write(Char ch, size_t count) = 0;
+    };
+
+    // SmallStringの末尾へ書き込む出力先
+    template<size_t N>
+    class _SmallStringFormatOutput: public IFormatOutput
+    {
+        SmallString<N> &mString; // 出力先
+
+    public:
+
+        _SmallStringFormatOutput(SmallString<N> &string)
+            : mString(string)
+        {}
+
+        void write(const Char *string, size_t count) override
+        {
+            mString.append(string, count);
+        }
+
+        void write(Char ch, size_t count) override
+        {
+            mString.append(ch, count);
+        }
+    };
+
+    // 固定長の領域へ書き込む出力先
+    // 溢れた分は書き込まず、必要な文字数のみを数える
+    class _BufferFormatOutput: public IFormatOutput
+    {
+        Char *mBuffer;    // 出力先
+        size_t mCapacity; // 書き込める文字数
+        size_t mCount;    // 必要な文字数
+
+    public:
+
+        _BufferFormatOutput(Char *buffer, size_t capacity)
+            : mBuffer(buffer)
+            , mCapacity(capacity)
+            , mCount(0)
+        {}
+
+        void write(const Char *string, size_t count) override
+        {
+            auto rest = mCount < mCapacity ? mCapacity - mCount : 0;
+            auto written = count < rest ? count : rest;
+            for(size_t i = 0; i < written; i++) mBuffer[mCount + i] = string[i];
+            mCount += count;
+        }
+
+        void write(Char ch, size_t count) override
+        {
+            auto rest = mCount < mCapacity ? mCapacity - mCount : 0;
+            auto written = count < rest ? count : rest;
+            for(size_t i = 0; i < written; i++) mBuffer[mCount + i] = ch;
+            mCount += count;
+        }
+
+        // 必要な文字数を返す
+        size_t count() const
+        {
+            return mCount;
+        }
+
+        // 書き込んだ文字数を返す
+        size_t written() const
+        {
+            return mCount < mCapacity ? mCount : mCapacity;
+        }
+    };
+
+    /// 文字列を書式に従って書き込みます
+    void ELEKICORE_EXPORT formatString(IFormatOutput &output, StringView value, const FormatField &field);
+
+    /// 整数を書式に従って書き込みます
+    void ELEKICORE_EXPORT formatInteger(IFormatOutput &output, i64 value, const FormatField &field);
+
+    /// 整数を書式に従って書き込みます
+    void ELEKICORE_EXPORT formatInteger(IFormatOutput &output, u64 value, const FormatField &field);
+
+    /// 浮動小数点数を書式に従って書き込みます
+    void ELEKICORE_EXPORT formatFloat(IFormatOutput &output, f32 value, const FormatField &field);
+
+    /// 浮動小数点数を書式に従って書き込みます
+    void ELEKICORE_EXPORT formatFloat(IFormatOutput &output, f64 value, const FormatField &field);
+
+    /// 書式に値を書き込む特殊化構造体です
+    /// 独自の型は特殊化し、formatStringなどでIFormatOutputに書き込んでください
+    /// 特殊化していない型は、ToStringで文字列に変換してから書き込みます
+    template<class T>
+    struct Formatter
+    {
+        /// 書き込みます
+        void operator()(IFormatOutput &output, const T &value, const FormatField &field)
+        {
+            if constexpr(std::is_same_v<T, bool>)
+            {
+                formatString(output, value ? StringView(TXT("true"), 4) : StringView(TXT("false"), 5), field);
+            }
+            else if constexpr(std::is_same_v<T, Char>)
+            {
+                formatString(output, StringView(&value, 1), field);
+            }
+            else if constexpr(std::is_enum_v<T>)
+            {
+                Formatter<std::underlying_type_t<T>>{}(output, (std::underlying_type_t<T>) value, field);
+            }
+            else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                formatInteger(output, (i64) value, field);
+            }
+            else if constexpr(std::is_integral_v<T>)
+            {
+                formatInteger(output, (u64) value, field);
+            }
+            else if constexpr(std::is_same_v<T, f32>)
+            {
+                formatFloat(output, value, field);
+            }
+            else if constexpr(std::is_floating_point_v<T>)
+            {
+                formatFloat(output, (f64) value, field);
+            }
+            else if constexpr(std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, Char>)
+            {
+                formatString(output, StringView(value), field);
+            }
+            else if constexpr(std::is_pointer_v<T> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, Char>)
+            {
+                formatString(output, StringView(value), field);
+            }
+            else if constexpr(std::is_pointer_v<T>)
+            {
+                // ポインタは接頭辞付きの16進数にする
+                auto hex = field;
+                hex.alternate = true;
+                if(!hex.type) hex.type = 'x';
+                formatInteger(output, (u64) (uintptr_t) value, hex);
+            }
+            else
+            {
+                formatString(output, ToString<T>{}(value).view(), field);
+            }
+        }
+    };
+
+    /// 書式に値を書き込む特殊化構造体です
+    template<>
+    struct Formatter<String>
+    {
+        /// 書き込みます
+        void operator()(IFormatOutput &output, const String &value, const FormatField &field)
+        {
+            formatString(output, value.view(), field);
+        }
+    };
+
+    /// 書式に値を書き込む特殊化構造体です
+    template<>
+    struct Formatter<StringView>
+    {
+        /// 書き込みます
+        void operator()(IFormatOutput &output, const StringView &value, const FormatField &field)
+        {
+            formatString(output, value, field);
+        }
+    };
+
+    /// 書式に値を書き込む特殊化構造体です
+    template<size_t N>
+    struct Formatter<SmallString<N>>
+    {
+        /// 書き込みます
+        void operator()(IFormatOutput &output, const SmallString<N> &value, const FormatField &field)
+        {
+            formatString(output, value.view(), field);
+        }
+    };
+
+    // 型を消去した引数
+    struct _FormatArgument
+    {
+        const void *value;                                                                   // 値
+        void (*write)(IFormatOutput &output, const void *value, const FormatField &field); // 書き込む関数
+    };
+
+    // 引数を書き込みます
+    template<class T>
+    void _writeFormatArgument(IFormatOutput &output, const void *value, const FormatField &field)
+    {
+        Formatter<T>{}(output, *(const T *) value, field);
+    }
+
+    // 型を消去した引数を作成します
+    template<class T>
+    _FormatArgument _makeFormatArgument(const T &value)
+    {
+        return _FormatArgument{ &value, &_writeFormatArgument<T> };
+    }
+
+    // 解析済みの区間に従って書き込みます
+    void ELEKICORE_EXPORT _formatFields(IFormatOutput &output, const Char *format, const FormatField *fields, size_t fieldCount, const _FormatArgument *arguments, size_t argumentCount);
+
+    // 書式を解析しながら書き込みます
+    void ELEKICORE_EXPORT _formatRuntime(IFormatOutput &output, StringView format, const _FormatArgument *arguments, size_t argumentCount);
+
+    /// 書式に値を埋め込み、末尾に連結します
+    /// StringBuilderにも使用できます
+    /// @param string 連結先
+    /// @param format ELEKI_FORMATで解析した書式
+    /// @param values 埋め込む値
+    template<size_t N, size_t F, size_t A, class...Ts>
+    SmallString<N> &formatTo(SmallString<N> &string, const FormatString<F, A> &format, const Ts &...values)
+    {
+        static_assert(A <= sizeof...(Ts), "too few format arguments. SmallString<N> &formatTo(SmallString<N> &string, const FormatString<F, A> &format, const Ts &...values)");
+        _SmallStringFormatOutput<N> output(string);
+        const _FormatArgument arguments[] = { _makeFormatArgument(values)..., _FormatArgument{ nullptr, nullptr } };
+        _formatFields(output, format.data(), format.fields(), F, arguments, sizeof...(Ts));
+        return string;
+    }
+
+    /// 書式に値を埋め込み、末尾に連結します
+    /// 書式は実行時に解析し、誤りと範囲外の添え字はエラーを出力します
+    /// @param string 連結先
+    /// @param format 書式
+    /// @param values 埋め込む値
+    template<size_t N, class...Ts>
+    SmallString<N> &formatTo(SmallString<N> &string, StringView format, const Ts &...values)
+    {
+        _SmallStringFormatOutput<N> output(string);
+        const _FormatArgument arguments[] = { _makeFormatArgument(values)..., _FormatArgument{ nullptr, nullptr } };
+        _formatRuntime(output, format, arguments, sizeof...(Ts));
+        return string;
+    }
+
+    /// 書式に値を埋め込み、固定長の領域に書き込みます
+    /// 常にヌル終端し、収まらない分は切り捨てます
+    /// @param buffer 書き込み先
+    /// @param count 書き込み先の文字数 ヌル終端を含みます
+    /// @param format ELEKI_FORMATで解析した書式
+    /// @param values 埋め込む値
+    /// @return 切り捨てずに書き込むのに必要な文字数 ヌル終端を含みません
+    template<size_t F, size_t A, class...Ts>
+    size_t formatTo(Char *buffer, size_t count, const FormatString<F, A> &format, const Ts &...values)
+    {
+        static_assert(A <= sizeof...(Ts), "too few format arguments. size_t formatTo(Char *buffer, size_t count, const FormatString<F, A> &format, const Ts &...values)");
+        _BufferFormatOutput output(buffer, count ? count - 1 : 0);
+        const _FormatArgument arguments[] = { _makeFormatArgument(values)..., _FormatArgument{ nullptr, nullptr } };
+        _formatFields(output, format.data(), format.fields(), F, arguments, sizeof...(Ts));
+        if(count) buffer[output.written()] = NULL_CHAR;
+        return output.count();
+    }
+
+    /// 書式に値を埋め込み、固定長の領域に書き込みます
+    /// 書式は実行時に解析します
+    /// @return 切り捨てずに書き込むのに必要な文字数 ヌル終端を含みません
+    template<class...Ts>
+    size_t formatTo(Char *buffer, size_t count, StringView format, const Ts &...values)
+    {
+        _BufferFormatOutput output(buffer, count ? count - 1 : 0);
+        const _FormatArgument arguments[] = { _makeFormatArgument(values)..., _FormatArgument{ nullptr, nullptr } };
+        _formatRuntime(output, format, arguments, sizeof...(Ts));
+        if(count) buffer[output.written()] = NULL_CHAR;
+        return output.count();
+    }
+
+    /// 書式に値を埋め込んだ文字列を返します
+    /// インターンは完成した文字列に対して1度だけ行います
+    template<size_t F, size_t A, class...Ts>
+    String format(const FormatString<F, A> &format, const Ts &...values)
+    {
+        StringBuilder builder;
+        return formatTo(builder, format, values...).toString();
+    }
+
+    /// 書式に値を埋め込んだ文字列を返します
+    /// 書式は実行時に解析します
+    template<class...Ts>
+    String format(StringView format, const Ts &...values)
+    {
+        StringBuilder builder;
+        return formatTo(builder, format, values...).toString();
+    }
+
+    /// 書式に値を埋め込んでログへ出力します
+    /// 短い文字列は確保もインターンも行いません
+    template<size_t F, size_t A, class...Ts>
+    void printFormat(const FormatString<F, A> &format, const Ts &...values)
+    {
+        StringBuilder builder;
+        print(formatTo(builder, format, values...).cstr());
+    }
+
+    /// 書式に値を埋め込んでログへ出力します
+    /// 書式は実行時に解析します
+    template<class...Ts>
+    void printFormat(StringView format, const Ts &...values)
+    {
+        StringBuilder builder;
+        print(formatTo(builder, format, values...).cstr());
+    }
+
+    /// 書式に値を埋め込んでエラーログへ出力します
+    /// 短い文字列は確保もインターンも行いません
+    template<size_t F, size_t A, class...Ts>
+    void printErrorFormat(const FormatString<F, A> &format, const Ts &...values)
+    {
+        StringBuilder builder;
+        printError(formatTo(builder, format, values...).cstr());
+    }
+
+    /// 書式に値を埋め込んでエラーログへ出力します
+    /// 書式は実行時に解析します
+    template<class...Ts>
+    void printErrorFormat(StringView format, const Ts &...values)
+    {
+        StringBuilder builder;
+        printError(formatTo(builder, format, values...).cstr());
+    }
+
+    // 書式に値を埋め込みます
+    // @param values 埋め込む値
+    template<class...Ts>
+    String String::format(Ts...values) const
+    {
+        return ElekiEngine::format(view(), values...);
+    }
+
+}
+
+#endif // !ELEKICORE_FORMAT_HPP
\ No newline at end of file
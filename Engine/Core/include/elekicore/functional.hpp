@@ -15,6 +15,28 @@ namespace ElekiEngine
     template<class S> using Func = std::function<S>;                    ///< 関数オブジェクト型エイリアス
     template<class T> using Compare = Func<bool(const T &, const T &)>; ///< 比較関数オブジェクト型エイリアス
 
+    /// 小さいか判定する特殊化構造体です
+    template<class T>
+    struct Less
+    {
+        /// 左辺が右辺より小さいか判定します
+        bool operator()(const T &l, const T &r) const
+        {
+            return l < r;
+        }
+    };
+
+    /// 等しいか判定する特殊化構造体です
+    template<class T>
+    struct Equal
+    {
+        /// 左辺と右辺が等しいか判定します
+        bool operator()(const T &l, const T &r) const
+        {
+            return l == r;
+        }
+    };
+
     /// 仮名
     namespace Placeholders = std::placeholders;
 
@@ -0,0 +1,162 @@
+/// @file handletable.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 世代番号で無効な参照を検出するハンドル表を提供します
+
+#ifndef ELEKICORE_HANDLETABLE_HPP
+#define ELEKICORE_HANDLETABLE_HPP
+
+#include <utility>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "array.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// ハンドル型エイリアスです
+    /// 下位32ビットが表の位置、上位32ビットが世代番号です
+    using Handle = u64;
+
+    /// 無効なハンドルです
+    constexpr Handle INVALID_HANDLE = 0;
+
+    /// 値をハンドルで参照する表を提供します
+    /// 削除した位置は再利用し、世代番号で削除済みのハンドルを検出します
+    /// 値は既定構築可能である必要があります
+    template<class T>
+    class HandleTable
+    {
+        // 空き位置の番兵
+        static constexpr u32 NO_FREE = 0xFFFFFFFF;
+
+        // 表の要素
+        struct Slot
+        {
+            T value;        // 値
+            u32 generation; // 世代番号 奇数のとき使用中
+            u32 nextFree;   // 次の空き位置
+        };
+
+        List<Slot> mSlots; // 要素配列
+        u32 mFreeTop;      // 先頭の空き位置
+        size_t mCount;     // 使用中の要素数
+
+        // ハンドルから要素を取得する
+        Slot *slotOf(Handle handle) const
+        {
+            auto index = (size_t) (handle & 0xFFFFFFFF);
+            if(index >= mSlots.count()) return nullptr;
+            auto slot = (Slot *) &mSlots.data()[index];
+            return slot->generation == (u32) (handle >> 32) && (slot->generation & 1) ? slot : nullptr;
+        }
+
+    public:
+
+        /// コンストラクタ
+        /// @param allocator アロケータ
+        HandleTable(IAllocator *allocator = Memory::allocator())
+            : mSlots(allocator)
+            , mFreeTop(NO_FREE)
+            , mCount(0)
+        {}
+
+        /// 値を追加します
+        /// @return 値を参照するハンドル
+        Handle add(const T &value)
+        {
+            T tmp = value;
+            return add(std::move(tmp));
+        }
+
+        /// 値を追加します
+        /// @return 値を参照するハンドル
+        Handle add(T &&value)
+        {
+            u32 index;
+            if(mFreeTop != NO_FREE)
+            {
+                // 空き位置を再利用する 世代番号を使用中に進める
+                index = mFreeTop;
+                auto &slot = mSlots.data()[index];
+                mFreeTop = slot.nextFree;
+                slot.value = std::move(value);
+                slot.generation++;
+                slot.nextFree = NO_FREE;
+            }
+            else
+            {
+                if(mSlots.count() >= NO_FREE)
+                {
+                    printError("table is full. Handle HandleTable<T>::add(T &&value)");
+                    return INVALID_HANDLE;
+                }
+                index = (u32) mSlots.count();
+                mSlots.add(Slot{ std::move(value), 1, NO_FREE });
+            }
+            mCount++;
+            return (Handle) mSlots.data()[index].generation << 32 | index;
+        }
+
+        /// ハンドルが参照する値を削除します
+        /// @retval false 無効なハンドルでした
+        bool remove(Handle handle)
+        {
+            auto slot = slotOf(handle);
+            if(!slot) return false;
+
+            // 世代番号を未使用に進め、空き位置に繋ぐ
+            // 使用中の番号は奇数のため、1周しても無効なハンドルと一致しない
+            slot->value = T();
+            slot->generation++;
+            slot->nextFree = mFreeTop;
+            mFreeTop = (u32) (handle & 0xFFFFFFFF);
+            mCount--;
+            return true;
+        }
+
+        /// ハンドルが参照する値を取得します
+        /// @return 値 無効なハンドルの場合nullptr
+        T *find(Handle handle)
+        {
+            auto slot = slotOf(handle);
+            return slot ? &slot->value : nullptr;
+        }
+
+        /// ハンドルが参照する値を取得します
+        /// @return 値 無効なハンドルの場合nullptr
+        const T *find(Handle handle) const
+        {
+            auto slot = slotOf(handle);
+            return slot ? &slot->value : nullptr;
+        }
+
+        /// ハンドルが有効か判定します
+        bool contains(Handle handle) const
+        {
+            return slotOf(handle) != nullptr;
+        }
+
+        /// 使用中の要素数を返します
+        size_t count() const
+        {
+            return mCount;
+        }
+
+        /// すべての値を削除します
+        /// 削除前のハンドルは無効になります
+        void clear()
+        {
+            for(size_t i = 0; i < mSlots.count(); i++)
+            {
+                auto handle = (Handle) mSlots.data()[i].generation << 32 | i;
+                remove(handle);
+            }
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_HANDLETABLE_HPP
\ No newline at end of file
@@ -1,15 +1,23 @@
 /// @file hash.hpp
-/// @version 1.22.5
+/// @version 1.22.6
 /// @copyright © 2022 Taichi Ito
 /// ハッシュ生成特殊化クラス、生成関数を提供します
 
 #ifndef ELEKICORE_HASH_HPP
 #define ELEKICORE_HASH_HPP
 
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <utility>
 #include "preprocess.hpp"
 #include "integer.hpp"
 #include "floatingpoint.hpp"
 
+#if ELEKI_COMPILER_VC
+#include <intrin.h>
+#endif
+
 /// ELEKi ENGINE
 namespace ElekiEngine
 {
@@ -56,15 +64,151 @@ namespace ElekiEngine
     size_t ELEKICORE_EXPORT f64ToHash(const f64 &value);
     /// ハッシュ値を返します
     size_t ELEKICORE_EXPORT boolToHash(const bool &value);
+    // 長いバイト列のハッシュ値を返す
+    u64 ELEKICORE_EXPORT _bytesToHashLong(const u8 *bytes, size_t size, u64 seed);
+
+    /// 整数をよく混ぜ合わせたハッシュ値を返します
+    /// 連続した値も全ビットに散らばるため、剰余やマスクでバケットを選ぶ表に使用できます
+    /// 全単射のため、異なる値が衝突することはありません
+    constexpr u64 mixHash(u64 value)
+    {
+        // splitmix64の最終化関数
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    // 64ビット同士の積を求め、下位を左辺に、上位を右辺に格納する
+    inline void _hashMultiply(u64 &l, u64 &r)
+    {
+    #if defined(__SIZEOF_INT128__)
+        auto product = (unsigned __int128) l * r;
+        l = (u64) product;
+        r = (u64) (product >> 64);
+    #elif ELEKI_COMPILER_VC && ELEKI_OS_WINDOWS64
+        l = _umul128(l, r, &r);
+    #else
+        auto ll = l & 0xFFFFFFFF, lh = l >> 32, rl = r & 0xFFFFFFFF, rh = r >> 32;
+        auto lowLow = ll * rl, lowHigh = ll * rh, highLow = lh * rl, highHigh = lh * rh;
+        auto middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFF) + (highLow & 0xFFFFFFFF);
+        l = (lowLow & 0xFFFFFFFF) | (middle << 32);
+        r = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+    #endif
+    }
+
+    // 64ビット同士の積の上位と下位を排他的論理和で畳み込む
+    inline u64 _hashMix(u64 l, u64 r)
+    {
+        _hashMultiply(l, r);
+        return l ^ r;
+    }
+
+    // ハッシュ値の計算に使用する乱数定数
+    constexpr u64 _HASH_SECRET[4] = { 0x2D358DCCAA6C78A5ull, 0x8BB84B93962EACC9ull, 0x4B33A62ED433D4A3ull, 0x4D5A2DA51DE1AA47ull };
+
+    // 専用の処理に切り替えるバイト列長
+    constexpr size_t _HASH_LONG_SIZE = 240;
+
+    // リトルエンディアンで8バイト読み込む
+    inline u64 _hashRead8(const u8 *bytes)
+    {
+        u64 value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    // リトルエンディアンで4バイト読み込む
+    inline u64 _hashRead4(const u8 *bytes)
+    {
+        u32 value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    /// 2つのハッシュ値を混ぜ合わせます
+    /// 順序を区別するため、入れ替えると異なる値になります
+    /// @param seed これまでのハッシュ値
+    /// @param value 混ぜ合わせるハッシュ値
+    inline size_t hashCombine(size_t seed, size_t value)
+    {
+        return (size_t) _hashMix((u64) seed ^ _HASH_SECRET[0], (u64) value ^ _HASH_SECRET[1]);
+    }
+
+    /// バイト列のハッシュ値を返します
+    /// 短いバイト列はwyhashと同じ構成で処理し、長いバイト列は8レーンの累積をSIMD命令で処理します
+    /// 結果は命令セットによらず同じ値です
+    /// @param bytes バイト列の先頭
+    /// @param size バイト数
+    /// @param seed シード
+    inline size_t bytesToHash(const void *bytes, size_t size, u64 seed = 0)
+    {
+        auto data = (const u8 *) bytes;
+        if(size > _HASH_LONG_SIZE) return (size_t) _bytesToHashLong(data, size, seed);
+
+        seed ^= _hashMix(seed ^ _HASH_SECRET[0], _HASH_SECRET[1]);
+        u64 a, b;
+        if(size <= 16)
+        {
+            if(size >= 4)
+            {
+                // 重なりを許して先頭と末尾から4バイトずつ読む
+                auto offset = (size >> 3) << 2;
+                a = (_hashRead4(data) << 32) | _hashRead4(data + offset);
+                b = (_hashRead4(data + size - 4) << 32) | _hashRead4(data + size - 4 - offset);
+            }
+            else if(size > 0)
+            {
+                a = ((u64) data[0] << 16) | ((u64) data[size >> 1] << 8) | data[size - 1];
+                b = 0;
+            }
+            else
+            {
+                a = 0;
+                b = 0;
+            }
+        }
+        else
+        {
+            auto rest = size;
+            if(rest > 48)
+            {
+                // 3本の独立した連鎖で48バイトずつ処理する
+                auto seed1 = seed, seed2 = seed;
+                do
+                {
+                    seed = _hashMix(_hashRead8(data) ^ _HASH_SECRET[1], _hashRead8(data + 8) ^ seed);
+                    seed1 = _hashMix(_hashRead8(data + 16) ^ _HASH_SECRET[2], _hashRead8(data + 24) ^ seed1);
+                    seed2 = _hashMix(_hashRead8(data + 32) ^ _HASH_SECRET[3], _hashRead8(data + 40) ^ seed2);
+                    data += 48;
+                    rest -= 48;
+                }
+                while(rest > 48);
+                seed ^= seed1 ^ seed2;
+            }
+            while(rest > 16)
+            {
+                seed = _hashMix(_hashRead8(data) ^ _HASH_SECRET[1], _hashRead8(data + 8) ^ seed);
+                data += 16;
+                rest -= 16;
+            }
+            a = _hashRead8(data + rest - 16);
+            b = _hashRead8(data + rest - 8);
+        }
+        a ^= _HASH_SECRET[1];
+        b ^= seed;
+        _hashMultiply(a, b);
+        return (size_t) _hashMix(a ^ _HASH_SECRET[0] ^ size, b ^ _HASH_SECRET[1]);
+    }
 
     /// ハッシュ特殊化構造体です
     template<>
     struct Hash<i8>
     {
         /// ハッシュ値を返します
-        size_t operator()(const i8 &value)
+        size_t operator()(const i8 &value) const
         {
-            return i8ToHash(value);
+            return (size_t) mixHash((u64) value);
         }
     };
 
@@ -73,9 +217,9 @@ namespace ElekiEngine
     struct Hash<u8>
     {
         /// ハッシュ値を返します
-        size_t operator()(const u8 &value)
+        size_t operator()(const u8 &value) const
         {
-            return u8ToHash(value);
+            return (size_t) mixHash((u64) value);
         }
     };
 
@@ -84,9 +228,9 @@ namespace ElekiEngine
     struct Hash<i16>
     {
         /// ハッシュ値を返します
-        size_t operator()(const i16 &value)
+        size_t operator()(const i16 &value) const
         {
-            return i16ToHash(value);
+            return (size_t) mixHash((u64) value);
         }
     };
 
@@ -95,9 +239,9 @@ namespace ElekiEngine
     struct Hash<u16>
     {
         /// ハッシュ値を返します
-        size_t operator()(const u16 &value)
+        size_t operator()(const u16 &value) const
         {
-            return u16ToHash(value);
+            return (size_t) mixHash((u64) value);
         }
     };
 
@@ -106,9 +250,9 @@ namespace ElekiEngine
     struct Hash<i32>
     {
         /// ハッシュ値を返します
-        size_t operator()(const i32 &value)
+        size_t operator()(const i32 &value) const
         {
-            return i32ToHash(value);
+            return (size_t) mixHash((u64) value);
         }
     };
 
@@ -117,9 +261,9 @@ namespace ElekiEngine
     struct Hash<u32>
     {
         /// ハッシュ値を返します
-        size_t operator()(const u32 &value)
+        size_t operator()(const u32 &value) const
         {
-            return u32ToHash(value);
+            return (size_t) mixHash((u64) value);
         }
     };
 
@@ -128,9 +272,9 @@ namespace ElekiEngine
     struct Hash<i64>
     {
         /// ハッシュ値を返します
-        size_t operator()(const i64 &value)
+        size_t operator()(const i64 &value) const
         {
-            return i64ToHash(value);
+            return (size_t) mixHash((u64) value);
         }
     };
 
@@ -139,9 +283,9 @@ namespace ElekiEngine
     struct Hash<u64>
     {
         /// ハッシュ値を返します
-        size_t operator()(const u64 &value)
+        size_t operator()(const u64 &value) const
         {
-            return u64ToHash(value);
+            return (size_t) mixHash((u64) value);
         }
     };
 
@@ -150,9 +294,13 @@ namespace ElekiEngine
     struct Hash<f32>
     {
         /// ハッシュ値を返します
-        size_t operator()(const f32 &value)
+        size_t operator()(const f32 &value) const
         {
-            return f32ToHash(value);
+            // 0と-0は等しいため、同じハッシュ値にする
+            if(value == 0) return (size_t) mixHash(0);
+            u32 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return (size_t) mixHash((u64) bits);
         }
     };
 
@@ -161,9 +309,13 @@ namespace ElekiEngine
     struct Hash<f64>
     {
         /// ハッシュ値を返します
-        size_t operator()(const f64 &value)
+        size_t operator()(const f64 &value) const
         {
-            return f64ToHash(value);
+            // 0と-0は等しいため、同じハッシュ値にする
+            if(value == 0) return (size_t) mixHash(0);
+            u64 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return (size_t) mixHash((u64) bits);
         }
     };
 
@@ -172,9 +324,9 @@ namespace ElekiEngine
     struct Hash<bool>
     {
         /// ハッシュ値を返します
-        size_t operator()(const bool &value)
+        size_t operator()(const bool &value) const
         {
-            return boolToHash(value);
+            return (size_t) mixHash((u64) value);
         }
     };
 
@@ -183,9 +335,9 @@ namespace ElekiEngine
     struct Hash<char>
     {
         /// ハッシュ値を返します
-        size_t operator()(const char &value)
+        size_t operator()(const char &value) const
         {
-            return u8ToHash((u8)value);
+            return (size_t) mixHash((u64) (u8) value);
         }
     };
 
@@ -194,9 +346,9 @@ namespace ElekiEngine
     struct Hash<wchar_t>
     {
         /// ハッシュ値を返します
-        size_t operator()(const wchar_t &value)
+        size_t operator()(const wchar_t &value) const
         {
-            return u32ToHash((u32)value);
+            return (size_t) mixHash((u64) (u32) value);
         }
     };
 
@@ -205,9 +357,9 @@ namespace ElekiEngine
     struct Hash<char16_t>
     {
         /// ハッシュ値を返します
-        size_t operator()(const char16_t &value)
+        size_t operator()(const char16_t &value) const
         {
-            return u16ToHash((u16)value);
+            return (size_t) mixHash((u64) (u16) value);
         }
     };
 
@@ -216,9 +368,57 @@ namespace ElekiEngine
     struct Hash<char32_t>
     {
         /// ハッシュ値を返します
-        size_t operator()(const char32_t &value)
+        size_t operator()(const char32_t &value) const
+        {
+            return (size_t) mixHash((u64) (u32) value);
+        }
+    };
+
+    /// ハッシュ特殊化構造体です
+    /// アドレスを混ぜ合わせ、アラインメントで常に0となる下位ビットを全体へ広げます
+    /// 参照先の型を使わないため、前方宣言のみの型へのポインタも使えます
+    template<class T>
+    struct Hash<T *>
+    {
+        /// ハッシュ値を返します
+        size_t operator()(T *const &value) const
+        {
+            auto address = (u64) reinterpret_cast<uintptr_t>(value);
+            return (size_t) mixHash(address);
+        }
+    };
+
+    /// ハッシュ特殊化構造体です
+    template<class A, class B>
+    struct Hash<std::pair<A, B>>
+    {
+        /// ハッシュ値を返します
+        size_t operator()(const std::pair<A, B> &value) const
+        {
+            return hashCombine(Hash<A>{}(value.first), Hash<B>{}(value.second));
+        }
+    };
+
+    /// ハッシュ特殊化構造体です
+    /// 要素のハッシュ値を先頭から順に混ぜ合わせます
+    template<class...Ts>
+    struct Hash<std::tuple<Ts...>>
+    {
+        /// ハッシュ値を返します
+        size_t operator()(const std::tuple<Ts...> &value) const
+        {
+            return combine(value, std::index_sequence_for<Ts...>{});
+        }
+
+    private:
+
+        // 要素のハッシュ値を混ぜ合わせる
+        template<size_t...Is>
+        static size_t combine(const std::tuple<Ts...> &value, std::index_sequence<Is...>)
         {
-            return u32ToHash((u32)value);
+            size_t result = sizeof...(Ts);
+            ((result = hashCombine(result, Hash<std::tuple_element_t<Is, std::tuple<Ts...>>>{}(std::get<Is>(value)))), ...);
+            return result;
         }
     };
 }
@@ -0,0 +1,721 @@
+/// @file intrusive.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 要素に埋め込んだフックで連結する侵入型コンテナを提供します
+/// 要素の追加と削除でメモリの確保と解放を行いません
+
+#ifndef ELEKICORE_INTRUSIVE_HPP
+#define ELEKICORE_INTRUSIVE_HPP
+
+#include <utility>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "bit.hpp"
+#include "hash.hpp"
+#include "functional.hpp"
+#include "view.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    // フックのメンバポインタから要素のポインタを求める
+    template<class T, class H, H T::*M>
+    T *_intrusiveOwner(H *hook)
+    {
+        // 0番地を避けた仮の要素からメンバの位置を求める
+        constexpr size_t PROBE = 0x1000;
+        auto offset = (size_t) &(((T *) PROBE)->*M) - PROBE;
+        return (T *) ((u8 *) hook - offset);
+    }
+
+    /// 侵入型リストのフックです
+    /// 要素のメンバとして宣言し、IntrusiveList<T, &T::hook>に渡します
+    /// コピーしても連結状態はコピーされません
+    class IntrusiveListHook
+    {
+        template<class T, IntrusiveListHook T::*H> friend class IntrusiveList;
+
+        IntrusiveListHook *mPrev; // 前のフック
+        IntrusiveListHook *mNext; // 次のフック
+
+    public:
+
+        /// コンストラクタ
+        IntrusiveListHook()
+            : mPrev(nullptr)
+            , mNext(nullptr)
+        {}
+
+        /// コピーコンストラクタ
+        IntrusiveListHook(const IntrusiveListHook &)
+            : IntrusiveListHook()
+        {}
+
+        /// デストラクタ
+        ~IntrusiveListHook()
+        {
+            if(mNext) printError("hook is still linked. IntrusiveListHook::~IntrusiveListHook()");
+        }
+
+        /// コピー代入します
+        /// 連結状態は変更しません
+        IntrusiveListHook &operator=(const IntrusiveListHook &)
+        {
+            return *this;
+        }
+
+        /// リストに連結されているか判定します
+        bool linked() const
+        {
+            return mNext != nullptr;
+        }
+    };
+
+    /// 侵入型の双方向循環リストを提供します
+    /// 要素に埋め込んだフックで連結するため、追加と削除で確保を行いません
+    /// 要素の寿命は呼び出し元が管理し、破棄する前にリストから削除してください
+    /// @tparam H 要素のフックのメンバポインタ
+    template<class T, IntrusiveListHook T::*H>
+    class IntrusiveList
+    {
+        IntrusiveListHook mHead; // 番兵
+        size_t mCount;           // 要素数
+
+        // 要素のフックを取得する
+        static IntrusiveListHook *hookOf(T &value)
+        {
+            return &(value.*H);
+        }
+
+        // フックの前に連結する
+        static void link(IntrusiveListHook *position, IntrusiveListHook *hook)
+        {
+            hook->mPrev = position->mPrev;
+            hook->mNext = position;
+            position->mPrev->mNext = hook;
+            position->mPrev = hook;
+        }
+
+        // フックを切り離す
+        static void unlink(IntrusiveListHook *hook)
+        {
+            hook->mPrev->mNext = hook->mNext;
+            hook->mNext->mPrev = hook->mPrev;
+            hook->mPrev = nullptr;
+            hook->mNext = nullptr;
+        }
+
+        // 番兵を空の状態にする
+        void reset()
+        {
+            mHead.mPrev = &mHead;
+            mHead.mNext = &mHead;
+            mCount = 0;
+        }
+
+    public:
+
+        /// 双方向イテレータです
+        template<class R>
+        class Itr
+        {
+            friend class IntrusiveList<T, H>;
+
+            IntrusiveListHook *mHook; // 現在のフック
+
+        public:
+
+            /// コンストラクタ
+            Itr(IntrusiveListHook *hook)
+                : mHook(hook)
+            {}
+
+            /// 次に移動します
+            Itr<R> &operator++()
+            {
+                mHook = mHook->mNext;
+                return *this;
+            }
+
+            /// 前に移動します
+            Itr<R> &operator--()
+            {
+                mHook = mHook->mPrev;
+                return *this;
+            }
+
+            /// 要素を取得します
+            R &operator*() const
+            {
+                return *_intrusiveOwner<T, IntrusiveListHook, H>(mHook);
+            }
+
+            /// 要素を取得します
+            R *operator->() const
+            {
+                return _intrusiveOwner<T, IntrusiveListHook, H>(mHook);
+            }
+
+            /// 位置が等しいか判定します
+            bool operator==(const Itr<R> &r) const
+            {
+                return mHook == r.mHook;
+            }
+
+            /// 位置が等しくないか判定します
+            bool operator!=(const Itr<R> &r) const
+            {
+                return mHook != r.mHook;
+            }
+        };
+
+        /// コンストラクタ
+        IntrusiveList()
+        {
+            reset();
+        }
+
+        IntrusiveList(const IntrusiveList<T, H> &) = delete;
+        IntrusiveList<T, H> &operator=(const IntrusiveList<T, H> &) = delete;
+
+        /// ムーブコンストラクタ
+        IntrusiveList(IntrusiveList<T, H> &&list) noexcept
+        {
+            reset();
+            splice(list);
+        }
+
+        /// デストラクタ
+        /// 残っている要素は切り離すだけで破棄しません
+        ~IntrusiveList()
+        {
+            clear();
+            mHead.mPrev = nullptr;
+            mHead.mNext = nullptr;
+        }
+
+        /// ムーブ代入します
+        IntrusiveList<T, H> &operator=(IntrusiveList<T, H> &&list) noexcept
+        {
+            if(this == &list) return *this;
+            clear();
+            splice(list);
+            return *this;
+        }
+
+        /// 先頭に追加します
+        /// @retval false 既にリストに連結されていました
+        bool addFirst(T &value)
+        {
+            return insert(begin(), value);
+        }
+
+        /// 末尾に追加します
+        /// @retval false 既にリストに連結されていました
+        bool add(T &value)
+        {
+            return insert(end(), value);
+        }
+
+        /// 位置の前に挿入します
+        /// @param position 挿入する位置
+        /// @retval false 既にリストに連結されていました
+        bool insert(Itr<T> position, T &value)
+        {
+            auto hook = hookOf(value);
+            if(hook->mNext)
+            {
+                printError("value is already linked. bool IntrusiveList<T, H>::insert(Itr<T> position, T &value)");
+                return false;
+            }
+            link(position.mHook, hook);
+            mCount++;
+            return true;
+        }
+
+        /// 要素を削除します
+        /// 要素はこのリストに連結されている必要があります
+        /// @retval false 連結されていませんでした
+        bool remove(T &value)
+        {
+            auto hook = hookOf(value);
+            if(!hook->mNext)
+            {
+                printError("value is not linked. bool IntrusiveList<T, H>::remove(T &value)");
+                return false;
+            }
+            unlink(hook);
+            mCount--;
+            return true;
+        }
+
+        /// 位置の要素を削除します
+        /// @return 削除した要素の次の位置
+        Itr<T> removeAt(Itr<T> position)
+        {
+            if(position.mHook == &mHead)
+            {
+                printError("out of range. Itr<T> IntrusiveList<T, H>::removeAt(Itr<T> position)");
+                return position;
+            }
+            auto next = position.mHook->mNext;
+            unlink(position.mHook);
+            mCount--;
+            return Itr<T>(next);
+        }
+
+        /// 先頭の要素を取り出します
+        /// @return 取り出した要素 空の場合nullptr
+        T *removeFirst()
+        {
+            if(!mCount) return nullptr;
+            auto hook = mHead.mNext;
+            unlink(hook);
+            mCount--;
+            return _intrusiveOwner<T, IntrusiveListHook, H>(hook);
+        }
+
+        /// 末尾の要素を取り出します
+        /// @return 取り出した要素 空の場合nullptr
+        T *removeLast()
+        {
+            if(!mCount) return nullptr;
+            auto hook = mHead.mPrev;
+            unlink(hook);
+            mCount--;
+            return _intrusiveOwner<T, IntrusiveListHook, H>(hook);
+        }
+
+        /// 他のリストの要素をすべて末尾に移動します
+        /// 要素毎の処理は行いません
+        IntrusiveList<T, H> &splice(IntrusiveList<T, H> &list)
+        {
+            if(this == &list || !list.mCount) return *this;
+            auto first = list.mHead.mNext;
+            auto last = list.mHead.mPrev;
+            first->mPrev = mHead.mPrev;
+            mHead.mPrev->mNext = first;
+            last->mNext = &mHead;
+            mHead.mPrev = last;
+            mCount += list.mCount;
+            list.reset();
+            return *this;
+        }
+
+        /// 先頭の要素を取得します
+        T &first()
+        {
+            if(!mCount) printError("list is empty. T &IntrusiveList<T, H>::first()");
+            return *_intrusiveOwner<T, IntrusiveListHook, H>(mHead.mNext);
+        }
+
+        /// 末尾の要素を取得します
+        T &last()
+        {
+            if(!mCount) printError("list is empty. T &IntrusiveList<T, H>::last()");
+            return *_intrusiveOwner<T, IntrusiveListHook, H>(mHead.mPrev);
+        }
+
+        /// 要素数を返します
+        size_t count() const
+        {
+            return mCount;
+        }
+
+        /// 空か判定します
+        bool empty() const
+        {
+            return mCount == 0;
+        }
+
+        /// すべての要素を切り離します
+        /// 要素は破棄しません
+        void clear()
+        {
+            auto hook = mHead.mNext;
+            while(hook != &mHead)
+            {
+                auto next = hook->mNext;
+                hook->mPrev = nullptr;
+                hook->mNext = nullptr;
+                hook = next;
+            }
+            reset();
+        }
+
+        /// 先頭イテレータを返します
+        Itr<T> begin()
+        {
+            return Itr<T>(mHead.mNext);
+        }
+
+        /// 番兵イテレータを返します
+        Itr<T> end()
+        {
+            return Itr<T>(&mHead);
+        }
+
+        /// 先頭イテレータを返します
+        Itr<const T> begin() const
+        {
+            return Itr<const T>(mHead.mNext);
+        }
+
+        /// 番兵イテレータを返します
+        Itr<const T> end() const
+        {
+            return Itr<const T>((IntrusiveListHook *) &mHead);
+        }
+    };
+
+    /// 侵入型ハッシュ集合のフックです
+    /// 要素のメンバとして宣言し、IntrusiveHashSet<T, &T::hook>に渡します
+    /// 連結元のポインタを保持するため、削除は探索無しで行えます
+    class IntrusiveHashSetHook
+    {
+        template<class T, IntrusiveHashSetHook T::*H, class HF, class EF> friend class IntrusiveHashSet;
+
+        IntrusiveHashSetHook *mNext;   // 同じバケットの次のフック
+        IntrusiveHashSetHook **mPoint; // このフックを指しているポインタ
+        size_t mHash;                  // 要素のハッシュ値
+
+    public:
+
+        /// コンストラクタ
+        IntrusiveHashSetHook()
+            : mNext(nullptr)
+            , mPoint(nullptr)
+            , mHash(0)
+        {}
+
+        /// コピーコンストラクタ
+        IntrusiveHashSetHook(const IntrusiveHashSetHook &)
+            : IntrusiveHashSetHook()
+        {}
+
+        /// デストラクタ
+        ~IntrusiveHashSetHook()
+        {
+            if(mPoint) printError("hook is still linked. IntrusiveHashSetHook::~IntrusiveHashSetHook()");
+        }
+
+        /// コピー代入します
+        /// 連結状態は変更しません
+        IntrusiveHashSetHook &operator=(const IntrusiveHashSetHook &)
+        {
+            return *this;
+        }
+
+        /// 集合に連結されているか判定します
+        bool linked() const
+        {
+            return mPoint != nullptr;
+        }
+    };
+
+    /// 侵入型のハッシュ集合を提供します
+    /// バケット配列は呼び出し元が用意し、要素は埋め込んだフックで連結するため確保を行いません
+    /// 要素の寿命は呼び出し元が管理し、破棄する前に集合から削除してください
+    /// 連結中の要素のハッシュ値が変わる変更はしないでください
+    /// @tparam H 要素のフックのメンバポインタ
+    /// @tparam HF ハッシュ関数オブジェクト
+    /// @tparam EF 等価判定関数オブジェクト
+    template<class T, IntrusiveHashSetHook T::*H, class HF = Hash<T>, class EF = Equal<T>>
+    class IntrusiveHashSet
+    {
+        IntrusiveHashSetHook **mBuckets; // バケット配列
+        size_t mMask;                    // バケット数 - 1
+        size_t mCount;                   // 要素数
+
+        // 要素のフックを取得する
+        static IntrusiveHashSetHook *hookOf(const T &value)
+        {
+            return (IntrusiveHashSetHook *) &(value.*H);
+        }
+
+        // フックから要素を取得する
+        static T *ownerOf(IntrusiveHashSetHook *hook)
+        {
+            return _intrusiveOwner<T, IntrusiveHashSetHook, H>(hook);
+        }
+
+        // ハッシュ値からバケットを求める
+        IntrusiveHashSetHook **bucketOf(size_t hash) const
+        {
+            // 下位ビットの偏りを避けるため上位ビットを混ぜる
+            auto mixed = (u64) hash * 0x9E3779B97F4A7C15ull;
+            return &mBuckets[(size_t) (mixed ^ (mixed >> 32)) & mMask];
+        }
+
+        // バケットの先頭に連結する
+        static void link(IntrusiveHashSetHook **bucket, IntrusiveHashSetHook *hook)
+        {
+            hook->mNext = *bucket;
+            if(hook->mNext) hook->mNext->mPoint = &hook->mNext;
+            hook->mPoint = bucket;
+            *bucket = hook;
+        }
+
+        // フックを切り離す
+        static void unlink(IntrusiveHashSetHook *hook)
+        {
+            *hook->mPoint = hook->mNext;
+            if(hook->mNext) hook->mNext->mPoint = hook->mPoint;
+            hook->mNext = nullptr;
+            hook->mPoint = nullptr;
+        }
+
+        // バケット配列を設定する 2の冪乗に切り下げ、空の場合はバケット無しとする
+        void setBuckets(Span<IntrusiveHashSetHook *> buckets)
+        {
+            auto size = buckets.count();
+            while(size & (size - 1)) size &= size - 1;
+            mBuckets = size ? buckets.data() : nullptr;
+            mMask = size ? size - 1 : 0;
+            for(size_t i = 0; i < size; i++) mBuckets[i] = nullptr;
+        }
+
+    public:
+
+        /// 前方向イテレータです
+        template<class R>
+        class Itr
+        {
+            const IntrusiveHashSet<T, H, HF, EF> *mSet; // 集合
+            size_t mBucket;                             // バケットの位置
+            IntrusiveHashSetHook *mHook;                // 現在のフック
+
+            // 空でないバケットまで進める
+            void skip()
+            {
+                while(!mHook && mBucket < mSet->bucketsCount())
+                {
+                    if(++mBucket < mSet->bucketsCount()) mHook = mSet->mBuckets[mBucket];
+                }
+            }
+
+        public:
+
+            /// コンストラクタ
+            Itr(const IntrusiveHashSet<T, H, HF, EF> *set, size_t bucket)
+                : mSet(set)
+                , mBucket(bucket)
+                , mHook(bucket < set->bucketsCount() ? set->mBuckets[bucket] : nullptr)
+            {
+                skip();
+            }
+
+            /// 次に移動します
+            Itr<R> &operator++()
+            {
+                mHook = mHook->mNext;
+                skip();
+                return *this;
+            }
+
+            /// 要素を取得します
+            R &operator*() const
+            {
+                return *ownerOf(mHook);
+            }
+
+            /// 要素を取得します
+            R *operator->() const
+            {
+                return ownerOf(mHook);
+            }
+
+            /// 位置が等しいか判定します
+            bool operator==(const Itr<R> &r) const
+            {
+                return mHook == r.mHook;
+            }
+
+            /// 位置が等しくないか判定します
+            bool operator!=(const Itr<R> &r) const
+            {
+                return mHook != r.mHook;
+            }
+        };
+
+        /// コンストラクタ
+        /// @param buckets バケット配列 集合より長く保持してください 要素数は2の冪乗に切り下げ、空の場合は追加できません
+        IntrusiveHashSet(Span<IntrusiveHashSetHook *> buckets)
+            : mCount(0)
+        {
+            setBuckets(buckets);
+        }
+
+        /// コンストラクタ
+        /// @param buckets バケットの生配列 集合より長く保持してください 要素数は2の冪乗に切り下げます
+        template<size_t N>
+        IntrusiveHashSet(IntrusiveHashSetHook *(&buckets)[N])
+            : IntrusiveHashSet(Span<IntrusiveHashSetHook *>(buckets, N))
+        {}
+
+        IntrusiveHashSet(const IntrusiveHashSet<T, H, HF, EF> &) = delete;
+        IntrusiveHashSet<T, H, HF, EF> &operator=(const IntrusiveHashSet<T, H, HF, EF> &) = delete;
+
+        /// デストラクタ
+        /// 残っている要素は切り離すだけで破棄しません
+        ~IntrusiveHashSet()
+        {
+            clear();
+        }
+
+        /// 追加します
+        /// @retval false 等しい要素が既にあるか、既に連結されていました
+        bool add(T &value)
+        {
+            auto hook = hookOf(value);
+            if(hook->mPoint)
+            {
+                printError("value is already linked. bool IntrusiveHashSet<T, H, HF, EF>::add(T &value)");
+                return false;
+            }
+            if(!mBuckets)
+            {
+                printError("buckets are empty. bool IntrusiveHashSet<T, H, HF, EF>::add(T &value)");
+                return false;
+            }
+            auto hash = HF{}(value);
+            auto bucket = bucketOf(hash);
+            for(auto node = *bucket; node; node = node->mNext)
+            {
+                if(node->mHash == hash && EF{}(*ownerOf(node), value)) return false;
+            }
+            hook->mHash = hash;
+            link(bucket, hook);
+            mCount++;
+            return true;
+        }
+
+        /// 要素を削除します
+        /// 連結元のポインタから切り離すため探索を行いません
+        /// @retval false 連結されていませんでした
+        bool remove(T &value)
+        {
+            auto hook = hookOf(value);
+            if(!hook->mPoint) return false;
+            unlink(hook);
+            mCount--;
+            return true;
+        }
+
+        /// 等しい要素を検索します
+        /// @return 見つかった要素 無い場合nullptr
+        T *find(const T &value) const
+        {
+            auto hash = HF{}(value);
+            return findIf(hash, [&](const T &element) { return EF{}(element, value); });
+        }
+
+        /// ハッシュ値と条件で要素を検索します
+        /// 要素を作らずにキーで検索する場合に使用します
+        /// @param hash 要素と同じハッシュ関数で求めたハッシュ値
+        /// @param predicate bool(const T &element)の関数オブジェクト
+        /// @return 見つかった要素 無い場合nullptr
+        template<class P>
+        T *findIf(size_t hash, const P &predicate) const
+        {
+            if(!mBuckets) return nullptr;
+            for(auto node = *bucketOf(hash); node; node = node->mNext)
+            {
+                if(node->mHash == hash && predicate(*ownerOf(node))) return ownerOf(node);
+            }
+            return nullptr;
+        }
+
+        /// 等しい要素があるか判定します
+        bool contains(const T &value) const
+        {
+            return find(value) != nullptr;
+        }
+
+        /// バケット配列を置き換え、要素を再配置します
+        /// 要素の移動と確保は行いません
+        /// @param buckets 新しいバケット配列 古いバケット配列とは別の領域を指定してください
+        void rehash(Span<IntrusiveHashSetHook *> buckets)
+        {
+            if(mCount && !buckets.count())
+            {
+                printError("buckets are empty. void IntrusiveHashSet<T, H, HF, EF>::rehash(Span<IntrusiveHashSetHook *> buckets)");
+                return;
+            }
+
+            // 古いバケットの連結をたどりながら新しいバケットへ移す
+            auto oldBuckets = mBuckets;
+            auto oldSize = mBuckets ? mMask + 1 : 0;
+            setBuckets(buckets);
+            for(size_t i = 0; i < oldSize; i++)
+            {
+                auto node = oldBuckets[i];
+                while(node)
+                {
+                    auto next = node->mNext;
+                    link(bucketOf(node->mHash), node);
+                    node = next;
+                }
+                oldBuckets[i] = nullptr;
+            }
+        }
+
+        /// 要素数を返します
+        size_t count() const
+        {
+            return mCount;
+        }
+
+        /// 空か判定します
+        bool empty() const
+        {
+            return mCount == 0;
+        }
+
+        /// バケット数を返します
+        size_t bucketsCount() const
+        {
+            return mBuckets ? mMask + 1 : 0;
+        }
+
+        /// すべての要素を切り離します
+        /// 要素は破棄しません
+        void clear()
+        {
+            for(size_t i = 0; i < bucketsCount(); i++)
+            {
+                while(mBuckets[i]) unlink(mBuckets[i]);
+            }
+            mCount = 0;
+        }
+
+        /// 先頭イテレータを返します
+        Itr<T> begin()
+        {
+            return Itr<T>(this, 0);
+        }
+
+        /// 番兵イテレータを返します
+        Itr<T> end()
+        {
+            return Itr<T>(this, bucketsCount());
+        }
+
+        /// 先頭イテレータを返します
+        Itr<const T> begin() const
+        {
+            return Itr<const T>(this, 0);
+        }
+
+        /// 番兵イテレータを返します
+        Itr<const T> end() const
+        {
+            return Itr<const T>(this, bucketsCount());
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_INTRUSIVE_HPP
\ No newline at end of file
@@ -1,5 +1,5 @@
 /// @file map.hpp
-/// @version 1.22.5
+/// @version 1.22.6
 /// @copyright © 2022 Taichi Ito
 /// 連想配列を提供します
 
@@ -26,6 +26,17 @@ namespace ElekiEngine
         {}
     };
 
+    /// ハッシュ特殊化構造体です
+    template<class K, class V>
+    struct Hash<KeyValuePair<K, V>>
+    {
+        /// ハッシュ値を返します
+        size_t operator()(const KeyValuePair<K, V> &value) const
+        {
+            return hashCombine(Hash<std::remove_const_t<K>>{}(value.key), Hash<std::remove_const_t<V>>{}(value.value));
+        }
+    };
+
     /// 連想配列を提供します
     template<class K, class V, class H = Hash<K>, class E = EqualTo<K>>
     class Map
@@ -52,16 +63,18 @@ namespace ElekiEngine
         }
 
         // ハッシュ値から要素を見つける
-        size_t elementIndexOf(const K &key, const List<KeyValuePair<const K, V>> &elements, const List<size_t> &indexes) const
+        // キーと同じハッシュ値と等価判定を持つ型でも検索できる
+        template<class Q>
+        size_t elementIndexOf(const Q &key, const List<KeyValuePair<const K, V>> &elements, const List<size_t> &indexes) const
         {
             size_t index = H{}(key) % indexes.count();
             for(size_t i = index; i < indexes.count(); i++)
             {
-                if(indexes[i] == NONE_INDEX_NUM && E{}(elements[indexes[i]].key, key)) return i;
+                if(indexes[i] != NONE_INDEX_NUM && E{}(elements[indexes[i]].key, key)) return i;
             }
             for(size_t i = 0; i < index; i++)
             {
-                if(indexes[i] == NONE_INDEX_NUM && E{}(elements[indexes[i]].key, key)) return i;
+                if(indexes[i] != NONE_INDEX_NUM && E{}(elements[indexes[i]].key, key)) return i;
             }
             return NONE_INDEX_NUM;
         }
@@ -312,6 +325,27 @@ namespace ElekiEngine
             return NONE_INDEX_NUM != elementIndexOf(key, mElements, mIndexes);
         }
 
+        /// キーから値を検索します
+        /// キーと同じハッシュ値と等価判定を持つ型で検索できます
+        /// StringをキーとするならStringViewで、文字列をインターンせずに検索できます
+        /// @retval nullptr キーが見つかりませんでした
+        template<class Q>
+        V *find(const Q &key)
+        {
+            auto index = elementIndexOf(key, mElements, mIndexes);
+            return NONE_INDEX_NUM == index ? nullptr : &mElements[mIndexes[index]].value;
+        }
+
+        /// キーから値を検索します
+        /// キーと同じハッシュ値と等価判定を持つ型で検索できます
+        /// @retval nullptr キーが見つかりませんでした
+        template<class Q>
+        const V *find(const Q &key) const
+        {
+            auto index = elementIndexOf(key, mElements, mIndexes);
+            return NONE_INDEX_NUM == index ? nullptr : &mElements[mIndexes[index]].value;
+        }
+
         /// 要素数を返します
         size_t count() const
         {
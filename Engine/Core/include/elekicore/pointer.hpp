@@ -1,12 +1,20 @@
 /// @file pointer.hpp
-/// @version 1.22.5
+/// @version 1.22.6
 /// @copyright © 2022 Taichi Ito
-/// ファイルの説明(複数行可)
+/// 所有権を持つポインタと、制御ブロックへのポインタのみを持つ弱い参照を提供します
+/// newUR、newRCは制御ブロックとオブジェクトを1度に確保し、IntrusiveRCは制御ブロックを持ちません
 
 #ifndef ELEKICORE_POINTER_HPP
 #define ELEKICORE_POINTER_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include "allocation.hpp"
 #include "datalog.hpp"
 
@@ -21,69 +29,132 @@ namespace ElekiEngine
     template<class T>
     class UR;
 
+    /// 参照カウントを原子的に増減する方針です
+    /// 増加はrelaxed、減少はreleaseで行い、0になったときのみacquireで同期します
+    /// スレッド間で共有する資産やタスクの結果に使用します
+    struct AtomicRefCount
+    {
+        /// 参照を1つ増やします
+        static void increment(std::atomic<size_t> &count)
+        {
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// 参照を1つ減らします
+        /// @return 0になった場合真
+        static bool decrement(std::atomic<size_t> &count)
+        {
+            if(count.fetch_sub(1, std::memory_order_release) != 1) return false;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return true;
+        }
+    };
+
+    /// 参照カウントを原子的な命令を使わずに増減する方針です
+    /// 読み込みと書き込みを分けて行うため、単一のスレッドからのみ使用してください
+    struct LocalRefCount
+    {
+        /// 参照を1つ増やします
+        static void increment(std::atomic<size_t> &count)
+        {
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        /// 参照を1つ減らします
+        /// @return 0になった場合真
+        static bool decrement(std::atomic<size_t> &count)
+        {
+            auto value = count.load(std::memory_order_relaxed) - 1;
+            count.store(value, std::memory_order_relaxed);
+            return !value;
+        }
+    };
+
     /// 参照カウンタクラスです
-    template<class T>
+    template<class T, class P = AtomicRefCount>
     class RC;
 
+    /// 参照数をオブジェクトに埋め込む参照カウンタクラスです
+    template<class T, class P = AtomicRefCount>
+    class IntrusiveRC;
+
+    // 制御ブロックと同じ領域に構築したオブジェクトの終了処理
+    // 領域は制御ブロックと一緒に解放するため、デストラクタのみ呼び出す
+    template<class T>
+    class _InplaceDeleter: public IDeleter
+    {
+    public:
+
+        // デストラクタを呼び出す
+        void operator()(void *pointer) override
+        {
+            ((T *) pointer)->~T();
+        }
+
+        // 型ごとの終了処理を返す
+        static IDeleter *instance()
+        {
+            static _InplaceDeleter<T> deleter;
+            return &deleter;
+        }
+    };
+
+    // 制御ブロック
+    // 参照先の型に依らず共通で、オブジェクトを直後に構築する場合もある
+    // 最後の参照はどのスレッドでも外れるため、排他しない共有メモリではなくmallocで確保する
+    struct _RefInfo
+    {
+        void *pointer;             // 参照先
+        std::atomic<size_t> count; // 所有者の参照数 0の場合は破棄済み
+        std::atomic<size_t> weak;  // 弱い参照数 所有者が残る間は1つ多い
+        IDeleter *deleter;         // 参照先の終了処理
+    #ifdef _DEBUG
+        std::thread::id thread;    // 確保したスレッド 共有メモリへ返す終了処理の呼び出し元を検査する
+    #endif
+    };
+
     /// 弱い参照クラスです
+    /// 制御ブロックへのポインタのみを持ち、コピーは弱い参照数を1つ増やすのみです
+    /// 参照先が破棄されると参照数が0になり、他の参照に触れずに失効を検出できます
+    /// 制御ブロックは最後の弱い参照が無くなるまで残ります
+    /// 参照先の寿命は所有者が管理するため、他のスレッドから参照先を使用する場合は所有者と同期してください
     template<class T>
     class Ref
     {
-        template<class T> friend class UR;
-        template<class T> friend class RC;
-        friend class Ref<void>;
+        template<class U> friend class Ref;
+        template<class U> friend class UR;
+        template<class U, class Q> friend class RC;
 
-        struct Info
-        {
-            void *pointer;
-            size_t count;
-            IDeleter *deleter;
-            Ref<u8> *top;
-        };
+        using Info = _RefInfo;
 
-        Info          *mInfo; // 参照情報
-        Ref<u8>       *mPrev; // 前の参照
-        Ref<u8>       *mNext; // 次の参照
+        Info *mInfo; // 参照情報
 
-        // 接続します
-        static void connect(Info *&info, Ref<u8> *&prev, Ref<u8> *&next)
+        // 弱い参照を1つ増やします
+        static void acquire(Info *info)
         {
-            if(info)
-            {
-                if(info->top)
-                {
-                    prev = info->top->mPrev;
-                    next = info->top;
-                }
-                else
-                {
-                    prev = (Ref<u8>*)this;
-                    next = (Ref<u8>*)this;
-                    info->top = (Ref<u8>*)this;
-                }
-                info->top->mPrev->mNext = (Ref<u8>*)this;
-                info->top->mPrev = (Ref<u8>*)this;
-            }
+            if(info) info->weak.fetch_add(1, std::memory_order_relaxed);
         }
 
-        // 切断します
-        static void disconnect(Info *&info, Ref<u8> *&prev, Ref<u8> *&next)
+        // 弱い参照を1つ減らし、0になった場合は制御ブロックを解放します
+        static void release(Info *info)
         {
-            if(info)
+            if(info && info->weak.fetch_sub(1, std::memory_order_acq_rel) == 1)
             {
-                if(info->top == (Ref<u8>*)this) info->top = next;
-                prev->mNext = next;
-                next->mPrev = prev;
+                std::free(info);
             }
         }
 
-        /// コンストラクタ
+        // 参照先を返します 破棄済みの場合はnullptr
+        static void *get(Info *info)
+        {
+            return (info && info->count.load(std::memory_order_acquire) ? info->pointer : nullptr);
+        }
+
+        // コンストラクタ
         Ref(Info *info)
             : mInfo(info)
-            , mPrev(nullptr)
-            , mNext(nullptr)
         {
-            connect(mInfo, mPrev, mNext);
+            acquire(mInfo);
         }
 
     public:
@@ -91,63 +162,61 @@ namespace ElekiEngine
         /// コンストラクタ
         Ref()
             : mInfo(nullptr)
-            , mPrev(nullptr)
-            , mNext(nullptr)
         {}
 
         /// コピーコンストラクタ
         Ref(const Ref<T> &ref)
             : mInfo(ref.mInfo)
-            , mPrev(nullptr)
-            , mNext(nullptr)
         {
-            connect(mInfo, mPrev, mNext);
+            acquire(mInfo);
         }
 
-        /// コピーコンストラクタ
+        /// ムーブコンストラクタ
         Ref(Ref<T> &&ref) noexcept
             : mInfo(ref.mInfo)
-            , mPrev(nullptr)
-            , mNext(nullptr)
         {
-            connect(mInfo, mPrev, mNext);
+            ref.mInfo = nullptr;
         }
 
         /// デストラクタ
         ~Ref()
         {
-            disconnect(mInfo, mPrev, mNext);
+            release(mInfo);
         }
 
         /// 代入演算子
+        /// 自身への代入で解放しないよう、先に参照を増やします
         Ref<T> &operator=(const Ref<T> &ref)
         {
-            disconnect(mInfo, mPrev, mNext);
+            acquire(ref.mInfo);
+            release(mInfo);
             mInfo = ref.mInfo;
-            connect(mInfo, mPrev, mNext);
             return *this;
         }
 
         /// 代入演算子
         Ref<T> &operator=(Ref<T> &&ref) noexcept
         {
-            disconnect(mInfo, mPrev, mNext);
+            if(&ref == this) return *this;
+            release(mInfo);
             mInfo = ref.mInfo;
-            connect(mInfo, mPrev, mNext);
+            ref.mInfo = nullptr;
             return *this;
         }
 
         /// 参照先を取得します
         T &operator*() const
         {
-            if(!mInfo) printError("null pointer. T &Ref<T>::operator*() const");
-            return *(T *) mInfo->pointer;
+            auto pointer = (T *) get(mInfo);
+            if(!pointer) printError("null pointer. T &Ref<T>::operator*() const");
+            return *pointer;
         }
 
         /// 参照先にアクセスします
+        /// 破棄済みの場合はnullptrを返します
         T *operator->() const noexcept
         {
-            return (mInfo ? (T *) mInfo->pointer : nullptr);
+            return (T *) get(mInfo);
         }
 
         /// キャストします
@@ -160,20 +229,30 @@ namespace ElekiEngine
         /// 参照先を取得します
         T &reference() const
         {
-            if(!mInfo) printError("null pointer. T &Ref<T>::reference() const");
-            return *(T *) mInfo->pointer;
+            auto pointer = (T *) get(mInfo);
+            if(!pointer) printError("null pointer. T &Ref<T>::reference() const");
+            return *pointer;
         }
 
         /// 参照先にアクセスします
+        /// 破棄済みの場合はnullptrを返します
         T *pointer() const noexcept
         {
-            return (mInfo ? (T *) mInfo->pointer : nullptr);
+            return (T *) get(mInfo);
+        }
+
+        /// 参照先が破棄済みか判定します
+        /// 空の参照も破棄済みとみなします
+        bool expired() const
+        {
+            return !get(mInfo);
         }
 
         /// 参照カウントを返します
+        /// 破棄済みの場合は0です
         size_t count() const
         {
-            return (mInfo ? mInfo->count : 0);
+            return (mInfo ? mInfo->count.load(std::memory_order_relaxed) : 0);
         }
     };
 
@@ -181,20 +260,17 @@ namespace ElekiEngine
     template<>
     class Ref<void>
     {
-        template<class T> friend class UR;
-        template<class T> friend class RC;
+        template<class U> friend class Ref;
+        template<class U> friend class UR;
+        template<class U, class Q> friend class RC;
+
+        Ref<u8>::Info *mInfo; // 参照情報
 
-        Ref<u8>::Info *mInfo;   // 参照情報
-        Ref<u8> *mPrev;         // 前の参照
-        Ref<u8> *mNext;         // 次の参照
-        
         // コンストラクタ
         Ref(Ref<u8>::Info *info)
             : mInfo(info)
-            , mPrev(nullptr)
-            , mNext(nullptr)
         {
-            Ref<u8>::connect(mInfo, mPrev, mNext);
+            Ref<u8>::acquire(mInfo);
         }
 
     public:
@@ -202,49 +278,44 @@ namespace ElekiEngine
         /// コンストラクタ
         Ref()
             : mInfo(nullptr)
-            , mPrev(nullptr)
-            , mNext(nullptr)
         {}
 
         /// コピーコンストラクタ
         Ref(const Ref<void> &ref)
             : mInfo(ref.mInfo)
-            , mPrev(nullptr)
-            , mNext(nullptr)
         {
-            Ref<u8>::connect(mInfo, mPrev, mNext);
+            Ref<u8>::acquire(mInfo);
         }
 
-        /// コピーコンストラクタ
+        /// ムーブコンストラクタ
         Ref(Ref<void> &&ref) noexcept
             : mInfo(ref.mInfo)
-            , mPrev(nullptr)
-            , mNext(nullptr)
         {
-            Ref<u8>::connect(mInfo, mPrev, mNext);
+            ref.mInfo = nullptr;
         }
 
         /// デストラクタ
         ~Ref()
         {
-            Ref<u8>::disconnect(mInfo, mPrev, mNext);
+            Ref<u8>::release(mInfo);
         }
 
         /// 代入演算子
         Ref<void> &operator=(const Ref<void> &ref)
         {
-            Ref<u8>::disconnect(mInfo, mPrev, mNext);
+            Ref<u8>::acquire(ref.mInfo);
+            Ref<u8>::release(mInfo);
             mInfo = ref.mInfo;
-            Ref<u8>::connect(mInfo, mPrev, mNext);
             return *this;
         }
 
         /// 代入演算子
         Ref<void> &operator=(Ref<void> &&ref) noexcept
         {
-            Ref<u8>::disconnect(mInfo, mPrev, mNext);
+            if(&ref == this) return *this;
+            Ref<u8>::release(mInfo);
             mInfo = ref.mInfo;
-            Ref<u8>::connect(mInfo, mPrev, mNext);
+            ref.mInfo = nullptr;
             return *this;
         }
 
@@ -256,15 +327,22 @@ namespace ElekiEngine
         }
 
         /// 参照先にアクセスします
+        /// 破棄済みの場合はnullptrを返します
         void *pointer() const
         {
-            return (mInfo ? (void *) mInfo->pointer : nullptr);
+            return Ref<u8>::get(mInfo);
+        }
+
+        /// 参照先が破棄済みか判定します
+        bool expired() const
+        {
+            return !Ref<u8>::get(mInfo);
         }
 
         /// 参照カウントを返します
         size_t count() const
         {
-            return (mInfo ? mInfo->count : 0);
+            return (mInfo ? mInfo->count.load(std::memory_order_relaxed) : 0);
         }
     };
 
@@ -272,33 +350,66 @@ namespace ElekiEngine
     template<class T>
     class UR
     {
-        template<class T> friend class RC;
+        template<class U, class Q> friend class RC;
         friend class UR<void>;
 
         Ref<u8>::Info *mInfo; // 参照情報
 
         // Infoを確保します
+        // 弱い参照数は所有者の分の1から始めます
         static Ref<u8>::Info *alloc()
         {
-            return new(Memory::allocate(sizeof(Ref<u8>::Info))) Ref<u8>::Info();
+            auto info = new(std::malloc(sizeof(Ref<u8>::Info))) Ref<u8>::Info();
+            info->weak.store(1, std::memory_order_relaxed);
+        #ifdef _DEBUG
+            info->thread = std::this_thread::get_id();
+        #endif
+            return info;
         }
 
         // 解放します
+        // 参照数を0にしてRefを失効させ、Infoは最後のRefが解放します
         static void free(Ref<u8>::Info *&info)
         {
             if(info)
             {
-                // Refをすべてnullptrにする
-                for(auto p = info->top->mNext; p != info->top; p = p->mNext)
+                info->count.store(0, std::memory_order_release);
+            #ifdef _DEBUG
+                // 共有メモリは排他されないため、確保したスレッド以外から返すと壊れる
+                if(info->deleter == Memory::deleter() && info->thread != std::this_thread::get_id())
                 {
-                    p->mInfo = nullptr;
+                    printError("Memory::deleter() called from another thread. void UR<T>::free(Ref<u8>::Info *&info)");
                 }
-                info->top->mInfo = nullptr;
+            #endif
                 // ポインタ解放
                 (*info->deleter)(info->pointer);
-                // Info解放
-                Memory::deallocate(info);
+                // 所有者の分の弱い参照を解放
+                Ref<u8>::release(info);
+            }
+        }
+
+        // 制御ブロックの直後にオブジェクトを構築します
+        // 確保は1度で、領域は最後のRefが無くなったときに制御ブロックと一緒に解放されます
+        // mallocの整列を超える型は余分に確保し、オブジェクトの位置を実行時に整列します
+        template<class...Args>
+        static Ref<u8>::Info *allocInplace(Args &&...args)
+        {
+            constexpr size_t infoSize = (sizeof(Ref<u8>::Info) + alignof(T) - 1) / alignof(T) * alignof(T);
+            constexpr size_t padding = alignof(T) > alignof(std::max_align_t) ? alignof(T) - 1 : 0;
+            auto memory = (u8 *) std::malloc(infoSize + padding + sizeof(T));
+            if(!memory)
+            {
+                printError("failed to allocate. Ref<u8>::Info *UR<T>::allocInplace(Args &&...args)");
+                return nullptr;
             }
+            auto end = (uintptr_t) (memory + sizeof(Ref<u8>::Info));
+            size_t offset = (end + alignof(T) - 1) / alignof(T) * alignof(T) - (uintptr_t) memory;
+            auto info = new(memory) Ref<u8>::Info();
+            info->pointer = new(memory + offset) T(std::forward<Args>(args)...);
+            info->deleter = _InplaceDeleter<T>::instance();
+            info->count.store(1, std::memory_order_relaxed);
+            info->weak.store(1, std::memory_order_relaxed);
+            return info;
         }
 
         // 移します
@@ -331,12 +442,14 @@ namespace ElekiEngine
 
         /// ムーブコンストラクタ
         UR(UR<T> &ur)
+            : mInfo(nullptr)
         {
             move(ur, *this);
         }
 
         /// ムーブコンストラクタ
         UR(UR<T> &&ur) noexcept
+            : mInfo(nullptr)
         {
             move(ur, *this);
         }
@@ -405,13 +518,25 @@ namespace ElekiEngine
         {
             return (mInfo ? (T *) mInfo->pointer : nullptr);
         }
+
+        /// 制御ブロックと同じ領域にオブジェクトを構築します
+        /// 確保は1度で、オブジェクトは制御ブロックの直後に置かれます
+        /// @param args コンストラクタの引数
+        template<class...Args>
+        static UR<T> make(Args &&...args)
+        {
+            UR<T> ur;
+            ur.mInfo = allocInplace(std::forward<Args>(args)...);
+            return ur;
+        }
     };
 
     /// ユニーク参照クラスです
     template<>
     class UR<void>
     {
-        template<class T> friend class RC;
+        template<class U> friend class UR;
+        template<class U, class Q> friend class RC;
 
         Ref<u8>::Info *mInfo; // 参照情報
 
@@ -434,12 +559,14 @@ namespace ElekiEngine
 
         /// ムーブコンストラクタ
         UR(UR<void> &ur)
+            : mInfo(nullptr)
         {
             UR<u8>::move(ur, *this);
         }
 
         /// ムーブコンストラクタ
         UR(UR<void> &&ur) noexcept
+            : mInfo(nullptr)
         {
             UR<u8>::move(ur, *this);
         }
@@ -491,19 +618,25 @@ namespace ElekiEngine
     };
 
     /// ユニーク参照ポインタを作成します
+    /// 制御ブロックとオブジェクトを1度に確保します
     template<class T, class...Args>
-    UR<T> newUR(Args...args)
+    UR<T> newUR(Args &&...args)
     {
-        auto ptr = new(Memory::allocate(sizeof(T))) T(args...);
-        return UR(ptr, Memory::deleter());
+        return UR<T>::make(std::forward<Args>(args)...);
     }
 
     /// 参照カウンタクラスです
-    template<class T>
+    /// 参照数の増減は方針Pに従います 既定では原子的に増減するため、スレッド間で共有できます
+    /// 単一のスレッドでのみ使用する場合は、LocalRCを使用すると原子的な命令を使いません
+    /// 制御ブロックとnewRCで構築したオブジェクトは、どのスレッドで最後の参照が外れても解放できます
+    /// ポインタから作成した場合の終了処理は最後の参照を外したスレッドで呼ばれるため、スレッド間で共有する場合はスレッド安全な終了処理を指定してください
+    /// 既定のMemory::deleter()は確保したスレッドでのみ呼び出せ、_DEBUGでは他のスレッドからの呼び出しをエラーとして出力します
+    /// @tparam P 参照数を増減する方針
+    template<class T, class P>
     class RC
     {
-        template<class T> friend class UR;
-        friend class RC<void>;
+        template<class U> friend class UR;
+        template<class U, class Q> friend class RC;
 
         Ref<u8>::Info *mInfo; // 参照情報
 
@@ -513,29 +646,36 @@ namespace ElekiEngine
             return UR<u8>::alloc();
         }
 
-        // 解放します
+        // 参照を1つ減らし、0になった場合は解放します
         static void free(Ref<u8>::Info *&info)
         {
-            if(info)
+            if(info && P::decrement(info->count))
             {
-                info->count -= 1;
-                if(!info->count)
-                {
-                    UR<u8>::free(info);
-                }
+                UR<u8>::free(info);
             }
+            info = nullptr;
         }
 
         // コピーします
-        template<class U>
-        static void copy(const RC<U> &from, RC<U> &to)
+        // 自身への代入で解放しないよう、先に参照を増やします
+        static void copy(Ref<u8>::Info *from, Ref<u8>::Info *&to)
         {
-            free(to.mInfo);
-            to.mInfo = from.mInfo;
-            if(to.mInfo)
+            if(from)
             {
-                to.mInfo->count += 1;
+                P::increment(from->count);
             }
+            free(to);
+            to = from;
+        }
+
+        // 移します
+        // 参照数は変わりません
+        static void move(Ref<u8>::Info *&from, Ref<u8>::Info *&to)
+        {
+            if(&from == &to) return;
+            free(to);
+            to = from;
+            from = nullptr;
         }
 
     public:
@@ -551,19 +691,21 @@ namespace ElekiEngine
         {
             mInfo->pointer = pointer;
             mInfo->deleter = deleter;
-            mInfo->count = 1;
+            mInfo->count.store(1, std::memory_order_relaxed);
         }
 
         /// コピーコンストラクタ
-        RC(const RC<T> &rc)
+        RC(const RC<T, P> &rc)
+            : mInfo(nullptr)
         {
-            copy(rc, *this);
+            copy(rc.mInfo, mInfo);
         }
 
         /// ムーブコンストラクタ
-        RC(RC<T> &&rc) noexcept
+        RC(RC<T, P> &&rc) noexcept
+            : mInfo(nullptr)
         {
-            copy(rc, *this);
+            move(rc.mInfo, mInfo);
         }
 
         /// デストラクタ
@@ -573,23 +715,23 @@ namespace ElekiEngine
         }
 
         /// 代入演算子
-        RC<T> &operator=(const RC<T> &rc)
+        RC<T, P> &operator=(const RC<T, P> &rc)
         {
-            copy(rc, *this);
+            copy(rc.mInfo, mInfo);
             return *this;
         }
 
         /// 代入演算子
-        RC<T> &operator=(RC<T> &&rc) noexcept
+        RC<T, P> &operator=(RC<T, P> &&rc) noexcept
         {
-            copy(rc, *this);
+            move(rc.mInfo, mInfo);
             return *this;
         }
 
         /// 参照先を取得します
         T &operator*() const
         {
-            if(!mInfo) printError("null pointer. T &RC<T>::operator*() const");
+            if(!mInfo) printError("null pointer. T &RC<T, P>::operator*() const");
             return *(T *) mInfo->pointer;
         }
 
@@ -601,14 +743,10 @@ namespace ElekiEngine
 
         /// キャストします
         template<class U>
-        explicit operator RC<U>() const
+        explicit operator RC<U, P>() const
         {
-            RC<U> rc;
-            rc.mInfo = mInfo;
-            if(mInfo)
-            {
-                mInfo->count += 1;
-            }
+            RC<U, P> rc;
+            copy(mInfo, rc.mInfo);
             return rc;
         }
 
@@ -621,7 +759,7 @@ namespace ElekiEngine
         /// 参照先を取得します
         T &reference() const
         {
-            if(!mInfo) printError("null pointer. T &RC<T>::reference() const");
+            if(!mInfo) printError("null pointer. T &RC<T, P>::reference() const");
             return *(T *) mInfo->pointer;
         }
 
@@ -632,17 +770,30 @@ namespace ElekiEngine
         }
 
         /// 参照カウントを返します
+        /// 他のスレッドが増減している場合は、呼び出した時点の目安です
         size_t count() const
         {
-            return (mInfo ? mInfo->count : 0);
+            return (mInfo ? mInfo->count.load(std::memory_order_relaxed) : 0);
+        }
+
+        /// 制御ブロックと同じ領域にオブジェクトを構築します
+        /// 確保は1度で、参照数とオブジェクトが同じキャッシュラインに載りやすくなります
+        /// @param args コンストラクタの引数
+        template<class...Args>
+        static RC<T, P> make(Args &&...args)
+        {
+            RC<T, P> rc;
+            rc.mInfo = UR<T>::allocInplace(std::forward<Args>(args)...);
+            return rc;
         }
     };
 
     /// 参照カウンタクラスです
-    template<>
-    class RC<void>
+    template<class P>
+    class RC<void, P>
     {
-        template<class T> friend class UR;
+        template<class U> friend class UR;
+        template<class U, class Q> friend class RC;
 
         Ref<u8>::Info *mInfo; // 参照情報
 
@@ -655,55 +806,53 @@ namespace ElekiEngine
 
         /// コンストラクタ
         RC(void *pointer, IDeleter *deleter = Memory::deleter())
-            : mInfo(RC<u8>::alloc())
+            : mInfo(RC<u8, P>::alloc())
         {
             mInfo->pointer = pointer;
             mInfo->deleter = deleter;
-            mInfo->count = 1;
+            mInfo->count.store(1, std::memory_order_relaxed);
         }
 
         /// コピーコンストラクタ
-        RC(const RC<void> &rc)
+        RC(const RC<void, P> &rc)
+            : mInfo(nullptr)
         {
-            RC<u8>::copy(rc, *this);
+            RC<u8, P>::copy(rc.mInfo, mInfo);
         }
 
         /// ムーブコンストラクタ
-        RC(RC<void> &&rc) noexcept
+        RC(RC<void, P> &&rc) noexcept
+            : mInfo(nullptr)
         {
-            RC<u8>::copy(rc, *this);
+            RC<u8, P>::move(rc.mInfo, mInfo);
         }
 
         /// デストラクタ
         ~RC()
         {
-            free(mInfo);
+            RC<u8, P>::free(mInfo);
         }
 
         /// 代入演算子
-        RC<void> &operator=(const RC<void> &rc)
+        RC<void, P> &operator=(const RC<void, P> &rc)
         {
-            RC<u8>::copy(rc, *this);
+            RC<u8, P>::copy(rc.mInfo, mInfo);
             return *this;
         }
 
         /// 代入演算子
-        RC<void> &operator=(RC<void> &&rc) noexcept
+        RC<void, P> &operator=(RC<void, P> &&rc) noexcept
         {
-            RC<u8>::copy(rc, *this);
+            RC<u8, P>::move(rc.mInfo, mInfo);
             return *this;
         }
 
         /// キャストします
         template<class U>
-        explicit operator RC<U>() const
+        explicit operator RC<U, P>() const
         {
-            RC<U> rc;
-            rc.mInfo = mInfo;
-            if(mInfo)
-            {
-                mInfo->count += 1;
-            }
+            RC<U, P> rc;
+            RC<u8, P>::copy(mInfo, rc.mInfo);
             return rc;
         }
 
@@ -712,7 +861,7 @@ namespace ElekiEngine
         {
             return Ref<void>(mInfo);
         }
-        
+
         /// 参照先にアクセスします
         void *pointer() const
         {
@@ -722,16 +871,209 @@ namespace ElekiEngine
         /// 参照カウントを返します
         size_t count() const
         {
-            return (mInfo ? mInfo->count : 0);
+            return (mInfo ? mInfo->count.load(std::memory_order_relaxed) : 0);
         }
     };
 
+    /// 単一のスレッドでのみ使用する参照カウンタクラスです
+    /// 参照数の増減に原子的な命令を使わないため、頻繁にコピーする処理に使用します
+    /// 他のスレッドへ渡す場合はRCを使用してください
+    template<class T>
+    using LocalRC = RC<T, LocalRefCount>;
+
     /// 参照カウンタポインタを作成します
+    /// 制御ブロックとオブジェクトを1度に確保します
     template<class T, class...Args>
-    RC<T> newRC(Args...args)
+    RC<T> newRC(Args &&...args)
+    {
+        return RC<T>::make(std::forward<Args>(args)...);
+    }
+
+    /// 単一のスレッドでのみ使用する参照カウンタポインタを作成します
+    /// 制御ブロックとオブジェクトを1度に確保します
+    template<class T, class...Args>
+    LocalRC<T> newLocalRC(Args &&...args)
+    {
+        return LocalRC<T>::make(std::forward<Args>(args)...);
+    }
+
+    /// 参照数を埋め込む基底クラスです
+    /// 継承したクラスはIntrusiveRCで、制御ブロックを確保せずに共有できます
+    /// コピーや代入では参照数を写しません
+    class RefCounted
+    {
+        template<class T, class P> friend class IntrusiveRC;
+
+        mutable std::atomic<size_t> mRefCount; // 参照数
+
+    protected:
+
+        /// コンストラクタ
+        RefCounted()
+            : mRefCount(0)
+        {}
+
+        /// コピーコンストラクタ
+        RefCounted(const RefCounted &)
+            : mRefCount(0)
+        {}
+
+        /// 代入演算子
+        RefCounted &operator=(const RefCounted &)
+        {
+            return *this;
+        }
+
+    public:
+
+        /// 参照カウントを返します
+        size_t refCount() const
+        {
+            return mRefCount.load(std::memory_order_relaxed);
+        }
+    };
+
+    /// 参照数をオブジェクトに埋め込む参照カウンタクラスです
+    /// TはRefCountedを公開継承し、newIntrusiveRCで作成してください
+    /// 制御ブロックを持たないため、確保は1度で、大きさはポインタ1つ分です
+    /// 参照数がオブジェクトにあるため、生のポインタから作り直せますが、弱い参照は作成できません
+    /// @tparam P 参照数を増減する方針
+    template<class T, class P>
+    class IntrusiveRC
+    {
+        template<class U, class Q> friend class IntrusiveRC;
+
+        T *mPointer; // 参照先
+
+        // 参照数を返します
+        static std::atomic<size_t> &counter(T *pointer)
+        {
+            return static_cast<const RefCounted *>(pointer)->mRefCount;
+        }
+
+        // 参照を1つ減らし、0になった場合は破棄します
+        // 多態的な型は、基底クラスのポインタから確保した先頭を求めます
+        static void release(T *pointer)
+        {
+            if(!pointer || !P::decrement(counter(pointer))) return;
+            void *memory = pointer;
+            if constexpr(std::is_polymorphic_v<T>) memory = dynamic_cast<void *>(pointer);
+            pointer->~T();
+            std::free(memory);
+        }
+
+    public:
+
+        /// コンストラクタ
+        IntrusiveRC()
+            : mPointer(nullptr)
+        {}
+
+        /// コンストラクタ
+        /// 参照を1つ増やして共有します
+        /// @param pointer newIntrusiveRCで作成したオブジェクト
+        explicit IntrusiveRC(T *pointer)
+            : mPointer(pointer)
+        {
+            static_assert(std::is_base_of_v<RefCounted, T>, "T must derive from RefCounted. IntrusiveRC<T, P>");
+            if(mPointer) P::increment(counter(mPointer));
+        }
+
+        /// コピーコンストラクタ
+        IntrusiveRC(const IntrusiveRC<T, P> &rc)
+            : IntrusiveRC(rc.mPointer)
+        {}
+
+        /// コピーコンストラクタ
+        /// 派生クラスから基底クラスへ変換します
+        template<class U, std::enable_if_t<std::is_convertible_v<U *, T *>, int> = 0>
+        IntrusiveRC(const IntrusiveRC<U, P> &rc)
+            : IntrusiveRC(static_cast<T *>(rc.mPointer))
+        {}
+
+        /// ムーブコンストラクタ
+        IntrusiveRC(IntrusiveRC<T, P> &&rc) noexcept
+            : mPointer(rc.mPointer)
+        {
+            rc.mPointer = nullptr;
+        }
+
+        /// デストラクタ
+        ~IntrusiveRC()
+        {
+            release(mPointer);
+        }
+
+        /// 代入演算子
+        /// 自身への代入で破棄しないよう、先に参照を増やします
+        IntrusiveRC<T, P> &operator=(const IntrusiveRC<T, P> &rc)
+        {
+            auto pointer = rc.mPointer;
+            if(pointer) P::increment(counter(pointer));
+            release(mPointer);
+            mPointer = pointer;
+            return *this;
+        }
+
+        /// 代入演算子
+        IntrusiveRC<T, P> &operator=(IntrusiveRC<T, P> &&rc) noexcept
+        {
+            if(&rc == this) return *this;
+            release(mPointer);
+            mPointer = rc.mPointer;
+            rc.mPointer = nullptr;
+            return *this;
+        }
+
+        /// 参照先を取得します
+        T &operator*() const
+        {
+            if(!mPointer) printError("null pointer. T &IntrusiveRC<T, P>::operator*() const");
+            return *mPointer;
+        }
+
+        /// 参照先にアクセスします
+        T *operator->() const noexcept
+        {
+            return mPointer;
+        }
+
+        /// 参照先を取得します
+        T &reference() const
+        {
+            if(!mPointer) printError("null pointer. T &IntrusiveRC<T, P>::reference() const");
+            return *mPointer;
+        }
+
+        /// 参照先にアクセスします
+        T *pointer() const noexcept
+        {
+            return mPointer;
+        }
+
+        /// 参照カウントを返します
+        /// 他のスレッドが増減している場合は、呼び出した時点の目安です
+        size_t count() const
+        {
+            return (mPointer ? counter(mPointer).load(std::memory_order_relaxed) : 0);
+        }
+    };
+
+    /// 参照数を埋め込む参照カウンタポインタを作成します
+    /// オブジェクトのみを1度で確保します
+    /// 最後の参照はどのスレッドでも外れるため、mallocで確保します
+    template<class T, class P = AtomicRefCount, class...Args>
+    IntrusiveRC<T, P> newIntrusiveRC(Args &&...args)
     {
-        auto ptr = new(Memory::allocate(sizeof(T))) T(args...);
-        return RC(ptr, Memory::deleter());
+        static_assert(std::is_base_of_v<RefCounted, T>, "T must derive from RefCounted. newIntrusiveRC<T, P>");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned type. newIntrusiveRC<T, P>");
+        auto memory = std::malloc(sizeof(T));
+        if(!memory)
+        {
+            printError("failed to allocate. IntrusiveRC<T, P> newIntrusiveRC(Args &&...args)");
+            return IntrusiveRC<T, P>();
+        }
+        return IntrusiveRC<T, P>(new(memory) T(std::forward<Args>(args)...));
     }
 }
 
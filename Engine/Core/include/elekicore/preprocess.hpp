@@ -131,6 +131,29 @@ ELEKI_STATICERROR_NOT_SUPPORTED_COMPILER
 
 
 
+#endif
+
+
+//
+// SIMD命令セットを判別します
+// -----
+
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+
+#define ELEKI_SIMD_SSE2 1 ///< SSE2
+
+
+#endif
+
+
+#if defined(__AVX2__)
+
+
+#define ELEKI_SIMD_AVX2 1 ///< AVX2
+
+
 #endif
 
 
@@ -0,0 +1,251 @@
+/// @file priorityqueue.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// d分木ヒープによる優先度付きキューを提供します
+
+#ifndef ELEKICORE_PRIORITYQUEUE_HPP
+#define ELEKICORE_PRIORITYQUEUE_HPP
+
+#include <utility>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "functional.hpp"
+#include "array.hpp"
+#include "handletable.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// d分木ヒープによる優先度付きキューを提供します
+    /// 比較関数で前に並ぶ要素ほど先に取り出します Less<T>の場合は最小の要素からです
+    /// 追加時に返すハンドルで、要素の優先度の変更と削除を行えます
+    /// 子をD個並べて配置するため、2分ヒープより木が浅くキャッシュ効率が良くなります
+    /// @tparam C 第1引数を第2引数より前に並べる場合、真を返す関数オブジェクト
+    /// @tparam D 1節点の子の数
+    template<class T, class C = Less<T>, size_t D = 4>
+    class PriorityQueue
+    {
+        static_assert(D >= 2, "D must be 2 or more. PriorityQueue<T, C, D>");
+
+        // ヒープの要素
+        struct Entry
+        {
+            T value;       // 値
+            Handle handle; // 位置表のハンドル
+        };
+
+        List<Entry> mHeap;            // ヒープ
+        HandleTable<size_t> mIndices; // ハンドルからヒープ上の位置への表
+        C mTrueLR;                    // 比較関数
+
+        // 要素を位置に置き、位置表を更新する
+        void place(size_t index, Entry &&entry)
+        {
+            *mIndices.find(entry.handle) = index;
+            mHeap.data()[index] = std::move(entry);
+        }
+
+        // 要素を根の方向に移動する
+        void siftUp(size_t index)
+        {
+            auto heap = mHeap.data();
+            auto moving = std::move(heap[index]);
+            while(index)
+            {
+                auto parent = (index - 1) / D;
+                if(!mTrueLR(moving.value, heap[parent].value)) break;
+                place(index, std::move(heap[parent]));
+                index = parent;
+            }
+            place(index, std::move(moving));
+        }
+
+        // 要素を葉の方向に移動する
+        void siftDown(size_t index)
+        {
+            auto heap = mHeap.data();
+            auto count = mHeap.count();
+            auto moving = std::move(heap[index]);
+            for(;;)
+            {
+                // 子の中で最も前に並ぶものを探す
+                auto first = index * D + 1;
+                if(first >= count) break;
+                auto last = first + D < count ? first + D : count;
+                auto best = first;
+                for(auto i = first + 1; i < last; i++)
+                {
+                    if(mTrueLR(heap[i].value, heap[best].value)) best = i;
+                }
+                if(!mTrueLR(heap[best].value, moving.value)) break;
+                place(index, std::move(heap[best]));
+                index = best;
+            }
+            place(index, std::move(moving));
+        }
+
+        // 位置の要素を取り除く
+        void removeIndex(size_t index)
+        {
+            auto last = mHeap.count() - 1;
+            mIndices.remove(mHeap.data()[index].handle);
+            if(index != last)
+            {
+                // 末尾の要素を空いた位置に移し、上下どちらかに整える
+                mHeap.data()[index] = std::move(mHeap.data()[last]);
+                mHeap.removeAt(last);
+                *mIndices.find(mHeap.data()[index].handle) = index;
+                if(index && mTrueLR(mHeap.data()[index].value, mHeap.data()[(index - 1) / D].value)) siftUp(index);
+                else siftDown(index);
+            }
+            else
+            {
+                mHeap.removeAt(last);
+            }
+        }
+
+    public:
+
+        /// コンストラクタ
+        /// @param trueLR 第1引数を第2引数より前に並べる場合、真を返してください 等しい場合は偽を返してください
+        /// @param allocator アロケータ
+        PriorityQueue(const C &trueLR = C{}, IAllocator *allocator = Memory::allocator())
+            : mHeap(allocator)
+            , mIndices(allocator)
+            , mTrueLR(trueLR)
+        {}
+
+        /// 追加します
+        /// @return 要素を参照するハンドル 取り出すまで有効です
+        Handle push(const T &value)
+        {
+            return emplace(value);
+        }
+
+        /// 追加します
+        /// @return 要素を参照するハンドル 取り出すまで有効です
+        Handle push(T &&value)
+        {
+            return emplace(std::move(value));
+        }
+
+        /// 直接構築して追加します
+        /// @return 要素を参照するハンドル 取り出すまで有効です
+        template<class...Args>
+        Handle emplace(Args &&...args)
+        {
+            auto index = mHeap.count();
+            auto handle = mIndices.add(index);
+            mHeap.add(Entry{ T(std::forward<Args>(args)...), handle });
+            siftUp(index);
+            return handle;
+        }
+
+        /// 先頭の要素を取得します
+        const T &top() const
+        {
+            if(!mHeap.count()) printError("queue is empty. const T &PriorityQueue<T, C, D>::top() const");
+            return mHeap.data()[0].value;
+        }
+
+        /// 先頭の要素のハンドルを取得します
+        /// @retval INVALID_HANDLE 空でした
+        Handle topHandle() const
+        {
+            return mHeap.count() ? mHeap.data()[0].handle : INVALID_HANDLE;
+        }
+
+        /// 先頭の要素を削除します
+        /// @retval false 空でした
+        bool pop()
+        {
+            if(!mHeap.count()) return false;
+            removeIndex(0);
+            return true;
+        }
+
+        /// 先頭の要素を取り出します
+        /// @param [out] value 取り出した値
+        /// @retval false 空でした
+        bool pop(T &value)
+        {
+            if(!mHeap.count()) return false;
+            value = std::move(mHeap.data()[0].value);
+            removeIndex(0);
+            return true;
+        }
+
+        /// ハンドルが参照する要素の値を変更し、位置を整えます
+        /// 優先度を上げる場合も下げる場合も使用できます
+        /// @retval false 無効なハンドルでした
+        bool update(Handle handle, const T &value)
+        {
+            T tmp = value;
+            return update(handle, std::move(tmp));
+        }
+
+        /// ハンドルが参照する要素の値を変更し、位置を整えます
+        /// 優先度を上げる場合も下げる場合も使用できます
+        /// @retval false 無効なハンドルでした
+        bool update(Handle handle, T &&value)
+        {
+            auto index = mIndices.find(handle);
+            if(!index) return false;
+            auto &entry = mHeap.data()[*index];
+            auto raise = mTrueLR(value, entry.value);
+            entry.value = std::move(value);
+            if(raise) siftUp(*index);
+            else siftDown(*index);
+            return true;
+        }
+
+        /// ハンドルが参照する要素を削除します
+        /// @retval false 無効なハンドルでした
+        bool remove(Handle handle)
+        {
+            auto index = mIndices.find(handle);
+            if(!index) return false;
+            removeIndex(*index);
+            return true;
+        }
+
+        /// ハンドルが参照する要素を取得します
+        /// @return 要素 無効なハンドルの場合nullptr
+        const T *find(Handle handle) const
+        {
+            auto index = mIndices.find(handle);
+            return index ? &mHeap.data()[*index].value : nullptr;
+        }
+
+        /// ハンドルが有効か判定します
+        bool contains(Handle handle) const
+        {
+            return mIndices.contains(handle);
+        }
+
+        /// 要素数を返します
+        size_t count() const
+        {
+            return mHeap.count();
+        }
+
+        /// 空か判定します
+        bool empty() const
+        {
+            return mHeap.count() == 0;
+        }
+
+        /// クリアします
+        /// すべてのハンドルは無効になります
+        void clear()
+        {
+            mHeap.clear();
+            mIndices.clear();
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_PRIORITYQUEUE_HPP
\ No newline at end of file
@@ -0,0 +1,286 @@
+/// @file queue.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// スレッド間で要素を受け渡す固定容量のロックフリーキューを提供します
+
+#ifndef ELEKICORE_QUEUE_HPP
+#define ELEKICORE_QUEUE_HPP
+
+#include <new>
+#include <atomic>
+#include <utility>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "bit.hpp"
+#include "allocation.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// キャッシュラインのバイト数です
+    /// スレッド毎に更新する変数の偽共有を避けるために使用します
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    /// 単一生産者単一消費者のキューを提供します
+    /// 追加と取り出しは待機無しで完了します
+    /// 生産者と消費者はそれぞれ1スレッドに限ります
+    template<class T>
+    class SPSCQueue
+    {
+        // 要素の格納領域
+        struct Slot
+        {
+            alignas(T) u8 data[sizeof(T)];
+        };
+
+        IAllocator *mAllocator;                                // アロケータ
+        size_t mCapacity;                                      // 容量
+        Slot *mSlots;                                          // 格納領域配列
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> mHead;    // 消費者の位置
+        size_t mTailCache;                                     // 消費者が最後に読んだ生産者の位置
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> mTail;    // 生産者の位置
+        size_t mHeadCache;                                     // 生産者が最後に読んだ消費者の位置
+
+        // 位置から要素を取得する
+        T *element(size_t position) const
+        {
+            return (T *) (void *) mSlots[position & (mCapacity - 1)].data;
+        }
+
+    public:
+
+        /// コンストラクタ
+        /// @param capacity 容量 2の冪乗に切り上げます
+        /// @param allocator アロケータ
+        SPSCQueue(size_t capacity, IAllocator *allocator = Memory::allocator())
+            : mAllocator(allocator)
+            , mCapacity((size_t) nextPowerOfTwo(capacity))
+            , mSlots((Slot *) allocator->allocate(sizeof(Slot) * mCapacity))
+            , mHead(0)
+            , mTailCache(0)
+            , mTail(0)
+            , mHeadCache(0)
+        {
+            if(!mSlots) printError("failed to allocate. SPSCQueue<T>::SPSCQueue(size_t capacity, IAllocator *allocator)");
+        }
+
+        SPSCQueue(const SPSCQueue<T> &) = delete;
+        SPSCQueue<T> &operator=(const SPSCQueue<T> &) = delete;
+
+        /// デストラクタ
+        ~SPSCQueue()
+        {
+            auto tail = mTail.load(std::memory_order_relaxed);
+            for(auto i = mHead.load(std::memory_order_relaxed); i != tail; i++) element(i)->~T();
+            if(mSlots) mAllocator->deallocate(mSlots);
+        }
+
+        /// 末尾に追加します
+        /// 生産者スレッドからのみ呼び出せます
+        /// @retval false 満杯でした
+        template<class U>
+        bool push(U &&value)
+        {
+            auto tail = mTail.load(std::memory_order_relaxed);
+            if(tail - mHeadCache == mCapacity)
+            {
+                mHeadCache = mHead.load(std::memory_order_acquire);
+                if(tail - mHeadCache == mCapacity) return false;
+            }
+            new(element(tail)) T(std::forward<U>(value));
+            mTail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// 先頭から取り出します
+        /// 消費者スレッドからのみ呼び出せます
+        /// @param [out] value 取り出した値
+        /// @retval false 空でした
+        bool pop(T &value)
+        {
+            auto head = mHead.load(std::memory_order_relaxed);
+            if(head == mTailCache)
+            {
+                mTailCache = mTail.load(std::memory_order_acquire);
+                if(head == mTailCache) return false;
+            }
+            auto e = element(head);
+            value = std::move(*e);
+            e->~T();
+            mHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// 要素数を返します
+        /// 他スレッドが操作中の場合は概算です
+        size_t count() const
+        {
+            auto head = mHead.load(std::memory_order_acquire);
+            return mTail.load(std::memory_order_acquire) - head;
+        }
+
+        /// 空か判定します
+        /// 他スレッドが操作中の場合は概算です
+        bool empty() const
+        {
+            return count() == 0;
+        }
+
+        /// 容量を返します
+        size_t capacity() const
+        {
+            return mCapacity;
+        }
+    };
+
+    /// 複数生産者複数消費者の固定容量キューを提供します
+    /// 格納領域毎の順番号で所有を判定する方式で、追加と取り出しはロックを使用しません
+    template<class T>
+    class MPMCQueue
+    {
+        // 要素の格納領域
+        struct Cell
+        {
+            std::atomic<size_t> sequence;   // 順番号
+            alignas(T) u8 data[sizeof(T)];  // 要素
+        };
+
+        IAllocator *mAllocator;                             // アロケータ
+        size_t mCapacity;                                   // 容量
+        Cell *mCells;                                       // 格納領域配列
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> mHead; // 取り出し位置
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> mTail; // 追加位置
+
+    public:
+
+        /// コンストラクタ
+        /// @param capacity 容量 2以上の2の冪乗に切り上げます
+        /// @param allocator アロケータ
+        MPMCQueue(size_t capacity, IAllocator *allocator = Memory::allocator())
+            : mAllocator(allocator)
+            , mCapacity((size_t) nextPowerOfTwo(capacity < 2 ? 2 : capacity))
+            , mCells((Cell *) allocator->allocate(sizeof(Cell) * mCapacity))
+            , mHead(0)
+            , mTail(0)
+        {
+            if(!mCells)
+            {
+                printError("failed to allocate. MPMCQueue<T>::MPMCQueue(size_t capacity, IAllocator *allocator)");
+                return;
+            }
+            for(size_t i = 0; i < mCapacity; i++)
+            {
+                new(&mCells[i].sequence) std::atomic<size_t>(i);
+            }
+        }
+
+        MPMCQueue(const MPMCQueue<T> &) = delete;
+        MPMCQueue<T> &operator=(const MPMCQueue<T> &) = delete;
+
+        /// デストラクタ
+        ~MPMCQueue()
+        {
+            if(!mCells) return;
+            auto tail = mTail.load(std::memory_order_relaxed);
+            for(auto i = mHead.load(std::memory_order_relaxed); i != tail; i++)
+            {
+                ((T *) (void *) mCells[i & (mCapacity - 1)].data)->~T();
+            }
+            for(size_t i = 0; i < mCapacity; i++) mCells[i].sequence.~atomic();
+            mAllocator->deallocate(mCells);
+        }
+
+        /// 末尾に追加します
+        /// @retval false 満杯でした
+        template<class U>
+        bool push(U &&value)
+        {
+            Cell *cell;
+            auto position = mTail.load(std::memory_order_relaxed);
+            for(;;)
+            {
+                cell = &mCells[position & (mCapacity - 1)];
+                auto sequence = cell->sequence.load(std::memory_order_acquire);
+                auto diff = (i64) sequence - (i64) position;
+                if(diff == 0)
+                {
+                    // 空いている領域の所有を試みる
+                    if(mTail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+                }
+                else if(diff < 0)
+                {
+                    // 1周前の要素が取り出されていない
+                    return false;
+                }
+                else
+                {
+                    position = mTail.load(std::memory_order_relaxed);
+                }
+            }
+            new(cell->data) T(std::forward<U>(value));
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// 先頭から取り出します
+        /// @param [out] value 取り出した値
+        /// @retval false 空でした
+        bool pop(T &value)
+        {
+            Cell *cell;
+            auto position = mHead.load(std::memory_order_relaxed);
+            for(;;)
+            {
+                cell = &mCells[position & (mCapacity - 1)];
+                auto sequence = cell->sequence.load(std::memory_order_acquire);
+                auto diff = (i64) sequence - (i64) (position + 1);
+                if(diff == 0)
+                {
+                    // 書き込み済みの領域の所有を試みる
+                    if(mHead.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+                }
+                else if(diff < 0)
+                {
+                    // まだ書き込まれていない
+                    return false;
+                }
+                else
+                {
+                    position = mHead.load(std::memory_order_relaxed);
+                }
+            }
+            auto e = (T *) (void *) cell->data;
+            value = std::move(*e);
+            e->~T();
+            cell->sequence.store(position + mCapacity, std::memory_order_release);
+            return true;
+        }
+
+        /// 要素数を返します
+        /// 他スレッドが操作中の場合は概算です
+        size_t count() const
+        {
+            auto head = mHead.load(std::memory_order_acquire);
+            auto tail = mTail.load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+
+        /// 空か判定します
+        /// 他スレッドが操作中の場合は概算です
+        bool empty() const
+        {
+            return count() == 0;
+        }
+
+        /// 容量を返します
+        size_t capacity() const
+        {
+            return mCapacity;
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_QUEUE_HPP
\ No newline at end of file
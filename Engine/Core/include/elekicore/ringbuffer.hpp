@@ -0,0 +1,264 @@
+/// @file ringbuffer.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 固定容量の循環バッファを提供します
+
+#ifndef ELEKICORE_RINGBUFFER_HPP
+#define ELEKICORE_RINGBUFFER_HPP
+
+#include <new>
+#include <utility>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "bit.hpp"
+#include "allocation.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// 循環バッファが満杯のときの追加方法の列挙です
+    enum class ERingBufferMode
+    {
+
+        OVERWRITE, ///< 最も古い要素を上書きします
+        REJECT,    ///< 追加を拒否します
+
+    };
+
+    /// 固定容量の循環バッファを提供します
+    /// 容量は2の冪乗に切り上げ、添え字はマスクで求めます
+    /// 生成後は要素を追加しても確保を行いません
+    template<class T>
+    class RingBuffer
+    {
+        IAllocator *mAllocator; // アロケータ
+        ERingBufferMode mMode;  // 満杯のときの追加方法
+        size_t mCapacity;       // 容量
+        size_t mHead;           // 先頭位置
+        size_t mTail;           // 末尾位置
+        T *mElements;           // 要素配列
+
+        // 位置から要素を取得する
+        T &slot(size_t position) const
+        {
+            return mElements[position & (mCapacity - 1)];
+        }
+
+    public:
+
+        /// コンストラクタ
+        /// @param capacity 容量 2の冪乗に切り上げます
+        /// @param mode 満杯のときの追加方法
+        /// @param allocator アロケータ
+        RingBuffer(size_t capacity, ERingBufferMode mode = ERingBufferMode::REJECT, IAllocator *allocator = Memory::allocator())
+            : mAllocator(allocator)
+            , mMode(mode)
+            , mCapacity((size_t) nextPowerOfTwo(capacity))
+            , mHead(0)
+            , mTail(0)
+            , mElements((T *) allocator->allocate(sizeof(T) * mCapacity))
+        {
+            if(!mElements) printError("failed to allocate. RingBuffer<T>::RingBuffer(size_t capacity, ERingBufferMode mode, IAllocator *allocator)");
+        }
+
+        /// コピーコンストラクタ
+        RingBuffer(const RingBuffer<T> &buffer)
+            : RingBuffer(buffer.mCapacity, buffer.mMode, buffer.mAllocator)
+        {
+            for(auto i = buffer.mHead; i != buffer.mTail; i++)
+            {
+                new(&slot(mTail++)) T(buffer.slot(i));
+            }
+        }
+
+        /// ムーブコンストラクタ
+        RingBuffer(RingBuffer<T> &&buffer) noexcept
+            : mAllocator(buffer.mAllocator)
+            , mMode(buffer.mMode)
+            , mCapacity(buffer.mCapacity)
+            , mHead(buffer.mHead)
+            , mTail(buffer.mTail)
+            , mElements(buffer.mElements)
+        {
+            buffer.mHead = 0;
+            buffer.mTail = 0;
+            buffer.mElements = nullptr;
+        }
+
+        /// デストラクタ
+        ~RingBuffer()
+        {
+            clear();
+            if(mElements) mAllocator->deallocate(mElements);
+        }
+
+        /// コピー代入します
+        RingBuffer<T> &operator=(const RingBuffer<T> &buffer)
+        {
+            if(this == &buffer) return *this;
+            this->~RingBuffer();
+            new(this) RingBuffer<T>(buffer);
+            return *this;
+        }
+
+        /// ムーブ代入します
+        RingBuffer<T> &operator=(RingBuffer<T> &&buffer) noexcept
+        {
+            if(this == &buffer) return *this;
+            this->~RingBuffer();
+            new(this) RingBuffer<T>(std::move(buffer));
+            return *this;
+        }
+
+        /// 古い方からの位置で要素を取得します
+        T &operator[](size_t index)
+        {
+            return at(index);
+        }
+
+        /// 古い方からの位置で要素を取得します
+        const T &operator[](size_t index) const
+        {
+            return at(index);
+        }
+
+        /// 末尾に追加します
+        /// @retval false 満杯のため追加を拒否しました
+        bool push(const T &value)
+        {
+            return emplace(value);
+        }
+
+        /// 末尾に追加します
+        /// @retval false 満杯のため追加を拒否しました
+        bool push(T &&value)
+        {
+            return emplace(std::move(value));
+        }
+
+        /// 末尾に直接構築します
+        /// @retval false 満杯のため追加を拒否しました
+        template<class...Args>
+        bool emplace(Args &&...args)
+        {
+            if(!full())
+            {
+                new(&slot(mTail)) T(std::forward<Args>(args)...);
+                mTail++;
+                return true;
+            }
+            if(mMode == ERingBufferMode::REJECT) return false;
+
+            // 引数がバッファ内の要素を参照している場合があるため、最も古い要素を破棄する前に構築する
+            T value(std::forward<Args>(args)...);
+            slot(mHead).~T();
+            mHead++;
+            new(&slot(mTail)) T(std::move(value));
+            mTail++;
+            return true;
+        }
+
+        /// 先頭から取り出します
+        /// @param [out] value 取り出した値
+        /// @retval false 空でした
+        bool pop(T &value)
+        {
+            if(empty()) return false;
+            auto &element = slot(mHead);
+            value = std::move(element);
+            element.~T();
+            mHead++;
+            return true;
+        }
+
+        /// 先頭の要素を破棄します
+        /// @retval false 空でした
+        bool drop()
+        {
+            if(empty()) return false;
+            slot(mHead).~T();
+            mHead++;
+            return true;
+        }
+
+        /// 古い方からの位置で要素を取得します
+        T &at(size_t index)
+        {
+            if(index >= count()) printError("out of range. T &RingBuffer<T>::at(size_t index)");
+            return slot(mHead + index);
+        }
+
+        /// 古い方からの位置で要素を取得します
+        const T &at(size_t index) const
+        {
+            if(index >= count()) printError("out of range. const T &RingBuffer<T>::at(size_t index) const");
+            return slot(mHead + index);
+        }
+
+        /// 最も古い要素を取得します
+        T &front()
+        {
+            if(empty()) printError("buffer is empty. T &RingBuffer<T>::front()");
+            return slot(mHead);
+        }
+
+        /// 最も新しい要素を取得します
+        T &back()
+        {
+            if(empty()) printError("buffer is empty. T &RingBuffer<T>::back()");
+            return slot(mTail - 1);
+        }
+
+        /// 要素数を返します
+        size_t count() const
+        {
+            return mTail - mHead;
+        }
+
+        /// 容量を返します
+        size_t capacity() const
+        {
+            return mCapacity;
+        }
+
+        /// 空か判定します
+        bool empty() const
+        {
+            return mHead == mTail;
+        }
+
+        /// 満杯か判定します
+        bool full() const
+        {
+            return count() == mCapacity;
+        }
+
+        /// 満杯のときの追加方法を返します
+        ERingBufferMode mode() const
+        {
+            return mMode;
+        }
+
+        /// クリアします
+        void clear()
+        {
+            if(mElements)
+            {
+                for(auto i = mHead; i != mTail; i++) slot(i).~T();
+            }
+            mHead = 0;
+            mTail = 0;
+        }
+
+        /// アロケータを取得します
+        IAllocator *allocator() const
+        {
+            return mAllocator;
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_RINGBUFFER_HPP
\ No newline at end of file
@@ -0,0 +1,423 @@
+/// @file rope.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 編集可能な長い文字列を、文字列片の平衡木で保持するロープを提供します
+/// 挿入、削除、位置と行の検索は全体の長さに依らず対数時間で行い、インターンは行いません
+
+#ifndef ELEKICORE_ROPE_HPP
+#define ELEKICORE_ROPE_HPP
+
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "allocation.hpp"
+#include "stringsimd.hpp"
+#include "stringview.hpp"
+#include "string.hpp"
+#include "stringbuilder.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// ロープの1つの文字列片の最大文字数です
+    constexpr size_t ROPE_CHUNK_CHARS = 1024;
+
+    /// ロープの内部節点の最大の子の数です
+    constexpr size_t ROPE_NODE_CHILDREN = 16;
+
+    /// ロープのメモリプールが1度に確保する節点数です
+    constexpr size_t ROPE_POOL_NODES_COUNT = 16;
+
+    /// 編集可能な長い文字列です
+    /// 文字列片を葉に持つB+木で、内部節点は子の文字数と改行の数を持ちます
+    /// エディタのテキストバッファやログの表示など、長い文字列を少しずつ編集する場合に使用します
+    /// 位置はバイト単位で、文字列片の境界はUTF-8の文字の途中になる場合があります
+    /// 節点はメモリプールから確保します
+    class ELEKICORE_EXPORT Rope
+    {
+        static constexpr size_t MAX_DEPTH = 48; // 内部節点の深さの上限
+
+        // 節点
+        struct Node
+        {
+            size_t count; // 文字列片の文字数、または、子の数
+            bool leaf;    // 葉か
+        };
+
+        // 葉 文字列片を持ち、前後の葉と連結する
+        struct Leaf: Node
+        {
+            Leaf *prev;                  // 前の葉
+            Leaf *next;                  // 次の葉
+            size_t lines;                // 改行の数
+            Char text[ROPE_CHUNK_CHARS]; // 文字列片
+        };
+
+        // 内部節点 分割前に1つ多く入れられるようにする
+        struct Inner: Node
+        {
+            size_t chars[ROPE_NODE_CHILDREN + 1];   // 子の文字数
+            size_t lines[ROPE_NODE_CHILDREN + 1];   // 子の改行の数
+            Node *children[ROPE_NODE_CHILDREN + 1]; // 子
+        };
+
+        IAllocator *mAllocator;        // メモリプールを確保するアロケータ
+        DynamicMemoryPool *mLeafPool;  // 葉を確保するメモリプール
+        DynamicMemoryPool *mInnerPool; // 内部節点を確保するメモリプール
+        Node *mRoot;                   // 根
+        Leaf *mFirst;                  // 先頭の葉
+        Leaf *mLast;                   // 末尾の葉
+        size_t mCount;                 // 文字数
+        size_t mLines;                 // 改行の数
+        size_t mHeight;                // 高さ 空の場合0
+
+        // メモリプールを作成する
+        DynamicMemoryPool *createPool(size_t size);
+
+        // 葉を確保する
+        Leaf *newLeaf();
+
+        // 内部節点を確保する
+        Inner *newInner();
+
+        // 節点と子孫を破棄する
+        static void destroyNode(Node *node);
+
+        // 子の文字数と改行の数を数え直す
+        static void updateEntry(Inner *parent, size_t slot);
+
+        // 経路上の文字数と改行の数を数え直す
+        static void updatePath(Inner **path, size_t *slots, size_t depth);
+
+        // 位置を含む葉を探し、経路を記録する
+        Leaf *findLeaf(size_t &index, Inner **path, size_t *slots, size_t &depth, bool atEnd) const;
+
+        // 分割した節点を経路の親へ挿入する
+        void insertChild(Inner **path, size_t *slots, size_t depth, Node *node, Inner **spares, size_t &spareCount);
+
+        // 1つの葉に収まる文字列を挿入する
+        bool insertChunk(size_t index, const Char *text, size_t count);
+
+        // 空になった節点を外し、小さな節点を兄弟と併合する
+        void rebalance(Inner **path, size_t *slots, size_t depth);
+
+        // 葉を連結から外す
+        void unlinkLeaf(Leaf *leaf);
+
+        // 位置を進める
+        static void advance(Leaf *&leaf, size_t &offset, size_t count)
+        {
+            while(leaf && count >= leaf->count - offset)
+            {
+                count -= leaf->count - offset;
+                leaf = leaf->next;
+                offset = 0;
+                if(!count) break;
+            }
+            offset += count;
+        }
+
+    public:
+
+        /// 文字列片の範囲です
+        /// 範囲for文で、各文字列片を複製せずにStringViewとして走査できます
+        class Range
+        {
+            Leaf *mLeaf;    // 先頭の葉
+            size_t mOffset; // 先頭の葉の中の位置
+            size_t mCount;  // 文字数
+
+        public:
+
+            /// 前方向イテレータ
+            class Itr
+            {
+                Leaf *mLeaf;      // 葉
+                size_t mOffset;   // 葉の中の位置
+                size_t mRemained; // 残りの文字数
+
+            public:
+
+                /// コンストラクタ
+                Itr(Leaf *leaf, size_t offset, size_t remained)
+                    : mLeaf(leaf)
+                    , mOffset(offset)
+                    , mRemained(remained)
+                {}
+
+                /// 次の文字列片に移動します
+                Itr &operator++()
+                {
+                    auto count = mLeaf->count - mOffset;
+                    mRemained -= count < mRemained ? count : mRemained;
+                    mLeaf = mLeaf->next;
+                    mOffset = 0;
+                    return *this;
+                }
+
+                /// 文字列片を取得します
+                StringView operator*() const
+                {
+                    auto count = mLeaf->count - mOffset;
+                    return StringView(mLeaf->text + mOffset, count < mRemained ? count : mRemained);
+                }
+
+                /// 位置が等しいか判定します
+                bool operator==(const Itr &r) const
+                {
+                    return mRemained == r.mRemained;
+                }
+
+                /// 位置が等しくないか判定します
+                bool operator!=(const Itr &r) const
+                {
+                    return mRemained != r.mRemained;
+                }
+            };
+
+            /// コンストラクタ
+            Range(Leaf *leaf, size_t offset, size_t count)
+                : mLeaf(leaf)
+                , mOffset(offset)
+                , mCount(count)
+            {}
+
+            /// 先頭イテレータを返します
+            Itr begin() const
+            {
+                return Itr(mLeaf, mOffset, mCount);
+            }
+
+            /// 番兵イテレータを返します
+            Itr end() const
+            {
+                return Itr(nullptr, 0, 0);
+            }
+
+            /// 文字数を返します
+            size_t count() const
+            {
+                return mCount;
+            }
+
+            /// 空か判定します
+            bool empty() const
+            {
+                return mCount == 0;
+            }
+
+            /// 末尾に連結します
+            /// @param string 連結先
+            template<size_t N>
+            SmallString<N> &appendTo(SmallString<N> &string) const
+            {
+                for(auto chunk : *this) string.append(chunk.data(), chunk.count());
+                return string;
+            }
+
+            /// 文字列に変換します
+            /// インターンは完成した文字列に対して1度だけ行います
+            String toString() const
+            {
+                StringBuilder builder(mCount);
+                return appendTo(builder).toString();
+            }
+        };
+
+        /// 行の範囲です
+        /// 範囲for文で、各行を改行を含まない文字列片の範囲として走査できます
+        class LineRange
+        {
+            Leaf *mLeaf;    // 先頭の葉
+            size_t mLines;  // 行数
+
+        public:
+
+            /// 前方向イテレータ
+            class Itr
+            {
+                Leaf *mLeaf;    // 行の先頭の葉
+                size_t mOffset; // 行の先頭の葉の中の位置
+                size_t mLine;   // 行番号
+                size_t mCount;  // 行の文字数
+
+                // 行の文字数を数える
+                void measure()
+                {
+                    mCount = 0;
+                    auto offset = mOffset;
+                    for(auto leaf = mLeaf; leaf; leaf = leaf->next, offset = 0)
+                    {
+                        auto rest = leaf->count - offset;
+                        auto index = stringIndexOf(leaf->text + offset, rest, '\n');
+                        mCount += index;
+                        if(index < rest) break;
+                    }
+                }
+
+            public:
+
+                /// コンストラクタ
+                Itr(Leaf *leaf, size_t line)
+                    : mLeaf(leaf)
+                    , mOffset(0)
+                    , mLine(line)
+                    , mCount(0)
+                {
+                    measure();
+                }
+
+                /// 次の行に移動します
+                Itr &operator++()
+                {
+                    advance(mLeaf, mOffset, mCount + 1);
+                    mLine++;
+                    measure();
+                    return *this;
+                }
+
+                /// 行を取得します
+                Range operator*() const
+                {
+                    return Range(mLeaf, mOffset, mCount);
+                }
+
+                /// 行番号を返します
+                size_t line() const
+                {
+                    return mLine;
+                }
+
+                /// 位置が等しいか判定します
+                bool operator==(const Itr &r) const
+                {
+                    return mLine == r.mLine;
+                }
+
+                /// 位置が等しくないか判定します
+                bool operator!=(const Itr &r) const
+                {
+                    return mLine != r.mLine;
+                }
+            };
+
+            /// コンストラクタ
+            LineRange(Leaf *leaf, size_t lines)
+                : mLeaf(leaf)
+                , mLines(lines)
+            {}
+
+            /// 先頭イテレータを返します
+            Itr begin() const
+            {
+                return Itr(mLeaf, 0);
+            }
+
+            /// 番兵イテレータを返します
+            Itr end() const
+            {
+                return Itr(nullptr, mLines);
+            }
+        };
+
+        /// コンストラクタ
+        /// @param allocator メモリプールを確保するアロケータ
+        Rope(IAllocator *allocator = Memory::allocator());
+
+        /// コンストラクタ
+        /// @param text 初期の文字列
+        /// @param allocator メモリプールを確保するアロケータ
+        explicit Rope(StringView text, IAllocator *allocator = Memory::allocator());
+
+        /// コピーコンストラクタ
+        Rope(const Rope &rope);
+
+        /// ムーブコンストラクタ
+        Rope(Rope &&rope) noexcept;
+
+        /// デストラクタ
+        ~Rope();
+
+        /// コピー代入
+        Rope &operator=(const Rope &rope);
+
+        /// ムーブ代入
+        Rope &operator=(Rope &&rope) noexcept;
+
+        /// 文字列を挿入します
+        /// 文字列片の最大文字数の半分ずつ挿入するため、挿入する文字数に比例した時間がかかります
+        /// @param index 挿入する位置
+        /// @param text 挿入する文字列
+        /// @return 挿入に成功した場合真
+        bool insert(size_t index, StringView text);
+
+        /// 末尾に連結します
+        /// @param text 連結する文字列
+        /// @return 連結に成功した場合真
+        bool append(StringView text);
+
+        /// 範囲の文字を削除します
+        /// @param index 削除する先頭の位置
+        /// @param count 削除する文字数
+        void remove(size_t index, size_t count);
+
+        /// 全ての文字を削除します
+        void clear();
+
+        /// 位置の文字を返します
+        Char at(size_t index) const;
+
+        /// 範囲を切り出します
+        /// 複製は行わず、ロープを変更するまで使用できます
+        /// @param index 切り出す先頭の位置
+        /// @param count 切り出す文字数
+        Range slice(size_t index, size_t count) const;
+
+        /// 全体を文字列片の範囲として返します
+        Range chunks() const;
+
+        /// 行の先頭の位置を返します
+        /// @param line 行番号
+        size_t lineStart(size_t line) const;
+
+        /// 位置を含む行の行番号を返します
+        /// @param index 位置
+        size_t lineOf(size_t index) const;
+
+        /// 行を改行を含まない範囲として返します
+        /// @param line 行番号
+        Range line(size_t line) const;
+
+        /// 全ての行を先頭から走査する範囲を返します
+        LineRange lines() const;
+
+        /// 文字数を返します
+        size_t count() const;
+
+        /// 行数を返します
+        /// 末尾が改行の場合、その後ろの空の行も数えます
+        size_t lineCount() const;
+
+        /// 空か判定します
+        bool empty() const;
+
+        /// 文字列に変換します
+        /// インターンは完成した文字列に対して1度だけ行います
+        String toString() const;
+
+        /// 末尾に連結します
+        /// @param string 連結先
+        template<size_t N>
+        SmallString<N> &appendTo(SmallString<N> &string) const
+        {
+            return chunks().appendTo(string);
+        }
+
+        /// アロケータを返します
+        IAllocator *allocator() const;
+    };
+
+}
+
+#endif // !ELEKICORE_ROPE_HPP
\ No newline at end of file
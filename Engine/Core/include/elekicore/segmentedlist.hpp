@@ -0,0 +1,344 @@
+/// @file segmentedlist.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 要素のアドレスが変わらない分割配列を提供します
+
+#ifndef ELEKICORE_SEGMENTEDLIST_HPP
+#define ELEKICORE_SEGMENTEDLIST_HPP
+
+#include <new>
+#include <utility>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "bit.hpp"
+#include "allocation.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// 分割配列のメモリプールが1度に確保するブロック数です
+    constexpr size_t SEGMENTEDLIST_POOL_BLOCKS_COUNT = 8;
+
+    /// 要素のアドレスが変わらない分割配列を提供します
+    /// 固定長のブロックをメモリプールから確保し、ブロックのポインタ表で管理します
+    /// 伸長してもブロックは移動しないため、要素へのポインタを保持し続けられます
+    /// @tparam B 1ブロックの要素数 2の冪乗である必要があります
+    template<class T, size_t B = 64>
+    class SegmentedList
+    {
+        static_assert(isPowerOfTwo(B), "block size must be a power of two. SegmentedList<T, B>");
+        static_assert(alignof(T) <= alignof(size_t), "not supported alignment. SegmentedList<T, B>");
+
+        IAllocator *mAllocator;   // ブロック表と、メモリプールを確保するアロケータ
+        DynamicMemoryPool *mPool; // ブロックを確保するメモリプール
+        T **mBlocks;              // ブロック表
+        size_t mBlocksSize;       // ブロック表のサイズ
+        size_t mBlocksCount;      // 確保済みブロック数
+        size_t mCount;            // 要素数
+
+        // 要素を取得する
+        T &element(size_t index) const
+        {
+            return mBlocks[index / B][index & (B - 1)];
+        }
+
+        // ブロックを1つ追加する
+        bool addBlock()
+        {
+            // ブロック表を伸長する ブロック自体は移動しない
+            if(mBlocksCount == mBlocksSize)
+            {
+                auto newSize = mBlocksSize ? mBlocksSize * 2 : 4;
+                auto newBlocks = (T **) mAllocator->allocate(sizeof(T *) * newSize);
+                if(!newBlocks) return false;
+                for(size_t i = 0; i < mBlocksCount; i++) newBlocks[i] = mBlocks[i];
+                if(mBlocks) mAllocator->deallocate(mBlocks);
+                mBlocks = newBlocks;
+                mBlocksSize = newSize;
+            }
+
+            // メモリプールは初回に作成する
+            if(!mPool)
+            {
+                auto memory = mAllocator->allocate(sizeof(DynamicMemoryPool));
+                if(!memory) return false;
+                mPool = new(memory) DynamicMemoryPool(sizeof(T) * B, SEGMENTEDLIST_POOL_BLOCKS_COUNT);
+            }
+
+            auto block = (T *) mPool->allocate();
+            if(!block) return false;
+            mBlocks[mBlocksCount++] = block;
+            return true;
+        }
+
+    public:
+
+        /// 順方向イテレータです
+        template<class R>
+        class Itr
+        {
+            const SegmentedList<T, B> *mList; // 分割配列
+            size_t mIndex;                    // 位置
+
+        public:
+
+            /// コンストラクタ
+            Itr(const SegmentedList<T, B> *list, size_t index)
+                : mList(list)
+                , mIndex(index)
+            {}
+
+            /// 次に移動します
+            Itr<R> &operator++()
+            {
+                mIndex++;
+                return *this;
+            }
+
+            /// 要素を取得します
+            R &operator*() const
+            {
+                return mList->element(mIndex);
+            }
+
+            /// 要素を取得します
+            R *operator->() const
+            {
+                return &mList->element(mIndex);
+            }
+
+            /// 位置が等しいか判定します
+            bool operator==(const Itr<R> &r) const
+            {
+                return mIndex == r.mIndex;
+            }
+
+            /// 位置が等しくないか判定します
+            bool operator!=(const Itr<R> &r) const
+            {
+                return mIndex != r.mIndex;
+            }
+        };
+
+        /// コンストラクタ
+        /// @param allocator ブロック表と、メモリプールを確保するアロケータ
+        SegmentedList(IAllocator *allocator = Memory::allocator())
+            : mAllocator(allocator)
+            , mPool(nullptr)
+            , mBlocks(nullptr)
+            , mBlocksSize(0)
+            , mBlocksCount(0)
+            , mCount(0)
+        {}
+
+        /// コピーコンストラクタ
+        SegmentedList(const SegmentedList<T, B> &list)
+            : SegmentedList(list.mAllocator)
+        {
+            reserve(list.mCount);
+            for(size_t i = 0; i < list.mCount; i++) add(list.element(i));
+        }
+
+        /// ムーブコンストラクタ
+        SegmentedList(SegmentedList<T, B> &&list) noexcept
+            : mAllocator(list.mAllocator)
+            , mPool(list.mPool)
+            , mBlocks(list.mBlocks)
+            , mBlocksSize(list.mBlocksSize)
+            , mBlocksCount(list.mBlocksCount)
+            , mCount(list.mCount)
+        {
+            list.mPool = nullptr;
+            list.mBlocks = nullptr;
+            list.mBlocksSize = 0;
+            list.mBlocksCount = 0;
+            list.mCount = 0;
+        }
+
+        /// デストラクタ
+        ~SegmentedList()
+        {
+            clear();
+            shrink();
+            if(mBlocks) mAllocator->deallocate(mBlocks);
+            if(mPool)
+            {
+                mPool->~DynamicMemoryPool();
+                mAllocator->deallocate(mPool);
+            }
+        }
+
+        /// コピー代入します
+        SegmentedList<T, B> &operator=(const SegmentedList<T, B> &list)
+        {
+            if(this == &list) return *this;
+            clear();
+            reserve(list.mCount);
+            for(size_t i = 0; i < list.mCount; i++) add(list.element(i));
+            return *this;
+        }
+
+        /// ムーブ代入します
+        SegmentedList<T, B> &operator=(SegmentedList<T, B> &&list) noexcept
+        {
+            if(this == &list) return *this;
+            this->~SegmentedList();
+            new(this) SegmentedList<T, B>(std::move(list));
+            return *this;
+        }
+
+        /// 添え字からアクセスします
+        T &operator[](size_t index)
+        {
+            return at(index);
+        }
+
+        /// 添え字からアクセスします
+        const T &operator[](size_t index) const
+        {
+            return at(index);
+        }
+
+        /// 末尾に追加します
+        /// @return 追加した要素 追加後に伸長してもアドレスは変わりません
+        T &add(const T &value)
+        {
+            return emplace(value);
+        }
+
+        /// 末尾に追加します
+        /// @return 追加した要素 追加後に伸長してもアドレスは変わりません
+        T &add(T &&value)
+        {
+            return emplace(std::move(value));
+        }
+
+        /// 末尾に直接構築します
+        /// @return 追加した要素 追加後に伸長してもアドレスは変わりません
+        template<class...Args>
+        T &emplace(Args &&...args)
+        {
+            if(mCount == capacity() && !addBlock()) printError("failed to allocate. T &SegmentedList<T, B>::emplace(Args &&...args)");
+            auto &e = element(mCount);
+            new(&e) T(std::forward<Args>(args)...);
+            mCount++;
+            return e;
+        }
+
+        /// 末尾の要素を削除します
+        SegmentedList<T, B> &removeLast()
+        {
+            if(!mCount)
+            {
+                printError("list is empty. SegmentedList<T, B> &SegmentedList<T, B>::removeLast()");
+                return *this;
+            }
+            element(--mCount).~T();
+            return *this;
+        }
+
+        /// 添え字からアクセスします
+        T &at(size_t index)
+        {
+            if(index >= mCount) printError("out of range. T &SegmentedList<T, B>::at(size_t index)");
+            return element(index);
+        }
+
+        /// 添え字からアクセスします
+        const T &at(size_t index) const
+        {
+            if(index >= mCount) printError("out of range. const T &SegmentedList<T, B>::at(size_t index) const");
+            return element(index);
+        }
+
+        /// 末尾の要素を取得します
+        T &last()
+        {
+            if(!mCount) printError("list is empty. T &SegmentedList<T, B>::last()");
+            return element(mCount - 1);
+        }
+
+        /// 要素数を返します
+        size_t count() const
+        {
+            return mCount;
+        }
+
+        /// 確保済みの容量を返します
+        size_t capacity() const
+        {
+            return mBlocksCount * B;
+        }
+
+        /// 確保済みのブロック数を返します
+        size_t blocksCount() const
+        {
+            return mBlocksCount;
+        }
+
+        /// 容量を指定数以上にします
+        SegmentedList<T, B> &reserve(size_t size)
+        {
+            while(capacity() < size)
+            {
+                if(!addBlock())
+                {
+                    printError("failed to allocate. SegmentedList<T, B> &SegmentedList<T, B>::reserve(size_t size)");
+                    break;
+                }
+            }
+            return *this;
+        }
+
+        /// 使用していないブロックを解放します
+        SegmentedList<T, B> &shrink()
+        {
+            auto used = (mCount + B - 1) / B;
+            while(mBlocksCount > used) DynamicMemoryPool::deallocate(mBlocks[--mBlocksCount]);
+            return *this;
+        }
+
+        /// すべての要素を削除します
+        /// ブロックは解放せず再利用します
+        void clear()
+        {
+            for(size_t i = 0; i < mCount; i++) element(i).~T();
+            mCount = 0;
+        }
+
+        /// 先頭イテレータを返します
+        Itr<T> begin()
+        {
+            return Itr<T>(this, 0);
+        }
+
+        /// 番兵イテレータを返します
+        Itr<T> end()
+        {
+            return Itr<T>(this, mCount);
+        }
+
+        /// 先頭イテレータを返します
+        Itr<const T> begin() const
+        {
+            return Itr<const T>(this, 0);
+        }
+
+        /// 番兵イテレータを返します
+        Itr<const T> end() const
+        {
+            return Itr<const T>(this, mCount);
+        }
+
+        /// アロケータを取得します
+        IAllocator *allocator() const
+        {
+            return mAllocator;
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_SEGMENTEDLIST_HPP
\ No newline at end of file
@@ -48,6 +48,7 @@
 #include "utility.hpp"
 #include "tasks.hpp"
 #include "map.hpp"
+#include "stringid.hpp"
 
 /// ELEKi ENGINE
 namespace ElekiEngine
@@ -70,6 +71,11 @@ namespace ElekiEngine
 		/// @param allocator 使用するアロケータ
 		Binary(std::initializer_list<u8> list, IAllocator *allocator = Memory::allocator());
 
+		/// コンストラクタ
+		/// @param view コピーするバイト列のビュー
+		/// @param allocator 使用するアロケータ
+		explicit Binary(ByteView view, IAllocator *allocator = Memory::allocator());
+
 		/// コピーコンストラクタ
 		Binary(const Binary &binary);
 
@@ -91,6 +97,9 @@ namespace ElekiEngine
 		/// 末尾に追加します
 		Binary &operator+=(Binary &&binary) noexcept;
 
+		/// 末尾に追加します
+		Binary &operator+=(ByteView view);
+
 		/// 末尾に追加します
 		Binary &operator+=(const u8 &element);
 
@@ -399,31 +408,36 @@ namespace ElekiEngine
 			}
 		};
 
-		// データバイナリをシリアライズバイナリにシリアライズします
-		template<> struct ToBinary<Binary>
+		// バイト列をシリアライズバイナリにシリアライズします
+		template<> struct ToBinary<ByteView>
 		{
-			void operator()(Ref<Binary> binary, SerializeInfo &info, const Binary &value)
+			void operator()(Ref<Binary> binary, SerializeInfo &info, ByteView value)
 			{
-				size_t size = value.count();
 				size_t index = 0;
 				do
 				{
 					binary->add((u8) EBinarySign::BINARY);
-					size_t length = size > U32_MAX ? U32_MAX : size;
-					size -= length;
+					auto rest = value.count() - index;
+					auto length = rest > U32_MAX ? (size_t) U32_MAX : rest;
 
-					ToBinary<u32>{}(binary, info, length);
-					while(index != 0)
-					{
-						binary->add(value[index]);
-						index++;
-					}
+					ToBinary<u32>{}(binary, info, (u32) length);
+					binary->add(value.sub(index, length));
+					index += length;
 				}
-				while(size != 0);
+				while(index != value.count());
 				binary->add((u8) EBinarySign::END);
 			}
 		};
 
+		// データバイナリをシリアライズバイナリにシリアライズします
+		template<> struct ToBinary<Binary>
+		{
+			void operator()(Ref<Binary> binary, SerializeInfo &info, const Binary &value)
+			{
+				ToBinary<ByteView>{}(binary, info, value);
+			}
+		};
+
 		/// シリアライズクラスを使いバイナリにシリアライズします
 		template<class T, bool IS_ISERIALIZABLE = std::is_base_of_v<ISerializable, T>>
 		struct SerializableToBinary
@@ -543,7 +557,7 @@ namespace ElekiEngine
 		/// 構造データノード構造体です
 		struct ELEKICORE_EXPORT StructDataNode: DataNode
 		{
-			Map<String, UR<DataNode>> value; ///< ノードのマップです
+			Map<StringId, UR<DataNode>> value; ///< フィールド名の文字列IDからノードへのマップです
 
 			/// コンストラクタです
 			StructDataNode();
@@ -577,6 +591,10 @@ namespace ElekiEngine
 		/// バイナリデータからノードに変換します
 		List<ToNodeResult> ELEKICORE_EXPORT toNode(const UR<Binary> &binary);
 
+		/// バイナリデータからノードに変換します
+		/// @param binary バイナリデータのビュー 変換が終わるまで参照先を保持してください
+		List<ToNodeResult> ELEKICORE_EXPORT toNode(ByteView binary);
+
 		/// シリアライズ情報構造体です
 		struct ELEKICORE_EXPORT DeserializeInfo
 		{
@@ -715,11 +733,11 @@ namespace ElekiEngine
 			{
 				if (node->type == EBinarySign::STRUCT)
 				{
-					static const String keyName = TXT("key");
-					static const String valueName = TXT("value");
+					constexpr StringId keyId(TXT("key"));
+					constexpr StringId valueId(TXT("value"));
 					auto structNode = (Ref<StructDataNode>) node;
-					if (node->value.contains(keyName)) FromBinary<K>{}(node->value[keyName]);
-					if (node->value.contains(valueName)) FromBinary<K>{}(node->value[valueName]);
+					if (structNode->value.contains(keyId)) FromBinary<K>{}(structNode->value[keyId], info, value.key);
+					if (structNode->value.contains(valueId)) FromBinary<V>{}(structNode->value[valueId], info, value.value);
 				}
 			}
 		};
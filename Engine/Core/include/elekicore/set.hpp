@@ -1,5 +1,5 @@
 /// @file set.hpp
-/// @version 1.22.5
+/// @version 1.22.6
 /// @copyright © 2022 Taichi Ito
 /// 集合を提供します
 
@@ -22,6 +22,14 @@ namespace ElekiEngine
         {
             return l == r;
         }
+
+        /// 異なる型の値と等しいか判定します
+        /// 検索するキーを要素の型に変換せずに比較する場合に使用します
+        template<class Q>
+        bool operator()(const T &l, const Q &r)
+        {
+            return l == r;
+        }
     };
 
     /// 集合を提供します
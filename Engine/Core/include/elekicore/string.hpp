@@ -1,5 +1,5 @@
 /// @file string.hpp
-/// @version 1.22.5
+/// @version 1.22.6
 /// @copyright © 2022 Taichi Ito
 /// 文字列を提供します
 
@@ -8,6 +8,7 @@
 
 #include "hash.hpp"
 #include "array.hpp"
+#include "stringview.hpp"
 
 /// ELEKi ENGINE
 namespace ElekiEngine
@@ -30,12 +31,26 @@ namespace ElekiEngine
         /// コンストラクタ
         String(const Char *string);
 
+        /// コンストラクタ
+        /// @param string 文字列の先頭 ヌル終端である必要はありません
+        /// @param count 文字数
+        String(const Char *string, size_t count);
+
+        /// コンストラクタ
+        /// 参照している範囲を複製してインターンします
+        /// @param string 文字列ビュー
+        explicit String(StringView string);
+
         /// コピーコンストラクタ
         String(const String &string);
 
         /// ムーブコンストラクタ
         String(String &&string) noexcept;
 
+        /// デストラクタ
+        /// 最後の参照であれば、インターン表から文字列を解放します
+        ~String();
+
         /// コピー代入
         String &operator=(const String &string);
 
@@ -63,6 +78,18 @@ namespace ElekiEngine
         /// 生文字列を返します
         const Char *cstr() const;
 
+        /// 全体を参照する文字列ビューを返します
+        StringView view() const
+        {
+            return StringView(mString, mCount);
+        }
+
+        /// 全体を参照する文字列ビューに変換します
+        operator StringView() const
+        {
+            return StringView(mString, mCount);
+        }
+
         /// 末尾に連結します
         String &join(const String &string);
 
@@ -90,22 +117,23 @@ namespace ElekiEngine
         size_t indexOf(Char ch, bool invers = false) const;
 
         /// 一致する文字列の位置を返します
-        /// @param string 検索する文字
+        /// @param string 検索する文字列
         /// @param invers 真のとき末尾から、偽のとき先頭から走査します
         /// @return 一致した文字列の位置
         /// @retval 要素数 一致する文字列がありませんでした
-        size_t indexOf(const String &string, bool invers = false) const;
+        size_t indexOf(StringView string, bool invers = false) const;
 
         /// '添え字'の位置の引数を文字列の'{添え字}'の位置に埋め込みます
+        /// 書式は実行時に解析します 定義はformat.hppにあり、string.hppの末尾で読み込みます
         /// @param values 埋め込む値
         template<class...Ts>
         String format(Ts...values) const;
 
         /// イテレータの先頭を返します
-        PointerItr<const Char &> begin() const;
+        PointerItr<const Char> begin() const;
 
         /// イテレータの番兵を返します
-        PointerItr<const Char &> end() const;
+        PointerItr<const Char> end() const;
 
     };
 
@@ -118,6 +146,32 @@ namespace ElekiEngine
         {
             return value.mHash;
         }
+
+        /// 文字列ビューのハッシュ値を返します
+        /// 同じ文字列のStringと同じ値のため、Stringをキーとする表をインターンせずに検索できます
+        size_t operator()(StringView value)
+        {
+            return value.hash();
+        }
+
+        /// 生文字列のハッシュ値を返します
+        /// StringとStringViewのどちらにも変換できるため、曖昧にならないようStringViewとして計算します
+        size_t operator()(const Char *value)
+        {
+            return StringView(value).hash();
+        }
+    };
+
+    /// 順序特殊化クラスです
+    /// インターン済み生文字列のアドレスで比較するため、辞書順にはなりません
+    template<>
+    struct Less<String>
+    {
+        /// 左辺が右辺より小さいか判定します
+        bool operator()(const String &l, const String &r) const
+        {
+            return l.cstr() < r.cstr();
+        }
     };
 
     /// 文字列変換特殊化クラスです
@@ -160,6 +214,64 @@ namespace ElekiEngine
     /// 文字列に変換します
     String ELEKICORE_EXPORT f64ToString(const f64 &value);
 
+    /// 数値の文字列表現の最大文字数です
+    /// 浮動小数点数は、読み戻すと同じ値になる最短の表現で書き込みます
+    constexpr size_t NUMBER_CHARS_MAX = 32;
+
+    /// 文字列に変換して書き込みます
+    /// 確保もインターンも行わず、ヌル終端も書き込みません
+    /// @param buffer 書き込み先
+    /// @param count 書き込み先の文字数
+    /// @param value 値
+    /// @return 書き込んだ文字数 書き込み先が足りない場合は0
+    size_t ELEKICORE_EXPORT i8ToChars(Char *buffer, size_t count, i8 value);
+    /// 文字列に変換して書き込みます
+    size_t ELEKICORE_EXPORT u8ToChars(Char *buffer, size_t count, u8 value);
+    /// 文字列に変換して書き込みます
+    size_t ELEKICORE_EXPORT i16ToChars(Char *buffer, size_t count, i16 value);
+    /// 文字列に変換して書き込みます
+    size_t ELEKICORE_EXPORT u16ToChars(Char *buffer, size_t count, u16 value);
+    /// 文字列に変換して書き込みます
+    size_t ELEKICORE_EXPORT i32ToChars(Char *buffer, size_t count, i32 value);
+    /// 文字列に変換して書き込みます
+    size_t ELEKICORE_EXPORT u32ToChars(Char *buffer, size_t count, u32 value);
+    /// 文字列に変換して書き込みます
+    size_t ELEKICORE_EXPORT i64ToChars(Char *buffer, size_t count, i64 value);
+    /// 文字列に変換して書き込みます
+    size_t ELEKICORE_EXPORT u64ToChars(Char *buffer, size_t count, u64 value);
+    /// 文字列に変換して書き込みます
+    size_t ELEKICORE_EXPORT f32ToChars(Char *buffer, size_t count, f32 value);
+    /// 文字列に変換して書き込みます
+    size_t ELEKICORE_EXPORT f64ToChars(Char *buffer, size_t count, f64 value);
+
+    /// 文字列に変換して書き込みます
+    /// 型の大きさと符号に応じた*ToCharsを呼び出すため、longなど処理系で別名が異なる整数型にも使用できます
+    /// @return 書き込んだ文字数 書き込み先が足りない場合は0
+    template<class T>
+    size_t toChars(Char *buffer, size_t count, T value)
+    {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "not supported type. size_t toChars(Char *buffer, size_t count, T value)");
+        if constexpr(std::is_floating_point_v<T>)
+        {
+            if constexpr(sizeof(T) == sizeof(f32)) return f32ToChars(buffer, count, (f32) value);
+            else return f64ToChars(buffer, count, (f64) value);
+        }
+        else if constexpr(std::is_signed_v<T>)
+        {
+            if constexpr(sizeof(T) == sizeof(i8)) return i8ToChars(buffer, count, (i8) value);
+            else if constexpr(sizeof(T) == sizeof(i16)) return i16ToChars(buffer, count, (i16) value);
+            else if constexpr(sizeof(T) == sizeof(i32)) return i32ToChars(buffer, count, (i32) value);
+            else return i64ToChars(buffer, count, (i64) value);
+        }
+        else
+        {
+            if constexpr(sizeof(T) == sizeof(u8)) return u8ToChars(buffer, count, (u8) value);
+            else if constexpr(sizeof(T) == sizeof(u16)) return u16ToChars(buffer, count, (u16) value);
+            else if constexpr(sizeof(T) == sizeof(u32)) return u32ToChars(buffer, count, (u32) value);
+            else return u64ToChars(buffer, count, (u64) value);
+        }
+    }
+
     /// 文字列変換特殊化クラスです
     template<>
     struct ToString<i8>
@@ -282,118 +394,89 @@ namespace ElekiEngine
     };
 
     /// 文字列から値に変換します
+    /// 先頭の空白と'+'を読み飛ばし、数値として読める所までを変換します
+    /// 文字列の複製もインターンも行いません
     /// @param string 文字列
     /// @param [out] value 変換後の値
-    /// @return 変換に成功した場合真
-    bool ELEKICORE_EXPORT stringToI32(const String &string, i32 &value);
+    /// @return 変換に成功した場合真 範囲外の場合は偽
+    bool ELEKICORE_EXPORT stringToI32(StringView string, i32 &value);
 
     /// 文字列から値に変換します
     /// @param string 文字列
     /// @param [out] value 変換後の値
     /// @return 変換に成功した場合真
-    bool ELEKICORE_EXPORT stringToU32(const String &string, u32 &value);
+    bool ELEKICORE_EXPORT stringToU32(StringView string, u32 &value);
 
     /// 文字列から値に変換します
     /// @param string 文字列
     /// @param [out] value 変換後の値
     /// @return 変換に成功した場合真
-    bool ELEKICORE_EXPORT stringToI64(const String &string, i64 &value);
+    bool ELEKICORE_EXPORT stringToI64(StringView string, i64 &value);
 
     /// 文字列から値に変換します
     /// @param string 文字列
     /// @param [out] value 変換後の値
     /// @return 変換に成功した場合真
-    bool ELEKICORE_EXPORT stringToU64(const String &string, u64 &value);
+    bool ELEKICORE_EXPORT stringToU64(StringView string, u64 &value);
 
     /// 文字列から値に変換します
     /// @param string 文字列
     /// @param [out] value 変換後の値
     /// @return 変換に成功した場合真
-    bool ELEKICORE_EXPORT stringToF32(const String &string, f32 &value);
+    bool ELEKICORE_EXPORT stringToF32(StringView string, f32 &value);
 
     /// 文字列から値に変換します
     /// @param string 文字列
     /// @param [out] value 変換後の値
     /// @return 変換に成功した場合真
-    bool ELEKICORE_EXPORT stringToF64(const String &string, f64 &value);
+    bool ELEKICORE_EXPORT stringToF64(StringView string, f64 &value);
 
-    // 引数の文字列リストを作成するクラス
-    template<class T, class...Ts>
-    struct _MakeStringList
-    {
-        void operator()(List<String> &strings, const T &value, const T &...values)
-        {
-            strings.add(toString(value));
-            _MakeStringList<Ts...>{}(strings, values...);
-        }
-    };
-
-    // 引数の文字列リストを作成するクラスの末尾の特殊化
-    template<class T>
-    struct _MakeStringList<T>
+    /// 区切られた数値の列を一括で変換します
+    /// 空白と','を区切りとし、数値として読めない要素があった場合はそこで止めます
+    /// @param string 文字列
+    /// @param [out] values 変換後の値の書き込み先
+    /// @param count 書き込み先の要素数
+    /// @return 変換した要素数
+    size_t ELEKICORE_EXPORT stringToI32s(StringView string, i32 *values, size_t count);
+    /// 区切られた数値の列を一括で変換します
+    size_t ELEKICORE_EXPORT stringToU32s(StringView string, u32 *values, size_t count);
+    /// 区切られた数値の列を一括で変換します
+    size_t ELEKICORE_EXPORT stringToI64s(StringView string, i64 *values, size_t count);
+    /// 区切られた数値の列を一括で変換します
+    size_t ELEKICORE_EXPORT stringToU64s(StringView string, u64 *values, size_t count);
+    /// 区切られた数値の列を一括で変換します
+    size_t ELEKICORE_EXPORT stringToF32s(StringView string, f32 *values, size_t count);
+    /// 区切られた数値の列を一括で変換します
+    size_t ELEKICORE_EXPORT stringToF64s(StringView string, f64 *values, size_t count);
+
+    /// インターン表の統計です
+    struct StringTableStatistics
     {
-        void operator()(List<String> &strings, const T &value)
-        {
-            strings.add(toString(value));
-        }
+        size_t count;      ///< 登録されている文字列の数 遅延解放で参照が0のものを含みます
+        size_t bytes;      ///< 登録されている文字列が使用しているバイト数
+        size_t tableBytes; ///< 表が使用しているバイト数
     };
 
-    // '添え字'の位置の引数を文字列の'{添え字}'の位置に埋め込みます
-    // @param values 埋め込む値
-    template<class ...Ts>
-    String ElekiEngine::String::format(Ts ...values) const
-    {
-
-        // 引数から文字列リストを作成
-        List<String> valstrs;
-        _MakeStringList<Ts...>{}(valstrs, values...);
-
-        // 戻り値用の文字リスト
-        List<Char> retstr;
+    /// インターン表の統計を返します
+    StringTableStatistics ELEKICORE_EXPORT stringTableStatistics();
 
-        // 文字列を埋め込む
-        for(size_t i = 0; i < mCount; i++)
-        {
+    /// 参照が0になった文字列の解放を遅延させるか設定します
+    /// 遅延させる場合、参照が0の文字列は表に残り、同じ文字列を作成すると再利用します
+    /// 残った文字列はsweepStrings()を呼んだときか、表を拡張するときにまとめて解放します
+    /// 既定では最後の参照が無くなった時点で解放します
+    /// @param deferred 遅延させるか
+    void ELEKICORE_EXPORT setStringSweepDeferred(bool deferred);
 
-            // { から } までの処理
-            if('{' == mString[i])
-            {
-                List<Char> numstr;
-                for(size_t j = i + 1; j < mCount; j++)
-                {
-                    if('}' == mString[j])
-                    {
-                        u32 index = 0;
-                        numstr.add(NULL_CHAR);
-                        // {} 、変換失敗、または、添え字が範囲外の場合
-                        if(!numstr.count() ||
-                           !stringToU32(&numstr[0], index) ||
-                           valstrs.count() >= index)
-                        {
-                            // { から先も文字として挿入
-                            retstr.add(mString[i]);
-                            break;
-                        }
-                        // 値を挿入
-                        for(size_t i = 0; i < valstrs[index].count(); i++)
-                        {
-                            retstr.add(valstrs[index][i]);
-                        }
-                        // { 型 } までの区間をとばす
-                        i = j;
-                    }
-                    numstr.add(mString[j]);
-                }
-            }
-            // { から } までの区間ではないので挿入
-            else
-            {
-                retstr.add(mString[i]);
-            }
-        }
-        retstr.add(NULL_CHAR);
-        return &retstr[0];
-    }
+    /// 参照が0の文字列をまとめて解放します
+    /// 遅延解放の場合は、フレームの区切りなどで定期的に呼んでください
+    /// @return 解放した文字列の数
+    size_t ELEKICORE_EXPORT sweepStrings();
 }
 
+// String::formatの定義を読み込む
+// stringbuilder.hppから読み込まれた場合は、SmallStringの定義の後にstringbuilder.hppが読み込む
+#ifndef ELEKICORE_STRINGBUILDER_HPP
+#include "format.hpp"
+#endif
+
 #endif // !ELEKICORE_STRING_HPP
\ No newline at end of file
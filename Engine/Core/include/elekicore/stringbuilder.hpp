@@ -0,0 +1,546 @@
+/// @file stringbuilder.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// インターンしない可変長文字列と、文字列の組み立て機能を提供します
+/// 組み立て途中の文字列は表に登録せず、Stringへ変換するときに1度だけインターンします
+
+#ifndef ELEKICORE_STRINGBUILDER_HPP
+#define ELEKICORE_STRINGBUILDER_HPP
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "allocation.hpp"
+#include "array.hpp"
+#include "string.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// SmallStringが確保せずに保持できる既定の文字数です
+    constexpr size_t SMALLSTRING_INLINE_COUNT = 23;
+
+    /// StringBuilderが確保せずに保持できる文字数です
+    constexpr size_t STRINGBUILDER_INLINE_COUNT = 255;
+
+    /// 短い文字列を確保せずに保持する可変長文字列です
+    /// N文字までは内部のバッファに格納し、超えるとアロケータから確保します
+    /// 常にヌル終端を保ちます インターンはtoString()を呼んだときのみ行います
+    /// @tparam N 内部のバッファに格納できる文字数
+    template<size_t N = SMALLSTRING_INLINE_COUNT>
+    class SmallString
+    {
+        template<size_t M> friend class SmallString;
+
+        IAllocator *mAllocator; // アロケータ
+        Char *mData;            // 文字列 内部のバッファか、確保したバッファを指す
+        size_t mCount;          // 文字数
+        size_t mCapacity;       // ヌル文字を除いて格納できる文字数
+        Char mInline[N + 1];    // 内部のバッファ
+
+        // 確保したバッファを使用しているか
+        bool allocated() const
+        {
+            return mData != mInline;
+        }
+
+        // 格納できる文字数を広げる
+        bool grow(size_t required)
+        {
+            if(required <= mCapacity) return true;
+            auto capacity = mCapacity * 2;
+            if(capacity < required) capacity = required;
+            auto data = (Char *) mAllocator->allocate(sizeof(Char) * (capacity + 1));
+            if(!data)
+            {
+                printError("failed to allocate. bool SmallString<N>::grow(size_t required)");
+                return false;
+            }
+            std::memcpy(data, mData, sizeof(Char) * (mCount + 1));
+            if(allocated()) mAllocator->deallocate(mData);
+            mData = data;
+            mCapacity = capacity;
+            return true;
+        }
+
+        // 確保したバッファを解放し、内部のバッファに戻す
+        void release()
+        {
+            if(allocated()) mAllocator->deallocate(mData);
+            mData = mInline;
+            mCapacity = N;
+            mCount = 0;
+            mInline[0] = NULL_CHAR;
+        }
+
+    public:
+
+        /// コンストラクタ
+        /// @param allocator 内部のバッファを超えた場合に使用するアロケータ
+        SmallString(IAllocator *allocator = Memory::allocator())
+            : mAllocator(allocator)
+            , mData(mInline)
+            , mCount(0)
+            , mCapacity(N)
+        {
+            mInline[0] = NULL_CHAR;
+        }
+
+        /// コンストラクタ
+        /// @param string ヌル終端文字列
+        /// @param allocator 内部のバッファを超えた場合に使用するアロケータ
+        SmallString(const Char *string, IAllocator *allocator = Memory::allocator())
+            : SmallString(allocator)
+        {
+            if(string) append(string, std::char_traits<Char>::length(string));
+        }
+
+        /// コンストラクタ
+        /// @param string 文字列の先頭
+        /// @param count 文字数
+        /// @param allocator 内部のバッファを超えた場合に使用するアロケータ
+        SmallString(const Char *string, size_t count, IAllocator *allocator = Memory::allocator())
+            : SmallString(allocator)
+        {
+            append(string, count);
+        }
+
+        /// コンストラクタ
+        /// @param string 文字列
+        /// @param allocator 内部のバッファを超えた場合に使用するアロケータ
+        explicit SmallString(const String &string, IAllocator *allocator = Memory::allocator())
+            : SmallString(allocator)
+        {
+            append(string.cstr(), string.count());
+        }
+
+        /// コピーコンストラクタ
+        SmallString(const SmallString<N> &string)
+            : SmallString(string.mAllocator)
+        {
+            append(string.mData, string.mCount);
+        }
+
+        /// ムーブコンストラクタ
+        /// 確保したバッファは引き継ぎ、内部のバッファの文字列は写します
+        SmallString(SmallString<N> &&string) noexcept
+            : SmallString(string.mAllocator)
+        {
+            operator=(std::move(string));
+        }
+
+        /// デストラクタ
+        ~SmallString()
+        {
+            if(allocated()) mAllocator->deallocate(mData);
+        }
+
+        /// コピー代入
+        SmallString<N> &operator=(const SmallString<N> &string)
+        {
+            if(this == &string) return *this;
+            mCount = 0;
+            mData[0] = NULL_CHAR;
+            return append(string.mData, string.mCount);
+        }
+
+        /// ムーブ代入
+        /// 確保したバッファは引き継ぎ、内部のバッファの文字列は写します
+        SmallString<N> &operator=(SmallString<N> &&string) noexcept
+        {
+            if(this == &string) return *this;
+            release();
+            if(string.allocated() && string.mAllocator == mAllocator)
+            {
+                mData = string.mData;
+                mCount = string.mCount;
+                mCapacity = string.mCapacity;
+                string.mData = string.mInline;
+                string.mCapacity = N;
+            }
+            else
+            {
+                append(string.mData, string.mCount);
+            }
+            string.release();
+            return *this;
+        }
+
+        /// 代入します
+        SmallString<N> &operator=(const Char *string)
+        {
+            mCount = 0;
+            mData[0] = NULL_CHAR;
+            if(string) append(string, std::char_traits<Char>::length(string));
+            return *this;
+        }
+
+        /// 代入します
+        SmallString<N> &operator=(const String &string)
+        {
+            mCount = 0;
+            mData[0] = NULL_CHAR;
+            return append(string.cstr(), string.count());
+        }
+
+        /// 末尾に連結します
+        SmallString<N> &operator+=(Char ch)
+        {
+            return append(ch);
+        }
+
+        /// 末尾に連結します
+        SmallString<N> &operator+=(const Char *string)
+        {
+            return append(string);
+        }
+
+        /// 末尾に連結します
+        SmallString<N> &operator+=(const String &string)
+        {
+            return append(string.cstr(), string.count());
+        }
+
+        /// 末尾に連結します
+        SmallString<N> &operator+=(StringView string)
+        {
+            return append(string.data(), string.count());
+        }
+
+        /// 末尾に連結します
+        template<size_t M>
+        SmallString<N> &operator+=(const SmallString<M> &string)
+        {
+            return append(string.mData, string.mCount);
+        }
+
+        /// 文字列が等しいか判定します
+        template<size_t M>
+        bool operator==(const SmallString<M> &string) const
+        {
+            return mCount == string.mCount && !std::memcmp(mData, string.mData, sizeof(Char) * mCount);
+        }
+
+        /// 文字列が等しくないか判定します
+        template<size_t M>
+        bool operator!=(const SmallString<M> &string) const
+        {
+            return !operator==(string);
+        }
+
+        /// 文字列が等しいか判定します
+        bool operator==(const String &string) const
+        {
+            return mCount == string.count() && !std::memcmp(mData, string.cstr(), sizeof(Char) * mCount);
+        }
+
+        /// 文字列が等しくないか判定します
+        bool operator!=(const String &string) const
+        {
+            return !operator==(string);
+        }
+
+        /// 添え字から文字にアクセスします
+        Char &operator[](size_t index)
+        {
+            return at(index);
+        }
+
+        /// 添え字から文字にアクセスします
+        const Char &operator[](size_t index) const
+        {
+            return at(index);
+        }
+
+        /// 添え字から文字にアクセスします
+        Char &at(size_t index)
+        {
+            if(index >= mCount) printError("out of range. Char &SmallString<N>::at(size_t index)");
+            return mData[index];
+        }
+
+        /// 添え字から文字にアクセスします
+        const Char &at(size_t index) const
+        {
+            if(index >= mCount) printError("out of range. const Char &SmallString<N>::at(size_t index) const");
+            return mData[index];
+        }
+
+        /// 末尾に文字を連結します
+        SmallString<N> &append(Char ch)
+        {
+            if(!grow(mCount + 1)) return *this;
+            mData[mCount++] = ch;
+            mData[mCount] = NULL_CHAR;
+            return *this;
+        }
+
+        /// 末尾に同じ文字を繰り返し連結します
+        /// @param ch 文字
+        /// @param count 繰り返す数
+        SmallString<N> &append(Char ch, size_t count)
+        {
+            if(!grow(mCount + count)) return *this;
+            for(size_t i = 0; i < count; i++) mData[mCount++] = ch;
+            mData[mCount] = NULL_CHAR;
+            return *this;
+        }
+
+        /// 末尾にヌル終端文字列を連結します
+        SmallString<N> &append(const Char *string)
+        {
+            if(!string) return *this;
+            return append(string, std::char_traits<Char>::length(string));
+        }
+
+        /// 末尾に文字列を連結します
+        /// @param string 文字列の先頭 ヌル終端である必要はなく、この文字列の一部を指していても構いません
+        /// @param count 文字数
+        SmallString<N> &append(const Char *string, size_t count)
+        {
+            if(!count) return *this;
+
+            // 自身の一部を連結する場合に備え、広げた後のバッファから読む
+            auto self = string >= mData && string < mData + mCount;
+            auto offset = (size_t) (string - mData);
+            if(!grow(mCount + count)) return *this;
+            if(self) string = mData + offset;
+            std::memmove(mData + mCount, string, sizeof(Char) * count);
+            mCount += count;
+            mData[mCount] = NULL_CHAR;
+            return *this;
+        }
+
+        /// 位置に文字列を挿入します
+        /// @param index 挿入する位置
+        /// @param string 文字列の先頭 この文字列の一部を指していても構いません
+        /// @param count 文字数
+        SmallString<N> &insert(size_t index, const Char *string, size_t count)
+        {
+            if(index > mCount)
+            {
+                printError("out of range. SmallString<N> &SmallString<N>::insert(size_t index, const Char *string, size_t count)");
+                return *this;
+            }
+            if(!count) return *this;
+
+            // 自身の一部を挿入する場合に備え、広げる前に写しておく
+            if(string >= mData && string < mData + mCount)
+            {
+                SmallString<N> tmp(string, count, mAllocator);
+                return insert(index, tmp.mData, count);
+            }
+            if(!grow(mCount + count)) return *this;
+            std::memmove(mData + index + count, mData + index, sizeof(Char) * (mCount - index + 1));
+            std::memcpy(mData + index, string, sizeof(Char) * count);
+            mCount += count;
+            return *this;
+        }
+
+        /// 位置から文字を削除します
+        /// @param index 削除する先頭の位置
+        /// @param count 削除する文字数 末尾を超える分は無視します
+        SmallString<N> &remove(size_t index, size_t count = 1)
+        {
+            if(index > mCount)
+            {
+                printError("out of range. SmallString<N> &SmallString<N>::remove(size_t index, size_t count)");
+                return *this;
+            }
+            if(count > mCount - index) count = mCount - index;
+            std::memmove(mData + index, mData + index + count, sizeof(Char) * (mCount - index - count + 1));
+            mCount -= count;
+            return *this;
+        }
+
+        /// 文字数を変更します
+        /// 増やした文字は指定した文字で埋めます
+        SmallString<N> &resize(size_t count, Char fill = ' ')
+        {
+            if(count > mCount) return append(fill, count - mCount);
+            mCount = count;
+            mData[mCount] = NULL_CHAR;
+            return *this;
+        }
+
+        /// 数値を文字列に変換して末尾に連結します
+        /// 一時的な文字列を作らず、バッファに直接書き込みます
+        template<class T>
+        SmallString<N> &appendNumber(T value)
+        {
+            if(!grow(mCount + NUMBER_CHARS_MAX)) return *this;
+            mCount += toChars(mData + mCount, NUMBER_CHARS_MAX, value);
+            mData[mCount] = NULL_CHAR;
+            return *this;
+        }
+
+        /// 少なくとも指定した文字数を確保します
+        void reserve(size_t capacity)
+        {
+            grow(capacity);
+        }
+
+        /// 文字列を空にします
+        /// 確保したバッファは再利用のため保持します
+        void clear()
+        {
+            mCount = 0;
+            mData[0] = NULL_CHAR;
+        }
+
+        /// 文字数を返します
+        size_t count() const
+        {
+            return mCount;
+        }
+
+        /// ヌル文字を除いて格納できる文字数を返します
+        size_t capacity() const
+        {
+            return mCapacity;
+        }
+
+        /// 空か判定します
+        bool empty() const
+        {
+            return mCount == 0;
+        }
+
+        /// 文字列の先頭を返します
+        Char *data()
+        {
+            return mData;
+        }
+
+        /// ヌル終端文字列を返します
+        const Char *cstr() const
+        {
+            return mData;
+        }
+
+        /// 全体を参照する文字列ビューを返します
+        /// 連結や削除で内部のバッファが変わると無効になります
+        StringView view() const
+        {
+            return StringView(mData, mCount);
+        }
+
+        /// インターンしてStringに変換します
+        String toString() const
+        {
+            return String(mData, mCount);
+        }
+
+        /// アロケータを取得します
+        IAllocator *allocator() const
+        {
+            return mAllocator;
+        }
+
+        /// イテレータの先頭を返します
+        PointerItr<Char> begin()
+        {
+            return PointerItr<Char>(mData);
+        }
+
+        /// イテレータの番兵を返します
+        PointerItr<Char> end()
+        {
+            return PointerItr<Char>(mData + mCount);
+        }
+
+        /// イテレータの先頭を返します
+        PointerItr<const Char> begin() const
+        {
+            return PointerItr<const Char>(mData);
+        }
+
+        /// イテレータの番兵を返します
+        PointerItr<const Char> end() const
+        {
+            return PointerItr<const Char>(mData + mCount);
+        }
+    };
+
+    /// 文字列を組み立てます
+    /// 途中の文字列はインターンせず、toString()で完成した文字列だけをインターンします
+    /// 1フレームの間だけ使う場合は、FrameAllocatorを渡すと解放の手間がありません
+    class StringBuilder: public SmallString<STRINGBUILDER_INLINE_COUNT>
+    {
+        using Base = SmallString<STRINGBUILDER_INLINE_COUNT>;
+
+    public:
+
+        /// コンストラクタ
+        /// @param allocator 内部のバッファを超えた場合に使用するアロケータ
+        StringBuilder(IAllocator *allocator = Memory::allocator())
+            : Base(allocator)
+        {}
+
+        /// コンストラクタ
+        /// @param capacity 予め確保する文字数
+        /// @param allocator 内部のバッファを超えた場合に使用するアロケータ
+        explicit StringBuilder(size_t capacity, IAllocator *allocator = Memory::allocator())
+            : Base(allocator)
+        {
+            reserve(capacity);
+        }
+
+        /// 末尾に連結します
+        StringBuilder &operator<<(Char ch)
+        {
+            append(ch);
+            return *this;
+        }
+
+        /// 末尾に連結します
+        StringBuilder &operator<<(const Char *string)
+        {
+            append(string);
+            return *this;
+        }
+
+        /// 末尾に連結します
+        StringBuilder &operator<<(const String &string)
+        {
+            append(string.cstr(), string.count());
+            return *this;
+        }
+
+        /// 数値を文字列に変換して末尾に連結します
+        /// 真偽値は"true"または"false"を連結します
+        template<class T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, Char>, int> = 0>
+        StringBuilder &operator<<(T value)
+        {
+            if constexpr(std::is_same_v<T, bool>) append(value ? TXT("true") : TXT("false"));
+            else appendNumber(value);
+            return *this;
+        }
+
+        /// 末尾に連結します
+        StringBuilder &operator<<(StringView string)
+        {
+            append(string.data(), string.count());
+            return *this;
+        }
+
+        /// 末尾に連結します
+        template<size_t M>
+        StringBuilder &operator<<(const SmallString<M> &string)
+        {
+            append(string.cstr(), string.count());
+            return *this;
+        }
+    };
+
+}
+
+// String::formatの定義を読み込む
+#include "format.hpp"
+
+#endif // !ELEKICORE_STRINGBUILDER_HPP
\ No newline at end of file
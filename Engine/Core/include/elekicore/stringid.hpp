@@ -0,0 +1,202 @@
+/// @file stringid.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// コンパイル時に計算できる文字列のハッシュ値と、それを識別子とする文字列IDを提供します
+/// 型名やフィールド名の照合を、文字列のインターンや比較の代わりに64ビット整数の比較で行えます
+
+#ifndef ELEKICORE_STRINGID_HPP
+#define ELEKICORE_STRINGID_HPP
+
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "hash.hpp"
+#include "string.hpp"
+
+#if !defined(ELEKI_STRINGID_NAMES) && defined(_DEBUG)
+/// 文字列IDから元の文字列を逆引きできるよう、registeredで生成した文字列IDの名前を登録します
+#define ELEKI_STRINGID_NAMES 1
+#endif
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// 文字列のハッシュ値をコンパイル時に計算します
+    /// FNV-1aで畳み込んだ後、mixHashで全ビットに散らします
+    /// 実行時に計算しても同じ値になります
+    /// @param string 文字列の先頭
+    /// @param count 文字数
+    constexpr u64 constHash(const Char *string, size_t count)
+    {
+        u64 result = 0xCBF29CE484222325ull;
+        for(size_t i = 0; i < count; i++)
+        {
+            result ^= (u8) string[i];
+            result *= 0x100000001B3ull;
+        }
+        return mixHash(result ^ count);
+    }
+
+    /// ヌル終端文字列のハッシュ値をコンパイル時に計算します
+    constexpr u64 constHash(const Char *string)
+    {
+        size_t count = 0;
+        while(string[count] != NULL_CHAR) count++;
+        return constHash(string, count);
+    }
+
+    // 配列の最初のヌル文字までの文字数を返す
+    // リテラルでない配列は末尾に未使用の文字が残るため、配列の長さは使わない
+    template<size_t N>
+    constexpr size_t _charArrayLength(const Char (&string)[N])
+    {
+        size_t count = 0;
+        while(count < N && string[count] != NULL_CHAR) count++;
+        return count;
+    }
+
+    /// 文字列IDの名前を登録します
+    /// 既に異なる名前が同じ値で登録されている場合は、衝突としてエラーを出力します
+    /// @param value 文字列IDの値
+    /// @param name 名前の先頭
+    /// @param count 名前の文字数
+    void ELEKICORE_EXPORT registerStringIdName(u64 value, const Char *name, size_t count);
+
+    /// 文字列IDの名前を取得します
+    /// @return 登録された名前 登録されていない場合は空文字列
+    String ELEKICORE_EXPORT stringIdName(u64 value);
+
+    /// 文字列のハッシュ値による識別子です
+    /// 文字列リテラルからはコンパイル時に生成でき、比較は64ビット整数の比較です
+    /// ELEKI_STRINGID_NAMESが有効な場合、registeredで生成した識別子は名前を登録し、name()で逆引きできます
+    /// 登録は排他ロックを取るため、検索のたびに生成する識別子は登録せず、型名などは1度だけ登録してください
+    class StringId
+    {
+        u64 mValue; // ハッシュ値
+
+        // ハッシュ値から生成する
+        struct FromValue {};
+        constexpr StringId(u64 value, FromValue)
+            : mValue(value)
+        {}
+
+    public:
+
+        /// コンストラクタ
+        /// 空文字列の識別子になります
+        constexpr StringId()
+            : mValue(constHash(TXT(""), 0))
+        {}
+
+        /// コンストラクタ
+        /// @param string 文字列の先頭
+        /// @param count 文字数
+        constexpr StringId(const Char *string, size_t count)
+            : mValue(constHash(string, count))
+        {}
+
+        /// コンストラクタ
+        /// Stringを受け取る多重定義と曖昧にならないよう、明示的に生成してください
+        /// 最初のヌル文字までを使うため、文字列を書き込んだ配列からもStringと同じ識別子になります
+        /// @param string 文字列リテラルか文字配列
+        template<size_t N>
+        explicit constexpr StringId(const Char (&string)[N])
+            : mValue(constHash(string, _charArrayLength(string)))
+        {}
+
+        /// コンストラクタ
+        /// 名前は登録しません
+        /// @param string 文字列
+        explicit StringId(const String &string)
+            : mValue(constHash(string.cstr(), string.count()))
+        {}
+
+        /// ハッシュ値から生成します
+        /// @param value value()で取得したハッシュ値
+        static constexpr StringId fromValue(u64 value)
+        {
+            return StringId(value, FromValue{});
+        }
+
+        /// 等しいか判定します
+        constexpr bool operator==(const StringId &r) const
+        {
+            return mValue == r.mValue;
+        }
+
+        /// 等しくないか判定します
+        constexpr bool operator!=(const StringId &r) const
+        {
+            return mValue != r.mValue;
+        }
+
+        /// 小さいか判定します
+        /// ハッシュ値の順のため、辞書順にはなりません
+        constexpr bool operator<(const StringId &r) const
+        {
+            return mValue < r.mValue;
+        }
+
+        /// ハッシュ値を返します
+        constexpr u64 value() const
+        {
+            return mValue;
+        }
+
+        /// 元の文字列を取得します
+        /// 名前を登録していない場合は空文字列を返します
+        String name() const
+        {
+            return stringIdName(mValue);
+        }
+
+        /// 名前を登録して返します
+        /// リテラルから生成した識別子を逆引きする場合に使用します
+        /// ELEKI_STRINGID_NAMESが無効な場合は何もしません
+        /// @param string 文字列リテラルか文字配列
+        template<size_t N>
+        static StringId registered(const Char (&string)[N])
+        {
+            StringId id(string);
+        #if ELEKI_STRINGID_NAMES
+            registerStringIdName(id.mValue, string, _charArrayLength(string));
+        #endif
+            return id;
+        }
+
+        /// 名前を登録して返します
+        /// 実行時に得た名前を逆引きする場合に、1度だけ呼び出してください
+        /// ELEKI_STRINGID_NAMESが無効な場合は何もしません
+        /// @param string 文字列
+        static StringId registered(const String &string)
+        {
+            StringId id(string);
+        #if ELEKI_STRINGID_NAMES
+            registerStringIdName(id.mValue, string.cstr(), string.count());
+        #endif
+            return id;
+        }
+    };
+
+    /// ハッシュ特殊化構造体です
+    /// ハッシュ値は生成時に混ぜ合わせているため、そのまま返します
+    template<>
+    struct Hash<StringId>
+    {
+        /// ハッシュ値を返します
+        size_t operator()(const StringId &value) const
+        {
+            return (size_t) value.value();
+        }
+    };
+
+    /// 文字列IDリテラルです
+    /// constexprな変数の初期化や定数式に使用すると、コンパイル時に計算されます
+    constexpr StringId operator""_sid(const Char *string, size_t count)
+    {
+        return StringId(string, count);
+    }
+
+}
+
+#endif // !ELEKICORE_STRINGID_HPP
\ No newline at end of file
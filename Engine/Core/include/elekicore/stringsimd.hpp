@@ -0,0 +1,58 @@
+/// @file stringsimd.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// SIMDによる文字列の長さ、比較、検索と、UTF-8の検証、符号位置の計数を提供します
+/// 初回の呼び出しでCPUを判別し、AVX2が使える場合はAVX2、そうでなければSSE2の実装を使用します
+
+#ifndef ELEKICORE_STRINGSIMD_HPP
+#define ELEKICORE_STRINGSIMD_HPP
+
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// ヌル終端文字列の文字数を返します
+    /// @param string ヌル終端文字列
+    size_t ELEKICORE_EXPORT stringLength(const Char *string);
+
+    /// 文字列が等しいか判定します
+    /// @param l 左辺の先頭
+    /// @param r 右辺の先頭
+    /// @param count 比較する文字数
+    bool ELEKICORE_EXPORT stringEqual(const Char *l, const Char *r, size_t count);
+
+    /// 一致する文字の位置を返します
+    /// @param string 文字列の先頭
+    /// @param count 文字数
+    /// @param ch 検索する文字
+    /// @retval count 一致する文字がありませんでした
+    size_t ELEKICORE_EXPORT stringIndexOf(const Char *string, size_t count, Char ch);
+
+    /// 一致する文字列の位置を返します
+    /// 先頭と末尾の文字が一致する位置をSIMDで絞り込み、その位置のみを比較します
+    /// @param string 文字列の先頭
+    /// @param count 文字数
+    /// @param pattern 検索する文字列の先頭
+    /// @param patternCount 検索する文字列の文字数
+    /// @retval count 一致する文字列がありませんでした
+    size_t ELEKICORE_EXPORT stringIndexOf(const Char *string, size_t count, const Char *pattern, size_t patternCount);
+
+    /// 正しいUTF-8か判定します
+    /// 過長な符号化、サロゲート、U+10FFFFを超える符号位置を不正とします
+    /// @param string 文字列の先頭
+    /// @param count 文字数
+    bool ELEKICORE_EXPORT isValidUtf8(const Char *string, size_t count);
+
+    /// UTF-8の符号位置の数を返します
+    /// 継続バイト以外を数えるため、正しいUTF-8でない場合の結果は不定です
+    /// @param string 文字列の先頭
+    /// @param count 文字数
+    size_t ELEKICORE_EXPORT utf8CodePointCount(const Char *string, size_t count);
+
+}
+
+#endif // !ELEKICORE_STRINGSIMD_HPP
\ No newline at end of file
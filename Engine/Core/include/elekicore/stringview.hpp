@@ -0,0 +1,265 @@
+/// @file stringview.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 文字列の一部を複製せずに参照する文字列ビューを提供します
+/// 切り出しや検索で確保もインターンも行わないため、字句解析や数値の読み取りに使用します
+
+#ifndef ELEKICORE_STRINGVIEW_HPP
+#define ELEKICORE_STRINGVIEW_HPP
+
+#include <cstring>
+#include <string>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "functional.hpp"
+#include "hash.hpp"
+#include "stringsimd.hpp"
+#include "array.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// 文字列の一部を参照するビューです
+    /// 先頭のポインタと文字数のみを持ち、ヌル終端であるとは限りません
+    /// 参照先の文字列より長く使用しないでください
+    class StringView
+    {
+        const Char *mString; // 先頭の文字
+        size_t mCount;       // 文字数
+
+    public:
+
+        /// コンストラクタ
+        constexpr StringView()
+            : mString(nullptr)
+            , mCount(0)
+        {}
+
+        /// コンストラクタ
+        /// @param string 先頭の文字
+        /// @param count 文字数
+        constexpr StringView(const Char *string, size_t count)
+            : mString(string)
+            , mCount(count)
+        {}
+
+        /// コンストラクタ
+        /// @param string ヌル終端文字列
+        constexpr StringView(const Char *string)
+            : mString(string)
+            , mCount(string ? std::char_traits<Char>::length(string) : 0)
+        {}
+
+        /// 添え字から文字を取得します
+        constexpr const Char &operator[](size_t index) const
+        {
+            return mString[index];
+        }
+
+        /// 添え字から文字を取得します
+        const Char &at(size_t index) const
+        {
+            if(index >= mCount) printError("out of range. const Char &StringView::at(size_t index) const");
+            return mString[index];
+        }
+
+        /// 先頭の文字を返します
+        constexpr const Char *data() const
+        {
+            return mString;
+        }
+
+        /// 文字数を返します
+        constexpr size_t count() const
+        {
+            return mCount;
+        }
+
+        /// 空か判定します
+        constexpr bool empty() const
+        {
+            return mCount == 0;
+        }
+
+        /// 一部を切り出します
+        /// 範囲を超える分は切り詰めます
+        /// @param index 切り出す先頭の位置
+        /// @param length 切り出す文字数
+        constexpr StringView sub(size_t index, size_t length) const
+        {
+            if(index > mCount) index = mCount;
+            if(length > mCount - index) length = mCount - index;
+            return StringView(mString + index, length);
+        }
+
+        /// 指定位置から後ろを切り出します
+        /// @param index 切り出す先頭の位置
+        constexpr StringView sub(size_t index) const
+        {
+            return sub(index, mCount);
+        }
+
+        /// 先頭から文字数分を切り出します
+        constexpr StringView first(size_t length) const
+        {
+            return sub(0, length);
+        }
+
+        /// 末尾から文字数分を切り出します
+        constexpr StringView last(size_t length) const
+        {
+            return length < mCount ? StringView(mString + mCount - length, length) : *this;
+        }
+
+        /// 一致する文字の位置を返します
+        /// @param ch 検索する文字
+        /// @param invers 真のとき末尾から、偽のとき先頭から走査します
+        /// @retval 要素数 一致する文字がありませんでした
+        size_t indexOf(Char ch, bool invers = false) const
+        {
+            if(!invers) return stringIndexOf(mString, mCount, ch);
+            for(auto i = mCount; i > 0; i--)
+            {
+                if(mString[i - 1] == ch) return i - 1;
+            }
+            return mCount;
+        }
+
+        /// 一致する文字列の位置を返します
+        /// @param string 検索する文字列
+        /// @param invers 真のとき末尾から、偽のとき先頭から走査します
+        /// @retval 要素数 一致する文字列がありませんでした
+        size_t indexOf(StringView string, bool invers = false) const
+        {
+            if(!invers) return stringIndexOf(mString, mCount, string.mString, string.mCount);
+            if(string.mCount > mCount) return mCount;
+            if(!string.mCount) return mCount;
+            for(auto i = mCount - string.mCount + 1; i > 0; i--)
+            {
+                if(mString[i - 1] == string.mString[0] && stringEqual(mString + i - 1, string.mString, string.mCount)) return i - 1;
+            }
+            return mCount;
+        }
+
+        /// 文字列を含むか判定します
+        bool contains(StringView string) const
+        {
+            return indexOf(string) != mCount || (!string.mCount);
+        }
+
+        /// 先頭が一致するか判定します
+        bool startsWith(StringView string) const
+        {
+            return string.mCount <= mCount && stringEqual(mString, string.mString, string.mCount);
+        }
+
+        /// 末尾が一致するか判定します
+        bool endsWith(StringView string) const
+        {
+            return string.mCount <= mCount && stringEqual(mString + mCount - string.mCount, string.mString, string.mCount);
+        }
+
+        /// 前後の空白文字を除いた範囲を返します
+        StringView trim() const
+        {
+            size_t begin = 0, end = mCount;
+            while(begin < end && isSpace(mString[begin])) begin++;
+            while(end > begin && isSpace(mString[end - 1])) end--;
+            return StringView(mString + begin, end - begin);
+        }
+
+        /// 区切り文字までを切り出し、自身をその後ろに進めます
+        /// 区切り文字が無い場合は全体を切り出し、自身は空になります
+        /// @param delimiter 区切り文字
+        StringView split(Char delimiter)
+        {
+            auto index = indexOf(delimiter);
+            auto token = StringView(mString, index);
+            *this = index < mCount ? sub(index + 1) : StringView(mString + mCount, 0);
+            return token;
+        }
+
+        /// 辞書順で比較します
+        /// @return 自身が小さい場合は負、等しい場合は0、大きい場合は正
+        int compare(StringView string) const
+        {
+            auto count = mCount < string.mCount ? mCount : string.mCount;
+            auto result = count ? std::memcmp(mString, string.mString, sizeof(Char) * count) : 0;
+            if(result) return result;
+            return mCount < string.mCount ? -1 : (mCount > string.mCount ? 1 : 0);
+        }
+
+        /// 正しいUTF-8か判定します
+        bool isValidUtf8() const
+        {
+            return ElekiEngine::isValidUtf8(mString, mCount);
+        }
+
+        /// UTF-8の符号位置の数を返します
+        /// 正しいUTF-8でない場合の結果は不定です
+        size_t codePointCount() const
+        {
+            return utf8CodePointCount(mString, mCount);
+        }
+
+        /// ハッシュ値を返します
+        /// 呼ぶたびに計算します 同じ文字列のStringと同じ値です
+        size_t hash() const
+        {
+            return bytesToHash(mString, sizeof(Char) * mCount);
+        }
+
+        /// イテレータの先頭を返します
+        PointerItr<const Char> begin() const
+        {
+            return PointerItr<const Char>(mString);
+        }
+
+        /// イテレータの番兵を返します
+        PointerItr<const Char> end() const
+        {
+            return PointerItr<const Char>(mString + mCount);
+        }
+
+        /// 空白文字か判定します
+        static constexpr bool isSpace(Char ch)
+        {
+            return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\v' || ch == '\f';
+        }
+    };
+
+    /// 文字列が等しいか判定します
+    inline bool operator==(StringView l, StringView r)
+    {
+        return l.count() == r.count() && stringEqual(l.data(), r.data(), l.count());
+    }
+
+    /// 文字列が等しくないか判定します
+    inline bool operator!=(StringView l, StringView r)
+    {
+        return !(l == r);
+    }
+
+    /// 辞書順で小さいか判定します
+    inline bool operator<(StringView l, StringView r)
+    {
+        return l.compare(r) < 0;
+    }
+
+    /// ハッシュ特殊化構造体です
+    /// 同じ文字列のStringと同じ値を返すため、Stringをキーとする表の検索に使用できます
+    template<>
+    struct Hash<StringView>
+    {
+        /// ハッシュ値を返します
+        size_t operator()(const StringView &value) const
+        {
+            return value.hash();
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_STRINGVIEW_HPP
\ No newline at end of file
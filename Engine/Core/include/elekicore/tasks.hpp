@@ -2,11 +2,15 @@
 /// @version 1.22.6
 /// @copyright © 2022 Taichi Ito
 /// 並行処理機能を提供します
+/// スレッドプールはワーカー毎の作業両端キューと盗み合いで、細かいタスクを分散します
 
 #ifndef ELEKICORE_TASKS_HPP
 #define ELEKICORE_TASKS_HPP
 
+#include <atomic>
+#include <cstdlib>
 #include <mutex>
+#include <thread>
 #include <type_traits>
 #include "preprocess.hpp"
 #include "functional.hpp"
@@ -38,17 +42,31 @@ namespace ElekiEngine
 	template<class R>
 	UR<Task<R>> parallel(const Func<R()> &func, EThreadMode mode);
 
+	/// スレッドプールです
+	/// 実装はtasks.cppにあります
+	class ThreadPool;
+
 	/// スレッドクラスです
 	class ELEKICORE_EXPORT Thread
 	{
+		friend class ThreadPool;
+
 		EThreadMode mMode;                // スレッドモード
+		bool mStarted;                    // 実行を開始したか
+		std::atomic<bool> mEnded;         // 並列処理が終了したか
 		std::thread *mIndependenceThread; // 独立スレッドモード用スレッド
 
-		// 初期化します
-		void init();
+		// 実行し、終了を記録します
+		void execute();
 		// 終了化します
 		void fin();
 
+	protected:
+
+		/// 並列処理を開始します
+		/// 派生クラスの構築が終わる前に実行されないよう、構築後に呼び出します
+		void start();
+
 	public:
 
 		/// コンストラクタです
@@ -96,8 +114,11 @@ namespace ElekiEngine
 		Task<R> &operator=(Task<R> &&) noexcept = delete;
 
 		/// デストラクタです
+		/// 戻り値と関数を破棄する前に、並列処理の終了を待ちます
 		~Task() override
-		{}
+		{
+			join();
+		}
 
 		/// 並列処理の終了を待ち、合流します
 		R marge()
@@ -159,12 +180,36 @@ namespace ElekiEngine
 		}
 	};
 
+	// タスクの終了を待って破棄し、mallocの領域を解放する終了処理
+	// タスクはワーカーからも作成、破棄されるため、排他しない共有メモリは使わない
+	template<class T>
+	class _TaskDeleter: public IDeleter
+	{
+	public:
+
+		// 終了処理を実行する
+		void operator()(void *pointer) override
+		{
+			((T *) pointer)->~T();
+			std::free(pointer);
+		}
+
+		// 型ごとの終了処理を返す
+		static IDeleter *instance()
+		{
+			static _TaskDeleter<T> deleter;
+			return &deleter;
+		}
+	};
+
 	/// 並列処理で実行します
+	/// タスクを構築し終えてから実行を開始します
 	template<class F>
 	auto parallel(const F &func, EThreadMode mode = EThreadMode::THREAD_POOL)  -> UR<Task<decltype(func())>>
 	{
-		auto ptr = new(Memory::allocate(sizeof(Task<decltype(func())>))) Task<decltype(func())>(func);
-		return UR<Task<decltype(func())>>(ptr, Memory::deleter());
+		auto ptr = new(std::malloc(sizeof(Task<decltype(func())>))) Task<decltype(func())>(func, mode);
+		ptr->start();
+		return UR<Task<decltype(func())>>(ptr, _TaskDeleter<Task<decltype(func())>>::instance());
 	}
 
 }
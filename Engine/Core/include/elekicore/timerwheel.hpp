@@ -0,0 +1,254 @@
+/// @file timerwheel.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 多数の遅延処理を定数時間で登録、取消できる階層タイマーホイールを提供します
+
+#ifndef ELEKICORE_TIMERWHEEL_HPP
+#define ELEKICORE_TIMERWHEEL_HPP
+
+#include <new>
+#include <utility>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "functional.hpp"
+#include "allocation.hpp"
+#include "intrusive.hpp"
+#include "handletable.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// タイマーホイールの階層数です
+    constexpr size_t TIMERWHEEL_LEVELS = 4;
+
+    /// タイマーホイールの1階層のスロット数のビット数です
+    constexpr size_t TIMERWHEEL_SLOT_BITS = 6;
+
+    /// タイマーホイールのメモリプールが1度に確保するタイマー数です
+    constexpr size_t TIMERWHEEL_POOL_TIMERS_COUNT = 64;
+
+    /// 階層タイマーホイールを提供します
+    /// 時刻は呼び出し元が決める単位の整数で、advanceで進めた分だけ期限の来た処理を実行します
+    /// 1階層64スロットを4階層持ち、2^24未満の遅延は登録と取消を定数時間で行います
+    /// それより長い遅延は最上位の階層で待機し、繰り返し再配置します
+    /// タイマーはメモリプールから確保し、スロットには侵入型リストで連結します
+    class TimerWheel
+    {
+        // 1階層のスロット数
+        static constexpr size_t SLOTS = (size_t) 1 << TIMERWHEEL_SLOT_BITS;
+        // 実行待ちのタイマーを表すスロット番号
+        static constexpr u32 FIRING_SLOT = (u32) (TIMERWHEEL_LEVELS * SLOTS);
+
+        // タイマー
+        struct Timer
+        {
+            IntrusiveListHook hook; // スロットへの連結
+            u64 deadline;           // 期限の時刻
+            Func<void()> callback;  // 実行する処理
+            Handle handle;          // このタイマーのハンドル
+            u32 slot;               // 連結しているスロットの番号
+        };
+
+        static_assert(alignof(Timer) <= alignof(size_t), "not supported alignment. TimerWheel::Timer");
+
+        using TimerList = IntrusiveList<Timer, &Timer::hook>;
+
+        IAllocator *mAllocator;                     // ハンドル表と、メモリプールを確保するアロケータ
+        DynamicMemoryPool *mPool;                   // タイマーを確保するメモリプール
+        HandleTable<Timer *> mHandles;              // ハンドル表
+        TimerList mWheel[TIMERWHEEL_LEVELS][SLOTS]; // スロット
+        TimerList mFiring;                          // 実行待ちのタイマー
+        u64 mNow;                                   // 現在の時刻
+        bool mAdvancing;                            // 時刻を進めている途中か
+
+        // スロット番号からスロットを取得する
+        TimerList &listOf(u32 slot)
+        {
+            return slot == FIRING_SLOT ? mFiring : mWheel[slot / SLOTS][slot % SLOTS];
+        }
+
+        // 期限までの時間から階層を選び、スロットに連結する
+        void insert(Timer *timer)
+        {
+            auto delta = timer->deadline > mNow ? timer->deadline - mNow : 0;
+            size_t level = 0;
+            while(level < TIMERWHEEL_LEVELS - 1 && delta >> (TIMERWHEEL_SLOT_BITS * (level + 1))) level++;
+
+            // 範囲を超える期限は最上位の階層の最も遠いスロットで待機する
+            auto deadline = timer->deadline;
+            auto range = (u64) 1 << (TIMERWHEEL_SLOT_BITS * TIMERWHEEL_LEVELS);
+            if(delta >= range) deadline = mNow + range - 1;
+
+            auto slot = (size_t) (deadline >> (TIMERWHEEL_SLOT_BITS * level)) & (SLOTS - 1);
+            timer->slot = (u32) (level * SLOTS + slot);
+            mWheel[level][slot].add(*timer);
+        }
+
+        // タイマーを破棄する
+        void destroy(Timer *timer)
+        {
+            mHandles.remove(timer->handle);
+            timer->~Timer();
+            DynamicMemoryPool::deallocate(timer);
+        }
+
+        // 時刻を1進め、期限の来たタイマーを実行する
+        // @return 実行した数
+        size_t tick()
+        {
+            mNow++;
+
+            // 下位の階層が1周したら、上位の階層のスロットを下位へ再配置する
+            for(size_t level = 1; level < TIMERWHEEL_LEVELS; level++)
+            {
+                auto shift = TIMERWHEEL_SLOT_BITS * level;
+                if(mNow & (((u64) 1 << shift) - 1)) break;
+                TimerList cascading(std::move(mWheel[level][(size_t) (mNow >> shift) & (SLOTS - 1)]));
+                while(auto timer = cascading.removeFirst()) insert(timer);
+            }
+
+            // 実行中に取り消せるよう、実行待ちのリストに移してから実行する
+            mFiring.splice(mWheel[0][(size_t) mNow & (SLOTS - 1)]);
+            for(auto &timer : mFiring) timer.slot = FIRING_SLOT;
+            size_t fired = 0;
+            while(auto timer = mFiring.removeFirst())
+            {
+                auto callback = std::move(timer->callback);
+                destroy(timer);
+                if(callback) callback();
+                fired++;
+            }
+            return fired;
+        }
+
+    public:
+
+        /// コンストラクタ
+        /// @param now 開始時刻
+        /// @param allocator ハンドル表と、メモリプールを確保するアロケータ
+        TimerWheel(u64 now = 0, IAllocator *allocator = Memory::allocator())
+            : mAllocator(allocator)
+            , mPool(nullptr)
+            , mHandles(allocator)
+            , mNow(now)
+            , mAdvancing(false)
+        {}
+
+        TimerWheel(const TimerWheel &) = delete;
+        TimerWheel &operator=(const TimerWheel &) = delete;
+
+        /// デストラクタ
+        /// 実行されていない処理は実行せずに破棄します
+        ~TimerWheel()
+        {
+            clear();
+            if(mPool)
+            {
+                mPool->~DynamicMemoryPool();
+                mAllocator->deallocate(mPool);
+            }
+        }
+
+        /// 遅延処理を登録します
+        /// @param delay 現在の時刻からの遅延 0の場合は次に時刻を進めたときに実行します
+        /// @param callback 実行する処理
+        /// @return 取消に使用するハンドル
+        /// @retval INVALID_HANDLE 登録に失敗しました
+        Handle schedule(u64 delay, const Func<void()> &callback)
+        {
+            if(!mPool)
+            {
+                auto memory = mAllocator->allocate(sizeof(DynamicMemoryPool));
+                if(!memory)
+                {
+                    printError("failed to allocate. Handle TimerWheel::schedule(u64 delay, const Func<void()> &callback)");
+                    return INVALID_HANDLE;
+                }
+                mPool = new(memory) DynamicMemoryPool(sizeof(Timer), TIMERWHEEL_POOL_TIMERS_COUNT);
+            }
+
+            auto memory = mPool->allocate();
+            if(!memory)
+            {
+                printError("failed to allocate. Handle TimerWheel::schedule(u64 delay, const Func<void()> &callback)");
+                return INVALID_HANDLE;
+            }
+            auto timer = new(memory) Timer();
+            timer->deadline = mNow + (delay ? delay : 1);
+            timer->callback = callback;
+            timer->handle = mHandles.add(timer);
+            insert(timer);
+            return timer->handle;
+        }
+
+        /// 遅延処理を取り消します
+        /// @retval false 無効なハンドルか、既に実行されていました
+        bool cancel(Handle handle)
+        {
+            auto timer = mHandles.find(handle);
+            if(!timer) return false;
+            listOf((*timer)->slot).remove(**timer);
+            destroy(*timer);
+            return true;
+        }
+
+        /// 遅延処理が実行待ちか判定します
+        bool pending(Handle handle) const
+        {
+            return mHandles.contains(handle);
+        }
+
+        /// 時刻を進め、期限の来た処理を順に実行します
+        /// 処理の中から登録と取消は行えますが、時刻を進めることはできません
+        /// @param ticks 進める時間
+        /// @return 実行した処理の数
+        size_t advance(u64 ticks)
+        {
+            if(mAdvancing)
+            {
+                printError("already advancing. size_t TimerWheel::advance(u64 ticks)");
+                return 0;
+            }
+            mAdvancing = true;
+            size_t fired = 0;
+            for(u64 i = 0; i < ticks; i++)
+            {
+                // 待機中の処理が無ければ残りを一度に進める
+                if(!mHandles.count())
+                {
+                    mNow += ticks - i;
+                    break;
+                }
+                fired += tick();
+            }
+            mAdvancing = false;
+            return fired;
+        }
+
+        /// 現在の時刻を返します
+        u64 now() const
+        {
+            return mNow;
+        }
+
+        /// 待機中の処理の数を返します
+        size_t count() const
+        {
+            return mHandles.count();
+        }
+
+        /// すべての処理を実行せずに取り消します
+        void clear()
+        {
+            for(u32 slot = 0; slot <= FIRING_SLOT; slot++)
+            {
+                while(auto timer = listOf(slot).removeFirst()) destroy(timer);
+            }
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_TIMERWHEEL_HPP
\ No newline at end of file
@@ -11,6 +11,7 @@
 #endif
 
 #include "string.hpp"
+#include "stringid.hpp"
 
 
 /// ELEKi ENGINE
@@ -71,6 +72,15 @@ namespace ElekiEngine
 		return typenameByTypeinfo(typeid(T));
 	}
 
+	/// 型名の文字列IDを取得します
+	/// 型名の生成と名前の登録は初回のみ行い、以降は保持した値を返します
+	template<class T>
+	StringId typeIdOf()
+	{
+		static const StringId id = StringId::registered(typenameOf<T>());
+		return id;
+	}
+
 
 	/// バイトオーダーの種類の列挙です
 	enum class EEndian: u8
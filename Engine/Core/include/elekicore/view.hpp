@@ -0,0 +1,287 @@
+/// @file view.hpp
+/// @version 1.22.6
+/// @copyright © 2022 Taichi Ito
+/// 連続した要素を所有せずに参照するビューを提供します
+/// 部分範囲の受け渡しをコピー無しで行えます
+
+#ifndef ELEKICORE_VIEW_HPP
+#define ELEKICORE_VIEW_HPP
+
+#include <type_traits>
+#include "preprocess.hpp"
+#include "integer.hpp"
+#include "hash.hpp"
+#include "datalog.hpp"
+
+/// ELEKi ENGINE
+namespace ElekiEngine
+{
+
+    /// 不変な連続要素のビューです
+    /// 参照先の要素を所有しないため、参照先より長く保持しないでください
+    template<class T>
+    class ArrayView
+    {
+        const T *mElements; // 先頭要素
+        size_t mCount;      // 要素数
+
+    public:
+
+        /// コンストラクタ
+        constexpr ArrayView()
+            : mElements(nullptr)
+            , mCount(0)
+        {}
+
+        /// コンストラクタ
+        /// @param elements 先頭要素
+        /// @param count 要素数
+        constexpr ArrayView(const T *elements, size_t count)
+            : mElements(elements)
+            , mCount(count)
+        {}
+
+        /// コンストラクタ
+        /// @param elements 生配列
+        template<size_t N>
+        constexpr ArrayView(const T (&elements)[N])
+            : mElements(elements)
+            , mCount(N)
+        {}
+
+        /// 添え字から要素にアクセスします
+        const T &operator[](size_t index) const
+        {
+            if(index >= mCount) printError("out of range. const T &ArrayView<T>::operator[](size_t index) const");
+            return mElements[index];
+        }
+
+        /// 要素が等しいか判定します
+        bool operator==(ArrayView<T> r) const
+        {
+            if(mCount != r.mCount) return false;
+            for(size_t i = 0; i < mCount; i++)
+            {
+                if(!(mElements[i] == r.mElements[i])) return false;
+            }
+            return true;
+        }
+
+        /// 要素が等しくないか判定します
+        bool operator!=(ArrayView<T> r) const
+        {
+            return !(*this == r);
+        }
+
+        /// 添え字から要素にアクセスします
+        const T &at(size_t index) const
+        {
+            if(index >= mCount) printError("out of range. const T &ArrayView<T>::at(size_t index) const");
+            return mElements[index];
+        }
+
+        /// 一部を参照するビューを返します
+        /// 範囲外の部分は切り詰めます
+        /// @param index 先頭位置
+        /// @param length 要素数
+        ArrayView<T> sub(size_t index, size_t length) const
+        {
+            if(index > mCount) index = mCount;
+            if(length > mCount - index) length = mCount - index;
+            return ArrayView<T>(mElements + index, length);
+        }
+
+        /// 指定位置から後ろを参照するビューを返します
+        /// @param index 先頭位置
+        ArrayView<T> sub(size_t index) const
+        {
+            return sub(index, mCount);
+        }
+
+        /// 要素数を返します
+        constexpr size_t count() const
+        {
+            return mCount;
+        }
+
+        /// 空か判定します
+        constexpr bool empty() const
+        {
+            return mCount == 0;
+        }
+
+        /// 先頭要素のポインタを返します
+        constexpr const T *data() const
+        {
+            return mElements;
+        }
+
+        /// 先頭イテレータを返します
+        constexpr const T *begin() const
+        {
+            return mElements;
+        }
+
+        /// 番兵イテレータを返します
+        constexpr const T *end() const
+        {
+            return mElements + mCount;
+        }
+    };
+
+    /// 可変な連続要素のビューです
+    /// 参照先の要素を所有しないため、参照先より長く保持しないでください
+    template<class T>
+    class Span
+    {
+        T *mElements;  // 先頭要素
+        size_t mCount; // 要素数
+
+    public:
+
+        /// コンストラクタ
+        constexpr Span()
+            : mElements(nullptr)
+            , mCount(0)
+        {}
+
+        /// コンストラクタ
+        /// @param elements 先頭要素
+        /// @param count 要素数
+        constexpr Span(T *elements, size_t count)
+            : mElements(elements)
+            , mCount(count)
+        {}
+
+        /// コンストラクタ
+        /// @param elements 生配列
+        template<size_t N>
+        constexpr Span(T (&elements)[N])
+            : mElements(elements)
+            , mCount(N)
+        {}
+
+        /// 不変ビューに変換します
+        constexpr operator ArrayView<T>() const
+        {
+            return ArrayView<T>(mElements, mCount);
+        }
+
+        /// 添え字から要素にアクセスします
+        T &operator[](size_t index) const
+        {
+            if(index >= mCount) printError("out of range. T &Span<T>::operator[](size_t index) const");
+            return mElements[index];
+        }
+
+        /// 添え字から要素にアクセスします
+        T &at(size_t index) const
+        {
+            if(index >= mCount) printError("out of range. T &Span<T>::at(size_t index) const");
+            return mElements[index];
+        }
+
+        /// 一部を参照するビューを返します
+        /// 範囲外の部分は切り詰めます
+        /// @param index 先頭位置
+        /// @param length 要素数
+        Span<T> sub(size_t index, size_t length) const
+        {
+            if(index > mCount) index = mCount;
+            if(length > mCount - index) length = mCount - index;
+            return Span<T>(mElements + index, length);
+        }
+
+        /// 指定位置から後ろを参照するビューを返します
+        /// @param index 先頭位置
+        Span<T> sub(size_t index) const
+        {
+            return sub(index, mCount);
+        }
+
+        /// 不変ビューを返します
+        constexpr ArrayView<T> view() const
+        {
+            return ArrayView<T>(mElements, mCount);
+        }
+
+        /// 要素数を返します
+        constexpr size_t count() const
+        {
+            return mCount;
+        }
+
+        /// 空か判定します
+        constexpr bool empty() const
+        {
+            return mCount == 0;
+        }
+
+        /// 先頭要素のポインタを返します
+        constexpr T *data() const
+        {
+            return mElements;
+        }
+
+        /// 先頭イテレータを返します
+        constexpr T *begin() const
+        {
+            return mElements;
+        }
+
+        /// 番兵イテレータを返します
+        constexpr T *end() const
+        {
+            return mElements + mCount;
+        }
+    };
+
+    /// バイト列のビュー型エイリアスです
+    using ByteView = ArrayView<u8>;
+
+    /// 要素のバイト表現を参照するビューを返します
+    template<class T>
+    ByteView toByteView(ArrayView<T> view)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "not supported type. ByteView toByteView(ArrayView<T> view)");
+        return ByteView((const u8 *) (const void *) view.data(), view.count() * sizeof(T));
+    }
+
+    /// ハッシュ特殊化構造体です
+    /// 整数と文字の要素はバイト列として、その他は要素毎のハッシュ値を混ぜ合わせます
+    template<class T>
+    struct Hash<ArrayView<T>>
+    {
+        /// ハッシュ値を返します
+        size_t operator()(const ArrayView<T> &value)
+        {
+            if constexpr(std::is_integral_v<T>)
+            {
+                return bytesToHash(value.data(), value.count() * sizeof(T));
+            }
+            else
+            {
+                size_t result = value.count();
+                for(auto &element : value)
+                {
+                    result = hashCombine(result, Hash<T>{}(element));
+                }
+                return result;
+            }
+        }
+    };
+
+    /// ハッシュ特殊化構造体です
+    template<class T>
+    struct Hash<Span<T>>
+    {
+        /// ハッシュ値を返します
+        size_t operator()(const Span<T> &value)
+        {
+            return Hash<ArrayView<T>>{}(value.view());
+        }
+    };
+
+}
+
+#endif // !ELEKICORE_VIEW_HPP
\ No newline at end of file
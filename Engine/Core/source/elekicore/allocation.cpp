@@ -209,11 +209,10 @@ size_t ElekiEngine::StaticMemoryPool::freeElementsCount() const
 // -----
 
 // コンストラクタ
-ElekiEngine::DynamicMemoryPool::Node::Node(size_t elementSize, size_t elementsCount, DynamicMemoryPool *system, Node *prev, Node *next)
+ElekiEngine::DynamicMemoryPool::Node::Node(size_t elementSize, size_t elementsCount, DynamicMemoryPool *system)
 	: mMemory(elementSize, elementsCount)
 	, mSystem(system)
-	, mPrev(prev)
-	, mNext(next)
+	, mHook()
 {}
 
 // デストラクタ
@@ -226,22 +225,19 @@ ElekiEngine::DynamicMemoryPool::Node::~Node()
 ElekiEngine::DynamicMemoryPool::DynamicMemoryPool(size_t elementSize, size_t elementsCount)
 	: mElementSize(elementSize)
 	, mElementsCount(elementsCount)
-	, mTopNode(new(std::malloc(sizeof(Node))) Node(sizeof(size_t) + mElementSize, mElementsCount, this, nullptr, nullptr))
+	, mNodes()
 {
-	mTopNode->mPrev = mTopNode;
-	mTopNode->mNext = mTopNode;
+	mNodes.add(*new(std::malloc(sizeof(Node))) Node(sizeof(size_t) + mElementSize, mElementsCount, this));
 }
 
 // デストラクタ
 ElekiEngine::DynamicMemoryPool::~DynamicMemoryPool()
 {
-	// すべてのノードを解放
-	while(mTopNode)
+	// すべてのノードを切り離して解放
+	while(auto node = mNodes.removeFirst())
 	{
-		auto tmp = mTopNode;
-		mTopNode = mTopNode->mPrev;
-		tmp->~Node();
-		std::free(tmp);
+		node->~Node();
+		std::free(node);
 	}
 }
 
@@ -249,20 +245,16 @@ ElekiEngine::DynamicMemoryPool::~DynamicMemoryPool()
 // @retval nullptr メモリの確保に失敗しました
 void *ElekiEngine::DynamicMemoryPool::allocate()
 {
-	// 使用可能な要素がない場合ノードを追加
-	if(!mTopNode->mMemory.freeElementsCount())
+	// 使用可能な要素がない場合、先頭にノードを追加
+	if(!mNodes.first().mMemory.freeElementsCount())
 	{
-		// [prev]-[old-top]
-		//   ↓
-		// [prev]-[new-top]-[old-top]
-		mTopNode = new(std::malloc(sizeof(Node))) Node(sizeof(size_t) + mElementSize, mElementsCount, this, mTopNode->mPrev, mTopNode);
-		mTopNode->mPrev->mNext = mTopNode;
-		mTopNode->mNext->mPrev = mTopNode;
+		mNodes.addFirst(*new(std::malloc(sizeof(Node))) Node(sizeof(size_t) + mElementSize, mElementsCount, this));
 	}
 
 	// アドレスサイズ＋要素サイズのメモリを確保
-	auto tmp = (Node **) mTopNode->mMemory.allocate();
-	tmp[0] = mTopNode;
+	auto &top = mNodes.first();
+	auto tmp = (Node **) top.mMemory.allocate();
+	tmp[0] = &top;
 	return &tmp[1];
 }
 
@@ -274,10 +266,11 @@ void ElekiEngine::DynamicMemoryPool::deallocate(void *pointer)
 	auto node = *tmp;
 	node->mMemory.deallocate(tmp);
 
-	if(node != node->mSystem->mTopNode && node->mMemory.freeElementsCount() == node->mMemory.elementsCount())
+	// 使用中のノード以外は、空になった時点でリストから外して解放
+	auto &nodes = node->mSystem->mNodes;
+	if(node != &nodes.first() && node->mMemory.freeElementsCount() == node->mMemory.elementsCount())
 	{
-		node->mPrev->mNext = node->mNext;
-		node->mNext->mPrev = node->mPrev;
+		nodes.remove(*node);
 		node->~Node();
 		std::free(node);
 	}
@@ -327,10 +320,10 @@ struct MemoryControl
 	MallocMemory sizeoverMemory;
 
 	static constexpr size_t SIZE16 = 16;
-	static constexpr size_t SIZE32 = 16;
-	static constexpr size_t SIZE64 = 16;
-	static constexpr size_t SIZE128 = 16;
-	static constexpr size_t SIZE256 = 16;
+	static constexpr size_t SIZE32 = 32;
+	static constexpr size_t SIZE64 = 64;
+	static constexpr size_t SIZE128 = 128;
+	static constexpr size_t SIZE256 = 256;
 
 	static constexpr size_t SIZE16_CNT = 32;
 	static constexpr size_t SIZE32_CNT = 32;
@@ -1,3 +1,93 @@
 #include "elekicore/component.hpp"
 
 using namespace ElekiEngine;
+
+//
+// Archetype
+// -----
+
+// 位置からコンポーネント情報にアクセスします
+const IComponent *ElekiEngine::Archetype::operator[](size_t index) const
+{
+	return atComponent(index);
+}
+
+// 型名からコンポーネント情報にアクセスします
+const IComponent *ElekiEngine::Archetype::operator[](const String &name) const
+{
+	return atComponent(name);
+}
+
+// 型名の文字列IDからコンポーネント情報にアクセスします
+const IComponent *ElekiEngine::Archetype::operator[](StringId id) const
+{
+	return atComponent(id);
+}
+
+// コンポーネント名から位置を取得します
+size_t ElekiEngine::Archetype::operator()(const String &name) const
+{
+	return atIndex(name);
+}
+
+// コンポーネント名の文字列IDから位置を取得します
+size_t ElekiEngine::Archetype::operator()(StringId id) const
+{
+	return atIndex(id);
+}
+
+// コンポーネントの集合が等しいか比較します
+// 文字列IDの順に並んだキーを比較するため、型名の比較は行いません
+bool ElekiEngine::Archetype::operator==(const Archetype &r) const
+{
+	if(mIndexes.count() != r.mIndexes.count()) return false;
+	for(size_t i = 0; i < mIndexes.count(); i++)
+	{
+		if(mIndexes.keyAt(i) != r.mIndexes.keyAt(i)) return false;
+	}
+	return true;
+}
+
+// コンポーネントの集合が等しくないか比較します
+bool ElekiEngine::Archetype::operator!=(const Archetype &r) const
+{
+	return !(*this == r);
+}
+
+// 位置からコンポーネント情報にアクセスします
+const IComponent *ElekiEngine::Archetype::atComponent(size_t index) const
+{
+	if(index >= mTypes.count())
+	{
+		printError("out of range. const IComponent *Archetype::atComponent(size_t index) const");
+		return nullptr;
+	}
+	return &mTypes[index];
+}
+
+// 型名からコンポーネント情報にアクセスします
+// 検索のたびに名前を登録しないよう、文字列IDは登録を行わない生成方法で作る
+const IComponent *ElekiEngine::Archetype::atComponent(const String &name) const
+{
+	return atComponent(StringId(name.cstr(), name.count()));
+}
+
+// 型名の文字列IDからコンポーネント情報にアクセスします
+const IComponent *ElekiEngine::Archetype::atComponent(StringId id) const
+{
+	auto index = mIndexes.find(id);
+	return index ? &mTypes[*index] : nullptr;
+}
+
+// コンポーネント名から位置を取得します
+size_t ElekiEngine::Archetype::atIndex(const String &name) const
+{
+	return atIndex(StringId(name.cstr(), name.count()));
+}
+
+// コンポーネント名の文字列IDから位置を取得します
+size_t ElekiEngine::Archetype::atIndex(StringId id) const
+{
+	auto index = mIndexes.find(id);
+	return index ? *index : mTypes.count();
+}
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "elekicore/datalog.hpp"
+#include "elekicore/epoch.hpp"
+
+using namespace ElekiEngine;
+
+//
+// 世代による遅延解放
+// -----
+// 各スレッドは区間に入るときに全体の世代を自身の記録に写し、抜けるときに消す
+// 区間内の全てのスレッドが現在の世代に追いついた場合のみ、全体の世代を1つ進める
+// 世代eで保留したオブジェクトは、世代がe+2になった時点でどのスレッドからも読まれていない
+// 記録はスレッドの終了後も解放せず、次に作成されたスレッドが保留と共に引き継ぐ
+// 共有メモリはスレッド安全でないため、記録と保留の配列はmallocで確保する
+
+// 保留した解放
+struct EpochRetired
+{
+	void *pointer;                                 // 解放するポインタ
+	void (*reclaim)(void *context, void *pointer); // 解放処理
+	void *context;                                 // 解放処理に渡す値
+	u64 epoch;                                     // 保留した世代
+};
+
+// スレッドの記録
+struct EpochRecord
+{
+	std::atomic<u64> state;   // 区間内の場合は世代を1ビット上げて最下位を立てた値、区間外の場合0
+	std::atomic<bool> inUse;  // スレッドが使用中か
+	EpochRecord *next;        // 次の記録
+	size_t nesting;           // ガードの入れ子の数
+	bool reclaiming;          // 解放中か 終了処理からの保留で解放を入れ子にしない
+	EpochRetired *retired;    // 保留の配列 世代の古い順
+	size_t retiredCount;      // 保留の数
+	size_t retiredCapacity;   // 保留の配列の容量
+};
+
+std::atomic<u64> gEpoch{0};                        // 全体の世代
+std::atomic<EpochRecord *> gEpochRecords{nullptr}; // 記録の連結リストの先頭
+
+// 記録を取得する
+// 終了したスレッドの記録があれば再利用し、無ければ作成して先頭に加える
+EpochRecord *acquireEpochRecord()
+{
+	for(auto record = gEpochRecords.load(std::memory_order_acquire); record; record = record->next)
+	{
+		auto inUse = false;
+		if(!record->inUse.load(std::memory_order_relaxed) && record->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire)) return record;
+	}
+
+	auto record = new(std::malloc(sizeof(EpochRecord))) EpochRecord();
+	record->state.store(0, std::memory_order_relaxed);
+	record->inUse.store(true, std::memory_order_relaxed);
+	record->nesting = 0;
+	record->reclaiming = false;
+	record->retired = nullptr;
+	record->retiredCount = 0;
+	record->retiredCapacity = 0;
+
+	auto head = gEpochRecords.load(std::memory_order_relaxed);
+	do record->next = head;
+	while(!gEpochRecords.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+	return record;
+}
+
+// スレッド毎の記録の所有
+// スレッドの終了時に記録を手放す
+struct EpochLocal
+{
+	EpochRecord *record; // 記録
+
+	// デストラクタ
+	~EpochLocal()
+	{
+		if(record) record->inUse.store(false, std::memory_order_release);
+	}
+};
+
+thread_local EpochLocal gEpochLocal{nullptr};
+
+// 現在のスレッドの記録を返す
+EpochRecord *currentEpochRecord()
+{
+	if(!gEpochLocal.record) gEpochLocal.record = acquireEpochRecord();
+	return gEpochLocal.record;
+}
+
+// 区間に入る
+void pinEpoch(EpochRecord *record)
+{
+	if(record->nesting++) return;
+	// 入り直す場合も、前の区間の読み込みを世代を進めるスレッドへ順序付ける
+	record->state.store((gEpoch.load(std::memory_order_relaxed) << 1) | 1, std::memory_order_release);
+	// 記録の書き込みを、以降の共有オブジェクトの読み込みより先に他のスレッドへ見せる
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+// 区間を抜ける
+void unpinEpoch(EpochRecord *record)
+{
+	if(--record->nesting) return;
+	record->state.store(0, std::memory_order_release);
+}
+
+// 区間内の全てのスレッドが現在の世代に追いついていれば世代を進める
+// @return 現在の世代
+u64 tryAdvanceEpoch()
+{
+	auto epoch = gEpoch.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	for(auto record = gEpochRecords.load(std::memory_order_acquire); record; record = record->next)
+	{
+		// 区間を抜けたスレッドの読み込みを、以降の解放より先に順序付ける
+		auto state = record->state.load(std::memory_order_acquire);
+		if((state & 1) && (state >> 1) != epoch) return epoch;
+	}
+	if(gEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_release, std::memory_order_relaxed)) return epoch + 1;
+	return epoch;
+}
+
+// 記録の保留のうち、世代の進んだものを解放する
+// 解放処理が保留を加えても、配列を走査し直せるよう添え字で読む
+// @return 解放した数
+size_t reclaimEpochRecord(EpochRecord *record, u64 epoch)
+{
+	if(record->reclaiming) return 0;
+	size_t count = 0;
+	while(count < record->retiredCount && record->retired[count].epoch + 2 <= epoch) count++;
+	if(!count) return 0;
+
+	record->reclaiming = true;
+	for(size_t i = 0; i < count; i++)
+	{
+		auto retired = record->retired[i];
+		retired.reclaim(retired.context, retired.pointer);
+	}
+	record->reclaiming = false;
+
+	record->retiredCount -= count;
+	std::memmove(record->retired, record->retired + count, sizeof(EpochRetired) * record->retiredCount);
+	return count;
+}
+
+// 終了したスレッドの記録を一時的に引き取って、世代の進んだ保留を解放する
+// @return 解放した数
+size_t reclaimReleasedEpochRecords(u64 epoch)
+{
+	size_t count = 0;
+	for(auto record = gEpochRecords.load(std::memory_order_acquire); record; record = record->next)
+	{
+		auto inUse = false;
+		if(record->inUse.load(std::memory_order_relaxed) || !record->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire)) continue;
+		count += reclaimEpochRecord(record, epoch);
+		record->inUse.store(false, std::memory_order_release);
+	}
+	return count;
+}
+
+// 保留を加える
+void retireEpoch(void *pointer, void (*reclaim)(void *context, void *pointer), void *context)
+{
+	if(!pointer) return;
+	auto record = currentEpochRecord();
+	pinEpoch(record);
+
+	if(record->retiredCount == record->retiredCapacity)
+	{
+		auto capacity = record->retiredCapacity ? record->retiredCapacity * 2 : EPOCH_RECLAIM_THRESHOLD * 2;
+		auto retired = (EpochRetired *) std::malloc(sizeof(EpochRetired) * capacity);
+		if(!retired)
+		{
+			// 解放できる時点が分からないため、解放せずに残す
+			printError("failed to allocate. void retireEpoch(void *pointer, void (*reclaim)(void *context, void *pointer), void *context)");
+			unpinEpoch(record);
+			return;
+		}
+		if(record->retiredCount) std::memcpy(retired, record->retired, sizeof(EpochRetired) * record->retiredCount);
+		std::free(record->retired);
+		record->retired = retired;
+		record->retiredCapacity = capacity;
+	}
+
+	// 外した後の世代を読むため、外す書き込みの後に順序付ける
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	record->retired[record->retiredCount++] = EpochRetired{pointer, reclaim, context, gEpoch.load(std::memory_order_relaxed)};
+
+	if(record->retiredCount >= EPOCH_RECLAIM_THRESHOLD)
+	{
+		reclaimEpochRecord(record, tryAdvanceEpoch());
+	}
+	unpinEpoch(record);
+}
+
+// 終了処理で解放する
+void reclaimByDeleter(void *context, void *pointer)
+{
+	(*(IDeleter *) context)(pointer);
+}
+
+// アロケータで解放する
+void reclaimByAllocator(void *context, void *pointer)
+{
+	((IAllocator *) context)->deallocate(pointer);
+}
+
+// 固定長メモリプールへ返す
+void reclaimByStaticPool(void *context, void *pointer)
+{
+	((StaticMemoryPool *) context)->deallocate(pointer);
+}
+
+// 可変長メモリプールへ返す
+void reclaimByDynamicPool(void *, void *pointer)
+{
+	DynamicMemoryPool::deallocate(pointer);
+}
+
+// 終了時に、解放できる保留を解放する
+// ワーカーの終了や他の静的なデストラクタとの順序は決まらないため、記録は解放しない
+// 使用中の記録と、区間内のスレッドが読んでいる可能性のある保留は残す
+struct FinEpoch
+{
+	~FinEpoch()
+	{
+		tryAdvanceEpoch();
+		auto epoch = tryAdvanceEpoch();
+		reclaimReleasedEpochRecords(epoch);
+	}
+} gFinEpoch;
+
+// コンストラクタ
+ElekiEngine::EpochGuard::EpochGuard()
+	: mRecord(currentEpochRecord())
+{
+	pinEpoch((EpochRecord *) mRecord);
+}
+
+// デストラクタ
+ElekiEngine::EpochGuard::~EpochGuard()
+{
+	unpinEpoch((EpochRecord *) mRecord);
+}
+
+// 全てのスレッドが読み終えた後に終了処理を実行します
+void ElekiEngine::retire(void *pointer, IDeleter *deleter)
+{
+	retireEpoch(pointer, reclaimByDeleter, deleter);
+}
+
+// 全てのスレッドが読み終えた後にアロケータで解放します
+void ElekiEngine::retire(void *pointer, IAllocator *allocator)
+{
+	retireEpoch(pointer, reclaimByAllocator, allocator);
+}
+
+// 全てのスレッドが読み終えた後にメモリプールへ返します
+void ElekiEngine::retire(void *pointer, StaticMemoryPool *pool)
+{
+	retireEpoch(pointer, reclaimByStaticPool, pool);
+}
+
+// 全てのスレッドが読み終えた後にメモリプールへ返します
+void ElekiEngine::retire(void *pointer, DynamicMemoryPool *pool)
+{
+	retireEpoch(pointer, reclaimByDynamicPool, pool);
+}
+
+// 世代を進め、解放できる保留を全て解放します
+size_t ElekiEngine::reclaimRetired()
+{
+	auto current = currentEpochRecord();
+	if(current->nesting)
+	{
+		// 区間内では自身が世代を止めるため、進められる分のみ解放する
+		return reclaimEpochRecord(current, tryAdvanceEpoch());
+	}
+
+	// 保留は2世代後に解放できるため、2回進める
+	tryAdvanceEpoch();
+	auto epoch = tryAdvanceEpoch();
+	auto count = reclaimEpochRecord(current, epoch);
+
+	return count + reclaimReleasedEpochRecords(epoch);
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "elekicore/format.hpp"
+
+using namespace ElekiEngine;
+
+//
+// 書式の書き込み
+// -----
+// 数値はstd::to_charsでスタック上の領域に変換し、幅を埋める文字と一緒に出力先へ直接書き込む
+// 途中の文字列は確保もインターンもしない
+
+// 浮動小数点数を変換する領域の文字数
+// 最大の倍精度を固定小数点で精度の上限まで書き込める大きさにする
+constexpr size_t FORMAT_FLOAT_CHARS_MAX = 512;
+
+// 型を省略した浮動小数点数に精度を指定した場合と、'e' 'g'の既定の精度
+constexpr i32 FORMAT_DEFAULT_PRECISION = 6;
+
+// 小文字を大文字にする
+void toUpperFormatChars(Char *begin, Char *end)
+{
+	for(auto i = begin; i < end; i++)
+	{
+		if(*i >= 'a' && *i <= 'z') *i = (Char) (*i - 'a' + 'A');
+	}
+}
+
+// 幅に足りない分を埋めて書き込む
+// @param prefix 符号と基数の接頭辞 0で埋める場合はこの後ろに埋める
+// @param body 本体
+// @param bodyWidth 本体の幅
+// @param numeric 数値か 数値は既定で右に揃え、0で埋められる
+void writePadded(IFormatOutput &output, StringView prefix, StringView body, size_t bodyWidth, const FormatField &field, bool numeric)
+{
+	auto width = prefix.count() + bodyWidth;
+	auto padding = field.width > width ? field.width - width : 0;
+
+	// 揃えの指定が無い数値は符号の後を0で埋める
+	if(numeric && field.zero && !field.align)
+	{
+		output.write(prefix.data(), prefix.count());
+		output.write('0', padding);
+		output.write(body.data(), body.count());
+		return;
+	}
+
+	auto align = field.align ? field.align : (numeric ? '>' : '<');
+	auto before = align == '>' ? padding : (align == '^' ? padding / 2 : 0);
+	output.write(field.fill, before);
+	output.write(prefix.data(), prefix.count());
+	output.write(body.data(), body.count());
+	output.write(field.fill, padding - before);
+}
+
+// 整数の絶対値と符号を書き込む
+void writeFormatInteger(IFormatOutput &output, bool negative, u64 magnitude, const FormatField &field)
+{
+	auto base = 10;
+	const Char *radix = TXT("");
+	switch(field.type)
+	{
+	case 'x': base = 16; radix = TXT("0x"); break;
+	case 'X': base = 16; radix = TXT("0X"); break;
+	case 'b': base = 2; radix = TXT("0b"); break;
+	case 'o': base = 8; radix = TXT("0"); break;
+	default: break;
+	}
+
+	Char digits[64];
+	auto converted = std::to_chars(digits, digits + 64, magnitude, base);
+	if(field.type == 'X') toUpperFormatChars(digits, converted.ptr);
+
+	Char prefix[3];
+	size_t prefixCount = 0;
+	if(negative) prefix[prefixCount++] = '-';
+	if(field.alternate)
+	{
+		for(auto i = radix; *i != NULL_CHAR; i++) prefix[prefixCount++] = *i;
+	}
+
+	auto bodyCount = (size_t) (converted.ptr - digits);
+	writePadded(output, StringView(prefix, prefixCount), StringView(digits, bodyCount), bodyCount, field, true);
+}
+
+// 浮動小数点数を書き込む
+template<class T>
+void writeFormatFloat(IFormatOutput &output, T value, const FormatField &field)
+{
+	auto precision = field.precision;
+	auto upper = false;
+	std::chars_format format = std::chars_format::general;
+	switch(field.type)
+	{
+	case 'f': format = std::chars_format::fixed; break;
+	case 'e': format = std::chars_format::scientific; break;
+	case 'E': format = std::chars_format::scientific; upper = true; break;
+	case 'g': format = std::chars_format::general; break;
+	case 'G': format = std::chars_format::general; upper = true; break;
+	case 'x': format = std::chars_format::hex; break;
+	case 'X': format = std::chars_format::hex; upper = true; break;
+	default:
+		// 型を省略して精度を指定した場合は小数点以下の桁数とする
+		if(precision >= 0) format = std::chars_format::fixed;
+		break;
+	}
+	if(precision < 0 && field.type && format != std::chars_format::hex) precision = FORMAT_DEFAULT_PRECISION;
+
+	auto negative = std::signbit(value);
+	if(negative) value = -value;
+
+	Char digits[FORMAT_FLOAT_CHARS_MAX];
+	std::to_chars_result converted;
+	if(precision < 0 && !field.type) converted = std::to_chars(digits, digits + FORMAT_FLOAT_CHARS_MAX, value);
+	else if(precision < 0) converted = std::to_chars(digits, digits + FORMAT_FLOAT_CHARS_MAX, value, format);
+	else converted = std::to_chars(digits, digits + FORMAT_FLOAT_CHARS_MAX, value, format, precision);
+	if(converted.ec != std::errc())
+	{
+		printError("failed to convert. void writeFormatFloat(IFormatOutput &output, T value, const FormatField &field)");
+		return;
+	}
+	if(upper) toUpperFormatChars(digits, converted.ptr);
+
+	Char sign = '-';
+	auto bodyCount = (size_t) (converted.ptr - digits);
+	writePadded(output, StringView(&sign, negative ? 1 : 0), StringView(digits, bodyCount), bodyCount, field, true);
+}
+
+// 整数に浮動小数点数の型を指定したか判定する
+bool isFloatFormatType(Char type)
+{
+	return type == 'f' || type == 'e' || type == 'E' || type == 'g' || type == 'G';
+}
+
+// 文字列を書式に従って書き込みます
+void ElekiEngine::formatString(IFormatOutput &output, StringView value, const FormatField &field)
+{
+	// 精度は符号位置の数で切り詰める
+	if(field.precision >= 0)
+	{
+		size_t codePoints = 0, i = 0;
+		for(; i < value.count(); i++)
+		{
+			if(((u8) value[i] & 0xC0) != 0x80 && codePoints++ == (size_t) field.precision) break;
+		}
+		value = value.first(i);
+	}
+	auto width = field.width ? value.codePointCount() : 0;
+	writePadded(output, StringView(), value, width, field, false);
+}
+
+// 整数を書式に従って書き込みます
+void ElekiEngine::formatInteger(IFormatOutput &output, i64 value, const FormatField &field)
+{
+	if(isFloatFormatType(field.type)) formatFloat(output, (f64) value, field);
+	else writeFormatInteger(output, value < 0, value < 0 ? 0 - (u64) value : (u64) value, field);
+}
+
+// 整数を書式に従って書き込みます
+void ElekiEngine::formatInteger(IFormatOutput &output, u64 value, const FormatField &field)
+{
+	if(isFloatFormatType(field.type)) formatFloat(output, (f64) value, field);
+	else writeFormatInteger(output, false, value, field);
+}
+
+// 浮動小数点数を書式に従って書き込みます
+void ElekiEngine::formatFloat(IFormatOutput &output, f32 value, const FormatField &field)
+{
+	writeFormatFloat(output, value, field);
+}
+
+// 浮動小数点数を書式に従って書き込みます
+void ElekiEngine::formatFloat(IFormatOutput &output, f64 value, const FormatField &field)
+{
+	writeFormatFloat(output, value, field);
+}
+
+// 区間の文字列と引数を書き込む
+void writeFormatField(IFormatOutput &output, const Char *format, const FormatField &field, const _FormatArgument *arguments, size_t argumentCount)
+{
+	output.write(format + field.literal, field.literalCount);
+	if(field.argument == FORMAT_NO_ARGUMENT) return;
+	if(field.argument >= argumentCount)
+	{
+		printError("format argument index out of range. void writeFormatField(IFormatOutput &output, const Char *format, const FormatField &field, const _FormatArgument *arguments, size_t argumentCount)");
+		return;
+	}
+	auto &argument = arguments[field.argument];
+	argument.write(output, argument.value, field);
+}
+
+// 解析済みの区間に従って書き込みます
+void ElekiEngine::_formatFields(IFormatOutput &output, const Char *format, const FormatField *fields, size_t fieldCount, const _FormatArgument *arguments, size_t argumentCount)
+{
+	for(size_t i = 0; i < fieldCount; i++) writeFormatField(output, format, fields[i], arguments, argumentCount);
+}
+
+// 書式を解析しながら書き込みます
+void ElekiEngine::_formatRuntime(IFormatOutput &output, StringView format, const _FormatArgument *arguments, size_t argumentCount)
+{
+	size_t nextArgument = 0;
+	FormatField field;
+	for(size_t i = 0; i < format.count();)
+	{
+		i = _parseFormatField(format.data(), format.count(), i, nextArgument, field);
+		writeFormatField(output, format.data(), field, arguments, argumentCount);
+	}
+}
\ No newline at end of file
@@ -1,68 +1,192 @@
-#include <functional>
 #include "elekicore/hash.hpp"
 
+#if ELEKI_SIMD_AVX2
+#include <immintrin.h>
+#elif ELEKI_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace ElekiEngine;
+
 /// ハッシュ値を返します
 size_t ElekiEngine::i8ToHash(const i8 &value)
 {
-	return std::hash<i8>{}(value);
+	return Hash<i8>{}(value);
 }
 
 /// ハッシュ値を返します
 size_t ElekiEngine::u8ToHash(const u8 &value)
 {
-	return std::hash<u8>{}(value);
+	return Hash<u8>{}(value);
 }
 
 /// ハッシュ値を返します
 size_t ElekiEngine::i16ToHash(const i16 &value)
 {
-	return std::hash<i16>{}(value);
+	return Hash<i16>{}(value);
 }
 
 /// ハッシュ値を返します
 size_t ElekiEngine::u16ToHash(const u16 &value)
 {
-	return std::hash<u16>{}(value);
+	return Hash<u16>{}(value);
 }
 
 /// ハッシュ値を返します
 size_t ElekiEngine::i32ToHash(const i32 &value)
 {
-	return std::hash<i32>{}(value);
+	return Hash<i32>{}(value);
 }
 
 /// ハッシュ値を返します
 size_t ElekiEngine::u32ToHash(const u32 &value)
 {
-	return std::hash<u32>{}(value);
+	return Hash<u32>{}(value);
 }
 
 /// ハッシュ値を返します
 size_t ElekiEngine::i64ToHash(const i64 &value)
 {
-	return std::hash<i64>{}(value);
+	return Hash<i64>{}(value);
 }
 
 /// ハッシュ値を返します
 size_t ElekiEngine::u64ToHash(const u64 &value)
 {
-	return std::hash<u64>{}(value);
+	return Hash<u64>{}(value);
 }
 
 /// ハッシュ値を返します
 size_t ElekiEngine::f32ToHash(const f32 &value)
 {
-	return std::hash<f32>{}(value);
+	return Hash<f32>{}(value);
 }
 
 /// ハッシュ値を返します
 size_t ElekiEngine::f64ToHash(const f64 &value)
 {
-	return std::hash<f64>{}(value);
+	return Hash<f64>{}(value);
 }
 
 /// ハッシュ値を返します
 size_t ElekiEngine::boolToHash(const bool &value)
 {
-	return std::hash<bool>{}(value);
+	return Hash<bool>{}(value);
+}
+
+// 長いバイト列の処理で使用する乱数定数
+constexpr u64 LONG_SECRET[24] = {
+	0x5B26B27F3B74A950ull, 0xB90800829EA102BEull, 0x62783A636CB2AC6Aull, 0x8A3933B017FD54CEull,
+	0xF10B403BA79CC8A7ull, 0x27A1E80F0F16AC99ull, 0x495840D7356A154Bull, 0x2CA5A4956E633896ull,
+	0xFE910402A7A1A6BFull, 0x95C5C710B850CB6Aull, 0xD84ED8D992E78CB6ull, 0xBAC35C8272ECF4C9ull,
+	0x6D858C2E974A90B5ull, 0x64597C6AD6890A3Aull, 0xAA9C4ACB275EC30Cull, 0x8ECAA7A695A7A70Aull,
+	0x26E48BB42356B1A9ull, 0xCD7D5C936F4F4F41ull, 0x1AD117844F6D9A00ull, 0x54999969F61EA865ull,
+	0x884B6FF978032BD4ull, 0xAA6D316871E3F371ull, 0x85A9D9A4C9120F11ull, 0x79D23611A60EB83Eull,
+};
+constexpr size_t LONG_LANES = 8;                                    // 累積値の数
+constexpr size_t LONG_STRIPE = LONG_LANES * sizeof(u64);            // 1度に累積するバイト数
+constexpr size_t LONG_STRIPES_PER_BLOCK = 8;                        // 撹拌までに累積する回数
+constexpr size_t LONG_BLOCK = LONG_STRIPE * LONG_STRIPES_PER_BLOCK; // 撹拌の間に処理するバイト数
+constexpr u32 LONG_PRIME = 0x9E3779B1u;                             // 撹拌の乗数
+
+// 64バイトを累積値に加える
+// 各レーンは鍵と混ぜた値の上位と下位の32ビットの積を加え、隣のレーンは元の値を加える
+void accumulateLong(u64 *acc, const u8 *data, const u64 *key)
+{
+#if ELEKI_SIMD_AVX2
+	for(size_t i = 0; i < LONG_LANES; i += 4)
+	{
+		auto value = _mm256_loadu_si256((const __m256i *) (data + i * sizeof(u64)));
+		auto keyed = _mm256_xor_si256(value, _mm256_loadu_si256((const __m256i *) (key + i)));
+		auto product = _mm256_mul_epu32(keyed, _mm256_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+		auto swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+		auto sum = _mm256_add_epi64(_mm256_loadu_si256((const __m256i *) (acc + i)), swapped);
+		_mm256_storeu_si256((__m256i *) (acc + i), _mm256_add_epi64(sum, product));
+	}
+#elif ELEKI_SIMD_SSE2
+	for(size_t i = 0; i < LONG_LANES; i += 2)
+	{
+		auto value = _mm_loadu_si128((const __m128i *) (data + i * sizeof(u64)));
+		auto keyed = _mm_xor_si128(value, _mm_loadu_si128((const __m128i *) (key + i)));
+		auto product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+		auto swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+		auto sum = _mm_add_epi64(_mm_loadu_si128((const __m128i *) (acc + i)), swapped);
+		_mm_storeu_si128((__m128i *) (acc + i), _mm_add_epi64(sum, product));
+	}
+#else
+	for(size_t i = 0; i < LONG_LANES; i++)
+	{
+		auto value = _hashRead8(data + i * sizeof(u64));
+		auto keyed = value ^ key[i];
+		acc[i ^ 1] += value;
+		acc[i] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+	}
+#endif
+}
+
+// 累積値を撹拌し、上位のビットを下位へ行き渡らせる
+void scrambleLong(u64 *acc, const u64 *key)
+{
+#if ELEKI_SIMD_AVX2
+	auto prime = _mm256_set1_epi32((int) LONG_PRIME);
+	for(size_t i = 0; i < LONG_LANES; i += 4)
+	{
+		auto value = _mm256_loadu_si256((const __m256i *) (acc + i));
+		value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+		value = _mm256_xor_si256(value, _mm256_loadu_si256((const __m256i *) (key + i)));
+		auto low = _mm256_mul_epu32(value, prime);
+		auto high = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+		_mm256_storeu_si256((__m256i *) (acc + i), _mm256_add_epi64(low, _mm256_slli_epi64(high, 32)));
+	}
+#elif ELEKI_SIMD_SSE2
+	auto prime = _mm_set1_epi32((int) LONG_PRIME);
+	for(size_t i = 0; i < LONG_LANES; i += 2)
+	{
+		auto value = _mm_loadu_si128((const __m128i *) (acc + i));
+		value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+		value = _mm_xor_si128(value, _mm_loadu_si128((const __m128i *) (key + i)));
+		auto low = _mm_mul_epu32(value, prime);
+		auto high = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+		_mm_storeu_si128((__m128i *) (acc + i), _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+	}
+#else
+	for(size_t i = 0; i < LONG_LANES; i++)
+	{
+		auto value = acc[i];
+		value ^= value >> 47;
+		value ^= key[i];
+		acc[i] = value * LONG_PRIME;
+	}
+#endif
+}
+
+// 長いバイト列のハッシュ値を返す
+// 8レーンの累積値に64バイトずつ加え、512バイト毎に撹拌する
+u64 ElekiEngine::_bytesToHashLong(const u8 *bytes, size_t size, u64 seed)
+{
+	u64 acc[LONG_LANES] = {
+		0x00000000C2B2AE3Dull ^ seed, 0x9E3779B185EBCA87ull ^ seed, 0xC2B2AE3D27D4EB4Full ^ seed, 0x165667B19E3779F9ull ^ seed,
+		0x85EBCA77C2B2AE63ull ^ seed, 0x0000000085EBCA77ull ^ seed, 0x27D4EB2F165667C5ull ^ seed, 0x000000009E3779B1ull ^ seed,
+	};
+
+	// 末尾の1ストライプは別に処理するため、最後の1バイトを除いた範囲で区切る
+	auto blocks = (size - 1) / LONG_BLOCK;
+	for(size_t i = 0; i < blocks; i++)
+	{
+		auto block = bytes + i * LONG_BLOCK;
+		for(size_t j = 0; j < LONG_STRIPES_PER_BLOCK; j++) accumulateLong(acc, block + j * LONG_STRIPE, LONG_SECRET + j);
+		scrambleLong(acc, LONG_SECRET + LONG_LANES);
+	}
+	auto stripes = ((size - 1) - blocks * LONG_BLOCK) / LONG_STRIPE;
+	auto block = bytes + blocks * LONG_BLOCK;
+	for(size_t j = 0; j < stripes; j++) accumulateLong(acc, block + j * LONG_STRIPE, LONG_SECRET + j);
+	accumulateLong(acc, bytes + size - LONG_STRIPE, LONG_SECRET + LONG_LANES + 1);
+
+	// レーンを2つずつ128ビット積で混ぜ合わせる
+	u64 result = (u64) size * 0x9E3779B185EBCA87ull;
+	for(size_t i = 0; i < LONG_LANES; i += 2)
+	{
+		result += _hashMix(acc[i] ^ LONG_SECRET[16 + i], acc[i + 1] ^ LONG_SECRET[17 + i]);
+	}
+	return mixHash(result);
 }
\ No newline at end of file
@@ -0,0 +1,650 @@
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <utility>
+#include "elekicore/rope.hpp"
+
+using namespace ElekiEngine;
+
+//
+// ロープ
+// -----
+// 葉に文字列片を持ち、内部節点は子毎の文字数と改行の数を持つB+木
+// 位置と行番号は内部節点の数を引きながら根から降りて探すため、長さに依らず対数時間になる
+// 挿入で溢れた葉は半分に分割し、削除で小さくなった節点は兄弟と1つに収まれば併合する
+// 分割に必要な節点は変更を始める前に全て確保し、確保に失敗しても木を壊さない
+
+constexpr size_t ROPE_INSERT_CHARS = ROPE_CHUNK_CHARS / 2;      // 1度に挿入する最大文字数
+constexpr size_t ROPE_LEAF_MERGE_CHARS = ROPE_CHUNK_CHARS / 4;  // 併合を試みる葉の文字数
+constexpr size_t ROPE_INNER_MERGE_CHILDREN = ROPE_NODE_CHILDREN / 4; // 併合を試みる内部節点の子の数
+
+// 改行の数を数える
+size_t countNewlines(const Char *text, size_t count)
+{
+	size_t lines = 0;
+	for(size_t i = 0; i < count; i++) lines += text[i] == '\n';
+	return lines;
+}
+
+// メモリプールを作成する
+DynamicMemoryPool *ElekiEngine::Rope::createPool(size_t size)
+{
+	auto memory = mAllocator->allocate(sizeof(DynamicMemoryPool));
+	return memory ? new(memory) DynamicMemoryPool(size, ROPE_POOL_NODES_COUNT) : nullptr;
+}
+
+// 葉を確保する
+Rope::Leaf *ElekiEngine::Rope::newLeaf()
+{
+	if(!mLeafPool) mLeafPool = createPool(sizeof(Leaf));
+	auto memory = mLeafPool ? mLeafPool->allocate() : nullptr;
+	if(!memory) return nullptr;
+	auto leaf = new(memory) Leaf;
+	leaf->count = 0;
+	leaf->leaf = true;
+	leaf->prev = nullptr;
+	leaf->next = nullptr;
+	leaf->lines = 0;
+	return leaf;
+}
+
+// 内部節点を確保する
+Rope::Inner *ElekiEngine::Rope::newInner()
+{
+	if(!mInnerPool) mInnerPool = createPool(sizeof(Inner));
+	auto memory = mInnerPool ? mInnerPool->allocate() : nullptr;
+	if(!memory) return nullptr;
+	auto inner = new(memory) Inner;
+	inner->count = 0;
+	inner->leaf = false;
+	return inner;
+}
+
+// 節点と子孫を破棄する
+void ElekiEngine::Rope::destroyNode(Node *node)
+{
+	if(!node->leaf)
+	{
+		auto inner = (Inner *) node;
+		for(size_t i = 0; i < inner->count; i++) destroyNode(inner->children[i]);
+	}
+	DynamicMemoryPool::deallocate(node);
+}
+
+// 子の文字数と改行の数を数え直す
+void ElekiEngine::Rope::updateEntry(Inner *parent, size_t slot)
+{
+	auto node = parent->children[slot];
+	if(node->leaf)
+	{
+		parent->chars[slot] = node->count;
+		parent->lines[slot] = ((Leaf *) node)->lines;
+		return;
+	}
+	auto inner = (Inner *) node;
+	size_t chars = 0, lines = 0;
+	for(size_t i = 0; i < inner->count; i++)
+	{
+		chars += inner->chars[i];
+		lines += inner->lines[i];
+	}
+	parent->chars[slot] = chars;
+	parent->lines[slot] = lines;
+}
+
+// 経路上の文字数と改行の数を数え直す
+void ElekiEngine::Rope::updatePath(Inner **path, size_t *slots, size_t depth)
+{
+	for(auto d = depth; d > 0; d--) updateEntry(path[d - 1], slots[d - 1]);
+}
+
+// 位置を含む葉を探し、経路を記録する
+// @param [in,out] index 探す位置 葉の中の位置を返す
+// @param atEnd 真の場合、子の境界の位置は前の子の末尾とする
+Rope::Leaf *ElekiEngine::Rope::findLeaf(size_t &index, Inner **path, size_t *slots, size_t &depth, bool atEnd) const
+{
+	depth = 0;
+	auto node = mRoot;
+	while(!node->leaf)
+	{
+		auto inner = (Inner *) node;
+		size_t i = 0;
+		while(i + 1 < inner->count && (atEnd ? index > inner->chars[i] : index >= inner->chars[i]))
+		{
+			index -= inner->chars[i];
+			i++;
+		}
+		path[depth] = inner;
+		slots[depth] = i;
+		depth++;
+		node = inner->children[i];
+	}
+	return (Leaf *) node;
+}
+
+// 分割した節点を経路の親へ挿入する
+// 親が溢れた場合は親も分割し、根まで繰り返す
+// @param node 経路の末尾の節点の右に挿入する節点
+// @param spares 予め確保した内部節点
+void ElekiEngine::Rope::insertChild(Inner **path, size_t *slots, size_t depth, Node *node, Inner **spares, size_t &spareCount)
+{
+	for(auto d = depth; ; d--)
+	{
+		// 根を分割した場合は根を作る
+		if(d == 0)
+		{
+			auto root = spares[--spareCount];
+			root->count = 2;
+			root->children[0] = mRoot;
+			root->children[1] = node;
+			updateEntry(root, 0);
+			updateEntry(root, 1);
+			mRoot = root;
+			mHeight++;
+			return;
+		}
+
+		auto parent = path[d - 1];
+		auto slot = slots[d - 1] + 1;
+		for(auto i = parent->count; i > slot; i--)
+		{
+			parent->chars[i] = parent->chars[i - 1];
+			parent->lines[i] = parent->lines[i - 1];
+			parent->children[i] = parent->children[i - 1];
+		}
+		parent->children[slot] = node;
+		parent->count++;
+		updateEntry(parent, slot - 1);
+		updateEntry(parent, slot);
+		if(parent->count <= ROPE_NODE_CHILDREN)
+		{
+			updatePath(path, slots, d - 1);
+			return;
+		}
+
+		// 後ろ半分を新しい内部節点へ移す
+		auto right = spares[--spareCount];
+		auto half = parent->count / 2;
+		right->count = parent->count - half;
+		for(size_t i = 0; i < right->count; i++)
+		{
+			right->chars[i] = parent->chars[half + i];
+			right->lines[i] = parent->lines[half + i];
+			right->children[i] = parent->children[half + i];
+		}
+		parent->count = half;
+		node = right;
+	}
+}
+
+// 1つの葉に収まる文字列を挿入する
+bool ElekiEngine::Rope::insertChunk(size_t index, const Char *text, size_t count)
+{
+	if(!mRoot)
+	{
+		auto leaf = newLeaf();
+		if(!leaf) return false;
+		mRoot = leaf;
+		mFirst = leaf;
+		mLast = leaf;
+		mHeight = 1;
+	}
+
+	Inner *path[MAX_DEPTH];
+	size_t slots[MAX_DEPTH];
+	size_t depth = 0;
+	auto offset = index;
+	auto leaf = findLeaf(offset, path, slots, depth, true);
+	auto lines = countNewlines(text, count);
+
+	if(leaf->count + count <= ROPE_CHUNK_CHARS)
+	{
+		std::memmove(leaf->text + offset + count, leaf->text + offset, sizeof(Char) * (leaf->count - offset));
+		std::memcpy(leaf->text + offset, text, sizeof(Char) * count);
+		leaf->count += count;
+		leaf->lines += lines;
+		updatePath(path, slots, depth);
+		mCount += count;
+		mLines += lines;
+		return true;
+	}
+
+	// 分割に必要な節点を確保する 溢れる親が続く数と、根まで溢れる場合は新しい根の分
+	size_t needed = 0;
+	while(needed < depth && path[depth - 1 - needed]->count == ROPE_NODE_CHILDREN) needed++;
+	if(needed == depth) needed++;
+	if(depth + 1 >= MAX_DEPTH) return false;
+	Inner *spares[MAX_DEPTH + 1];
+	size_t spareCount = 0;
+	auto right = newLeaf();
+	while(right && spareCount < needed)
+	{
+		auto inner = newInner();
+		if(!inner) break;
+		spares[spareCount++] = inner;
+	}
+	if(!right || spareCount < needed)
+	{
+		if(right) DynamicMemoryPool::deallocate(right);
+		for(size_t i = 0; i < spareCount; i++) DynamicMemoryPool::deallocate(spares[i]);
+		return false;
+	}
+
+	// 末尾への挿入は新しい葉へ、途中への挿入は半分に分けてから入れる
+	auto half = offset == leaf->count ? leaf->count : leaf->count / 2;
+	right->count = leaf->count - half;
+	std::memcpy(right->text, leaf->text + half, sizeof(Char) * right->count);
+	right->lines = countNewlines(right->text, right->count);
+	leaf->count = half;
+	leaf->lines -= right->lines;
+	right->prev = leaf;
+	right->next = leaf->next;
+	if(leaf->next) leaf->next->prev = right;
+	else mLast = right;
+	leaf->next = right;
+
+	auto target = leaf;
+	if(offset >= half)
+	{
+		target = right;
+		offset -= half;
+	}
+	std::memmove(target->text + offset + count, target->text + offset, sizeof(Char) * (target->count - offset));
+	std::memcpy(target->text + offset, text, sizeof(Char) * count);
+	target->count += count;
+	target->lines += lines;
+
+	insertChild(path, slots, depth, right, spares, spareCount);
+	mCount += count;
+	mLines += lines;
+	return true;
+}
+
+// 葉を連結から外す
+void ElekiEngine::Rope::unlinkLeaf(Leaf *leaf)
+{
+	if(leaf->prev) leaf->prev->next = leaf->next;
+	else mFirst = leaf->next;
+	if(leaf->next) leaf->next->prev = leaf->prev;
+	else mLast = leaf->prev;
+}
+
+// 空になった節点を外し、小さな節点を兄弟と併合する
+// 併合しても経路上の文字数は変わらないため、数え直しは併合した親のみ行う
+void ElekiEngine::Rope::rebalance(Inner **path, size_t *slots, size_t depth)
+{
+	for(auto d = depth; d > 0; d--)
+	{
+		auto parent = path[d - 1];
+		auto slot = slots[d - 1];
+		auto node = parent->children[slot];
+		auto small = node->leaf ? node->count < ROPE_LEAF_MERGE_CHARS : node->count < ROPE_INNER_MERGE_CHILDREN;
+		if(!small) break;
+
+		// 空の節点は外し、そうでなければ収まる方の兄弟と併合する
+		size_t removed;
+		if(!node->count)
+		{
+			if(node->leaf) unlinkLeaf((Leaf *) node);
+			DynamicMemoryPool::deallocate(node);
+			removed = slot;
+		}
+		else
+		{
+			auto capacity = node->leaf ? ROPE_CHUNK_CHARS : ROPE_NODE_CHILDREN;
+			size_t left;
+			if(slot + 1 < parent->count && node->count + parent->children[slot + 1]->count <= capacity) left = slot;
+			else if(slot > 0 && parent->children[slot - 1]->count + node->count <= capacity) left = slot - 1;
+			else break;
+
+			auto l = parent->children[left];
+			auto r = parent->children[left + 1];
+			if(node->leaf)
+			{
+				auto ll = (Leaf *) l, rl = (Leaf *) r;
+				std::memcpy(ll->text + ll->count, rl->text, sizeof(Char) * rl->count);
+				ll->count += rl->count;
+				ll->lines += rl->lines;
+				unlinkLeaf(rl);
+			}
+			else
+			{
+				auto li = (Inner *) l, ri = (Inner *) r;
+				for(size_t i = 0; i < ri->count; i++)
+				{
+					li->chars[li->count + i] = ri->chars[i];
+					li->lines[li->count + i] = ri->lines[i];
+					li->children[li->count + i] = ri->children[i];
+				}
+				li->count += ri->count;
+			}
+			DynamicMemoryPool::deallocate(r);
+			parent->chars[left] += parent->chars[left + 1];
+			parent->lines[left] += parent->lines[left + 1];
+			removed = left + 1;
+		}
+
+		for(auto i = removed; i + 1 < parent->count; i++)
+		{
+			parent->chars[i] = parent->chars[i + 1];
+			parent->lines[i] = parent->lines[i + 1];
+			parent->children[i] = parent->children[i + 1];
+		}
+		parent->count--;
+	}
+
+	// 子が1つ以下の根を外して高さを減らす
+	while(mRoot && !mRoot->leaf && mRoot->count <= 1)
+	{
+		auto root = (Inner *) mRoot;
+		mRoot = root->count ? root->children[0] : nullptr;
+		DynamicMemoryPool::deallocate(root);
+		mHeight--;
+	}
+	if(mRoot && mRoot->leaf && !mRoot->count)
+	{
+		unlinkLeaf((Leaf *) mRoot);
+		DynamicMemoryPool::deallocate(mRoot);
+		mRoot = nullptr;
+	}
+	if(!mRoot)
+	{
+		mFirst = nullptr;
+		mLast = nullptr;
+		mHeight = 0;
+	}
+}
+
+// コンストラクタ
+ElekiEngine::Rope::Rope(IAllocator *allocator)
+	: mAllocator(allocator)
+	, mLeafPool(nullptr)
+	, mInnerPool(nullptr)
+	, mRoot(nullptr)
+	, mFirst(nullptr)
+	, mLast(nullptr)
+	, mCount(0)
+	, mLines(0)
+	, mHeight(0)
+{}
+
+// コンストラクタ
+ElekiEngine::Rope::Rope(StringView text, IAllocator *allocator)
+	: Rope(allocator)
+{
+	append(text);
+}
+
+// コピーコンストラクタ
+ElekiEngine::Rope::Rope(const Rope &rope)
+	: Rope(rope.mAllocator)
+{
+	for(auto chunk : rope.chunks()) append(chunk);
+}
+
+// ムーブコンストラクタ
+ElekiEngine::Rope::Rope(Rope &&rope) noexcept
+	: mAllocator(rope.mAllocator)
+	, mLeafPool(rope.mLeafPool)
+	, mInnerPool(rope.mInnerPool)
+	, mRoot(rope.mRoot)
+	, mFirst(rope.mFirst)
+	, mLast(rope.mLast)
+	, mCount(rope.mCount)
+	, mLines(rope.mLines)
+	, mHeight(rope.mHeight)
+{
+	rope.mLeafPool = nullptr;
+	rope.mInnerPool = nullptr;
+	rope.mRoot = nullptr;
+	rope.mFirst = nullptr;
+	rope.mLast = nullptr;
+	rope.mCount = 0;
+	rope.mLines = 0;
+	rope.mHeight = 0;
+}
+
+// デストラクタ
+ElekiEngine::Rope::~Rope()
+{
+	clear();
+	for(auto pool : { mLeafPool, mInnerPool })
+	{
+		if(!pool) continue;
+		pool->~DynamicMemoryPool();
+		mAllocator->deallocate(pool);
+	}
+}
+
+// コピー代入
+Rope &ElekiEngine::Rope::operator=(const Rope &rope)
+{
+	if(this == &rope) return *this;
+	clear();
+	for(auto chunk : rope.chunks()) append(chunk);
+	return *this;
+}
+
+// ムーブ代入
+Rope &ElekiEngine::Rope::operator=(Rope &&rope) noexcept
+{
+	if(this == &rope) return *this;
+	this->~Rope();
+	new(this) Rope(std::move(rope));
+	return *this;
+}
+
+// 文字列を挿入します
+bool ElekiEngine::Rope::insert(size_t index, StringView text)
+{
+	if(index > mCount)
+	{
+		printError("out of range. bool Rope::insert(size_t index, StringView text)");
+		return false;
+	}
+	for(size_t i = 0; i < text.count();)
+	{
+		auto count = text.count() - i < ROPE_INSERT_CHARS ? text.count() - i : ROPE_INSERT_CHARS;
+		if(!insertChunk(index + i, text.data() + i, count))
+		{
+			printError("failed to allocate. bool Rope::insert(size_t index, StringView text)");
+			return false;
+		}
+		i += count;
+	}
+	return true;
+}
+
+// 末尾に連結します
+bool ElekiEngine::Rope::append(StringView text)
+{
+	return insert(mCount, text);
+}
+
+// 範囲の文字を削除します
+void ElekiEngine::Rope::remove(size_t index, size_t count)
+{
+	if(index > mCount || count > mCount - index)
+	{
+		printError("out of range. void Rope::remove(size_t index, size_t count)");
+		return;
+	}
+
+	// 葉毎に削除する
+	while(count)
+	{
+		Inner *path[MAX_DEPTH];
+		size_t slots[MAX_DEPTH];
+		size_t depth = 0;
+		auto offset = index;
+		auto leaf = findLeaf(offset, path, slots, depth, false);
+		auto removed = leaf->count - offset < count ? leaf->count - offset : count;
+		auto lines = countNewlines(leaf->text + offset, removed);
+		std::memmove(leaf->text + offset, leaf->text + offset + removed, sizeof(Char) * (leaf->count - offset - removed));
+		leaf->count -= removed;
+		leaf->lines -= lines;
+		mCount -= removed;
+		mLines -= lines;
+		count -= removed;
+		updatePath(path, slots, depth);
+		rebalance(path, slots, depth);
+	}
+}
+
+// 全ての文字を削除します
+void ElekiEngine::Rope::clear()
+{
+	if(mRoot) destroyNode(mRoot);
+	mRoot = nullptr;
+	mFirst = nullptr;
+	mLast = nullptr;
+	mCount = 0;
+	mLines = 0;
+	mHeight = 0;
+}
+
+// 位置の文字を返します
+Char ElekiEngine::Rope::at(size_t index) const
+{
+	if(index >= mCount)
+	{
+		printError("out of range. Char Rope::at(size_t index) const");
+		return NULL_CHAR;
+	}
+	Inner *path[MAX_DEPTH];
+	size_t slots[MAX_DEPTH];
+	size_t depth = 0;
+	auto leaf = findLeaf(index, path, slots, depth, false);
+	return leaf->text[index];
+}
+
+// 範囲を切り出します
+Rope::Range ElekiEngine::Rope::slice(size_t index, size_t count) const
+{
+	if(index > mCount || count > mCount - index)
+	{
+		printError("out of range. Rope::Range Rope::slice(size_t index, size_t count) const");
+		return Range(nullptr, 0, 0);
+	}
+	if(!count) return Range(nullptr, 0, 0);
+	Inner *path[MAX_DEPTH];
+	size_t slots[MAX_DEPTH];
+	size_t depth = 0;
+	auto leaf = findLeaf(index, path, slots, depth, false);
+	return Range(leaf, index, count);
+}
+
+// 全体を文字列片の範囲として返します
+Rope::Range ElekiEngine::Rope::chunks() const
+{
+	return Range(mFirst, 0, mCount);
+}
+
+// 行の先頭の位置を返します
+size_t ElekiEngine::Rope::lineStart(size_t line) const
+{
+	if(line > mLines)
+	{
+		printError("out of range. size_t Rope::lineStart(size_t line) const");
+		return mCount;
+	}
+	if(!line) return 0;
+
+	// line番目の改行を含む葉まで降りる
+	size_t index = 0;
+	auto node = mRoot;
+	while(!node->leaf)
+	{
+		auto inner = (Inner *) node;
+		size_t i = 0;
+		while(i + 1 < inner->count && line > inner->lines[i])
+		{
+			line -= inner->lines[i];
+			index += inner->chars[i];
+			i++;
+		}
+		node = inner->children[i];
+	}
+	auto leaf = (Leaf *) node;
+	size_t offset = 0;
+	for(;;)
+	{
+		offset += stringIndexOf(leaf->text + offset, leaf->count - offset, '\n') + 1;
+		if(!--line) return index + offset;
+	}
+}
+
+// 位置を含む行の行番号を返します
+size_t ElekiEngine::Rope::lineOf(size_t index) const
+{
+	if(index > mCount)
+	{
+		printError("out of range. size_t Rope::lineOf(size_t index) const");
+		return mLines;
+	}
+	if(!mRoot) return 0;
+	size_t line = 0;
+	auto node = mRoot;
+	while(!node->leaf)
+	{
+		auto inner = (Inner *) node;
+		size_t i = 0;
+		while(i + 1 < inner->count && index >= inner->chars[i])
+		{
+			index -= inner->chars[i];
+			line += inner->lines[i];
+			i++;
+		}
+		node = inner->children[i];
+	}
+	return line + countNewlines(((Leaf *) node)->text, index);
+}
+
+// 行を改行を含まない範囲として返します
+Rope::Range ElekiEngine::Rope::line(size_t line) const
+{
+	if(line > mLines)
+	{
+		printError("out of range. Rope::Range Rope::line(size_t line) const");
+		return Range(nullptr, 0, 0);
+	}
+	auto begin = lineStart(line);
+	auto end = line < mLines ? lineStart(line + 1) - 1 : mCount;
+	return slice(begin, end - begin);
+}
+
+// 全ての行を先頭から走査する範囲を返します
+Rope::LineRange ElekiEngine::Rope::lines() const
+{
+	return LineRange(mFirst, mLines + 1);
+}
+
+// 文字数を返します
+size_t ElekiEngine::Rope::count() const
+{
+	return mCount;
+}
+
+// 行数を返します
+size_t ElekiEngine::Rope::lineCount() const
+{
+	return mLines + 1;
+}
+
+// 空か判定します
+bool ElekiEngine::Rope::empty() const
+{
+	return mCount == 0;
+}
+
+// 文字列に変換します
+String ElekiEngine::Rope::toString() const
+{
+	return chunks().toString();
+}
+
+// アロケータを返します
+IAllocator *ElekiEngine::Rope::allocator() const
+{
+	return mAllocator;
+}
\ No newline at end of file
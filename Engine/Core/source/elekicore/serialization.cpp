@@ -1,3 +1,4 @@
+#include <cstring>
 #include "elekicore/serialization.hpp"
 
 using namespace ElekiEngine;
@@ -23,6 +24,13 @@ ElekiEngine::Binary::Binary(std::initializer_list<u8> list, IAllocator *allocato
 	: List<u8>(list, allocator)
 {}
 
+// コンストラクタ
+// @param view コピーするバイト列のビュー
+// @param allocator 使用するアロケータ
+ElekiEngine::Binary::Binary(ByteView view, IAllocator *allocator)
+	: List<u8>(view, allocator)
+{}
+
 // コピーコンストラクタ
 ElekiEngine::Binary::Binary(const Binary &binary)
 	: List<u8>(binary)
@@ -65,6 +73,13 @@ Binary &ElekiEngine::Binary::operator+=(Binary &&binary) noexcept
 	return *this;
 }
 
+// 末尾に追加します
+Binary &ElekiEngine::Binary::operator+=(ByteView view)
+{
+	List<u8>::operator+=(view);
+	return *this;
+}
+
 // 末尾に追加します
 Binary &ElekiEngine::Binary::operator+=(const u8 &element)
 {
@@ -167,11 +182,11 @@ _ELEKICORE_SERIALIZATION_DATANODE_CONSTRUCTER(Binary, BINARY);
 // -----
 
 template<class T, size_t SIZE = sizeof(T)>
-T readBinaryNumber(const UR<Binary> &binary, size_t &index)
+T readBinaryNumber(ByteView binary, size_t &index)
 {
 	T result;
 	auto outBytes = (u8 *) (void *) &result;
-	auto inBytes = (const u8 *) (const void *) &binary->at(index);
+	auto inBytes = &binary.at(index);
 
 	switch(endian())
 	{
@@ -188,26 +203,41 @@ T readBinaryNumber(const UR<Binary> &binary, size_t &index)
 	return result;
 }
 
-String readBinaryString(const UR<Binary> &binary, size_t &index)
+// 終端までの文字列をインターンせずに参照します
+// 位置は終端の次に進めます
+StringView readBinaryStringView(ByteView binary, size_t &index)
 {
-	String result = (Char*)&binary->at(index);
-	index += result.count();
-	return result;
+	if(index >= binary.count())
+	{
+		printError("out of range. StringView readBinaryStringView(ByteView binary, size_t &index)");
+		return StringView();
+	}
+	auto begin = binary.data() + index;
+	auto end = (const u8 *) std::memchr(begin, (int) EBinarySign::END, binary.count() - index);
+	if(!end)
+	{
+		printError("string is not terminated. StringView readBinaryStringView(ByteView binary, size_t &index)");
+		auto count = binary.count() - index;
+		index = binary.count();
+		return StringView((const Char *) begin, count);
+	}
+	index += (size_t) (end - begin) + 1;
+	return StringView((const Char *) begin, (size_t) (end - begin));
 }
 
-UR<Serialization::DataNode> makeDataNode(const UR<Binary> &binary, size_t &index);
+UR<Serialization::DataNode> makeDataNode(ByteView binary, size_t &index);
 
 template<class T, class D>
-UR<Serialization::DataNode> makeNumberDataNode(const UR<Binary> &binary, size_t &index)
+UR<Serialization::DataNode> makeNumberDataNode(ByteView binary, size_t &index)
 {
 	UR<D> result;
 	result->value = readBinaryNumber<T>(binary, index);
 	return (UR<Serialization::DataNode>)result;
 }
 
-UR<Serialization::DataNode> makeReferenceDataNode(const UR<Binary> &binary, size_t &index)
+UR<Serialization::DataNode> makeReferenceDataNode(ByteView binary, size_t &index)
 {
-	if((EBinarySign)binary->at(index) == EBinarySign::U32)
+	if((EBinarySign)binary.at(index) == EBinarySign::U32)
 	{
 		UR<Serialization::InsideReferenceDataNode> result;
 		result->value = readBinaryNumber<u32>(binary, ++index);
@@ -216,57 +246,57 @@ UR<Serialization::DataNode> makeReferenceDataNode(const UR<Binary> &binary, size
 	else
 	{
 		UR<Serialization::OutsideReferenceDataNode> result;
-		result->value = readBinaryString(binary, ++index);
+		// ノードは変換元のバイナリより長く生存するため、保持する値のみ文字列にする
+		result->value = String(readBinaryStringView(binary, ++index));
 		return (UR<Serialization::DataNode>) result;
 	}
 }
 
-UR<Serialization::DataNode> makeArrayDataNode(const UR<Binary> &binary, size_t &index)
+UR<Serialization::DataNode> makeArrayDataNode(ByteView binary, size_t &index)
 {
 	UR<Serialization::ArrayDataNode> result;
-	while((EBinarySign)binary->at(index) != EBinarySign::END)
+	while((EBinarySign)binary.at(index) != EBinarySign::END)
 	{
 		result->value.add(makeDataNode(binary, index));
 	}
 	return (UR<Serialization::DataNode>)result;
 }
 
-UR<Serialization::DataNode> makeStructDataNode(const UR<Binary> &binary, size_t &index)
+UR<Serialization::DataNode> makeStructDataNode(ByteView binary, size_t &index)
 {
 	UR<Serialization::StructDataNode> result;
-	while((EBinarySign)binary->at(index) != EBinarySign::END)
+	while((EBinarySign)binary.at(index) != EBinarySign::END)
 	{
-		result->value.add(readBinaryString(binary, ++index), makeDataNode(binary, index));
+		// フィールド名は文字列IDにするのみで、インターンも名前の登録も行わない
+		auto name = readBinaryStringView(binary, ++index);
+		result->value.add(StringId(name.data(), name.count()), makeDataNode(binary, index));
 	}
 	return (UR<Serialization::DataNode>)result;
 }
 
-UR<Serialization::DataNode> makeStringDataNode(const UR<Binary> &binary, size_t &index)
+UR<Serialization::DataNode> makeStringDataNode(ByteView binary, size_t &index)
 {
 	UR<Serialization::StringDataNode> result;
-	result->value = readBinaryString(binary, index);
+	result->value = String(readBinaryStringView(binary, index));
 	return (UR<Serialization::DataNode>)result;
 }
 
-UR<Serialization::DataNode> makeBinaryDataNode(const UR<Binary> &binary, size_t &index)
+UR<Serialization::DataNode> makeBinaryDataNode(ByteView binary, size_t &index)
 {
 	UR<Serialization::BinaryDataNode> result;
 	do
 	{
 		auto length = (size_t) readBinaryNumber<u32>(binary, index);
-		for(size_t i = 0; i < length; i++)
-		{
-			result->value.add(binary->at(index + i));
-		}
+		result->value.add(binary.sub(index, length));
 		index += length;
 	}
-	while((EBinarySign)binary->at(index) != EBinarySign::END);
+	while((EBinarySign)binary.at(index) != EBinarySign::END);
 	return (UR<Serialization::DataNode>)result;
 }
 
-UR<Serialization::DataNode> makeDataNode(const UR<Binary> &binary, size_t &index)
+UR<Serialization::DataNode> makeDataNode(ByteView binary, size_t &index)
 {
-	switch((EBinarySign)binary->at(index))
+	switch((EBinarySign)binary.at(index))
 	{
 		case EBinarySign::I8: return makeNumberDataNode<i8, Serialization::I8DataNode>(binary, ++index);
 		case EBinarySign::U8: return makeNumberDataNode<u8, Serialization::U8DataNode>(binary, ++index);
@@ -290,37 +320,44 @@ UR<Serialization::DataNode> makeDataNode(const UR<Binary> &binary, size_t &index
 	}
 }
 
-bool isElekiBinary(const UR<Binary> &binary)
+bool isElekiBinary(ByteView binary)
 {
 	size_t i = 0;
 	// 形式名を比較
 	for(; i < Serialization::BinaryInformation::NAME.count(); i++)
 	{
-		if(Serialization::BinaryInformation::NAME[i] != (Char) binary->at(i)) return;
+		if(Serialization::BinaryInformation::NAME[i] != (Char) binary.at(i)) return;
 	}
 	// バージョンを比較
 	return Serialization::BinaryInformation::VERSION == readBinaryNumber<u32>(binary, i);
 }
 
 // 型名と並列読み込み開始位置を取得します
-void readTypenameAndStartPosition(const UR<Binary> &binary, List<String> &typenameList, List<size_t> &startPositionList)
+// 型名は結果に格納するまでバイナリを参照する
+void readTypenameAndStartPosition(ByteView binary, List<StringView> &typenameList, List<size_t> &startPositionList)
 {
-	for(size_t i = Serialization::BinaryInformation::SIZE; i < binary->count();i += (size_t) readBinaryNumber<u32>(binary, i))
+	for(size_t i = Serialization::BinaryInformation::SIZE; i < binary.count();i += (size_t) readBinaryNumber<u32>(binary, i))
 	{
-		typenameList.add(readBinaryString(binary, i));
+		typenameList.add(readBinaryStringView(binary, i));
 		startPositionList.add(i);
 	}
 }
 
 // バイナリデータからノードに変換します
 List<Serialization::ToNodeResult> ElekiEngine::Serialization::toNode(const UR<Binary> &binary)
+{
+	return toNode((ByteView) *binary);
+}
+
+// バイナリデータからノードに変換します
+List<Serialization::ToNodeResult> ElekiEngine::Serialization::toNode(ByteView binary)
 {
 	// ElekiBinaryかチェックします
 	if(!isElekiBinary(binary)) return List<Serialization::ToNodeResult>();
 	
 	// 並列読み込み開始位置とサイズを取得します
 	List<size_t> startPositionList; 
-	List<String> typenameList;
+	List<StringView> typenameList;
 	readTypenameAndStartPosition(binary, typenameList, startPositionList);
 	
 	// 並列にノードへ変換します
@@ -331,7 +368,7 @@ List<Serialization::ToNodeResult> ElekiEngine::Serialization::toNode(const UR<Bi
 		{
 			Serialization::ToNodeResult result;
 			result.node = makeDataNode(binary, startPositionList[i]);
-			result.typeName = typenameList[i];
+			result.typeName = String(typenameList[i]);
 			return result;
 		});
 	}
@@ -1,109 +1,380 @@
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <mutex>
-#include <string>
+#include <new>
 #include "elekicore/string.hpp"
-#include "elekicore/map.hpp"
+#include "elekicore/stringbuilder.hpp"
+#include "elekicore/bit.hpp"
 
 using namespace ElekiEngine;
 
+//
+// 文字列インターン表
+// -----
+// ハッシュ値の上位ビットで64の分割表に振り分け、分割表毎に排他ロックを持つ
+// 登録済みの文字列の検索はロックを取らずに行い、見つからない場合のみロックを取って登録する
+// 参照数は原子的に増減し、コピーは表を引かずに参照数を増やすだけで行う
+// 共有メモリはスレッド安全でないため、情報と表はmallocで確保する
+//
+// 参照が0になった情報は、分割表のロックを取って参照数を0から解放済みの印に置き換えてから表から外す
+// 置き換える前に検索で見つかった情報は参照数を0から戻して再利用するため、外す処理と検索は競合しない
+// 遅延解放の場合、参照が0になっても表に残し、sweepStrings()か表の作り直しでまとめて外す
+
+constexpr size_t STRING_SHARDS_BITS = 6;                        // 分割表の数のビット数
+constexpr size_t STRING_SHARDS = (size_t) 1 << STRING_SHARDS_BITS; // 分割表の数
+constexpr size_t STRING_TABLE_INIT_SLOTS = 64;                  // 表の初期の位置数
+constexpr size_t DEAD_STRING_REF = ~(size_t) 0;                 // 表から外した情報の参照数
+
 // 文字列情報構造体
+// 生文字列を末尾に続けて確保し、Stringの生文字列から位置を逆算する
 struct StringInfo
 {
-    Char *string;    // 生文字列
-    size_t count;    // 生文字列長
-    size_t hash;     // 生文字列ハッシュ
+    std::atomic<size_t> refCount; // この情報を共有しているインスタンス数 表から外した情報はDEAD_STRING_REF
+    size_t hash;                  // 生文字列ハッシュ
+    size_t count;                 // 生文字列長
+    StringInfo *nextRetired;      // 解放待ちの次の情報
+    Char string[1];               // 生文字列
+};
 
-    size_t refCount; // この情報を共有しているインスタンス数
+// 開番地法の表
+struct StringTable
+{
+    size_t mask;                        // 位置のマスク
+    StringTable *nextRetired;           // 解放待ちの次の表
+    std::atomic<StringInfo *> slots[1]; // 位置
+};
 
-    // コンストラクタ
-    StringInfo(Char *string, size_t count, size_t hash)
-        : string(string)
-        , count(count)
-        , hash(hash)
-        , refCount(0)
-    {}
+// 分割表
+// 削除した情報と古い表は、ロックを取らずに読んでいるスレッドが居なくなるまで解放を待つ
+struct alignas(64) StringShard
+{
+    std::mutex lock;                           // 登録と削除の排他ロック
+    std::atomic<StringTable *> table{nullptr}; // 表
+    std::atomic<size_t> readers{0};            // ロックを取らずに表を読んでいるスレッド数
+    size_t used = 0;                           // 使用中と削除済みの位置の数
+    StringInfo *retiredInfos = nullptr;        // 解放待ちの情報
+    StringTable *retiredTables = nullptr;      // 解放待ちの表
 };
 
-// 生文字列ハッシュ関数オブジェクト
-struct HashToRawChar
+StringShard *gStringShards;                      // 分割表 静的なStringのデストラクタから使われるため、破棄しない
+std::once_flag gInitStringShardsFlag;            // initStringShards初期化フラグ
+std::atomic<size_t> gStringCount{0};             // 表に登録されている情報の数
+std::atomic<size_t> gStringBytes{0};             // 表に登録されている情報のバイト数
+std::atomic<size_t> gStringTableBytes{0};        // 使用中の表のバイト数
+std::atomic<bool> gStringSweepDeferred{false};   // 参照が0になった情報の解放を遅延させるか
+
+// 削除済みの位置の印
+StringInfo *const REMOVED_STRING_INFO = (StringInfo *) (uintptr_t) 1;
+
+// 生文字列から文字列情報を取得する
+StringInfo *infoOfString(const Char *string)
+{
+    return (StringInfo *) (void *) ((u8 *) string - offsetof(StringInfo, string));
+}
+
+// 分割表を初期化する
+// 他の翻訳単位の静的なStringから先に使われる場合があるため、初回の使用時に作成する
+// mallocの整列を超えるため、余分に確保して整列する
+void initStringShards()
+{
+    auto memory = (uintptr_t) std::malloc(sizeof(StringShard) * STRING_SHARDS + alignof(StringShard) - 1);
+    gStringShards = (StringShard *) ((memory + alignof(StringShard) - 1) / alignof(StringShard) * alignof(StringShard));
+    for(size_t i = 0; i < STRING_SHARDS; i++) new(&gStringShards[i]) StringShard();
+}
+
+// 分割表を取得する
+StringShard *stringShards()
+{
+    std::call_once(gInitStringShardsFlag, initStringShards);
+    return gStringShards;
+}
+
+// ハッシュ値から分割表を取得する
+// 表の位置は下位ビットから選ぶため、上位ビットで振り分ける
+StringShard &shardOfHash(size_t hash)
+{
+    return stringShards()[hash >> (sizeof(size_t) * 8 - STRING_SHARDS_BITS)];
+}
+
+// 文字列情報のバイト数を返す
+size_t stringInfoBytes(size_t count)
+{
+    return offsetof(StringInfo, string) + sizeof(Char) * (count + 1);
+}
+
+// 表のバイト数を返す
+size_t stringTableBytes(size_t slots)
+{
+    return offsetof(StringTable, slots) + sizeof(std::atomic<StringInfo *>) * slots;
+}
+
+// 位置数を指定して表を確保する
+StringTable *allocateStringTable(size_t slots)
+{
+    auto table = (StringTable *) std::malloc(stringTableBytes(slots));
+    if(!table) return nullptr;
+    table->mask = slots - 1;
+    table->nextRetired = nullptr;
+    for(size_t i = 0; i < slots; i++) new(&table->slots[i]) std::atomic<StringInfo *>(nullptr);
+    return table;
+}
+
+// 表から文字列情報を検索し、参照を1つ増やす
+// 参照が0の情報は再利用し、表から外した情報は読み飛ばす
+// @retval nullptr 見つかりませんでした
+StringInfo *acquireStringInfo(StringTable *table, const Char *string, size_t count, size_t hash)
 {
-    size_t operator()(const Char *string)
+    if(!table) return nullptr;
+    for(auto i = hash & table->mask; ; i = (i + 1) & table->mask)
     {
-        return std::hash<std::string>{}(string);
+        auto info = table->slots[i].load(std::memory_order_acquire);
+        if(!info) return nullptr;
+        if(info == REMOVED_STRING_INFO || info->hash != hash || info->count != count) continue;
+        if(!stringEqual(info->string, string, count)) continue;
+
+        auto refCount = info->refCount.load(std::memory_order_relaxed);
+        while(refCount != DEAD_STRING_REF)
+        {
+            if(info->refCount.compare_exchange_weak(refCount, refCount + 1, std::memory_order_acquire, std::memory_order_relaxed)) return info;
+        }
     }
-};
+}
+
+// 読んでいるスレッドが居なければ、解放待ちの情報と表を解放する
+// 分割表のロックを取って呼び出す
+void collectStringShard(StringShard &shard)
+{
+    if(!shard.retiredInfos && !shard.retiredTables) return;
+
+    // 削除の書き込みと、読み込みスレッド数の読み込みの順序を保証する
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(shard.readers.load(std::memory_order_acquire)) return;
+
+    while(auto info = shard.retiredInfos)
+    {
+        shard.retiredInfos = info->nextRetired;
+        std::free(info);
+    }
+    while(auto table = shard.retiredTables)
+    {
+        shard.retiredTables = table->nextRetired;
+        std::free(table);
+    }
+}
 
-// 生文字列比較関数オブジェクト
-struct EqualToRawChar
+// 参照が0の情報を表の位置から外し、解放待ちにする
+// 参照が戻された場合は外さない
+// 分割表のロックを取って呼び出す
+// @return 外した場合真
+bool retireStringInfo(StringShard &shard, StringTable *table, size_t slot, StringInfo *info)
 {
-    bool operator()(const Char *l, const Char *r)
+    size_t refCount = 0;
+    if(!info->refCount.compare_exchange_strong(refCount, DEAD_STRING_REF, std::memory_order_acquire, std::memory_order_relaxed)) return false;
+    table->slots[slot].store(REMOVED_STRING_INFO, std::memory_order_relaxed);
+    gStringCount.fetch_sub(1, std::memory_order_relaxed);
+    gStringBytes.fetch_sub(stringInfoBytes(info->count), std::memory_order_relaxed);
+    info->nextRetired = shard.retiredInfos;
+    shard.retiredInfos = info;
+    return true;
+}
+
+// 参照が0の情報をすべて表から外す
+// 分割表のロックを取って呼び出す
+// @return 外した情報の数
+size_t sweepStringShard(StringShard &shard)
+{
+    auto table = shard.table.load(std::memory_order_relaxed);
+    if(!table) return 0;
+    size_t swept = 0;
+    for(size_t i = 0; i <= table->mask; i++)
+    {
+        auto info = table->slots[i].load(std::memory_order_relaxed);
+        if(info && info != REMOVED_STRING_INFO && retireStringInfo(shard, table, i, info)) swept++;
+    }
+    return swept;
+}
+
+// 表を作り直す
+// 参照が0の情報は外し、削除済みの位置は写さない
+// 分割表のロックを取って呼び出す
+bool rehashStringShard(StringShard &shard, size_t count)
+{
+    sweepStringShard(shard);
+    auto old = shard.table.load(std::memory_order_relaxed);
+    size_t live = 0;
+    if(old)
     {
-        for(size_t i = 0; ; i++)
+        for(size_t i = 0; i <= old->mask; i++)
         {
-            if(l[i] == NULL_CHAR && r[i] == NULL_CHAR) return true;
-            if(l[i] != r[i]) return false;
-            if(l[i] == NULL_CHAR || r[i] == NULL_CHAR) return false;
+            auto info = old->slots[i].load(std::memory_order_relaxed);
+            if(info && info != REMOVED_STRING_INFO) live++;
         }
     }
-};
 
-// 文字列情報マップ型
-using StringInfoMap = Map<const Char *, StringInfo *, HashToRawChar, EqualToRawChar>;
+    // 使用率が半分以下になる位置数を選ぶ
+    auto slots = (size_t) nextPowerOfTwo((u64) (live + count) * 2);
+    if(slots < STRING_TABLE_INIT_SLOTS) slots = STRING_TABLE_INIT_SLOTS;
+    auto table = allocateStringTable(slots);
+    if(!table) return false;
+
+    shard.used = 0;
+    if(old)
+    {
+        for(size_t i = 0; i <= old->mask; i++)
+        {
+            auto info = old->slots[i].load(std::memory_order_relaxed);
+            if(!info || info == REMOVED_STRING_INFO) continue;
+            auto j = info->hash & table->mask;
+            while(table->slots[j].load(std::memory_order_relaxed)) j = (j + 1) & table->mask;
+            table->slots[j].store(info, std::memory_order_relaxed);
+            shard.used++;
+        }
+        old->nextRetired = shard.retiredTables;
+        shard.retiredTables = old;
+        gStringTableBytes.fetch_sub(stringTableBytes(old->mask + 1), std::memory_order_relaxed);
+    }
+    gStringTableBytes.fetch_add(stringTableBytes(slots), std::memory_order_relaxed);
+    shard.table.store(table, std::memory_order_release);
+    return true;
+}
+
+// 文字列を登録し、参照を1つ増やした文字列情報を返す
+// @retval nullptr メモリの確保に失敗しました
+StringInfo *internString(const Char *string, size_t count, size_t hash)
+{
+    auto &shard = shardOfHash(hash);
+
+    // ロックを取らずに検索する
+    shard.readers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto info = acquireStringInfo(shard.table.load(std::memory_order_acquire), string, count, hash);
+    shard.readers.fetch_sub(1, std::memory_order_release);
+    if(info) return info;
+
+    // 見つからなければロックを取り、検索し直してから登録する
+    std::unique_lock<std::mutex> lock(shard.lock);
+    auto table = shard.table.load(std::memory_order_relaxed);
+    info = acquireStringInfo(table, string, count, hash);
+    if(info) return info;
+
+    if(!table || (shard.used + 1) * 4 > (table->mask + 1) * 3)
+    {
+        if(!rehashStringShard(shard, 1))
+        {
+            printError("failed to allocate. StringInfo *internString(const Char *string, size_t count, size_t hash)");
+            return nullptr;
+        }
+        table = shard.table.load(std::memory_order_relaxed);
+    }
+
+    info = (StringInfo *) std::malloc(stringInfoBytes(count));
+    if(!info)
+    {
+        printError("failed to allocate. StringInfo *internString(const Char *string, size_t count, size_t hash)");
+        return nullptr;
+    }
+    new(&info->refCount) std::atomic<size_t>(1);
+    info->hash = hash;
+    info->count = count;
+    info->nextRetired = nullptr;
+    std::memcpy(info->string, string, sizeof(Char) * count);
+    info->string[count] = NULL_CHAR;
+
+    // 削除済みの位置は再利用する
+    auto i = hash & table->mask;
+    for(;;)
+    {
+        auto slot = table->slots[i].load(std::memory_order_relaxed);
+        if(!slot || slot == REMOVED_STRING_INFO)
+        {
+            if(!slot) shard.used++;
+            break;
+        }
+        i = (i + 1) & table->mask;
+    }
+    table->slots[i].store(info, std::memory_order_release);
+    gStringCount.fetch_add(1, std::memory_order_relaxed);
+    gStringBytes.fetch_add(stringInfoBytes(count), std::memory_order_relaxed);
+    collectStringShard(shard);
+    return info;
+}
 
-StringInfoMap *gStringInfos;      // 文字列情報マップ
-std::mutex gStringInfoLockFlag;   // 文字列情報マップ排他ロックフラグ
-std::once_flag gInitStringInfosF; // initStringInfo初期化フラグ
-void initStringInfos()
+// 参照を1つ増やす
+void retainString(const Char *string)
 {
-    gStringInfos = new(std::malloc(sizeof(StringInfoMap))) StringInfoMap();
+    if(string) infoOfString(string)->refCount.fetch_add(1, std::memory_order_relaxed);
 }
 
-// 文字列情報マップから取得します
-Char *setStringInfos(const Char *string, size_t &count, size_t &hash)
+// 参照を1つ減らし、0になった場合は表から削除する
+// 遅延解放の場合は表に残す
+void releaseString(const Char *string)
 {
-    std::call_once(gInitStringInfosF, initStringInfos);
-    Char *str = nullptr;
-    if(!gStringInfos->contains(string))
+    if(!string) return;
+    auto info = infoOfString(string);
+    auto hash = info->hash;
+    if(info->refCount.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    if(gStringSweepDeferred.load(std::memory_order_relaxed)) return;
+
+    // 参照を0にした後は、他のスレッドが既に外して解放している場合がある
+    // 表に残っている場合のみ情報に触れる
+    auto &shard = shardOfHash(hash);
+    std::unique_lock<std::mutex> lock(shard.lock);
+    auto table = shard.table.load(std::memory_order_relaxed);
+    if(!table) return;
+    for(auto i = hash & table->mask; ; i = (i + 1) & table->mask)
     {
-        std::string stdstr(string);
-        count = stdstr.size();
-        hash = std::hash<std::string>{}(stdstr);
-        str = new(Memory::allocate(sizeof(Char) * (stdstr.size() + 1))) Char();
-        for(size_t i = 0; i < count + 1; i++) str[i] = string[i];
-        auto info = new(Memory::allocate(sizeof(StringInfo))) StringInfo(str, count, hash);
-        info->refCount += 1;
-
-        gStringInfos->add(str, info);
+        auto slot = table->slots[i].load(std::memory_order_relaxed);
+        if(!slot) break;
+        if(slot == info)
+        {
+            retireStringInfo(shard, table, i, info);
+            break;
+        }
     }
-    else
+    collectStringShard(shard);
+}
+
+// 参照が0になった文字列の解放を遅延させるか設定します
+void ElekiEngine::setStringSweepDeferred(bool deferred)
+{
+    gStringSweepDeferred.store(deferred, std::memory_order_relaxed);
+}
+
+// 参照が0の文字列をまとめて解放します
+size_t ElekiEngine::sweepStrings()
+{
+    size_t swept = 0;
+    auto shards = stringShards();
+    for(size_t i = 0; i < STRING_SHARDS; i++)
     {
-        auto info = gStringInfos->at(string);
-        str = info->string;
-        count = info->count;
-        hash = info->hash;
-        info->refCount += 1;
+        auto &shard = shards[i];
+        std::unique_lock<std::mutex> lock(shard.lock);
+        swept += sweepStringShard(shard);
+        collectStringShard(shard);
     }
-    return str;
+    return swept;
 }
 
-// 文字列情報マップから削除します
-void removeStringInfos(const Char *string)
+// インターン表の統計を返します
+StringTableStatistics ElekiEngine::stringTableStatistics()
 {
-    auto info = gStringInfos->at(string);
-    gStringInfos->remove(string);
-    Memory::deallocate((void *) info->string);
-    Memory::deallocate(info);
+    StringTableStatistics statistics;
+    statistics.count = gStringCount.load(std::memory_order_relaxed);
+    statistics.bytes = gStringBytes.load(std::memory_order_relaxed);
+    statistics.tableBytes = gStringTableBytes.load(std::memory_order_relaxed);
+    return statistics;
 }
 
-// 文字列を接続します
-Char *joinStringInfos(const Char *strL, const Char *strR, size_t &countL, size_t countR, size_t &hashL)
+// 生文字列を登録する
+Char *setStringInfos(const Char *string, size_t count, size_t &hash)
 {
-    List<Char> tmpstr(countL + countR + 1);
-    for(size_t i = 0; i < countL; i++) tmpstr[i] = strL[i];
-    for(size_t i = countL, j = 0; j < countR; i++, j++) tmpstr[i] = strR[j];
-    tmpstr[countL + countR + 1] = NULL_CHAR;
-    std::unique_lock<std::mutex> lock(gStringInfoLockFlag);
-    auto retstr = setStringInfos(&tmpstr[0], countL, hashL);
-    return retstr;
+    hash = bytesToHash(string, count * sizeof(Char));
+    auto info = internString(string, count, hash);
+    return info ? info->string : nullptr;
 }
 
 // コンストラクタ
@@ -119,70 +390,91 @@ ElekiEngine::String::String(const Char *string)
     , mCount(0)
     , mHash(0)
 {
-    std::unique_lock<std::mutex> lock(gStringInfoLockFlag);
+    if(!string) return;
+    mCount = stringLength(string);
     mString = setStringInfos(string, mCount, mHash);
+    if(!mString) mCount = 0;
 }
 
-// コピーコンストラクタ
-ElekiEngine::String::String(const String &string)
+// コンストラクタ
+ElekiEngine::String::String(const Char *string, size_t count)
     : mString(nullptr)
-    , mCount(0)
+    , mCount(count)
     , mHash(0)
 {
-    std::unique_lock<std::mutex> lock(gStringInfoLockFlag);
-    mString = setStringInfos(string.mString, mCount, mHash);
+    mString = setStringInfos(string, mCount, mHash);
+    if(!mString) mCount = 0;
+}
+
+// コンストラクタ
+ElekiEngine::String::String(StringView string)
+    : String(string.data(), string.count())
+{}
+
+// コピーコンストラクタ
+ElekiEngine::String::String(const String &string)
+    : mString(string.mString)
+    , mCount(string.mCount)
+    , mHash(string.mHash)
+{
+    retainString(mString);
 }
 
 // ムーブコンストラクタ
 ElekiEngine::String::String(String &&string) noexcept
-    : mString(nullptr)
-    , mCount(0)
-    , mHash(0)
+    : mString(string.mString)
+    , mCount(string.mCount)
+    , mHash(string.mHash)
 {
-    std::unique_lock<std::mutex> lock(gStringInfoLockFlag);
-    mString = setStringInfos(string.mString, mCount, mHash);
+    string.mString = nullptr;
+    string.mCount = 0;
+    string.mHash = 0;
+}
+
+// デストラクタ
+ElekiEngine::String::~String()
+{
+    releaseString(mString);
 }
 
 // コピー代入
 String &ElekiEngine::String::operator=(const String &string)
 {
-    auto info = gStringInfos->at(mString);
-    std::unique_lock<std::mutex> lock(gStringInfoLockFlag);
-    info->refCount -= 1;
-    if(!info->refCount)
-    {
-        removeStringInfos(mString);
-    }
-    mString = setStringInfos(string.mString, mCount, mHash);
+    retainString(string.mString);
+    releaseString(mString);
+    mString = string.mString;
+    mCount = string.mCount;
+    mHash = string.mHash;
     return *this;
 }
 
 // ムーブ代入
 String &ElekiEngine::String::operator=(String &&string) noexcept
 {
-    auto info = gStringInfos->at(mString);
-    std::unique_lock<std::mutex> lock(gStringInfoLockFlag);
-    info->refCount -= 1;
-    if(!info->refCount)
-    {
-        removeStringInfos(mString);
-    }
-    mString = setStringInfos(string.mString, mCount, mHash);
+    if(this == &string) return *this;
+    releaseString(mString);
+    mString = string.mString;
+    mCount = string.mCount;
+    mHash = string.mHash;
+    string.mString = nullptr;
+    string.mCount = 0;
+    string.mHash = 0;
     return *this;
 }
 
 // 末尾に連結します
 String &ElekiEngine::String::operator+=(const String &string)
 {
-    auto newstr = joinStringInfos(mString, string.mString, mCount, string.mCount, mHash);
-    return operator=(newstr);
+    // 連結した文字列だけをインターンする
+    StringBuilder tmpstr(mCount + string.mCount);
+    tmpstr.append(mString, mCount).append(string.mString, string.mCount);
+    return operator=(tmpstr.toString());
 }
 
 // 末尾に連結します
 String &ElekiEngine::String::operator+=(String &&string) noexcept
 {
-    auto newstr = joinStringInfos(mString, string.mString, mCount, string.mCount, mHash);
-    return operator=(newstr);
+    return operator+=((const String &) string);
 }
 
 // 文字列が等しいか判定します
@@ -240,11 +532,12 @@ const Char &ElekiEngine::String::at(size_t index) const
 // @param length 抜き出す文字列の長さ
 String ElekiEngine::String::sub(size_t index, size_t length) const
 {
-    if(index + length >= mCount) printError("out of range. String String::sub(size_t index, size_t length) const");
-    List<Char> str(length + 1);
-    for(size_t i = 0, j = index; i < length; i++, j++) str[i] = mString[j];
-    str[length] = NULL_CHAR;
-    return &str[0];
+    if(index + length > mCount)
+    {
+        printError("out of range. String String::sub(size_t index, size_t length) const");
+        return String();
+    }
+    return String(mString + index, length);
 }
 
 // 文字列の指定位置から後ろを抜き出します
@@ -271,227 +564,327 @@ String ElekiEngine::String::sub(size_t index, bool invers) const
 // @retval 要素数 一致する文字がありませんでした
 size_t ElekiEngine::String::indexOf(Char ch, bool invers) const
 {
-    if(!invers)
-    {
-        for(size_t i = 0; i < mCount; i++)
-        {
-            if(ch == mString[i]) return i;
-        }
-    }
-    else
-    {
-        for(int i = mCount - 1; i >= 0; i--)
-        {
-            if(ch == mString[i]) return i;
-        }
-    }
-    return mCount;
+    return view().indexOf(ch, invers);
 }
 
 // 一致する文字列の位置を返します
-// @param string 検索する文字
+// @param string 検索する文字列
 // @param invers 真のとき末尾から、偽のとき先頭から走査します
 // @return 一致した文字列の位置
 // @retval 要素数 一致する文字列がありませんでした
-size_t ElekiEngine::String::indexOf(const String &string, bool invers) const
+size_t ElekiEngine::String::indexOf(StringView string, bool invers) const
 {
-    if(mCount > string.mCount) return mCount;
-
-    if(!invers)
-    {
-        for(size_t i = 0; i < mCount; i++)
-        {
-            for(size_t j = i, k = 0; j < mCount; j++, k++)
-            {
-                if(mString[j] != string.mString[k]) break;
-                if(k == string.mCount - 1) return i;
-            }
-        }
-    }
-    else
-    {
-        for(int i = mCount - string.mCount - 1; i >= 0; i--)
-        {
-            for(size_t j = i, k = 0; j < mCount; j++, k++)
-            {
-                if(mString[j] != string.mString[k]) break;
-                if(k == string.mCount - 1) return i;
-            }
-        }
-    }
-    return mCount;
+    return view().indexOf(string, invers);
 }
 
 // イテレータの先頭を返します
-PointerItr<const Char &> ElekiEngine::String::begin() const
+PointerItr<const Char> ElekiEngine::String::begin() const
 {
-    return PointerItr<const Char &>(&mString[0]);
+    return PointerItr<const Char>(&mString[0]);
 }
 
 // イテレータの番兵を返します
-PointerItr<const Char &> ElekiEngine::String::end() const
+PointerItr<const Char> ElekiEngine::String::end() const
+{
+    return PointerItr<const Char>(&mString[mCount]);
+}
+
+// 数値を文字列に変換して書き込みます
+// 浮動小数点数は読み戻すと同じ値になる最短の表現になります
+template<class T>
+size_t formatNumber(Char *buffer, size_t count, T value)
 {
-    return PointerItr<const Char &>(&mString[mCount]);
+    auto converted = std::to_chars(buffer, buffer + count, value);
+    return converted.ec == std::errc() ? (size_t) (converted.ptr - buffer) : 0;
+}
+
+// 数値を文字列に変換します
+// 一時的な文字列は確保せず、スタック上の領域から直接インターンします
+template<class T>
+String numberToString(T value)
+{
+    Char buffer[NUMBER_CHARS_MAX];
+    return String(buffer, formatNumber(buffer, NUMBER_CHARS_MAX, value));
 }
 
 // 文字列に変換します
 String ElekiEngine::i8ToString(const i8 &value)
 {
-    return std::to_string(value).c_str();
+    return numberToString(value);
 }
 
 // 文字列に変換します
 String ElekiEngine::u8ToString(const u8 &value)
 {
-    return std::to_string(value).c_str();
+    return numberToString(value);
 }
 
 // 文字列に変換します
 String ElekiEngine::i16ToString(const i16 &value)
 {
-    return std::to_string(value).c_str();
+    return numberToString(value);
 }
 
 // 文字列に変換します
 String ElekiEngine::u16ToString(const u16 &value)
 {
-    return std::to_string(value).c_str();
+    return numberToString(value);
 }
 
 // 文字列に変換します
 String ElekiEngine::i32ToString(const i32 &value)
 {
-    return std::to_string(value).c_str();
+    return numberToString(value);
 }
 
 // 文字列に変換します
 String ElekiEngine::u32ToString(const u32 &value)
 {
-    return std::to_string(value).c_str();
+    return numberToString(value);
 }
 
 // 文字列に変換します
 String ElekiEngine::i64ToString(const i64 &value)
 {
-    return std::to_string(value).c_str();
+    return numberToString(value);
 }
 
 // 文字列に変換します
 String ElekiEngine::u64ToString(const u64 &value)
 {
-    return std::to_string(value).c_str();
+    return numberToString(value);
 }
 
 // 文字列に変換します
 String ElekiEngine::f32ToString(const f32 &value)
 {
-    return std::to_string(value).c_str();
+    return numberToString(value);
 }
 
 // 文字列に変換します
 String ElekiEngine::f64ToString(const f64 &value)
 {
-    return std::to_string(value).c_str();
+    return numberToString(value);
 }
 
-// 文字列から値に変換します
-// @param string 文字列
-// @param [out] value 変換後の値
-// @return 変換に成功した場合真
-bool ElekiEngine::stringToI32(const String &string, i32 &value)
+// 文字列に変換して書き込みます
+size_t ElekiEngine::i8ToChars(Char *buffer, size_t count, i8 value)
+{
+    return formatNumber(buffer, count, value);
+}
+
+// 文字列に変換して書き込みます
+size_t ElekiEngine::u8ToChars(Char *buffer, size_t count, u8 value)
+{
+    return formatNumber(buffer, count, value);
+}
+
+// 文字列に変換して書き込みます
+size_t ElekiEngine::i16ToChars(Char *buffer, size_t count, i16 value)
+{
+    return formatNumber(buffer, count, value);
+}
+
+// 文字列に変換して書き込みます
+size_t ElekiEngine::u16ToChars(Char *buffer, size_t count, u16 value)
+{
+    return formatNumber(buffer, count, value);
+}
+
+// 文字列に変換して書き込みます
+size_t ElekiEngine::i32ToChars(Char *buffer, size_t count, i32 value)
 {
-    try
+    return formatNumber(buffer, count, value);
+}
+
+// 文字列に変換して書き込みます
+size_t ElekiEngine::u32ToChars(Char *buffer, size_t count, u32 value)
+{
+    return formatNumber(buffer, count, value);
+}
+
+// 文字列に変換して書き込みます
+size_t ElekiEngine::i64ToChars(Char *buffer, size_t count, i64 value)
+{
+    return formatNumber(buffer, count, value);
+}
+
+// 文字列に変換して書き込みます
+size_t ElekiEngine::u64ToChars(Char *buffer, size_t count, u64 value)
+{
+    return formatNumber(buffer, count, value);
+}
+
+// 文字列に変換して書き込みます
+size_t ElekiEngine::f32ToChars(Char *buffer, size_t count, f32 value)
+{
+    return formatNumber(buffer, count, value);
+}
+
+// 文字列に変換して書き込みます
+size_t ElekiEngine::f64ToChars(Char *buffer, size_t count, f64 value)
+{
+    return formatNumber(buffer, count, value);
+}
+
+// 位置から数値に変換します
+// 先頭の'+'を読み飛ばし、1文字以上読めた場合は読み終えた位置を返します
+// @retval nullptr 変換に失敗しました
+template<class T>
+const Char *parseNumberAt(const Char *first, const Char *last, T &value)
+{
+    if(first != last && *first == '+')
     {
-        value = std::stoi(string.cstr());
-        return true;
+        first++;
+        if(first != last && *first == '-') return nullptr;
     }
-    catch(...)
+    if(first == last) return nullptr;
+    T result;
+    auto converted = std::from_chars(first, last, result);
+    if(converted.ec != std::errc()) return nullptr;
+    value = result;
+    return converted.ptr;
+}
+
+// 文字列から数値に変換します
+// 先頭の空白を読み飛ばし、1文字以上読めた場合に成功とします
+template<class T>
+bool parseNumber(StringView string, T &value)
+{
+    auto first = string.data();
+    auto last = first + string.count();
+    while(first != last && StringView::isSpace(*first)) first++;
+    return parseNumberAt(first, last, value) != nullptr;
+}
+
+// 区切られた数値の列を変換します
+// 空白と','を区切りとし、読めない要素があった場合はそこで止めます
+template<class T>
+size_t parseNumbers(StringView string, T *values, size_t count)
+{
+    auto first = string.data();
+    auto last = first + string.count();
+    size_t parsed = 0;
+    while(parsed < count)
     {
-        return false;
+        while(first != last && (StringView::isSpace(*first) || *first == ',')) first++;
+        first = parseNumberAt(first, last, values[parsed]);
+        if(!first) break;
+        parsed++;
     }
+    return parsed;
 }
 
 // 文字列から値に変換します
 // @param string 文字列
 // @param [out] value 変換後の値
 // @return 変換に成功した場合真
-bool ElekiEngine::stringToU32(const String &string, u32 &value)
+bool ElekiEngine::stringToI32(StringView string, i32 &value)
 {
-    try
-    {
-        value = (u32)std::stoul(string.cstr());
-        return true;
-    }
-    catch(...)
-    {
-        return false;
-    }
+    return parseNumber(string, value);
 }
 
 // 文字列から値に変換します
 // @param string 文字列
 // @param [out] value 変換後の値
 // @return 変換に成功した場合真
-bool ElekiEngine::stringToI64(const String &string, i64 &value)
+bool ElekiEngine::stringToU32(StringView string, u32 &value)
 {
-    try
-    {
-        value = std::stoll(string.cstr());
-        return true;
-    }
-    catch(...)
-    {
-        return false;
-    }
+    return parseNumber(string, value);
 }
 
 // 文字列から値に変換します
 // @param string 文字列
 // @param [out] value 変換後の値
 // @return 変換に成功した場合真
-bool ElekiEngine::stringToU64(const String &string, u64 &value)
+bool ElekiEngine::stringToI64(StringView string, i64 &value)
 {
-    try
-    {
-        value = std::stoull(string.cstr());
-        return true;
-    }
-    catch(...)
-    {
-        return false;
-    }
+    return parseNumber(string, value);
 }
 
 // 文字列から値に変換します
 // @param string 文字列
 // @param [out] value 変換後の値
 // @return 変換に成功した場合真
-bool ElekiEngine::stringToF32(const String &string, f32 &value)
+bool ElekiEngine::stringToU64(StringView string, u64 &value)
 {
-    try
-    {
-        value = std::stof(string.cstr());
-        return true;
-    }
-    catch(...)
-    {
-        return false;
-    }
+    return parseNumber(string, value);
 }
 
 // 文字列から値に変換します
 // @param string 文字列
 // @param [out] value 変換後の値
 // @return 変換に成功した場合真
-bool ElekiEngine::stringToF64(const String &string, f64 &value)
+bool ElekiEngine::stringToF32(StringView string, f32 &value)
 {
-    try
-    {
-        value = std::stod(string.cstr());
-        return true;
-    }
-    catch(...)
-    {
-        return false;
-    }
+    return parseNumber(string, value);
+}
+
+// 文字列から値に変換します
+// @param string 文字列
+// @param [out] value 変換後の値
+// @return 変換に成功した場合真
+bool ElekiEngine::stringToF64(StringView string, f64 &value)
+{
+    return parseNumber(string, value);
+}
+
+// 区切られた数値の列を一括で変換します
+// @param string 文字列
+// @param [out] values 変換後の値の書き込み先
+// @param count 書き込み先の要素数
+// @return 変換した要素数
+size_t ElekiEngine::stringToI32s(StringView string, i32 *values, size_t count)
+{
+    return parseNumbers(string, values, count);
+}
+
+// 区切られた数値の列を一括で変換します
+// @param string 文字列
+// @param [out] values 変換後の値の書き込み先
+// @param count 書き込み先の要素数
+// @return 変換した要素数
+size_t ElekiEngine::stringToU32s(StringView string, u32 *values, size_t count)
+{
+    return parseNumbers(string, values, count);
+}
+
+// 区切られた数値の列を一括で変換します
+// @param string 文字列
+// @param [out] values 変換後の値の書き込み先
+// @param count 書き込み先の要素数
+// @return 変換した要素数
+size_t ElekiEngine::stringToI64s(StringView string, i64 *values, size_t count)
+{
+    return parseNumbers(string, values, count);
+}
+
+// 区切られた数値の列を一括で変換します
+// @param string 文字列
+// @param [out] values 変換後の値の書き込み先
+// @param count 書き込み先の要素数
+// @return 変換した要素数
+size_t ElekiEngine::stringToU64s(StringView string, u64 *values, size_t count)
+{
+    return parseNumbers(string, values, count);
+}
+
+// 区切られた数値の列を一括で変換します
+// @param string 文字列
+// @param [out] values 変換後の値の書き込み先
+// @param count 書き込み先の要素数
+// @return 変換した要素数
+size_t ElekiEngine::stringToF32s(StringView string, f32 *values, size_t count)
+{
+    return parseNumbers(string, values, count);
+}
+
+// 区切られた数値の列を一括で変換します
+// @param string 文字列
+// @param [out] values 変換後の値の書き込み先
+// @param count 書き込み先の要素数
+// @return 変換した要素数
+size_t ElekiEngine::stringToF64s(StringView string, f64 *values, size_t count)
+{
+    return parseNumbers(string, values, count);
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include <cstdlib>
+#include <mutex>
+#include "elekicore/stringid.hpp"
+#include "elekicore/btreemap.hpp"
+
+using namespace ElekiEngine;
+
+// 文字列IDの名前表型
+using StringIdNameMap = BTreeMap<u64, String>;
+
+StringIdNameMap *gStringIdNames;      // 文字列IDの名前表
+std::mutex gStringIdNamesLockFlag;    // 文字列IDの名前表排他ロックフラグ
+std::once_flag gInitStringIdNamesF;   // initStringIdNames初期化フラグ
+void initStringIdNames()
+{
+	// 終了時の破棄順に依存しないよう、破棄せずに保持する
+	gStringIdNames = new(std::malloc(sizeof(StringIdNameMap))) StringIdNameMap();
+}
+
+// 2つの文字列が等しいか判定する
+bool equalStringIdName(const String &l, const Char *r, size_t count)
+{
+	if(l.count() != count) return false;
+	auto lstr = l.cstr();
+	for(size_t i = 0; i < count; i++)
+	{
+		if(lstr[i] != r[i]) return false;
+	}
+	return true;
+}
+
+/// 文字列IDの名前を登録します
+void ElekiEngine::registerStringIdName(u64 value, const Char *name, size_t count)
+{
+	std::call_once(gInitStringIdNamesF, initStringIdNames);
+	std::unique_lock<std::mutex> lock(gStringIdNamesLockFlag);
+	if(auto registered = gStringIdNames->find(value))
+	{
+		if(!equalStringIdName(*registered, name, count))
+		{
+			printError("string id collision. void registerStringIdName(u64 value, const Char *name, size_t count)");
+		}
+		return;
+	}
+
+	// Stringはヌル終端の生文字列から生成するため、長さを指定された名前は写してから登録する
+	List<Char> tmpstr(count + 1);
+	for(size_t i = 0; i < count; i++) tmpstr[i] = name[i];
+	tmpstr[count] = NULL_CHAR;
+	gStringIdNames->set(value, String(tmpstr.data()));
+}
+
+/// 文字列IDの名前を取得します
+String ElekiEngine::stringIdName(u64 value)
+{
+	std::call_once(gInitStringIdNamesF, initStringIdNames);
+	std::unique_lock<std::mutex> lock(gStringIdNamesLockFlag);
+	auto registered = gStringIdNames->find(value);
+	return registered ? *registered : String();
+}
\ No newline at end of file
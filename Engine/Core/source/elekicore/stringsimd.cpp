@@ -0,0 +1,529 @@
+#include <cstdint>
+#include <cstring>
+#include "elekicore/stringsimd.hpp"
+#include "elekicore/bit.hpp"
+
+#if ELEKI_SIMD_SSE2
+#include <immintrin.h>
+#if ELEKI_COMPILER_VC
+#include <intrin.h>
+#endif
+#endif
+
+using namespace ElekiEngine;
+
+//
+// 文字列のSIMD処理
+// -----
+// SSE2はx64で常に使えるため既定の実装とし、AVX2は初回の呼び出しでCPUを判別して切り替える
+// GCCとClangではAVX2でコンパイルしない場合も、関数単位でAVX2の命令を許可してコンパイルする
+// 長さの計算は終端を越えて読むが、境界に揃えた読み込みはページを跨がないため安全である
+
+#if ELEKI_SIMD_SSE2 && (ELEKI_COMPILER_GCC || ELEKI_COMPILER_CLANG)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+#define TARGET_AVX2
+#define NO_SANITIZE_ADDRESS
+#endif
+
+// 関数の表
+struct StringKernels
+{
+	size_t (*length)(const Char *string);
+	bool (*equal)(const Char *l, const Char *r, size_t count);
+	size_t (*indexOfChar)(const Char *string, size_t count, Char ch);
+	size_t (*indexOfString)(const Char *string, size_t count, const Char *pattern, size_t patternCount);
+	bool (*validUtf8)(const u8 *bytes, size_t count);
+	size_t (*codePointCount)(const u8 *bytes, size_t count);
+};
+
+// 先頭のUTF-8の符号位置のバイト数を返す
+// 不正な場合は0を返す
+size_t utf8SequenceLength(const u8 *bytes, size_t rest)
+{
+	auto lead = bytes[0];
+	if(lead < 0x80) return 1;
+	size_t length;
+	u8 low = 0x80, high = 0xBF; // 2バイト目の範囲
+	if(lead >= 0xC2 && lead <= 0xDF)
+	{
+		length = 2;
+	}
+	else if(lead >= 0xE0 && lead <= 0xEF)
+	{
+		length = 3;
+		if(lead == 0xE0) low = 0xA0;       // 過長
+		else if(lead == 0xED) high = 0x9F; // サロゲート
+	}
+	else if(lead >= 0xF0 && lead <= 0xF4)
+	{
+		length = 4;
+		if(lead == 0xF0) low = 0x90;       // 過長
+		else if(lead == 0xF4) high = 0x8F; // U+10FFFFを超える
+	}
+	else
+	{
+		return 0;
+	}
+	if(rest < length) return 0;
+	if(bytes[1] < low || bytes[1] > high) return 0;
+	for(size_t i = 2; i < length; i++)
+	{
+		if((bytes[i] & 0xC0) != 0x80) return 0;
+	}
+	return length;
+}
+
+// 指定位置から末尾までのUTF-8を検証する
+bool validUtf8From(const u8 *bytes, size_t count, size_t index)
+{
+	while(index < count)
+	{
+		auto length = utf8SequenceLength(bytes + index, count - index);
+		if(!length) return false;
+		index += length;
+	}
+	return true;
+}
+
+// 汎用の実装
+// 標準ライブラリの関数は処理系がSIMD化しているため、そのまま使う
+
+size_t lengthScalar(const Char *string)
+{
+	return std::strlen(string);
+}
+
+bool equalScalar(const Char *l, const Char *r, size_t count)
+{
+	return !std::memcmp(l, r, count);
+}
+
+size_t indexOfCharScalar(const Char *string, size_t count, Char ch)
+{
+	auto found = (const Char *) std::memchr(string, ch, count);
+	return found ? (size_t) (found - string) : count;
+}
+
+size_t indexOfStringScalar(const Char *string, size_t count, const Char *pattern, size_t patternCount)
+{
+	auto end = count - patternCount + 1;
+	for(size_t i = 0; i < end; i++)
+	{
+		i += indexOfCharScalar(string + i, end - i, pattern[0]);
+		if(i >= end) break;
+		if(string[i + patternCount - 1] == pattern[patternCount - 1] && !std::memcmp(string + i + 1, pattern + 1, patternCount - 2)) return i;
+	}
+	return count;
+}
+
+bool validUtf8Scalar(const u8 *bytes, size_t count)
+{
+	return validUtf8From(bytes, count, 0);
+}
+
+size_t codePointCountScalar(const u8 *bytes, size_t count)
+{
+	size_t result = 0;
+	for(size_t i = 0; i < count; i++) result += (bytes[i] & 0xC0) != 0x80;
+	return result;
+}
+
+#if ELEKI_SIMD_SSE2
+
+// SSE2の実装
+
+NO_SANITIZE_ADDRESS size_t lengthSse2(const Char *string)
+{
+	auto zero = _mm_setzero_si128();
+	auto offset = (size_t) ((uintptr_t) string & 15);
+	auto block = (const __m128i *) (const void *) (string - offset);
+	auto mask = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(block), zero)) >> offset;
+	if(mask) return countTrailingZeros(mask);
+	for(;;)
+	{
+		block++;
+		mask = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(block), zero));
+		if(mask) return (size_t) ((const Char *) block - string) + countTrailingZeros(mask);
+	}
+}
+
+bool equalSse2(const Char *l, const Char *r, size_t count)
+{
+	if(count < 16) return !std::memcmp(l, r, count);
+	size_t i = 0;
+	for(; i + 16 <= count; i += 16)
+	{
+		auto eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (l + i)), _mm_loadu_si128((const __m128i *) (r + i)));
+		if(_mm_movemask_epi8(eq) != 0xFFFF) return false;
+	}
+	if(i == count) return true;
+	// 末尾は最後の16バイトを重ねて比較する
+	auto eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (l + count - 16)), _mm_loadu_si128((const __m128i *) (r + count - 16)));
+	return _mm_movemask_epi8(eq) == 0xFFFF;
+}
+
+size_t indexOfCharSse2(const Char *string, size_t count, Char ch)
+{
+	auto key = _mm_set1_epi8(ch);
+	size_t i = 0;
+	for(; i + 16 <= count; i += 16)
+	{
+		auto mask = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (string + i)), key));
+		if(mask) return i + countTrailingZeros(mask);
+	}
+	for(; i < count; i++)
+	{
+		if(string[i] == ch) return i;
+	}
+	return count;
+}
+
+size_t indexOfStringSse2(const Char *string, size_t count, const Char *pattern, size_t patternCount)
+{
+	auto first = _mm_set1_epi8(pattern[0]);
+	auto last = _mm_set1_epi8(pattern[patternCount - 1]);
+	auto end = count - patternCount + 1;
+	size_t i = 0;
+	for(; i + 16 <= end; i += 16)
+	{
+		auto blockFirst = _mm_loadu_si128((const __m128i *) (string + i));
+		auto blockLast = _mm_loadu_si128((const __m128i *) (string + i + patternCount - 1));
+		auto mask = (u32) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last)));
+		while(mask)
+		{
+			auto bit = countTrailingZeros(mask);
+			if(!std::memcmp(string + i + bit + 1, pattern + 1, patternCount - 2)) return i + bit;
+			mask &= mask - 1;
+		}
+	}
+	for(; i < end; i++)
+	{
+		if(string[i] == pattern[0] && string[i + patternCount - 1] == pattern[patternCount - 1] && !std::memcmp(string + i + 1, pattern + 1, patternCount - 2)) return i;
+	}
+	return count;
+}
+
+// ASCIIのみの16バイトを読み飛ばし、それ以外の範囲を1符号位置ずつ検証する
+bool validUtf8Sse2(const u8 *bytes, size_t count)
+{
+	size_t i = 0;
+	while(i + 16 <= count)
+	{
+		auto mask = (u32) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (bytes + i)));
+		if(!mask)
+		{
+			i += 16;
+			continue;
+		}
+		i += countTrailingZeros(mask);
+		auto end = i + 16;
+		while(i < end && i < count)
+		{
+			auto length = utf8SequenceLength(bytes + i, count - i);
+			if(!length) return false;
+			i += length;
+		}
+	}
+	return validUtf8From(bytes, count, i);
+}
+
+// 継続バイトは符号付きで-64未満となることを使い、それ以外を数える
+size_t codePointCountSse2(const u8 *bytes, size_t count)
+{
+	auto limit = _mm_set1_epi8(-65);
+	auto one = _mm_set1_epi8(1);
+	auto zero = _mm_setzero_si128();
+	auto total = _mm_setzero_si128();
+	size_t i = 0;
+	for(; i + 16 <= count; i += 16)
+	{
+		auto lead = _mm_and_si128(_mm_cmpgt_epi8(_mm_loadu_si128((const __m128i *) (bytes + i)), limit), one);
+		total = _mm_add_epi64(total, _mm_sad_epu8(lead, zero));
+	}
+	alignas(16) u64 lanes[2];
+	_mm_store_si128((__m128i *) (void *) lanes, total);
+	return (size_t) (lanes[0] + lanes[1]) + codePointCountScalar(bytes + i, count - i);
+}
+
+// AVX2の実装
+
+TARGET_AVX2 NO_SANITIZE_ADDRESS size_t lengthAvx2(const Char *string)
+{
+	auto zero = _mm256_setzero_si256();
+	auto offset = (size_t) ((uintptr_t) string & 31);
+	auto block = (const __m256i *) (const void *) (string - offset);
+	auto mask = (u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(block), zero)) >> offset;
+	if(mask) return countTrailingZeros(mask);
+	for(;;)
+	{
+		block++;
+		mask = (u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(block), zero));
+		if(mask) return (size_t) ((const Char *) block - string) + countTrailingZeros(mask);
+	}
+}
+
+TARGET_AVX2 bool equalAvx2(const Char *l, const Char *r, size_t count)
+{
+	if(count < 32) return equalSse2(l, r, count);
+	size_t i = 0;
+	for(; i + 32 <= count; i += 32)
+	{
+		auto eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (l + i)), _mm256_loadu_si256((const __m256i *) (r + i)));
+		if((u32) _mm256_movemask_epi8(eq) != 0xFFFFFFFFu) return false;
+	}
+	if(i == count) return true;
+	auto eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (l + count - 32)), _mm256_loadu_si256((const __m256i *) (r + count - 32)));
+	return (u32) _mm256_movemask_epi8(eq) == 0xFFFFFFFFu;
+}
+
+TARGET_AVX2 size_t indexOfCharAvx2(const Char *string, size_t count, Char ch)
+{
+	auto key = _mm256_set1_epi8(ch);
+	size_t i = 0;
+	for(; i + 32 <= count; i += 32)
+	{
+		auto mask = (u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (string + i)), key));
+		if(mask) return i + countTrailingZeros(mask);
+	}
+	auto rest = indexOfCharSse2(string + i, count - i, ch);
+	return i + rest;
+}
+
+TARGET_AVX2 size_t indexOfStringAvx2(const Char *string, size_t count, const Char *pattern, size_t patternCount)
+{
+	auto first = _mm256_set1_epi8(pattern[0]);
+	auto last = _mm256_set1_epi8(pattern[patternCount - 1]);
+	auto end = count - patternCount + 1;
+	size_t i = 0;
+	for(; i + 32 <= end; i += 32)
+	{
+		auto blockFirst = _mm256_loadu_si256((const __m256i *) (string + i));
+		auto blockLast = _mm256_loadu_si256((const __m256i *) (string + i + patternCount - 1));
+		auto mask = (u32) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last)));
+		while(mask)
+		{
+			auto bit = countTrailingZeros(mask);
+			if(!std::memcmp(string + i + bit + 1, pattern + 1, patternCount - 2)) return i + bit;
+			mask &= mask - 1;
+		}
+	}
+	auto rest = indexOfStringSse2(string + i, count - i, pattern, patternCount);
+	return i + rest;
+}
+
+// UTF-8の誤りの種類
+// 連続する2バイトの上位4ビットと、1バイト目の下位4ビットから表を引き、全ての表で立つビットを誤りとする
+constexpr u8 UTF8_TOO_SHORT = 1 << 0;      // 先頭バイトの後に継続バイトが無い
+constexpr u8 UTF8_TOO_LONG = 1 << 1;       // ASCIIの後に継続バイトがある
+constexpr u8 UTF8_OVERLONG_3 = 1 << 2;     // 3バイトの過長
+constexpr u8 UTF8_TOO_LARGE = 1 << 3;      // U+10FFFFを超える
+constexpr u8 UTF8_SURROGATE = 1 << 4;      // サロゲート
+constexpr u8 UTF8_OVERLONG_2 = 1 << 5;     // 2バイトの過長
+constexpr u8 UTF8_TOO_LARGE_1000 = 1 << 6; // U+10FFFFを超える(2バイト目が1000____)
+constexpr u8 UTF8_OVERLONG_4 = 1 << 6;     // 4バイトの過長
+constexpr u8 UTF8_TWO_CONTS = 1 << 7;      // 継続バイトが続く
+constexpr u8 UTF8_CARRY = UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS;
+
+// 32バイトの誤りを調べる状態
+struct Utf8StateAvx2
+{
+	__m256i previous;   // 前の32バイト
+	__m256i incomplete; // 前の32バイトの末尾で途切れた符号位置
+	__m256i error;      // 誤り
+};
+
+// 32バイトを検証し、誤りを状態に加える
+TARGET_AVX2 inline void checkUtf8Avx2(Utf8StateAvx2 &state, __m256i input)
+{
+	if(!_mm256_movemask_epi8(input))
+	{
+		state.error = _mm256_or_si256(state.error, state.incomplete);
+		state.incomplete = _mm256_setzero_si256();
+		state.previous = input;
+		return;
+	}
+
+	const auto byte1High = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+		UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+		UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+		(char) UTF8_TWO_CONTS, (char) UTF8_TWO_CONTS, (char) UTF8_TWO_CONTS, (char) UTF8_TWO_CONTS,
+		UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+		UTF8_TOO_SHORT,
+		UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+		UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4));
+	const auto byte1Low = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+		(char) (UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4),
+		(char) (UTF8_CARRY | UTF8_OVERLONG_2),
+		(char) UTF8_CARRY,
+		(char) UTF8_CARRY,
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+		(char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000)));
+	const auto byte2High = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+		UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+		UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+		(char) (UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4),
+		(char) (UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE),
+		(char) (UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+		(char) (UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+		UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT));
+	const auto low4 = _mm256_set1_epi8(0x0F);
+
+	// 1から3バイト前の値
+	auto carried = _mm256_permute2x128_si256(state.previous, input, 0x21);
+	auto prev1 = _mm256_alignr_epi8(input, carried, 15);
+	auto prev2 = _mm256_alignr_epi8(input, carried, 14);
+	auto prev3 = _mm256_alignr_epi8(input, carried, 13);
+
+	// 連続する2バイトの組み合わせの誤り
+	auto special = _mm256_and_si256(
+		_mm256_and_si256(
+			_mm256_shuffle_epi8(byte1High, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low4)),
+			_mm256_shuffle_epi8(byte1Low, _mm256_and_si256(prev1, low4))),
+		_mm256_shuffle_epi8(byte2High, _mm256_and_si256(_mm256_srli_epi16(input, 4), low4)));
+
+	// 3、4バイトの符号位置の3、4バイト目は継続バイトが続いてよい
+	auto third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char) (0xE0 - 0x80)));
+	auto fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char) (0xF0 - 0x80)));
+	auto must = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char) 0x80));
+	state.error = _mm256_or_si256(state.error, _mm256_xor_si256(must, special));
+
+	// 末尾の3バイトに、続きが必要な先頭バイトがあるか
+	const auto maxValue = _mm256_setr_epi8(
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		(char) (0xF0 - 1), (char) (0xE0 - 1), (char) (0xC0 - 1));
+	state.incomplete = _mm256_subs_epu8(input, maxValue);
+	state.previous = input;
+}
+
+TARGET_AVX2 bool validUtf8Avx2(const u8 *bytes, size_t count)
+{
+	Utf8StateAvx2 state = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+	size_t i = 0;
+	for(; i + 32 <= count; i += 32)
+	{
+		checkUtf8Avx2(state, _mm256_loadu_si256((const __m256i *) (bytes + i)));
+	}
+	if(i < count)
+	{
+		// 末尾はASCIIの0で埋めて検証する
+		alignas(32) u8 rest[32] = {};
+		std::memcpy(rest, bytes + i, count - i);
+		checkUtf8Avx2(state, _mm256_load_si256((const __m256i *) (const void *) rest));
+	}
+	state.error = _mm256_or_si256(state.error, state.incomplete);
+	return _mm256_testz_si256(state.error, state.error) != 0;
+}
+
+TARGET_AVX2 size_t codePointCountAvx2(const u8 *bytes, size_t count)
+{
+	auto limit = _mm256_set1_epi8(-65);
+	auto one = _mm256_set1_epi8(1);
+	auto zero = _mm256_setzero_si256();
+	auto total = _mm256_setzero_si256();
+	size_t i = 0;
+	for(; i + 32 <= count; i += 32)
+	{
+		auto lead = _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i *) (bytes + i)), limit), one);
+		total = _mm256_add_epi64(total, _mm256_sad_epu8(lead, zero));
+	}
+	alignas(32) u64 lanes[4];
+	_mm256_store_si256((__m256i *) (void *) lanes, total);
+	return (size_t) (lanes[0] + lanes[1] + lanes[2] + lanes[3]) + codePointCountSse2(bytes + i, count - i);
+}
+
+// AVX2が使えるか判定する
+bool supportsAvx2()
+{
+#if ELEKI_SIMD_AVX2
+	return true;
+#elif ELEKI_COMPILER_VC
+	int info[4];
+	__cpuid(info, 0);
+	if(info[0] < 7) return false;
+	// OSがAVXのレジスタを保存するか確認する
+	__cpuid(info, 1);
+	if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28))) return false;
+	if((_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+// 使用する関数の表を選ぶ
+StringKernels selectStringKernels()
+{
+#if ELEKI_SIMD_SSE2
+	if(supportsAvx2())
+	{
+		return { lengthAvx2, equalAvx2, indexOfCharAvx2, indexOfStringAvx2, validUtf8Avx2, codePointCountAvx2 };
+	}
+	return { lengthSse2, equalSse2, indexOfCharSse2, indexOfStringSse2, validUtf8Sse2, codePointCountSse2 };
+#else
+	return { lengthScalar, equalScalar, indexOfCharScalar, indexOfStringScalar, validUtf8Scalar, codePointCountScalar };
+#endif
+}
+
+// 関数の表を取得する
+// 静的初期化中のStringからも呼ばれるため、初回の呼び出しで選ぶ
+const StringKernels &stringKernels()
+{
+	static const StringKernels kernels = selectStringKernels();
+	return kernels;
+}
+
+/// ヌル終端文字列の文字数を返します
+size_t ElekiEngine::stringLength(const Char *string)
+{
+	return stringKernels().length(string);
+}
+
+/// 文字列が等しいか判定します
+bool ElekiEngine::stringEqual(const Char *l, const Char *r, size_t count)
+{
+	return stringKernels().equal(l, r, count);
+}
+
+/// 一致する文字の位置を返します
+size_t ElekiEngine::stringIndexOf(const Char *string, size_t count, Char ch)
+{
+	return stringKernels().indexOfChar(string, count, ch);
+}
+
+/// 一致する文字列の位置を返します
+size_t ElekiEngine::stringIndexOf(const Char *string, size_t count, const Char *pattern, size_t patternCount)
+{
+	if(!patternCount) return 0;
+	if(patternCount > count) return count;
+	if(patternCount == 1) return stringKernels().indexOfChar(string, count, pattern[0]);
+	return stringKernels().indexOfString(string, count, pattern, patternCount);
+}
+
+/// 正しいUTF-8か判定します
+bool ElekiEngine::isValidUtf8(const Char *string, size_t count)
+{
+	return stringKernels().validUtf8((const u8 *) string, count);
+}
+
+/// UTF-8の符号位置の数を返します
+size_t ElekiEngine::utf8CodePointCount(const Char *string, size_t count)
+{
+	return stringKernels().codePointCount((const u8 *) string, count);
+}
\ No newline at end of file
@@ -1,7 +1,9 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <new>
 #include <thread>
-#include "elekicore/array.hpp"
-#include "elekicore/set.hpp"
-#include "elekicore/map.hpp"
 #include "elekicore/tasks.hpp"
 
 using namespace ElekiEngine;
@@ -9,243 +11,447 @@ using namespace ElekiEngine;
 //
 // ThreadPool
 // -----
-
-class ThreadPool
+// ワーカー毎に作業両端キューを持ち、ワーカーが投入したタスクは自身のキューの末尾に積む
+// 自身のキューが空になったワーカーは、投入キューと無作為に選んだ他のワーカーのキューの先頭から盗む
+// プールの外から投入したタスクは、全てのワーカーが取り出す投入キューに入れる
+// タスクはキューから取り出したスレッドだけが実行し、合流するスレッドは終了まで他のタスクを手伝う
+// 共有メモリは排他されないため、キューとスレッドの領域はmallocで確保する
+
+constexpr size_t THREAD_DEQUE_CAPACITY = 256;       // 作業両端キューの初期容量
+constexpr size_t THREAD_INJECTION_CAPACITY = 16384; // 投入キューの容量
+constexpr u32 THREAD_SPIN_COUNT = 64;               // 譲る前に取り出しを試みる回数
+constexpr u32 THREAD_YIELD_COUNT = 16;              // 休止する前に実行を譲る回数
+constexpr size_t THREAD_CACHE_LINE = 64;            // 別のスレッドが書き込む値を離す大きさ
+
+// 作業両端キュー
+// 所有するワーカーのみが末尾に積んで末尾から取り出し、他のスレッドは先頭から盗む
+class WorkDeque
 {
-	struct Node
+	// 環状配列
+	// 拡張前の配列は盗み中のスレッドが読む場合があるため、キューの破棄まで残す
+	struct Buffer
 	{
-		void *id;
-		Func<void()> run;
-		Node *prev;
-		Node *next;
+		i64 mask;                       // 添え字のマスク
+		Buffer *prev;                   // 拡張前の配列
+		std::atomic<Thread *> slots[1]; // 要素 容量分確保する
 	};
 
-	std::condition_variable mCondition;
-
-	Mutex mIsRunningLockFlag;
-	bool mIsRunning;
-
-	Mutex mThreadQueueAndMapLockFlag;
-	Map<void *, Node *> mThreadMap;
-	Node *mThreadQueueFirst;
-	Node *mThreadQueueLast;
-
-	Mutex mFinishedSetLockFlag;
-	Set<void *> mFinishedSet;
+	std::atomic<i64> mTop;                                        // 先頭 盗むスレッドが進める
+	u8 mTopPadding[THREAD_CACHE_LINE - sizeof(std::atomic<i64>)]; // 末尾と別のキャッシュラインに置く
+	std::atomic<i64> mBottom;                                     // 末尾 所有するワーカーのみが書き込む
+	std::atomic<Buffer *> mBuffer;                                // 環状配列
+	u8 mBottomPadding[THREAD_CACHE_LINE];                         // 隣のキューと別のキャッシュラインに置く
 
-	size_t mThreadListSize;
-	std::thread *mThreadList;
-
-	void setIsRunning(bool isRunning)
+	// 環状配列を確保する
+	static Buffer *newBuffer(i64 capacity, Buffer *prev)
 	{
-		Lock lock(mIsRunningLockFlag);
-		mIsRunning = isRunning;
+		auto buffer = (Buffer *) std::malloc(sizeof(Buffer) + sizeof(std::atomic<Thread *>) * (capacity - 1));
+		if(!buffer) return nullptr;
+		buffer->mask = capacity - 1;
+		buffer->prev = prev;
+		for(i64 i = 0; i < capacity; i++) new(&buffer->slots[i]) std::atomic<Thread *>(nullptr);
+		return buffer;
 	}
 
-	bool getIsRunning()
+	// 容量を2倍にした環状配列へ移す
+	Buffer *grow(Buffer *buffer, i64 top, i64 bottom)
 	{
-		Lock lock(mIsRunningLockFlag);
-		return mIsRunning;
+		auto grown = newBuffer((buffer->mask + 1) * 2, buffer);
+		if(!grown) return nullptr;
+		for(auto i = top; i < bottom; i++)
+		{
+			grown->slots[i & grown->mask].store(buffer->slots[i & buffer->mask].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+		mBuffer.store(grown, std::memory_order_release);
+		return grown;
 	}
 
-	Node *newNode(void *id, const Func<void()> &func)
-	{
-		auto node = new(Memory::allocate(sizeof(Node))) Node();
-		node->id = id;
-		node->next = nullptr;
-		node->prev = nullptr;
-		node->run = func;
+public:
 
-		return node;
-	}
+	// コンストラクタ
+	WorkDeque()
+		: mTop(0)
+		, mBottom(0)
+		, mBuffer(newBuffer(THREAD_DEQUE_CAPACITY, nullptr))
+	{}
 
-	void deleteNode(Node *node)
+	// デストラクタ
+	~WorkDeque()
 	{
-		Memory::deallocate(node);
+		auto buffer = mBuffer.load(std::memory_order_relaxed);
+		while(buffer)
+		{
+			auto prev = buffer->prev;
+			std::free(buffer);
+			buffer = prev;
+		}
 	}
 
-	void enqueue(Node *node)
+	// 末尾に積む 所有するワーカーのみが呼び出す
+	// @return 確保に失敗した場合偽
+	bool push(Thread *thread)
 	{
-		if(mThreadQueueFirst)
-		{
-			mThreadQueueFirst->next = node;
-		}
-		else
+		auto bottom = mBottom.load(std::memory_order_relaxed);
+		auto top = mTop.load(std::memory_order_acquire);
+		auto buffer = mBuffer.load(std::memory_order_relaxed);
+		if(!buffer) return false;
+		if(bottom - top > buffer->mask)
 		{
-			mThreadQueueLast = node;
+			buffer = grow(buffer, top, bottom);
+			if(!buffer) return false;
 		}
-		node->prev = mThreadQueueFirst;
-		mThreadQueueFirst = node;
-
-		mThreadMap.add(node->id, node);
+		buffer->slots[bottom & buffer->mask].store(thread, std::memory_order_relaxed);
+		mBottom.store(bottom + 1, std::memory_order_release);
+		return true;
 	}
 
-	Node *dequeue()
+	// 末尾から取り出す 所有するワーカーのみが呼び出す
+	// 最後の1つは盗むスレッドと先頭を奪い合う
+	Thread *pop()
 	{
-		auto node = mThreadQueueLast;
-		mThreadQueueLast = node->next;
-		if(mThreadQueueLast)
+		auto bottom = mBottom.load(std::memory_order_relaxed) - 1;
+		auto buffer = mBuffer.load(std::memory_order_relaxed);
+		mBottom.store(bottom, std::memory_order_seq_cst);
+		auto top = mTop.load(std::memory_order_seq_cst);
+		if(top > bottom)
 		{
-			mThreadQueueLast->prev = nullptr;
+			mBottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
 		}
-		else
+		auto thread = buffer->slots[bottom & buffer->mask].load(std::memory_order_relaxed);
+		if(top == bottom)
 		{
-			mThreadQueueFirst = nullptr;
+			if(!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) thread = nullptr;
+			mBottom.store(bottom + 1, std::memory_order_relaxed);
 		}
+		return thread;
+	}
 
-		mThreadMap.remove(node->id);
+	// 先頭から盗む
+	// 他のスレッドと奪い合って負けた場合もnullptrを返す
+	Thread *steal()
+	{
+		auto top = mTop.load(std::memory_order_seq_cst);
+		auto bottom = mBottom.load(std::memory_order_seq_cst);
+		if(top >= bottom) return nullptr;
+		auto buffer = mBuffer.load(std::memory_order_acquire);
+		auto thread = buffer->slots[top & buffer->mask].load(std::memory_order_relaxed);
+		if(!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+		return thread;
+	}
 
-		return node;
+	// 空か判定する
+	bool empty() const
+	{
+		return mBottom.load(std::memory_order_seq_cst) <= mTop.load(std::memory_order_seq_cst);
 	}
+};
 
-	void work()
+// 投入キュー
+// 容量固定の多生産者多消費者キューで、各要素の番号で書き込みと読み込みの順番を判定する
+class InjectionQueue
+{
+	// 要素
+	struct Cell
 	{
+		std::atomic<size_t> sequence; // 書き込み、読み込みできる番号
+		Thread *thread;               // タスク
+	};
 
-		while(true)
+	Cell *mCells;                                                        // 要素の配列
+	size_t mMask;                                                        // 添え字のマスク
+	std::atomic<size_t> mEnqueue;                                        // 次に書き込む番号
+	u8 mEnqueuePadding[THREAD_CACHE_LINE - sizeof(std::atomic<size_t>)]; // 読み込む番号と別のキャッシュラインに置く
+	std::atomic<size_t> mDequeue;                                        // 次に読み込む番号
+	u8 mDequeuePadding[THREAD_CACHE_LINE - sizeof(std::atomic<size_t>)]; // 後ろのメンバと別のキャッシュラインに置く
+
+public:
+
+	// コンストラクタ
+	InjectionQueue(size_t capacity)
+		: mCells((Cell *) std::malloc(sizeof(Cell) * capacity))
+		, mMask(capacity - 1)
+		, mEnqueue(0)
+		, mDequeue(0)
+	{
+		if(!mCells) return;
+		for(size_t i = 0; i < capacity; i++)
 		{
-			bool isRunning = getIsRunning();
+			new(&mCells[i].sequence) std::atomic<size_t>(i);
+			mCells[i].thread = nullptr;
+		}
+	}
 
-			Node *node = nullptr;
+	// デストラクタ
+	~InjectionQueue()
+	{
+		std::free(mCells);
+	}
 
+	// 末尾に加える
+	// @return 満杯の場合偽
+	bool push(Thread *thread)
+	{
+		if(!mCells) return false;
+		auto position = mEnqueue.load(std::memory_order_relaxed);
+		while(true)
+		{
+			auto &cell = mCells[position & mMask];
+			auto diff = (i64) cell.sequence.load(std::memory_order_acquire) - (i64) position;
+			if(!diff)
 			{
-				Lock lock(mThreadQueueAndMapLockFlag);
-				mCondition.wait(lock, [&]
-				{
-					return mThreadQueueLast || !mIsRunning;
-				});
-
-				if(mThreadQueueLast)
-				{
-					node = dequeue();
-				}
-				else if(!mIsRunning)
-				{
-					return;
-				}
+				if(mEnqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
 			}
-
-			if(node)
+			else if(diff < 0)
 			{
-				node->run();
-
-				{
-					Lock lock(mFinishedSetLockFlag);
-					mFinishedSet.add(node->id);
-				}
-
-				deleteNode(node);
+				return false;
+			}
+			else
+			{
+				position = mEnqueue.load(std::memory_order_relaxed);
 			}
 		}
+		auto &cell = mCells[position & mMask];
+		cell.thread = thread;
+		cell.sequence.store(position + 1, std::memory_order_release);
+		return true;
 	}
 
-	Node *remove(void *id)
+	// 先頭から取り出す
+	Thread *pop()
 	{
-		Lock lock(mThreadQueueAndMapLockFlag);
-		if(mThreadMap.contains(id))
+		if(!mCells) return nullptr;
+		auto position = mDequeue.load(std::memory_order_relaxed);
+		while(true)
 		{
-			auto node = mThreadMap[id];
-			mThreadMap.remove(id);
+			auto &cell = mCells[position & mMask];
+			auto diff = (i64) cell.sequence.load(std::memory_order_acquire) - (i64) (position + 1);
+			if(!diff)
+			{
+				if(mDequeue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+			}
+			else if(diff < 0)
+			{
+				return nullptr;
+			}
+			else
+			{
+				position = mDequeue.load(std::memory_order_relaxed);
+			}
+		}
+		auto &cell = mCells[position & mMask];
+		auto thread = cell.thread;
+		cell.sequence.store(position + mMask + 1, std::memory_order_release);
+		return thread;
+	}
 
-			if(node->prev) node->prev->next = node->next;
-			else mThreadQueueFirst = node->next;
-			if(node->next) node->next->prev = node->prev;
-			else mThreadQueueLast = node->prev;
+	// 空か判定する
+	bool empty() const
+	{
+		return mEnqueue.load(std::memory_order_seq_cst) == mDequeue.load(std::memory_order_seq_cst);
+	}
+};
+
+thread_local ThreadPool *gWorkerPool = nullptr; // 現在のスレッドが属するプール
+thread_local size_t gWorkerIndex = 0;           // 現在のスレッドのワーカー番号
+thread_local u64 gStealSeed = 0;                // 盗む相手を選ぶ乱数の状態
+
+// 盗む相手を選ぶ乱数を返す
+u64 nextStealRandom()
+{
+	if(!gStealSeed) gStealSeed = (u64) (size_t) &gStealSeed | 1;
+	gStealSeed ^= gStealSeed << 13;
+	gStealSeed ^= gStealSeed >> 7;
+	gStealSeed ^= gStealSeed << 17;
+	return gStealSeed;
+}
 
-			return node;
+class ElekiEngine::ThreadPool
+{
+	WorkDeque *mDeques;                     // ワーカー毎の作業両端キュー
+	std::thread *mWorkers;                  // ワーカー
+	size_t mWorkersCount;                   // ワーカー数
+	InjectionQueue mInjection;              // プールの外から投入したタスク
+	std::atomic<bool> mIsRunning;           // 実行中か
+	std::atomic<u32> mSleepers;             // 休止中のワーカー数
+	Mutex mParkLockFlag;                    // 休止の排他ロックフラグ
+	std::condition_variable mParkCondition; // 休止中のワーカーを起こす条件変数
+
+	// 現在のスレッドがこのプールのワーカーか判定する
+	bool isWorker() const
+	{
+		return gWorkerPool == this;
+	}
+
+	// 実行するタスクを探す
+	// ワーカーは自身のキュー、投入キュー、他のワーカーのキューの順に探す
+	Thread *find()
+	{
+		if(isWorker())
+		{
+			if(auto thread = mDeques[gWorkerIndex].pop()) return thread;
 		}
-		else
+		if(auto thread = mInjection.pop()) return thread;
+
+		auto first = (size_t) (nextStealRandom() % mWorkersCount);
+		for(size_t i = 0; i < mWorkersCount; i++)
 		{
-			return nullptr;
+			auto victim = (first + i) % mWorkersCount;
+			if(isWorker() && victim == gWorkerIndex) continue;
+			if(auto thread = mDeques[victim].steal()) return thread;
 		}
+		return nullptr;
 	}
 
-	void wait(void *id)
+	// 実行するタスクがあるか判定する
+	bool hasWork() const
 	{
-		while(true)
+		if(!mInjection.empty()) return true;
+		for(size_t i = 0; i < mWorkersCount; i++)
 		{
-			Lock lock(mFinishedSetLockFlag);
-			if(mFinishedSet.contains(id))
-			{
-				mFinishedSet.remove(id);
-				return;
-			}
+			if(!mDeques[i].empty()) return true;
 		}
+		return false;
 	}
 
-	void newPool()
+	// 休止中のワーカーを1つ起こす
+	// タスクを積む書き込みと休止数の読み込みを順序付け、休止直前のワーカーを取りこぼさない
+	void wake()
 	{
-		setIsRunning(true);
-
-		mThreadListSize = std::thread::hardware_concurrency();
-		mThreadList = (std::thread*)malloc(sizeof(std::thread) * mThreadListSize);
-
-		for(size_t i = 0; i < mThreadListSize; i++)
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(mSleepers.load(std::memory_order_relaxed))
 		{
-			new(&mThreadList[i]) std::thread(bind(&ThreadPool::work, this));
+			Lock lock(mParkLockFlag);
+			mParkCondition.notify_one();
 		}
 	}
 
-	void deletePool()
+	// タスクが投入されるまで休止する
+	void park()
 	{
-		setIsRunning(false);
+		Lock lock(mParkLockFlag);
+		mSleepers.fetch_add(1, std::memory_order_seq_cst);
+		if(!hasWork() && mIsRunning.load(std::memory_order_seq_cst)) mParkCondition.wait(lock);
+		mSleepers.fetch_sub(1, std::memory_order_relaxed);
+	}
 
-		for(size_t i = 0; i < mThreadListSize; i++)
+	// ワーカーの処理
+	// 回って探し、実行を譲り、それでも無ければ休止する
+	void work(size_t index)
+	{
+		gWorkerPool = this;
+		gWorkerIndex = index;
+
+		u32 idle = 0;
+		while(true)
 		{
-			mThreadList[i].join();
-		}
+			if(auto thread = find())
+			{
+				thread->execute();
+				idle = 0;
+				continue;
+			}
+			if(!mIsRunning.load(std::memory_order_acquire)) return;
 
-		free(mThreadList);
+			if(idle < THREAD_SPIN_COUNT)
+			{
+				idle++;
+			}
+			else if(idle < THREAD_SPIN_COUNT + THREAD_YIELD_COUNT)
+			{
+				idle++;
+				std::this_thread::yield();
+			}
+			else
+			{
+				park();
+				idle = 0;
+			}
+		}
 	}
 
 public:
 
+	// コンストラクタ
 	ThreadPool()
+		: mDeques(nullptr)
+		, mWorkers(nullptr)
+		, mWorkersCount(std::thread::hardware_concurrency())
+		, mInjection(THREAD_INJECTION_CAPACITY)
+		, mIsRunning(true)
+		, mSleepers(0)
 	{
-		newPool();
+		if(!mWorkersCount) mWorkersCount = 1;
+		mDeques = (WorkDeque *) std::malloc(sizeof(WorkDeque) * mWorkersCount);
+		mWorkers = (std::thread *) std::malloc(sizeof(std::thread) * mWorkersCount);
+		for(size_t i = 0; i < mWorkersCount; i++) new(&mDeques[i]) WorkDeque();
+		for(size_t i = 0; i < mWorkersCount; i++) new(&mWorkers[i]) std::thread([this, i]() { work(i); });
 	}
 
+	// デストラクタ
+	// ワーカーは残ったタスクを実行し終えてから終了する
 	~ThreadPool()
 	{
-		deletePool();
-	}
-
-	bool add(void* id, const Func<void()> &func)
-	{
-		if(getIsRunning())
 		{
-			auto node = newNode(id, func);
-
-			Lock lock(mThreadQueueAndMapLockFlag);
-			enqueue(node);
-			return true;
+			Lock lock(mParkLockFlag);
+			mIsRunning.store(false, std::memory_order_seq_cst);
+			mParkCondition.notify_all();
 		}
-		else
+		for(size_t i = 0; i < mWorkersCount; i++)
 		{
-			return false;
+			mWorkers[i].join();
+			mWorkers[i].~thread();
 		}
+		for(size_t i = 0; i < mWorkersCount; i++) mDeques[i].~WorkDeque();
+		std::free(mWorkers);
+		std::free(mDeques);
 	}
 
-	// 強制
-	void run(void *id)
+	// タスクを投入する
+	// ワーカーからは自身のキューへ、それ以外からは投入キューへ入れる
+	// 入れられない場合は、呼び出したスレッドで実行する
+	void add(Thread *thread)
 	{
-		auto node = remove(id);
-		if(node)
+		auto added = isWorker() ? mDeques[gWorkerIndex].push(thread) : mInjection.push(thread);
+		if(!added)
 		{
-			node->run();
-			deleteNode(node);
-		}
-		else
-		{
-			wait(id);
+			thread->execute();
+			return;
 		}
+		wake();
 	}
 
-	bool finished(void *id)
+	// タスクの終了を待つ
+	// 待つ間は他のタスクを実行し、待つタスクがキューに残っていても必ず進むようにする
+	void wait(Thread *thread)
 	{
-		Lock lock(mFinishedSetLockFlag);
-		return mFinishedSet.contains(id);
+		u32 idle = 0;
+		while(!thread->mEnded.load(std::memory_order_acquire))
+		{
+			if(auto other = find())
+			{
+				other->execute();
+				idle = 0;
+				continue;
+			}
+
+			if(idle < THREAD_SPIN_COUNT)
+			{
+				idle++;
+			}
+			else if(idle < THREAD_SPIN_COUNT + THREAD_YIELD_COUNT)
+			{
+				idle++;
+				std::this_thread::yield();
+			}
+			else
+			{
+				// 他のスレッドで長いタスクを実行中
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		}
 	}
-} 
+}
 *gThreadPool;
 
 std::once_flag gInitThreadsOnceFlag;
@@ -270,24 +476,27 @@ struct FinThreadPool
 // Thread
 // -----
 
-// スレッドを初期化します
-void initThread(Thread *thread, EThreadMode mode)
+// 実行し、終了を記録します
+void ElekiEngine::Thread::execute()
 {
-	
+	run();
+	mEnded.store(true, std::memory_order_release);
 }
 
-// 初期化します
-void ElekiEngine::Thread::init()
+// 並列処理を開始します
+void ElekiEngine::Thread::start()
 {
-	std::call_once(gInitThreadsOnceFlag, initThreadPool);
+	if(mStarted) return;
+	mStarted = true;
 	switch(mMode)
 	{
 		case ElekiEngine::EThreadMode::THREAD_POOL:
-		gThreadPool->add(this, bind(&Thread::run, this));
+		std::call_once(gInitThreadsOnceFlag, initThreadPool);
+		gThreadPool->add(this);
 		break;
 
 		case ElekiEngine::EThreadMode::INDEPENDENCE:
-		mIndependenceThread = new(Memory::allocate(sizeof(std::thread))) std::thread(bind(&Thread::run, this));
+		mIndependenceThread = new(std::malloc(sizeof(std::thread))) std::thread([this]() { execute(); });
 		break;
 
 		default:
@@ -296,18 +505,30 @@ void ElekiEngine::Thread::init()
 }
 
 // 終了化します
+// 開始していない場合は、呼び出したスレッドで実行します
 void ElekiEngine::Thread::fin()
 {
+	if(!mStarted)
+	{
+		mStarted = true;
+		execute();
+		return;
+	}
+
 	switch(mMode)
 	{
 		case ElekiEngine::EThreadMode::THREAD_POOL:
-		gThreadPool->run(this);
+		if(!mEnded.load(std::memory_order_acquire)) gThreadPool->wait(this);
 		break;
 
 		case ElekiEngine::EThreadMode::INDEPENDENCE:
-		mIndependenceThread->join();
-		mIndependenceThread->~thread();
-		Memory::deallocate(mIndependenceThread);
+		if(mIndependenceThread)
+		{
+			mIndependenceThread->join();
+			mIndependenceThread->~thread();
+			std::free(mIndependenceThread);
+			mIndependenceThread = nullptr;
+		}
 		break;
 
 		default:
@@ -318,14 +539,16 @@ void ElekiEngine::Thread::fin()
 // コンストラクタです
 ElekiEngine::Thread::Thread(EThreadMode mode)
 	: mMode(mode)
-{
-	init();
-}
+	, mStarted(false)
+	, mEnded(false)
+	, mIndependenceThread(nullptr)
+{}
 
 // デストラクタです
+// 派生クラスは破棄済みのため、開始していない場合は実行しない
 ElekiEngine::Thread::~Thread()
 {
-	join();
+	if(mStarted) join();
 }
 
 // 並列処理の終了を待ち、スレッドを結合します
@@ -334,8 +557,8 @@ void ElekiEngine::Thread::join()
 	fin();
 }
 
-// デストラクタです
+// 並列処理が終了しているか判定します
 bool ElekiEngine::Thread::ended()
 {
-	return gThreadPool->finished(this); // これ　＋　!mIsRunning　add run で　waitを回避する方法
+	return mEnded.load(std::memory_order_acquire);
 }
\ No newline at end of file